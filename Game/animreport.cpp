@@ -0,0 +1,98 @@
+#include "animreport.h"
+
+#include <Tempest/Log>
+
+#include <zenload/modelAnimationParser.h>
+#include <zenload/zenParser.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+#include "graphics/mesh/animsamples.h"
+#include "resources.h"
+
+using namespace Tempest;
+
+int AnimReport::exec() {
+  auto& tol   = AnimSamples::tolerance();
+  auto  files = Resources::vdfsIndex().getKnownFiles();
+
+  Stat st;
+  for(auto& i:files) {
+    if(i.size()<4 || i.compare(i.size()-4,4,".MAN")!=0)
+      continue;
+    try {
+      process(i,st);
+      }
+    catch(...) {
+      st.failed++;
+      }
+    st.files++;
+    }
+
+  auto kib = [](uint64_t b) {
+    return double(b)/1024.0;
+    };
+  char buf[512] = {};
+  std::snprintf(buf,sizeof(buf),"%u files (%u failed), tolerance: rotation %g, position %g",
+                uint32_t(st.files),uint32_t(st.failed),double(tol.rotation),double(tol.position));
+  Log::i("anim-report: ",buf);
+  std::snprintf(buf,sizeof(buf),"raw %.1f KiB, compressed %.1f KiB (%.2fx), %llu keys of %llu samples",
+                kib(st.raw),kib(st.packed),st.packed==0 ? 0.0 : double(st.raw)/double(st.packed),
+                (unsigned long long)st.keys,(unsigned long long)st.samples);
+  Log::i("anim-report: ",buf);
+  std::snprintf(buf,sizeof(buf),"max rotation error %g (%s), max position error %g cm (%s)",
+                double(st.rotError),st.rotWorst.c_str(),double(st.posError),st.posWorst.c_str());
+  Log::i("anim-report: ",buf);
+  return 0;
+  }
+
+void AnimReport::process(const std::string& name, Stat& st) {
+  ZenLoad::ZenParser            zen(name,Resources::vdfsIndex());
+  ZenLoad::ModelAnimationParser p(zen);
+
+  while(true) {
+    switch(p.parse()) {
+      case ZenLoad::ModelAnimationParser::CHUNK_EOF:
+        return;
+      case ZenLoad::ModelAnimationParser::CHUNK_HEADER:
+        break;
+      case ZenLoad::ModelAnimationParser::CHUNK_ERROR:
+        throw std::runtime_error("animation load error");
+      case ZenLoad::ModelAnimationParser::CHUNK_RAWDATA: {
+        const size_t nodes   = p.getNodeIndex().size();
+        auto&        samples = p.getSamples();
+
+        AnimSamples packed;
+        packed.assign(samples,nodes);
+        st.raw     += samples.size()*sizeof(samples[0]);
+        st.packed  += packed.memoryUsage();
+        st.samples += packed.frameCount()*nodes*2;
+        st.keys    += packed.keyCount();
+
+        for(size_t f=0; f<packed.frameCount(); ++f)
+          for(size_t n=0; n<nodes; ++n) {
+            auto& a = samples[f*nodes+n];
+            auto  b = packed.at(f,n);
+
+            const float s  = (a.rotation.x*b.rotation.x + a.rotation.y*b.rotation.y +
+                              a.rotation.z*b.rotation.z + a.rotation.w*b.rotation.w)<0 ? -1.f : 1.f;
+            const float er = std::max(std::max(std::abs(a.rotation.x-b.rotation.x*s),std::abs(a.rotation.y-b.rotation.y*s)),
+                                      std::max(std::abs(a.rotation.z-b.rotation.z*s),std::abs(a.rotation.w-b.rotation.w*s)));
+            const float ep = std::max(std::abs(a.position.x-b.position.x),
+                                      std::max(std::abs(a.position.y-b.position.y),std::abs(a.position.z-b.position.z)));
+            if(er>st.rotError) {
+              st.rotError = er;
+              st.rotWorst = name;
+              }
+            if(ep>st.posError) {
+              st.posError = ep;
+              st.posWorst = name;
+              }
+            }
+        break;
+        }
+      }
+    }
+  }
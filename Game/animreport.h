@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// Headless tool: compresses every animation of the game with current AnimSamples tolerance,
+// and prints memory usage of raw and compressed key frames, together with maximum error.
+class AnimReport final {
+  public:
+    AnimReport() = default;
+    AnimReport(const AnimReport&) = delete;
+
+    int  exec();
+
+  private:
+    struct Stat {
+      size_t      files    = 0;
+      size_t      failed   = 0;
+      uint64_t    raw      = 0;
+      uint64_t    packed   = 0;
+      uint64_t    samples  = 0;
+      uint64_t    keys     = 0;
+      float       rotError = 0;
+      float       posError = 0;
+      std::string rotWorst, posWorst;
+      };
+
+    void process(const std::string& name, Stat& st);
+  };
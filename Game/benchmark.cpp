@@ -0,0 +1,157 @@
+#include "benchmark.h"
+
+#include <Tempest/File>
+#include <Tempest/Log>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "game/gamesession.h"
+#include "game/serialize.h"
+#include "graphics/rendererstorage.h"
+#include "utils/perfcounters.h"
+#include "gamemusic.h"
+#include "gothic.h"
+
+using namespace Tempest;
+
+Benchmark::Benchmark(Gothic& gothic)
+  :gothic(gothic) {
+  }
+
+void Benchmark::setupNullSound() {
+  // select null backend of OpenAL-soft
+#if defined(_WIN32)
+  _putenv_s("ALSOFT_DRIVERS","null");
+#else
+  setenv("ALSOFT_DRIVERS","null",1);
+#endif
+  }
+
+int Benchmark::exec() {
+  auto& st = gothic.benchmarkSettings();
+  GameMusic::inst().setEnabled(false);
+
+  RendererStorage storage(gothic);
+  Report          rep;
+  rep.dt = st.dt;
+
+  const uint64_t loadStart = now();
+  try {
+    std::unique_ptr<GameSession> game;
+    if(!gothic.defaultSave().empty()) {
+      RFile     file(gothic.defaultSave());
+      Serialize s(file);
+      game.reset(new GameSession(gothic,storage,s));
+      } else {
+      game.reset(new GameSession(gothic,storage,gothic.defaultWorld()));
+      }
+    gothic.setGame(std::move(game));
+    }
+  catch(std::exception& e) {
+    Log::e("benchmark: unable to load world: ",e.what());
+    return 1;
+    }
+  rep.loadNs = now()-loadStart;
+
+  auto world = gothic.world();
+  if(world==nullptr) {
+    Log::e("benchmark: no world");
+    return 1;
+    }
+  rep.world = world->name();
+  rep.npcs  = world->npcCount();
+
+  Log::i("benchmark: ",st.ticks," ticks, dt = ",st.dt," ms");
+  PerfCounters::reset();
+  PerfCounters::setEnabled(true);
+  rep.tickNs.resize(st.ticks);
+  for(auto& i:rep.tickNs) {
+    const uint64_t time = now();
+    gothic.tick(st.dt);
+    gothic.updateAnimation();
+    i = now()-time;
+    }
+  PerfCounters::setEnabled(false);
+
+  for(uint8_t i=0; i<PerfCounters::Count; ++i)
+    rep.subsystemNs[i] = PerfCounters::get(PerfCounters::Counter(i));
+  for(uint8_t i=0; i<PerfCounters::EventCount; ++i)
+    rep.events[i] = PerfCounters::get(PerfCounters::Event(i));
+
+  writeReport(rep);
+  gothic.clearGame();
+  return 0;
+  }
+
+void Benchmark::writeReport(const Report& r) const {
+  uint64_t total = 0;
+  for(auto i:r.tickNs)
+    total += i;
+
+  std::vector<uint64_t> sorted = r.tickNs;
+  std::sort(sorted.begin(),sorted.end());
+  auto percentile = [&sorted](size_t p) -> uint64_t {
+    if(sorted.empty())
+      return 0;
+    return sorted[std::min(sorted.size()-1,sorted.size()*p/100)];
+    };
+  auto ms = [](uint64_t ns) {
+    return double(ns)/1000000.0;
+    };
+
+  std::string world;
+  for(auto c:r.world) {
+    if(c=='"' || c=='\\')
+      world.push_back('\\');
+    world.push_back(c);
+    }
+
+  const double mean = r.tickNs.empty() ? 0.0 : ms(total)/double(r.tickNs.size());
+
+  char buf[2048] = {};
+  std::snprintf(buf,sizeof(buf),
+                "{\n"
+                "  \"world\": \"%s\",\n"
+                "  \"ticks\": %u,\n"
+                "  \"dt_ms\": %u,\n"
+                "  \"npcs\": %u,\n"
+                "  \"load_ms\": %.3f,\n"
+                "  \"total_ms\": %.3f,\n"
+                "  \"tick_ms\": {\"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n"
+                "  \"subsystems_ms\": {\"world_objects\": %.3f, \"physics\": %.3f, \"script\": %.3f, \"animation\": %.3f},\n"
+                "  \"anim_lod\": {\"full\": %llu, \"reduced\": %llu, \"far\": %llu, \"throttled\": %llu, \"frozen\": %llu}\n"
+                "}\n",
+                world.c_str(),
+                uint32_t(r.tickNs.size()), r.dt, uint32_t(r.npcs),
+                ms(r.loadNs), ms(total),
+                mean, ms(percentile(0)), ms(percentile(50)), ms(percentile(95)), ms(percentile(99)),
+                ms(sorted.empty() ? 0 : sorted.back()),
+                ms(r.subsystemNs[PerfCounters::WorldObjects]), ms(r.subsystemNs[PerfCounters::Physics]),
+                ms(r.subsystemNs[PerfCounters::Script]),       ms(r.subsystemNs[PerfCounters::Animation]),
+                (unsigned long long)r.events[PerfCounters::PoseFull],
+                (unsigned long long)r.events[PerfCounters::PoseReduced],
+                (unsigned long long)r.events[PerfCounters::PoseFar],
+                (unsigned long long)r.events[PerfCounters::PoseThrottled],
+                (unsigned long long)r.events[PerfCounters::PoseFrozen]);
+
+  auto& path = gothic.benchmarkSettings().report;
+  try {
+    WFile fout(path);
+    fout.write(buf,std::strlen(buf));
+    }
+  catch(std::exception& e) {
+    Log::e("benchmark: unable to write report \"",path.c_str(),"\": ",e.what());
+    }
+  char msg[64] = {};
+  std::snprintf(msg,sizeof(msg),"%.3f",mean);
+  Log::i("benchmark: mean tick ",msg," ms, report written to \"",path.c_str(),"\"");
+  }
+
+uint64_t Benchmark::now() {
+  auto t = std::chrono::steady_clock::now().time_since_epoch();
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t).count());
+  }
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "utils/perfcounters.h"
+
+class Gothic;
+
+// Headless simulation: world is loaded without window, swapchain and sound output, advanced by fixed
+// number of ticks with constant dt, and per-subsystem timings are written as json report.
+class Benchmark final {
+  public:
+    Benchmark(Gothic& gothic);
+    Benchmark(const Benchmark&) = delete;
+
+    int         exec();
+
+    // redirects audio output to null-device; must be called before any sound device is created
+    static void setupNullSound();
+
+  private:
+    struct Report {
+      std::string           world;
+      uint32_t              dt      = 0;
+      size_t                npcs    = 0;
+      uint64_t              loadNs  = 0;
+      std::vector<uint64_t> tickNs;
+      uint64_t              subsystemNs[PerfCounters::Count] = {};
+      uint64_t              events[PerfCounters::EventCount]  = {};
+      };
+
+    Gothic&     gothic;
+
+    void        writeReport(const Report& r) const;
+
+    static uint64_t now();
+  };
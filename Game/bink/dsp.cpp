@@ -0,0 +1,396 @@
+#include "dsp.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define BINK_SIMD_SSE 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BINK_SIMD_NEON 1
+#endif
+
+using namespace Bink;
+
+template<class T>
+static void idctTransform(T* dest, const int* src,
+                          int s0, int s1, int s2, int s3, int s4, int s5, int s6, int s7,
+                          int d0, int d1, int d2, int d3, int d4, int d5, int d6, int d7,
+                          T (*munge)(int)) {
+  enum {
+    A1 = 2896, /* (1/sqrt(2))<<12 */
+    A2 = 2217,
+    A3 = 3784,
+    A4 = -5352
+    };
+  static int (*mul)(int,int) = [](int x,int y) -> int { return int(uint32_t(x)*uint32_t(y)) >> 11; };
+
+  const int a0 = (src)[s0] + (src)[s4];
+  const int a1 = (src)[s0] - (src)[s4];
+  const int a2 = (src)[s2] + (src)[s6];
+  const int a3 = mul(A1, (src)[s2] - (src)[s6]);
+  const int a4 = (src)[s5] + (src)[s3];
+  const int a5 = (src)[s5] - (src)[s3];
+  const int a6 = (src)[s1] + (src)[s7];
+  const int a7 = (src)[s1] - (src)[s7];
+  const int b0 = a4 + a6;
+  const int b1 = mul(A3, a5 + a7);
+  const int b2 = mul(A4, a5) - b0 + b1;
+  const int b3 = mul(A1, a6 - a4) - b2;
+  const int b4 = mul(A2, a7) + b3 - b1;
+  dest[d0] = munge(a0+a2   +b0);
+  dest[d1] = munge(a1+a3-a2+b2);
+  dest[d2] = munge(a1-a3+a2+b3);
+  dest[d3] = munge(a0-a2   -b4);
+  dest[d4] = munge(a0-a2   +b4);
+  dest[d5] = munge(a1-a3+a2-b3);
+  dest[d6] = munge(a1+a3-a2-b2);
+  dest[d7] = munge(a0+a2   -b0);
+  }
+
+template<class T>
+static void idctCol(T* dest, const int* src) {
+  static T (*munge)(int) = [](int x) -> T { return T(x); };
+  idctTransform(dest,src,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,munge);
+  }
+
+template<class T>
+static void idctRow(T* dest, const int* src) {
+  static T (*munge)(int) = [](int x) -> T { return T((x + 0x7F)>>8); };
+  idctTransform(dest,src,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,munge);
+  }
+
+namespace {
+
+#if defined(BINK_SIMD_SSE)
+using i4 = __m128i;
+using f4 = __m128;
+
+inline i4   load4 (const int32_t* p)  { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline void store4(int32_t* p, i4 v)  { _mm_storeu_si128(reinterpret_cast<__m128i*>(p),v);       }
+inline i4   splat4(int32_t v)         { return _mm_set1_epi32(v); }
+inline i4   add4  (i4 a, i4 b)        { return _mm_add_epi32(a,b); }
+inline i4   sub4  (i4 a, i4 b)        { return _mm_sub_epi32(a,b); }
+inline i4   sra4  (i4 a, int n)       { return _mm_sra_epi32(a,_mm_cvtsi32_si128(n)); }
+// low 32 bits of product; sse2 has no pmulld
+inline i4   mullo4(i4 a, i4 b) {
+  const i4 even = _mm_mul_epu32(a,b);
+  const i4 odd  = _mm_mul_epu32(_mm_srli_si128(a,4),_mm_srli_si128(b,4));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even,_MM_SHUFFLE(0,0,2,0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+  }
+
+inline void transpose4(i4& a, i4& b, i4& c, i4& d) {
+  const i4 t0 = _mm_unpacklo_epi32(a,b);
+  const i4 t1 = _mm_unpacklo_epi32(c,d);
+  const i4 t2 = _mm_unpackhi_epi32(a,b);
+  const i4 t3 = _mm_unpackhi_epi32(c,d);
+  a = _mm_unpacklo_epi64(t0,t1);
+  b = _mm_unpackhi_epi64(t0,t1);
+  c = _mm_unpacklo_epi64(t2,t3);
+  d = _mm_unpackhi_epi64(t2,t3);
+  }
+
+inline f4   loadf (const float* p)    { return _mm_loadu_ps(p);   }
+inline f4   addf  (f4 a, f4 b)        { return _mm_add_ps(a,b); }
+inline f4   subf  (f4 a, f4 b)        { return _mm_sub_ps(a,b); }
+inline f4   mulf  (f4 a, f4 b)        { return _mm_mul_ps(a,b); }
+inline f4   negf  (f4 a)              { return _mm_xor_ps(a,_mm_set1_ps(-0.f)); }
+// p[0..3] in reverse order
+inline f4   loadr (const float* p)    { return _mm_shuffle_ps(_mm_loadu_ps(p),_mm_loadu_ps(p),_MM_SHUFFLE(0,1,2,3)); }
+
+inline void loadComplex4(const Video::FFTComplex* z, f4& re, f4& im) {
+  const f4 a = _mm_loadu_ps(&z[0].re);
+  const f4 b = _mm_loadu_ps(&z[2].re);
+  re = _mm_shuffle_ps(a,b,_MM_SHUFFLE(2,0,2,0));
+  im = _mm_shuffle_ps(a,b,_MM_SHUFFLE(3,1,3,1));
+  }
+
+inline void storeComplex4(Video::FFTComplex* z, f4 re, f4 im) {
+  _mm_storeu_ps(&z[0].re,_mm_unpacklo_ps(re,im));
+  _mm_storeu_ps(&z[2].re,_mm_unpackhi_ps(re,im));
+  }
+#elif defined(BINK_SIMD_NEON)
+using i4 = int32x4_t;
+using f4 = float32x4_t;
+
+inline i4   load4 (const int32_t* p)  { return vld1q_s32(p);     }
+inline void store4(int32_t* p, i4 v)  { vst1q_s32(p,v);          }
+inline i4   splat4(int32_t v)         { return vdupq_n_s32(v);   }
+inline i4   add4  (i4 a, i4 b)        { return vaddq_s32(a,b);   }
+inline i4   sub4  (i4 a, i4 b)        { return vsubq_s32(a,b);   }
+inline i4   sra4  (i4 a, int n)       { return vshlq_s32(a,vdupq_n_s32(-n)); }
+inline i4   mullo4(i4 a, i4 b)        { return vmulq_s32(a,b);   }
+
+inline void transpose4(i4& a, i4& b, i4& c, i4& d) {
+  const int32x4x2_t ab = vtrnq_s32(a,b);
+  const int32x4x2_t cd = vtrnq_s32(c,d);
+  a = vcombine_s32(vget_low_s32 (ab.val[0]),vget_low_s32 (cd.val[0]));
+  b = vcombine_s32(vget_low_s32 (ab.val[1]),vget_low_s32 (cd.val[1]));
+  c = vcombine_s32(vget_high_s32(ab.val[0]),vget_high_s32(cd.val[0]));
+  d = vcombine_s32(vget_high_s32(ab.val[1]),vget_high_s32(cd.val[1]));
+  }
+
+inline f4   loadf (const float* p)    { return vld1q_f32(p);   }
+inline f4   addf  (f4 a, f4 b)        { return vaddq_f32(a,b); }
+inline f4   subf  (f4 a, f4 b)        { return vsubq_f32(a,b); }
+inline f4   mulf  (f4 a, f4 b)        { return vmulq_f32(a,b); }
+inline f4   negf  (f4 a)              { return vnegq_f32(a);   }
+inline f4   loadr (const float* p)    { const f4 v = vrev64q_f32(vld1q_f32(p)); return vextq_f32(v,v,2); }
+
+inline void loadComplex4(const Video::FFTComplex* z, f4& re, f4& im) {
+  const float32x4x2_t v = vld2q_f32(&z[0].re);
+  re = v.val[0];
+  im = v.val[1];
+  }
+
+inline void storeComplex4(Video::FFTComplex* z, f4 re, f4 im) {
+  float32x4x2_t v;
+  v.val[0] = re;
+  v.val[1] = im;
+  vst2q_f32(&z[0].re,v);
+  }
+#endif
+
+}
+
+#if defined(BINK_SIMD_SSE) || defined(BINK_SIMD_NEON)
+// same as idctTransform, for 4 columns at once: v[0..7] are inputs s0..s7 and receive d0..d7
+static void idctTransform4(i4* v, int32_t round, int shift) {
+  auto mul = [](int32_t x, i4 y) { return sra4(mullo4(splat4(x),y),11); };
+
+  const i4 a0 = add4(v[0],v[4]);
+  const i4 a1 = sub4(v[0],v[4]);
+  const i4 a2 = add4(v[2],v[6]);
+  const i4 a3 = mul(2896,sub4(v[2],v[6]));
+  const i4 a4 = add4(v[5],v[3]);
+  const i4 a5 = sub4(v[5],v[3]);
+  const i4 a6 = add4(v[1],v[7]);
+  const i4 a7 = sub4(v[1],v[7]);
+  const i4 b0 = add4(a4,a6);
+  const i4 b1 = mul(3784,add4(a5,a7));
+  const i4 b2 = add4(sub4(mul(-5352,a5),b0),b1);
+  const i4 b3 = sub4(mul(2896,sub4(a6,a4)),b2);
+  const i4 b4 = sub4(add4(mul(2217,a7),b3),b1);
+
+  const i4 r  = splat4(round);
+  const i4 p0 = add4(a0,a2);
+  const i4 p1 = sub4(add4(a1,a3),a2);
+  const i4 p2 = add4(sub4(a1,a3),a2);
+  const i4 p3 = sub4(a0,a2);
+  v[0] = sra4(add4(add4(p0,b0),r),shift);
+  v[1] = sra4(add4(add4(p1,b2),r),shift);
+  v[2] = sra4(add4(add4(p2,b3),r),shift);
+  v[3] = sra4(add4(sub4(p3,b4),r),shift);
+  v[4] = sra4(add4(add4(p3,b4),r),shift);
+  v[5] = sra4(add4(sub4(p2,b3),r),shift);
+  v[6] = sra4(add4(sub4(p1,b2),r),shift);
+  v[7] = sra4(add4(sub4(p0,b0),r),shift);
+  }
+#endif
+
+void Dsp::Scalar::idct(int32_t* block) {
+  int temp[64] = {};
+  for(int i=0; i<8; i++) {
+    const int32_t* src = block+i;
+    if((src[8]|src[16]|src[24]|src[32]|src[40]|src[48]|src[56])==0) {
+      for(int r=0; r<8; ++r)
+        temp[i+r*8] = src[0];
+      } else {
+      idctCol(&temp[i], src);
+      }
+    }
+  for(int i=0; i<8; i++)
+    idctRow(&block[i*8], &temp[8*i]);
+  }
+
+void Dsp::Scalar::addBlock(uint8_t* dst, const uint8_t* prev, const int32_t* block) {
+  for(int i=0; i<64; ++i)
+    dst[i] = uint8_t(prev[i]+block[i]);
+  }
+
+void Dsp::Scalar::addBlock(uint8_t* dst, const uint8_t* prev, const int16_t* block) {
+  for(int i=0; i<64; ++i)
+    dst[i] = uint8_t(prev[i]+block[i]);
+  }
+
+void Dsp::Scalar::putBlock(uint8_t* dst, const int32_t* block) {
+  for(int i=0; i<64; ++i)
+    dst[i] = uint8_t(block[i]);
+  }
+
+void Dsp::Scalar::fftPass(Video::FFTComplex* z, const float* wre, unsigned int n) {
+  int o1 = 2*n;
+  int o2 = 4*n;
+  int o3 = 6*n;
+  const float *wim = wre+o1;
+  n--;
+
+  float t1, t2, t3, t4, t5, t6;
+  transformZero(z[0],z[o1],z[o2],z[o3], t1,t2,t3,t4,t5,t6);
+  transform(z[1],z[o1+1],z[o2+1],z[o3+1],wre[1],wim[-1], t1,t2,t3,t4,t5,t6);
+  for(; n>0; --n) {
+    z += 2;
+    wre += 2;
+    wim -= 2;
+    transform(z[0],z[o1],z[o2],z[o3],wre[0],wim[0], t1,t2,t3,t4,t5,t6);
+    transform(z[1],z[o1+1],z[o2+1],z[o3+1],wre[1],wim[-1], t1,t2,t3,t4,t5,t6);
+    }
+  }
+
+void Dsp::idct(int32_t* block) {
+#if defined(BINK_SIMD_SSE) || defined(BINK_SIMD_NEON)
+  i4 lo[8], hi[8];
+  for(int i=0; i<8; ++i) {
+    lo[i] = load4(block+i*8);
+    hi[i] = load4(block+i*8+4);
+    }
+  idctTransform4(lo,0,0);
+  idctTransform4(hi,0,0);
+
+  for(int half=0; half<8; half+=4) {
+    // rows 'half'..'half+3' become columns of 'v'
+    i4 v[8] = {lo[half],lo[half+1],lo[half+2],lo[half+3],hi[half],hi[half+1],hi[half+2],hi[half+3]};
+    transpose4(v[0],v[1],v[2],v[3]);
+    transpose4(v[4],v[5],v[6],v[7]);
+    idctTransform4(v,0x7F,8);
+    transpose4(v[0],v[1],v[2],v[3]);
+    transpose4(v[4],v[5],v[6],v[7]);
+    for(int i=0; i<4; ++i) {
+      store4(block+(half+i)*8,   v[i]);
+      store4(block+(half+i)*8+4, v[i+4]);
+      }
+    }
+#else
+  Scalar::idct(block);
+#endif
+  }
+
+void Dsp::addBlock(uint8_t* dst, const uint8_t* prev, const int32_t* block) {
+#if defined(BINK_SIMD_SSE)
+  const __m128i mask = _mm_set1_epi16(0xFF);
+  const __m128i zero = _mm_setzero_si128();
+  for(int i=0; i<64; i+=8) {
+    // only low byte of sum is stored, so block can be truncated to 8 bits first
+    const __m128i b0 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block+i)),  _mm_set1_epi32(0xFF));
+    const __m128i b1 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block+i+4)),_mm_set1_epi32(0xFF));
+    const __m128i p  = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(prev+i)),zero);
+    const __m128i s  = _mm_and_si128(_mm_add_epi16(p,_mm_packs_epi32(b0,b1)),mask);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst+i),_mm_packus_epi16(s,zero));
+    }
+#elif defined(BINK_SIMD_NEON)
+  for(int i=0; i<64; i+=8) {
+    const int16x8_t b = vcombine_s16(vmovn_s32(vld1q_s32(block+i)),vmovn_s32(vld1q_s32(block+i+4)));
+    vst1_u8(dst+i,vadd_u8(vld1_u8(prev+i),vmovn_u16(vreinterpretq_u16_s16(b))));
+    }
+#else
+  Scalar::addBlock(dst,prev,block);
+#endif
+  }
+
+void Dsp::addBlock(uint8_t* dst, const uint8_t* prev, const int16_t* block) {
+#if defined(BINK_SIMD_SSE)
+  const __m128i mask = _mm_set1_epi16(0xFF);
+  const __m128i zero = _mm_setzero_si128();
+  for(int i=0; i<64; i+=8) {
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block+i));
+    const __m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(prev+i)),zero);
+    const __m128i s = _mm_and_si128(_mm_add_epi16(p,b),mask);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst+i),_mm_packus_epi16(s,zero));
+    }
+#elif defined(BINK_SIMD_NEON)
+  for(int i=0; i<64; i+=8) {
+    const uint8x8_t b = vmovn_u16(vreinterpretq_u16_s16(vld1q_s16(block+i)));
+    vst1_u8(dst+i,vadd_u8(vld1_u8(prev+i),b));
+    }
+#else
+  Scalar::addBlock(dst,prev,block);
+#endif
+  }
+
+void Dsp::putBlock(uint8_t* dst, const int32_t* block) {
+#if defined(BINK_SIMD_SSE)
+  const __m128i mask = _mm_set1_epi32(0xFF);
+  for(int i=0; i<64; i+=16) {
+    __m128i v[4];
+    for(int r=0; r<4; ++r)
+      v[r] = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block+i+r*4)),mask);
+    const __m128i w = _mm_packus_epi16(_mm_packs_epi32(v[0],v[1]),_mm_packs_epi32(v[2],v[3]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+i),w);
+    }
+#elif defined(BINK_SIMD_NEON)
+  for(int i=0; i<64; i+=8) {
+    const int16x8_t v = vcombine_s16(vmovn_s32(vld1q_s32(block+i)),vmovn_s32(vld1q_s32(block+i+4)));
+    vst1_u8(dst+i,vmovn_u16(vreinterpretq_u16_s16(v)));
+    }
+#else
+  Scalar::putBlock(dst,block);
+#endif
+  }
+
+#if defined(BINK_SIMD_SSE) || defined(BINK_SIMD_NEON)
+// transform() for z[0..3] at once, with weights wre[0..3] and wim[0],wim[-1],wim[-2],wim[-3];
+// operations are done in the same order as in scalar code, so results are bit-exact
+static void transform4(Video::FFTComplex* z, int o1, int o2, int o3, const float* wre, const float* wim) {
+  f4 a0re, a0im, a1re, a1im, a2re, a2im, a3re, a3im;
+  loadComplex4(z,    a0re, a0im);
+  loadComplex4(z+o1, a1re, a1im);
+  loadComplex4(z+o2, a2re, a2im);
+  loadComplex4(z+o3, a3re, a3im);
+
+  const f4 wr  = loadf(wre);
+  const f4 wi  = loadr(wim-3);
+  const f4 nwi = negf(wi);
+
+  f4 t1 = subf(mulf(a2re,wr),mulf(a2im,nwi));
+  f4 t2 = addf(mulf(a2re,nwi),mulf(a2im,wr));
+  f4 t5 = subf(mulf(a3re,wr),mulf(a3im,wi));
+  f4 t6 = addf(mulf(a3re,wi),mulf(a3im,wr));
+
+  const f4 t3 = subf(t5,t1);
+  t5   = addf(t5,t1);
+  a2re = subf(a0re,t5);
+  a0re = addf(a0re,t5);
+  a3im = subf(a1im,t3);
+  a1im = addf(a1im,t3);
+  const f4 t4 = subf(t2,t6);
+  t6   = addf(t2,t6);
+  a3re = subf(a1re,t4);
+  a1re = addf(a1re,t4);
+  a2im = subf(a0im,t6);
+  a0im = addf(a0im,t6);
+
+  storeComplex4(z,    a0re, a0im);
+  storeComplex4(z+o1, a1re, a1im);
+  storeComplex4(z+o2, a2re, a2im);
+  storeComplex4(z+o3, a3re, a3im);
+  }
+#endif
+
+void Dsp::fftPass(Video::FFTComplex* z, const float* wre, unsigned int n) {
+#if defined(BINK_SIMD_SSE) || defined(BINK_SIMD_NEON)
+  int o1 = 2*n;
+  int o2 = 4*n;
+  int o3 = 6*n;
+  const float *wim = wre+o1;
+  n--;
+
+  float t1, t2, t3, t4, t5, t6;
+  transformZero(z[0],z[o1],z[o2],z[o3], t1,t2,t3,t4,t5,t6);
+  transform(z[1],z[o1+1],z[o2+1],z[o3+1],wre[1],wim[-1], t1,t2,t3,t4,t5,t6);
+  // two steps of the loop below at once
+  for(; n>=2; n-=2) {
+    transform4(z+2,o1,o2,o3,wre+2,wim-2);
+    z   += 4;
+    wre += 4;
+    wim -= 4;
+    }
+  for(; n>0; --n) {
+    z += 2;
+    wre += 2;
+    wim -= 2;
+    transform(z[0],z[o1],z[o2],z[o3],wre[0],wim[0], t1,t2,t3,t4,t5,t6);
+    transform(z[1],z[o1+1],z[o2+1],z[o3+1],wre[1],wim[-1], t1,t2,t3,t4,t5,t6);
+    }
+#else
+  Scalar::fftPass(z,wre,n);
+#endif
+  }
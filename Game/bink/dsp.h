@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#include "video.h"
+
+namespace Bink {
+
+// Inner kernels of the decoder. Default versions are vectorised, when compiled for SSE2 or NEON,
+// Scalar:: versions are plain c++ and serve as reference: both give same results.
+namespace Dsp {
+  // in-place 8x8 inverse DCT; output is not clamped, callers keep low 8 bits
+  void idct    (int32_t* block);
+  // dst = uint8_t(prev + block), block values are added with wrap-around
+  void addBlock(uint8_t* dst, const uint8_t* prev, const int32_t* block);
+  void addBlock(uint8_t* dst, const uint8_t* prev, const int16_t* block);
+  // dst = uint8_t(block)
+  void putBlock(uint8_t* dst, const int32_t* block);
+  // radix-4 pass of split-radix fft over 8*n complex values
+  void fftPass (Video::FFTComplex* z, const float* wre, unsigned int n);
+
+  namespace Scalar {
+    void idct    (int32_t* block);
+    void addBlock(uint8_t* dst, const uint8_t* prev, const int32_t* block);
+    void addBlock(uint8_t* dst, const uint8_t* prev, const int16_t* block);
+    void putBlock(uint8_t* dst, const int32_t* block);
+    void fftPass (Video::FFTComplex* z, const float* wre, unsigned int n);
+    }
+
+  template<class T>
+  inline void BF(T& x, T& y, const T& a, const T& b) {
+    x = a-b;
+    y = a+b;
+    }
+
+  template<class T>
+  inline void CMUL(T& dre, T& dim, const T& are, const T& aim, const T& bre, const T& bim) {
+    dre = are*bre - aim*bim;
+    dim = are*bim + aim*bre;
+    }
+
+  inline void BUTTERFLIES(Video::FFTComplex& a0, Video::FFTComplex& a1, Video::FFTComplex& a2, Video::FFTComplex& a3,
+                          float& t1, float& t2, float& t3, float& t4, float& t5, float& t6) {
+    BF(t3, t5, t5, t1);
+    BF(a2.re, a0.re, a0.re, t5);
+    BF(a3.im, a1.im, a1.im, t3);
+    BF(t4, t6, t2, t6);
+    BF(a3.re, a1.re, a1.re, t4);
+    BF(a2.im, a0.im, a0.im, t6);
+    }
+
+  inline void transform(Video::FFTComplex& a0, Video::FFTComplex& a1, Video::FFTComplex& a2, Video::FFTComplex& a3, const float wre, const float wim,
+                        float& t1, float& t2, float& t3, float& t4, float& t5, float& t6) {
+    CMUL(t1, t2, a2.re, a2.im, wre, -wim);
+    CMUL(t5, t6, a3.re, a3.im, wre,  wim);
+    BUTTERFLIES(a0,a1,a2,a3, t1,t2,t3,t4,t5,t6);
+    }
+
+  inline void transformZero(Video::FFTComplex& a0, Video::FFTComplex& a1, Video::FFTComplex& a2, Video::FFTComplex& a3,
+                            float& t1, float& t2, float& t3, float& t4, float& t5, float& t6) {
+    t1 = a2.re;
+    t2 = a2.im;
+    t5 = a3.re;
+    t6 = a3.im;
+    BUTTERFLIES(a0,a1,a2,a3, t1,t2,t3,t4,t5,t6);
+    }
+  }
+
+}
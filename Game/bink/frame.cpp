@@ -3,6 +3,11 @@
 #include <algorithm>
 #include <cstring>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define BINK_SIMD_SSE 1
+#endif
+
 using namespace Bink;
 
 void Frame::Plane::setSize(uint32_t iw, uint32_t ih) {
@@ -16,13 +21,14 @@ void Frame::Plane::setSize(uint32_t iw, uint32_t ih) {
   }
 
 void Frame::Plane::getPixels8x8(uint32_t rx, uint32_t ry, uint8_t* out) const {
-  const uint8_t* d = dat.data();
+  const uint8_t* d = dat.data() + rx + ry*stride;
+  for(uint32_t y=0; y<8; ++y)
+    std::memcpy(out+y*8, d+y*stride, 8);
+  }
 
-  for(uint32_t y=0; y<8; ++y) {
-    for(uint32_t x=0; x<8; ++x) {
-      out[x+y*8] = d[(x+rx) + (y+ry)*stride];
-      }
-    }
+bool Frame::Plane::hasPixels8x8(int32_t rx, int32_t ry) const {
+  const int64_t at = int64_t(rx) + int64_t(ry)*stride;
+  return at>=0 && at + 7*int64_t(stride) + 8 <= int64_t(dat.size());
   }
 
 void Frame::Plane::getBlock8x8(uint32_t bx, uint32_t by, uint8_t* out) const {
@@ -30,22 +36,26 @@ void Frame::Plane::getBlock8x8(uint32_t bx, uint32_t by, uint8_t* out) const {
   }
 
 void Frame::Plane::putBlock8x8(uint32_t bx, uint32_t by, const uint8_t* in) {
-  uint8_t* d = dat.data();
-
-  for(uint32_t y=0; y<8; ++y) {
-    for(uint32_t x=0; x<8; ++x) {
-      d[(x+bx*8) + (y+by*8)*stride] = in[x+y*8];
-      }
-    }
+  uint8_t* d = dat.data() + bx*8 + by*8*stride;
+  for(uint32_t y=0; y<8; ++y)
+    std::memcpy(d+y*stride, in+y*8, 8);
   }
 
 void Frame::Plane::putScaledBlock(uint32_t bx, uint32_t by, const uint8_t* in) {
-  uint8_t* d = dat.data();
-  for(uint32_t y=0; y<16; ++y) {
-    uint32_t y2 = y/2;
-    for(uint32_t x=0; x<16; ++x) {
-      d[(x+bx*8) + (y+by*8)*stride] = in[(x/2)+y2*8];
-      }
+  uint8_t* d = dat.data() + bx*8 + by*8*stride;
+  for(uint32_t y=0; y<8; ++y) {
+    uint8_t* row0 = d + (y*2  )*stride;
+    uint8_t* row1 = d + (y*2+1)*stride;
+#if defined(BINK_SIMD_SSE)
+    __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in+y*8));
+    v = _mm_unpacklo_epi8(v,v);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(row0),v);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(row1),v);
+#else
+    for(uint32_t x=0; x<16; ++x)
+      row0[x] = in[x/2 + y*8];
+    std::memcpy(row1,row0,16);
+#endif
     }
   }
 
@@ -73,6 +83,91 @@ void Frame::setSize(uint32_t w, uint32_t h) {
   planes[3].setSize(w,h);
   }
 
+// fixed point, 6 fractional bits:
+// R = 1.164*(Y-16) + 1.596*(V-128)
+// G = 1.164*(Y-16) - 0.391*(U-128) - 0.813*(V-128)
+// B = 1.164*(Y-16) + 2.018*(U-128)
+enum : int32_t {
+  YuvY  = 74,
+  YuvRV = 102,
+  YuvGU = 25,
+  YuvGV = 52,
+  YuvBU = 129,
+  };
+
+static uint8_t clampU8(int32_t v) {
+  return uint8_t(std::max(0,std::min(v,255)));
+  }
+
+static void yuvToRgbaRow(const uint8_t* py, const uint8_t* pu, const uint8_t* pv, uint8_t* dst,
+                         uint32_t begin, uint32_t end) {
+  for(uint32_t x=begin; x<end; ++x) {
+    const int32_t y = (int32_t(py[x])-16)*YuvY + 32;
+    const int32_t u = int32_t(pu[x/2])-128;
+    const int32_t v = int32_t(pv[x/2])-128;
+
+    uint8_t* rgb = dst+x*4;
+    rgb[0] = clampU8((y + YuvRV*v)>>6);
+    rgb[1] = clampU8((y - YuvGU*u - YuvGV*v)>>6);
+    rgb[2] = clampU8((y + YuvBU*u)>>6);
+    rgb[3] = 255;
+    }
+  }
+
+void Frame::toRgba(uint8_t* dst) const {
+  const uint32_t w = planes[0].w;
+  const uint32_t h = planes[0].h;
+
+  for(uint32_t y=0; y<h; ++y) {
+    const uint8_t* py  = planes[0].dat.data() + y*planes[0].stride;
+    const uint8_t* pu  = planes[1].dat.data() + (y/2)*planes[1].stride;
+    const uint8_t* pv  = planes[2].dat.data() + (y/2)*planes[2].stride;
+    uint8_t*       out = dst + size_t(y)*w*4;
+    uint32_t       x   = 0;
+#if defined(BINK_SIMD_SSE)
+    // 8 pixels per step, 16-bit lanes: every product fits into int16;
+    // only sum for blue can exceed it, saturation clamps the same way as packus would
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c16  = _mm_set1_epi16(16);
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i rnd  = _mm_set1_epi16(32);
+    const __m128i alf  = _mm_set1_epi8(char(0xFF));
+    for(; x+8<=w; x+=8) {
+      int32_t u4 = 0, v4 = 0;
+      std::memcpy(&u4,pu+x/2,4);
+      std::memcpy(&v4,pv+x/2,4);
+
+      __m128i yy = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(py+x)),zero);
+      __m128i uu = _mm_cvtsi32_si128(u4);
+      __m128i vv = _mm_cvtsi32_si128(v4);
+      uu = _mm_unpacklo_epi8(_mm_unpacklo_epi8(uu,uu),zero);
+      vv = _mm_unpacklo_epi8(_mm_unpacklo_epi8(vv,vv),zero);
+
+      yy = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(yy,c16),_mm_set1_epi16(YuvY)),rnd);
+      uu = _mm_sub_epi16(uu,c128);
+      vv = _mm_sub_epi16(vv,c128);
+
+      __m128i r = _mm_adds_epi16(yy,_mm_mullo_epi16(vv,_mm_set1_epi16(YuvRV)));
+      __m128i g = _mm_subs_epi16(_mm_subs_epi16(yy,_mm_mullo_epi16(uu,_mm_set1_epi16(YuvGU))),
+                                 _mm_mullo_epi16(vv,_mm_set1_epi16(YuvGV)));
+      __m128i b = _mm_adds_epi16(yy,_mm_mullo_epi16(uu,_mm_set1_epi16(YuvBU)));
+      r = _mm_srai_epi16(r,6);
+      g = _mm_srai_epi16(g,6);
+      b = _mm_srai_epi16(b,6);
+
+      const __m128i r8 = _mm_packus_epi16(r,zero);
+      const __m128i g8 = _mm_packus_epi16(g,zero);
+      const __m128i b8 = _mm_packus_epi16(b,zero);
+      const __m128i rg = _mm_unpacklo_epi8(r8,g8);
+      const __m128i ba = _mm_unpacklo_epi8(b8,alf);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out+x*4),   _mm_unpacklo_epi16(rg,ba));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out+x*4+16),_mm_unpackhi_epi16(rg,ba));
+      }
+#endif
+    yuvToRgbaRow(py,pu,pv,out,x,w);
+    }
+  }
+
 void Frame::setAudioChannels(uint8_t count) {
   aud.resize(count);
   }
@@ -16,6 +16,8 @@ class Frame final {
     class Plane final {
       public:
         void getPixels8x8  (uint32_t rx, uint32_t ry, uint8_t* out) const;
+        // motion vectors are not trusted: block at rx,ry must be inside of plane memory
+        bool hasPixels8x8  (int32_t rx, int32_t ry) const;
 
         void getBlock8x8   (uint32_t x, uint32_t y, uint8_t* out) const;
         void putBlock8x8   (uint32_t x, uint32_t y, const uint8_t* in);
@@ -49,6 +51,10 @@ class Frame final {
     const Audio& audio(uint8_t id) const;
     size_t       audioCount()      const { return aud.size(); }
 
+    // converts Y/U/V planes (BT.601, limited range) to RGBA8; alpha is opaque
+    // dst is width()*height()*4 bytes, rows are tightly packed
+    void         toRgba(uint8_t* dst) const;
+
   private:
     Plane              planes[4];
     std::vector<Audio> aud;
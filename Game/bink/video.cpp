@@ -6,6 +6,12 @@
 #include <cstring>
 #include <algorithm>
 #include <limits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "dsp.h"
 
 using namespace Bink;
 
@@ -571,146 +577,26 @@ static int av_log2(unsigned v) {
   return int(std::log2(v));
   }
 
-template<class T>
-static void idctTransform(T* dest, const int* src,
-                          int s0, int s1, int s2, int s3, int s4, int s5, int s6, int s7,
-                          int d0, int d1, int d2, int d3, int d4, int d5, int d6, int d7,
-                          T (*munge)(int)) {
-  enum {
-    A1 = 2896, /* (1/sqrt(2))<<12 */
-    A2 = 2217,
-    A3 = 3784,
-    A4 = -5352
-    };
-  static int (*mul)(int,int) = [](int x,int y) -> int { return int(uint32_t(x)*uint32_t(y)) >> 11; };
-
-  const int a0 = (src)[s0] + (src)[s4];
-  const int a1 = (src)[s0] - (src)[s4];
-  const int a2 = (src)[s2] + (src)[s6];
-  const int a3 = mul(A1, (src)[s2] - (src)[s6]);
-  const int a4 = (src)[s5] + (src)[s3];
-  const int a5 = (src)[s5] - (src)[s3];
-  const int a6 = (src)[s1] + (src)[s7];
-  const int a7 = (src)[s1] - (src)[s7];
-  const int b0 = a4 + a6;
-  const int b1 = mul(A3, a5 + a7);
-  const int b2 = mul(A4, a5) - b0 + b1;
-  const int b3 = mul(A1, a6 - a4) - b2;
-  const int b4 = mul(A2, a7) + b3 - b1;
-  dest[d0] = munge(a0+a2   +b0);
-  dest[d1] = munge(a1+a3-a2+b2);
-  dest[d2] = munge(a1-a3+a2+b3);
-  dest[d3] = munge(a0-a2   -b4);
-  dest[d4] = munge(a0-a2   +b4);
-  dest[d5] = munge(a1-a3+a2-b3);
-  dest[d6] = munge(a1+a3-a2-b2);
-  dest[d7] = munge(a0+a2   -b0);
-  }
-
-template<class T>
-static void idctCol(T* dest, const int* src) {
-  static T (*munge)(int) = [](int x) -> T { return T(x); };
-  idctTransform(dest,src,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,munge);
-  }
-
-template<class T>
-static void idctRow(T* dest, const int* src) {
-  static T (*munge)(int) = [](int x) -> T { return T((x + 0x7F)>>8); };
-  idctTransform(dest,src,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,munge);
-  }
-
-static void bink_idct_col(int *dest, const int32_t *src) {
-  if((src[8]|src[16]|src[24]|src[32]|src[40]|src[48]|src[56])==0) {
-    dest[0]  =
-        dest[8]  =
-        dest[16] =
-        dest[24] =
-        dest[32] =
-        dest[40] =
-        dest[48] =
-        dest[56] = src[0];
-    } else {
-    idctCol(dest, src);
-    }
-  }
-
-template<class T>
-static void BF(T& x, T& y, const T& a, const T& b) {
-  x = a-b;
-  y = a+b;
-  }
-
-template<class T>
-static void CMUL(T& dre, T& dim, const T& are, const T& aim, const T& bre, const T& bim) {
-  dre = are*bre - aim*bim;
-  dim = are*bim + aim*bre;
-  }
-
-static void BUTTERFLIES(Video::FFTComplex& a0, Video::FFTComplex& a1, Video::FFTComplex& a2, Video::FFTComplex& a3,
-                        float& t1, float& t2, float& t3, float& t4, float& t5, float& t6) {
-  BF(t3, t5, t5, t1);
-  BF(a2.re, a0.re, a0.re, t5);
-  BF(a3.im, a1.im, a1.im, t3);
-  BF(t4, t6, t2, t6);
-  BF(a3.re, a1.re, a1.re, t4);
-  BF(a2.im, a0.im, a0.im, t6);
-  }
-
-static void transform(Video::FFTComplex& a0, Video::FFTComplex& a1, Video::FFTComplex& a2, Video::FFTComplex& a3, const float wre, const float wim,
-                      float& t1, float& t2, float& t3, float& t4, float& t5, float& t6) {
-  CMUL(t1, t2, a2.re, a2.im, wre, -wim);
-  CMUL(t5, t6, a3.re, a3.im, wre,  wim);
-  BUTTERFLIES(a0,a1,a2,a3, t1,t2,t3,t4,t5,t6);
-  }
-
-static void transformZero(Video::FFTComplex& a0, Video::FFTComplex& a1, Video::FFTComplex& a2, Video::FFTComplex& a3,
-                          float& t1, float& t2, float& t3, float& t4, float& t5, float& t6) {
-  t1 = a2.re;
-  t2 = a2.im;
-  t5 = a3.re;
-  t6 = a3.im;
-  BUTTERFLIES(a0,a1,a2,a3, t1,t2,t3,t4,t5,t6);
-  }
-
-static void fftPass(Video::FFTComplex *z, const float *wre, unsigned int n) {
-  int o1 = 2*n;
-  int o2 = 4*n;
-  int o3 = 6*n;
-  const float *wim = wre+o1;
-  n--;
-
-  float t1, t2, t3, t4, t5, t6;
-  transformZero(z[0],z[o1],z[o2],z[o3], t1,t2,t3,t4,t5,t6);
-  transform(z[1],z[o1+1],z[o2+1],z[o3+1],wre[1],wim[-1], t1,t2,t3,t4,t5,t6);
-  do {
-    z += 2;
-    wre += 2;
-    wim -= 2;
-    transform(z[0],z[o1],z[o2],z[o3],wre[0],wim[0], t1,t2,t3,t4,t5,t6);
-    transform(z[1],z[o1+1],z[o2+1],z[o3+1],wre[1],wim[-1], t1,t2,t3,t4,t5,t6);
-    } while(--n);
-  }
-
 template<int n, int ord>
 static void fft(Video::FFTComplex *z) {
   fft<n/2,ord-1>(z);
   fft<n/4,ord-2>(z+(n/4)*2);
   fft<n/4,ord-2>(z+(n/4)*3);
-  fftPass(z,ffCosTabs[ord].data(),(n/4)/2);
+  Dsp::fftPass(z,ffCosTabs[ord].data(),(n/4)/2);
   }
 
 template<>
 void fft<4,2>(Video::FFTComplex *z) {
   float t1, t2, t3, t4, t5, t6, t7, t8;
 
-  BF(t3, t1, z[0].re, z[1].re);
-  BF(t8, t6, z[3].re, z[2].re);
-  BF(z[2].re, z[0].re, t1, t6);
-  BF(t4, t2, z[0].im, z[1].im);
-  BF(t7, t5, z[2].im, z[3].im);
-  BF(z[3].im, z[1].im, t4, t8);
-  BF(z[3].re, z[1].re, t3, t7);
-  BF(z[2].im, z[0].im, t2, t5);
+  Dsp::BF(t3, t1, z[0].re, z[1].re);
+  Dsp::BF(t8, t6, z[3].re, z[2].re);
+  Dsp::BF(z[2].re, z[0].re, t1, t6);
+  Dsp::BF(t4, t2, z[0].im, z[1].im);
+  Dsp::BF(t7, t5, z[2].im, z[3].im);
+  Dsp::BF(z[3].im, z[1].im, t4, t8);
+  Dsp::BF(z[3].re, z[1].re, t3, t7);
+  Dsp::BF(z[2].im, z[0].im, t2, t5);
   }
 
 template<>
@@ -718,13 +604,13 @@ void fft<8,3>(Video::FFTComplex *z) {
   fft<4,2>(z);
 
   float t1, t2, t3, t4, t5, t6;
-  BF(t1, z[5].re, z[4].re, -z[5].re);
-  BF(t2, z[5].im, z[4].im, -z[5].im);
-  BF(t5, z[7].re, z[6].re, -z[7].re);
-  BF(t6, z[7].im, z[6].im, -z[7].im);
+  Dsp::BF(t1, z[5].re, z[4].re, -z[5].re);
+  Dsp::BF(t2, z[5].im, z[4].im, -z[5].im);
+  Dsp::BF(t5, z[7].re, z[6].re, -z[7].re);
+  Dsp::BF(t6, z[7].im, z[6].im, -z[7].im);
 
-  BUTTERFLIES(z[0],z[2],z[4],z[6], t1,t2,t3,t4,t5,t6);
-  transform  (z[1],z[3],z[5],z[7],sqrthalf,sqrthalf, t1,t2,t3,t4,t5,t6);
+  Dsp::BUTTERFLIES(z[0],z[2],z[4],z[6], t1,t2,t3,t4,t5,t6);
+  Dsp::transform  (z[1],z[3],z[5],z[7],sqrthalf,sqrthalf, t1,t2,t3,t4,t5,t6);
   }
 
 template<>
@@ -737,10 +623,10 @@ void fft<16,4>(Video::FFTComplex *z) {
   fft<4,2>(z+12);
 
   float t1, t2, t3, t4, t5, t6;
-  transformZero(z[0],z[4],z[8],z[12], t1,t2,t3,t4,t5,t6);
-  transform    (z[2],z[6],z[10],z[14], sqrthalf,sqrthalf, t1,t2,t3,t4,t5,t6);
-  transform    (z[1],z[5],z[9],z[13],  cos_16_1,cos_16_3, t1,t2,t3,t4,t5,t6);
-  transform    (z[3],z[7],z[11],z[15], cos_16_3,cos_16_1, t1,t2,t3,t4,t5,t6);
+  Dsp::transformZero(z[0],z[4],z[8],z[12], t1,t2,t3,t4,t5,t6);
+  Dsp::transform    (z[2],z[6],z[10],z[14], sqrthalf,sqrthalf, t1,t2,t3,t4,t5,t6);
+  Dsp::transform    (z[1],z[5],z[9],z[13],  cos_16_1,cos_16_3, t1,t2,t3,t4,t5,t6);
+  Dsp::transform    (z[3],z[7],z[11],z[15], cos_16_3,cos_16_1, t1,t2,t3,t4,t5,t6);
   }
 
 struct Video::BitStream {
@@ -816,11 +702,96 @@ struct Video::BitStream {
   size_t         byteCount = 0;
   };
 
+// Persistent workers for concurrent parts of a frame: one per kind of job, so no thread is spawned per frame.
+// Threads are started on first use.
+class Video::DecodePool final {
+  public:
+    enum Job : uint8_t {
+      JOB_AUDIO = 0,
+      JOB_ALPHA,
+      JOB_CHROMA,
+      JOB_COUNT
+      };
+
+    DecodePool() = default;
+    DecodePool(const DecodePool&) = delete;
+    ~DecodePool() {
+      {
+      std::lock_guard<std::mutex> guard(sync);
+      exit = true;
+      }
+      wake.notify_all();
+      for(auto& w:workers)
+        if(w.th.joinable())
+          w.th.join();
+      }
+
+    void run(Job id, std::function<void()> fn) {
+      auto& w = workers[id];
+      {
+      std::lock_guard<std::mutex> guard(sync);
+      w.fn   = std::move(fn);
+      w.busy = true;
+      }
+      if(!w.th.joinable())
+        w.th = std::thread([this,&w](){ loop(w); });
+      wake.notify_all();
+      }
+
+    // rethrows exception of the job
+    void wait(Job id) {
+      auto& w = workers[id];
+      std::unique_lock<std::mutex> guard(sync);
+      done.wait(guard,[&w](){ return !w.busy; });
+      auto err = w.err;
+      w.err = nullptr;
+      guard.unlock();
+      if(err)
+        std::rethrow_exception(err);
+      }
+
+  private:
+    struct Worker {
+      std::thread           th;
+      std::function<void()> fn;
+      std::exception_ptr    err;
+      bool                  busy = false;
+      };
+
+    void loop(Worker& w) {
+      std::unique_lock<std::mutex> guard(sync);
+      while(true) {
+        wake.wait(guard,[this,&w](){ return exit || w.fn; });
+        if(exit)
+          return;
+        auto fn = std::move(w.fn);
+        w.fn = nullptr;
+        guard.unlock();
+        std::exception_ptr err;
+        try {
+          fn();
+          }
+        catch(...) {
+          err = std::current_exception();
+          }
+        guard.lock();
+        w.err  = err;
+        w.busy = false;
+        done.notify_all();
+        }
+      }
+
+    std::mutex              sync;
+    std::condition_variable wake, done;
+    bool                    exit = false;
+    Worker                  workers[JOB_COUNT];
+  };
+
 Video::AudioCtx::AudioCtx(uint16_t sampleRate, uint8_t channels, bool isDct)
   :sampleRate(sampleRate), channelsCnt(channels), isDct(isDct) {
   }
 
-Video::Video(Input* file) : fin(file) {
+Video::Video(Input* file) : fin(file), pool(new DecodePool()) {
   packet.reserve(4*1024*1024);
 
   uint32_t codec = rl32();
@@ -957,6 +928,7 @@ void Video::readPacket() {
   fin->seek(id.pos+smush_size);
 
   uint32_t videoSize = id.size;
+  bool     hasAudio  = false;
   for(size_t i=0; i<aud.size(); ++i) {
     uint32_t audioSize = rl32();
     if(audioSize+4 > videoSize) {
@@ -964,12 +936,14 @@ void Video::readPacket() {
       std::snprintf(buf,sizeof(buf),"audio size in header (%u) > size of packet left (%u)", audioSize, videoSize);
       throw std::runtime_error(buf);
       }
+    auto& packet = aud[i].packet;
     if(audioSize >= 4) { // This doesn't look good
       packet.resize(audioSize);
       fin->read(packet.data(),packet.size());
-      parseAudio(packet,i);
+      hasAudio = true;
       } else {
       fin->skip(audioSize);
+      packet.clear();
       frames[frameCounter%2].aud[i].samples.clear();
       }
     videoSize -= (audioSize+4);
@@ -977,7 +951,35 @@ void Video::readPacket() {
 
   packet.resize(videoSize);
   fin->read(packet.data(),packet.size());
-  parseFrame(packet);
+
+  // audio and video state are independent, so audio is decoded next to video
+  if(hasAudio) {
+    pool->run(DecodePool::JOB_AUDIO,[this]() {
+      for(size_t i=0; i<aud.size(); ++i)
+        if(!aud[i].packet.empty())
+          parseAudio(i);
+      });
+    }
+
+  std::exception_ptr err;
+  try {
+    parseFrame(packet);
+    }
+  catch(...) {
+    err = std::current_exception();
+    }
+  if(hasAudio) {
+    // audio job must be finished in any case: it works on members of this
+    try {
+      pool->wait(DecodePool::JOB_AUDIO);
+      }
+    catch(...) {
+      if(err==nullptr)
+        err = std::current_exception();
+      }
+    }
+  if(err!=nullptr)
+    std::rethrow_exception(err);
   }
 
 void Video::merge(BitStream& gb, uint8_t *dst, uint8_t *src, int size) {
@@ -1064,12 +1066,17 @@ void Video::decodeInit() {
   for(auto& i:frames)
     i.setSize(width,height);
 
-  const int bw     = (width  + 7) >> 3;
-  const int bh     = (height + 7) >> 3;
-  const int blocks = bw * bh;
-  for(auto& b:bundle) {
-    b.data.resize(blocks * 64);
-    b.data_end = b.data.data() + blocks * 64;
+  for(int i=0; i<4; ++i) {
+    if(i==3 && (flags&BINK_FLAG_ALPHA)!=BINK_FLAG_ALPHA)
+      continue;
+    const bool chroma = (i==1 || i==2);
+    const int  bw     = chroma ? (width  + 15) >> 4 : (width  + 7) >> 3;
+    const int  bh     = chroma ? (height + 15) >> 4 : (height + 7) >> 3;
+    const int  blocks = bw * bh;
+    for(auto& b:planeCtx[i].bundle) {
+      b.data.resize(size_t(blocks) * 64);
+      b.data_end = b.data.data() + blocks * 64;
+      }
     }
 
 /*
@@ -1117,22 +1124,94 @@ uint8_t Video::getHuff(BitStream& gb, const Tree& tree) {
   return tree.syms[vlc];
   }
 
-void Video::initLengths(int width, int bw) {
+void Video::initLengths(PlaneCtx& ctx, int width, int bw) {
   width = ((width+7)/8)*8;
 
-  bundle[BINK_SRC_BLOCK_TYPES].len     = av_log2((width >> 3) + 511) + 1;
-  bundle[BINK_SRC_SUB_BLOCK_TYPES].len = av_log2((width >> 4) + 511) + 1;
-  bundle[BINK_SRC_COLORS].len          = av_log2(bw*64 + 511) + 1;
-  bundle[BINK_SRC_INTRA_DC].len =
-      bundle[BINK_SRC_INTER_DC].len =
-      bundle[BINK_SRC_X_OFF].len =
-      bundle[BINK_SRC_Y_OFF].len = av_log2((width >> 3) + 511) + 1;
+  ctx.bundle[BINK_SRC_BLOCK_TYPES].len     = av_log2((width >> 3) + 511) + 1;
+  ctx.bundle[BINK_SRC_SUB_BLOCK_TYPES].len = av_log2((width >> 4) + 511) + 1;
+  ctx.bundle[BINK_SRC_COLORS].len          = av_log2(bw*64 + 511) + 1;
+  ctx.bundle[BINK_SRC_INTRA_DC].len =
+      ctx.bundle[BINK_SRC_INTER_DC].len =
+      ctx.bundle[BINK_SRC_X_OFF].len =
+      ctx.bundle[BINK_SRC_Y_OFF].len = av_log2((width >> 3) + 511) + 1;
 
-  bundle[BINK_SRC_PATTERN].len = av_log2((bw << 3) + 511) + 1;
-  bundle[BINK_SRC_RUN].len     = av_log2(bw*48 + 511) + 1;
+  ctx.bundle[BINK_SRC_PATTERN].len = av_log2((bw << 3) + 511) + 1;
+  ctx.bundle[BINK_SRC_RUN].len     = av_log2(bw*48 + 511) + 1;
   }
 
 void Video::parseFrame(const std::vector<uint8_t>& data) {
+  if(revision>='i' && (planeOffsets==OFFSET_ABSOLUTE || planeOffsets==OFFSET_RELATIVE)) {
+    if(parseFrameParallel(data))
+      return;
+    }
+  parseFrameSerial(data);
+  }
+
+bool Video::parseFrameParallel(const std::vector<uint8_t>& data) {
+  // planes are decoded starting from offsets, found in the packet, and each start is checked afterwards:
+  // with a wrong offset, frame is decoded again serially and offsets are not used anymore.
+  // Chroma planes have no offset in between, so U and V are decoded on one thread
+  const bool   hasAlpha   = (flags&BINK_FLAG_ALPHA) == BINK_FLAG_ALPHA;
+  const size_t bits_count = data.size()<<3;
+  const int    planeU     = (revision >= 'h') ? 2 : 1;
+  const int    planeV     = planeU ^ 3;
+
+  const size_t lumaWord   = hasAlpha ? planeOffset(data,0,planeOffsets) : 0;
+  if(lumaWord==size_t(-1))
+    return false;
+  const size_t chromaPos  = planeOffset(data,lumaWord,planeOffsets);
+  if(chromaPos==size_t(-1) || chromaPos>=bits_count)
+    return false;
+
+  size_t alphaEnd = 0;
+  if(hasAlpha) {
+    pool->run(DecodePool::JOB_ALPHA,[this,&data,&alphaEnd,bits_count]() {
+      BitStream gb(data.data(),bits_count);
+      gb.skip(32);
+      decodePlane(gb,3,false);
+      alphaEnd = gb.position();
+      });
+    }
+  pool->run(DecodePool::JOB_CHROMA,[this,&data,bits_count,chromaPos,planeU,planeV]() {
+    BitStream gb(data.data(),bits_count);
+    gb.skip(chromaPos);
+    decodePlane(gb,planeU,true);
+    if(gb.position()<bits_count)
+      decodePlane(gb,planeV,true);
+    });
+
+  bool valid = true;
+  try {
+    BitStream gb(data.data(),bits_count);
+    gb.skip(lumaWord+32);
+    decodePlane(gb,0,false);
+    valid = (gb.position()==chromaPos);
+    }
+  catch(...) {
+    valid = false;
+    }
+  try {
+    if(hasAlpha) {
+      pool->wait(DecodePool::JOB_ALPHA);
+      if(alphaEnd!=lumaWord)
+        valid = false;
+      }
+    }
+  catch(...) {
+    valid = false;
+    }
+  try {
+    pool->wait(DecodePool::JOB_CHROMA);
+    }
+  catch(...) {
+    valid = false;
+    }
+  if(!valid)
+    planeOffsets = OFFSET_NONE;
+  return valid;
+  }
+
+void Video::parseFrameSerial(const std::vector<uint8_t>& data) {
   const bool   swap_planes = (revision >= 'h');
   const size_t bits_count  = data.size()<<3;
 
@@ -1143,9 +1222,11 @@ void Video::parseFrame(const std::vector<uint8_t>& data) {
       gb.skip(32);
     decodePlane(gb,3,false);
     }
+  const size_t lumaWord = gb.position();
   if(revision >= 'i')
     gb.skip(32);
 
+  size_t chromaPos = bits_count;
   for(int plane=0; plane<3; plane++) {
     const int planeId = (!plane || !swap_planes) ? plane : (plane ^ 3);
 
@@ -1156,9 +1237,37 @@ void Video::parseFrame(const std::vector<uint8_t>& data) {
       throw std::runtime_error("not implemented");
       }
 
+    if(plane==0)
+      chromaPos = gb.position();
     if(gb.position()>=bits_count)
       break;
     }
+
+  if(revision>='i' && planeOffsets==OFFSET_UNKNOWN && chromaPos<bits_count) {
+    if(planeOffset(data,lumaWord,OFFSET_ABSOLUTE)==chromaPos)
+      planeOffsets = OFFSET_ABSOLUTE;
+    else if(planeOffset(data,lumaWord,OFFSET_RELATIVE)==chromaPos)
+      planeOffsets = OFFSET_RELATIVE;
+    else
+      planeOffsets = OFFSET_NONE;
+    }
+  }
+
+size_t Video::planeOffset(const std::vector<uint8_t>& data, size_t wordPos, PlaneOffsets mode) const {
+  if((wordPos & 0x1F) || wordPos/8+4>data.size())
+    return size_t(-1);
+
+  uint32_t word = 0;
+  std::memcpy(&word,data.data()+wordPos/8,4);
+
+  size_t pos = size_t(-1);
+  if(mode==OFFSET_ABSOLUTE)
+    pos = size_t(word)*8;
+  else if(mode==OFFSET_RELATIVE)
+    pos = wordPos + 32 + size_t(word)*8;
+  if(pos>(data.size()<<3))
+    return size_t(-1);
+  return pos;
   }
 
 void Video::decodePlane(BitStream& gb, int planeId, bool chroma) {
@@ -1166,6 +1275,7 @@ void Video::decodePlane(BitStream& gb, int planeId, bool chroma) {
   const int bh     = chroma ? (this->height + 15) >> 4 : (this->height + 7) >> 3;
   const int width  = this->width  >> (chroma ? 1 : 0);
 
+  auto& ctx   = planeCtx[planeId];
   auto& plane = frames[frameCounter%2]    .planes[planeId];
   auto& last  = frames[(frameCounter+1)%2].planes[planeId];
 
@@ -1177,24 +1287,24 @@ void Video::decodePlane(BitStream& gb, int planeId, bool chroma) {
     return;
     }
 
-  initLengths(std::max(width,8),bw);
+  initLengths(ctx,std::max(width,8),bw);
   for(int i=0; i<BINK_NB_SRC; i++)
-    readBundle(gb,i);
+    readBundle(ctx,gb,i);
 
   uint8_t dst[8*8] = {};
   for(int by = 0; by < bh; by++) {
-    readBlockTypes  (gb,bundle[BINK_SRC_BLOCK_TYPES]);
-    readBlockTypes  (gb,bundle[BINK_SRC_SUB_BLOCK_TYPES]);
-    readColors      (gb,bundle[BINK_SRC_COLORS]);
-    readPatterns    (gb,bundle[BINK_SRC_PATTERN]);
-    readMotionValues(gb,bundle[BINK_SRC_X_OFF]);
-    readMotionValues(gb,bundle[BINK_SRC_Y_OFF]);
-    readDcs         (gb,bundle[BINK_SRC_INTRA_DC], DC_START_BITS, 0);
-    readDcs         (gb,bundle[BINK_SRC_INTER_DC], DC_START_BITS, 1);
-    readRuns        (gb,bundle[BINK_SRC_RUN]);
+    readBlockTypes  (gb,ctx.bundle[BINK_SRC_BLOCK_TYPES]);
+    readBlockTypes  (gb,ctx.bundle[BINK_SRC_SUB_BLOCK_TYPES]);
+    readColors      (ctx,gb,ctx.bundle[BINK_SRC_COLORS]);
+    readPatterns    (gb,ctx.bundle[BINK_SRC_PATTERN]);
+    readMotionValues(gb,ctx.bundle[BINK_SRC_X_OFF]);
+    readMotionValues(gb,ctx.bundle[BINK_SRC_Y_OFF]);
+    readDcs         (gb,ctx.bundle[BINK_SRC_INTRA_DC], DC_START_BITS, 0);
+    readDcs         (gb,ctx.bundle[BINK_SRC_INTER_DC], DC_START_BITS, 1);
+    readRuns        (gb,ctx.bundle[BINK_SRC_RUN]);
 
     for(int bx=0; bx<bw; ++bx) {
-      BlockTypes blk = BlockTypes(getValue(BINK_SRC_BLOCK_TYPES));
+      BlockTypes blk = BlockTypes(getValue(ctx,BINK_SRC_BLOCK_TYPES));
       // 16x16 block type on odd line means part of the already decoded block, so skip it
       if((by & 1) && blk == SCALED_BLOCK) {
         bx++;
@@ -1203,7 +1313,7 @@ void Video::decodePlane(BitStream& gb, int planeId, bool chroma) {
 
       bool isScaled = false;
       if(blk==SCALED_BLOCK){
-        blk = BlockTypes(getValue(BINK_SRC_SUB_BLOCK_TYPES));
+        blk = BlockTypes(getValue(ctx,BINK_SRC_SUB_BLOCK_TYPES));
         isScaled = true;
         }
 
@@ -1214,100 +1324,98 @@ void Video::decodePlane(BitStream& gb, int planeId, bool chroma) {
           last.getBlock8x8(bx,by,dst);
           break;
         case FILL_BLOCK:    {
-          const uint8_t v = uint8_t(getValue(BINK_SRC_COLORS));
+          const uint8_t v = uint8_t(getValue(ctx,BINK_SRC_COLORS));
           std::memset(dst,v,sizeof(dst));
           break;
           }
         case RESIDUE_BLOCK: {
           uint8_t prev[8*8] = {};
-          const int xoff = getValue(BINK_SRC_X_OFF);
-          const int yoff = getValue(BINK_SRC_Y_OFF);
-          last.getPixels8x8(bx*8+xoff, by*8+yoff, prev);
+          const int xoff = getValue(ctx,BINK_SRC_X_OFF);
+          const int yoff = getValue(ctx,BINK_SRC_Y_OFF);
+          if(!last.hasPixels8x8(bx*8+xoff, by*8+yoff))
+            throw VideoDecodingException("motion vector out of bounds");
+          last.getPixels8x8(uint32_t(bx*8+xoff), uint32_t(by*8+yoff), prev);
 
           int16_t block[64] = {};
           int v = gb.getBits(7);
           readResidue(gb,block,v);
-          for(int i=0; i<64; ++i)
-            dst[i] = uint8_t(prev[i]+block[i]);
+          Dsp::addBlock(dst,prev,block);
           break;
           }
         case INTRA_BLOCK:   {
           int32_t dctblock[64] = {};
-          dctblock[0] = getValue(BINK_SRC_INTRA_DC);
+          dctblock[0] = getValue(ctx,BINK_SRC_INTRA_DC);
           int coef_count=0, coef_idx[64]={};
           int quant_idx = readDctCoeffs(gb, dctblock, bink_scan, coef_count, coef_idx, -1);
           unquantizeDctCoeffs(dctblock, bink_intra_quant[quant_idx], coef_count, coef_idx, bink_scan);
-          int temp[64]={};
-          for(int i=0; i<8; i++)
-            bink_idct_col(&temp[i], &dctblock[i]);
-          for(int i=0; i<8; i++)
-            idctRow(&dst[i*8], &temp[8*i]);
+          Dsp::idct(dctblock);
+          Dsp::putBlock(dst,dctblock);
           break;
           }
         case INTER_BLOCK:   {
           uint8_t prev[8*8] = {};
-          const int xoff = getValue(BINK_SRC_X_OFF);
-          const int yoff = getValue(BINK_SRC_Y_OFF);
-          last.getPixels8x8(bx*8+xoff, by*8+yoff, prev);
+          const int xoff = getValue(ctx,BINK_SRC_X_OFF);
+          const int yoff = getValue(ctx,BINK_SRC_Y_OFF);
+          if(!last.hasPixels8x8(bx*8+xoff, by*8+yoff))
+            throw VideoDecodingException("motion vector out of bounds");
+          last.getPixels8x8(uint32_t(bx*8+xoff), uint32_t(by*8+yoff), prev);
 
           int32_t dctblock[64] = {};
-          dctblock[0] = getValue(BINK_SRC_INTER_DC);
+          dctblock[0] = getValue(ctx,BINK_SRC_INTER_DC);
           int coef_count=0, coef_idx[64]={};
           int quant_idx = readDctCoeffs(gb, dctblock, bink_scan, coef_count, coef_idx, -1);
           unquantizeDctCoeffs(dctblock, bink_inter_quant[quant_idx], coef_count, coef_idx, bink_scan);
-
-          int temp[64]={};
-          for(int i=0; i<8; i++)
-            bink_idct_col(&temp[i], &dctblock[i]);
-          for(int i = 0; i < 8; i++)
-            idctRow(&dctblock[i*8], &temp[8*i]);
-          for(int i=0; i<64; ++i)
-            dst[i] = uint8_t(prev[i]+dctblock[i]);
+          Dsp::idct(dctblock);
+          Dsp::addBlock(dst,prev,dctblock);
           break;
           }
         case RUN_BLOCK:     {
           const uint8_t* scan = bink_patterns[gb.getBits(4)];
           int i = 0;
           do {
-            const int run = getValue(BINK_SRC_RUN) + 1;
+            const int run = getValue(ctx,BINK_SRC_RUN) + 1;
             i += run;
             if(i > 64)
               throw VideoDecodingException("Run went out of bounds");
             if(gb.getBit()) {
-              int v = getValue(BINK_SRC_COLORS);
+              int v = getValue(ctx,BINK_SRC_COLORS);
               for(int j = 0; j < run; j++)
                 dst[*scan++] = uint8_t(v);
               } else {
               for(int j = 0; j < run; j++)
-                dst[*scan++] = uint8_t(getValue(BINK_SRC_COLORS));
+                dst[*scan++] = uint8_t(getValue(ctx,BINK_SRC_COLORS));
               }
             } while (i < 63);
           if(i == 63)
-            dst[*scan++] = uint8_t(getValue(BINK_SRC_COLORS));
+            dst[*scan++] = uint8_t(getValue(ctx,BINK_SRC_COLORS));
           break;
           }
         case MOTION_BLOCK:  {
           if(isScaled)
             throw VideoDecodingException("unsupported type of superblock");
-          const int xoff = getValue(BINK_SRC_X_OFF);
-          const int yoff = getValue(BINK_SRC_Y_OFF);
-          last.getPixels8x8(bx*8+xoff, by*8+yoff, dst);
+          const int xoff = getValue(ctx,BINK_SRC_X_OFF);
+          const int yoff = getValue(ctx,BINK_SRC_Y_OFF);
+          if(!last.hasPixels8x8(bx*8+xoff, by*8+yoff))
+            throw VideoDecodingException("motion vector out of bounds");
+          last.getPixels8x8(uint32_t(bx*8+xoff), uint32_t(by*8+yoff), dst);
           break;
           }
         case PATTERN_BLOCK: {
           uint8_t col[2] = {};
           for(int i=0; i<2; i++)
-            col[i] = uint8_t(getValue(BINK_SRC_COLORS));
+            col[i] = uint8_t(getValue(ctx,BINK_SRC_COLORS));
           for(int i=0; i<8; i++) {
-            int v = getValue(BINK_SRC_PATTERN);
+            int v = getValue(ctx,BINK_SRC_PATTERN);
             for(int j=0; j<8; j++, v >>= 1)
               dst[i*8+j] = col[v & 1];
             }
           break;
           }
         case RAW_BLOCK:     {
-          std::memcpy(dst,bundle[BINK_SRC_COLORS].cur_ptr,64);
-          bundle[BINK_SRC_COLORS].cur_ptr += 64;
+          if(ctx.bundle[BINK_SRC_COLORS].cur_ptr+64>ctx.bundle[BINK_SRC_COLORS].data_end)
+            throw VideoDecodingException("raw block went out of bounds");
+          std::memcpy(dst,ctx.bundle[BINK_SRC_COLORS].cur_ptr,64);
+          ctx.bundle[BINK_SRC_COLORS].cur_ptr += 64;
           break;
           }
         default:
@@ -1327,18 +1435,18 @@ void Video::decodePlane(BitStream& gb, int planeId, bool chroma) {
   gb.align32();
   }
 
-void Video::readBundle(BitStream& gb, int bundle_num) {
+void Video::readBundle(PlaneCtx& ctx, BitStream& gb, int bundle_num) {
   if(bundle_num == BINK_SRC_COLORS) {
     for(int i=0; i<16; i++)
-      readTree(gb, col_high[i]);
-    col_lastval = 0;
+      readTree(gb, ctx.col_high[i]);
+    ctx.col_lastval = 0;
     }
 
   if(bundle_num != BINK_SRC_INTRA_DC && bundle_num != BINK_SRC_INTER_DC)
-    readTree(gb, bundle[bundle_num].tree);
+    readTree(gb, ctx.bundle[bundle_num].tree);
 
-  bundle[bundle_num].cur_dec =
-      bundle[bundle_num].cur_ptr = bundle[bundle_num].data.data();
+  ctx.bundle[bundle_num].cur_dec =
+      ctx.bundle[bundle_num].cur_ptr = ctx.bundle[bundle_num].data.data();
   }
 
 void Video::readTree(BitStream& gb, Tree& tree) {
@@ -1428,7 +1536,7 @@ void Video::readBlockTypes(BitStream& gb, Bundle& b) {
     }
   }
 
-void Video::readColors(BitStream& gb, Bundle& b) {
+void Video::readColors(PlaneCtx& ctx, BitStream& gb, Bundle& b) {
   int t=0, sign=0, v=0;
   const uint8_t *dec_end = nullptr;
 
@@ -1440,9 +1548,9 @@ void Video::readColors(BitStream& gb, Bundle& b) {
     throw VideoDecodingException("Too many color values");
 
   if(gb.getBit()) {
-    col_lastval = getHuff(gb, col_high[col_lastval]);
+    ctx.col_lastval = getHuff(gb, ctx.col_high[ctx.col_lastval]);
     v = getHuff(gb, b.tree);
-    v = (col_lastval << 4) | v;
+    v = (ctx.col_lastval << 4) | v;
     if(revision<'i') {
       sign = ((int8_t) v) >> 7;
       v = ((v & 0x7F) ^ sign) - sign;
@@ -1452,9 +1560,9 @@ void Video::readColors(BitStream& gb, Bundle& b) {
     b.cur_dec += t;
     } else {
     while(b.cur_dec<dec_end) {
-      col_lastval = getHuff(gb, col_high[col_lastval]);
+      ctx.col_lastval = getHuff(gb, ctx.col_high[ctx.col_lastval]);
       v = getHuff(gb, b.tree);
-      v = (col_lastval << 4) | v;
+      v = (ctx.col_lastval << 4) | v;
       if(revision<'i') {
         sign = ((int8_t) v) >> 7;
         v = ((v & 0x7F) ^ sign) - sign;
@@ -1576,13 +1684,19 @@ void Video::readRuns(BitStream& gb, Bundle& b) {
     }
   }
 
-int Video::getValue(Sources b) {
+int Video::getValue(PlaneCtx& ctx, Sources b) {
+  auto& bundle = ctx.bundle[b];
+  // int16 values are stored aligned, from start of even-sized buffer
+  if(bundle.cur_ptr>=bundle.data_end)
+    throw VideoDecodingException("bundle value went out of bounds");
   if(b<BINK_SRC_X_OFF || b==BINK_SRC_RUN)
-    return *bundle[int(b)].cur_ptr++;
+    return *bundle.cur_ptr++;
   if(b==BINK_SRC_X_OFF || b==BINK_SRC_Y_OFF)
-    return *reinterpret_cast<int8_t*&>(bundle[b].cur_ptr)++;
-  int16_t ret = *reinterpret_cast<int16_t*&>(bundle[b].cur_ptr);
-  bundle[b].cur_ptr += 2;
+    return *reinterpret_cast<int8_t*&>(bundle.cur_ptr)++;
+  if(bundle.cur_ptr+2>bundle.data_end)
+    throw VideoDecodingException("bundle value went out of bounds");
+  int16_t ret = *reinterpret_cast<int16_t*&>(bundle.cur_ptr);
+  bundle.cur_ptr += 2;
   return ret;
   }
 
@@ -1878,11 +1992,11 @@ void Video::initFfCosTabs(size_t index) {
     tab[m/2-i] = tab[i];
   }
 
-void Video::parseAudio(const std::vector<uint8_t>& data, size_t id) {
-  BitStream gb(data.data(),data.size()*8);
+void Video::parseAudio(size_t id) {
+  auto&     aud = this->aud[id];
+  BitStream gb(aud.packet.data(),aud.packet.size()*8);
   gb.skip(32); // skip reported size
 
-  auto& aud = this->aud[id];
   auto& ret = frames[frameCounter%2].aud[id].samples;
   ret.reserve(ret.capacity());
   ret.clear();
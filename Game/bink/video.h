@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 
@@ -164,9 +165,26 @@ class Video final {
       float                   previous[MAX_CHANNELS][BINK_BLOCK_MAX_SIZE/16];  // coeffs from previous audio block
 
       bool                    first = true;
+      std::vector<uint8_t>    packet;
+      };
+
+    // per-plane decoding state, so planes can be decoded concurrently
+    struct PlaneCtx final {
+      Bundle                  bundle[BINK_NB_SRC] = {};
+      Tree                    col_high[16];         // trees for decoding high nibble in "colours" data type
+      int                     col_lastval = 0;      // value of last decoded high nibble in "colours" data type
+      };
+
+    // meaning of 32-bit word in front of alpha and luma planes (revision 'i' and later)
+    enum PlaneOffsets : uint8_t {
+      OFFSET_UNKNOWN = 0, // not learned yet: decode serially and compare with actual plane positions
+      OFFSET_ABSOLUTE,    // byte offset of next plane, from start of the packet
+      OFFSET_RELATIVE,    // byte size of the plane, that follows the word
+      OFFSET_NONE,        // doesn't match plane positions: no concurrent decoding
       };
 
     struct BitStream;
+    class  DecodePool;
 
     uint32_t rl32();
     uint16_t rl16();
@@ -180,13 +198,16 @@ class Video final {
     int      getVlc2(BitStream& gb, int16_t (*table)[2], int bits, int max_depth);
     void     readPacket();
     void     parseFrame(const std::vector<uint8_t>& data);
+    bool     parseFrameParallel(const std::vector<uint8_t>& data);
+    void     parseFrameSerial(const std::vector<uint8_t>& data);
+    size_t   planeOffset(const std::vector<uint8_t>& data, size_t wordPos, PlaneOffsets mode) const;
     void     decodePlane(BitStream& gb, int planeId, bool chroma);
-    void     initLengths(int width, int bw);
-    void     readBundle(BitStream& gb, int bundle_num);
+    void     initLengths(PlaneCtx& ctx, int width, int bw);
+    void     readBundle(PlaneCtx& ctx, BitStream& gb, int bundle_num);
     void     readTree(BitStream& gb, Tree& tree);
 
     void     readBlockTypes  (BitStream& gb, Bundle& b);
-    void     readColors      (BitStream& gb, Bundle& b);
+    void     readColors      (PlaneCtx& ctx, BitStream& gb, Bundle& b);
     void     readPatterns    (BitStream& gb, Bundle& b);
     void     readMotionValues(BitStream& gb, Bundle& b);
     void     readDcs         (BitStream& gb, Bundle& b, int start_bits, int has_sign);
@@ -196,12 +217,12 @@ class Video final {
     void     unquantizeDctCoeffs(int32_t block[], const uint32_t quant[],
                                  int coef_count, int coef_idx[], const uint8_t* scan);
     void     readResidue     (BitStream& gb, int16_t block[], int masks_count);
-    int      getValue(Sources bundle);
+    int      getValue(PlaneCtx& ctx, Sources bundle);
     template<class T>
     static bool checkReadVal(BitStream& gb, Bundle& b, T& t);
 
     void     initFfCosTabs(size_t index);
-    void     parseAudio(const std::vector<uint8_t>& data, size_t id);
+    void     parseAudio(size_t id);
     void     parseAudioBlock(BitStream& gb, AudioCtx& track);
     void     dctCalc3C (AudioCtx& aud, float* data);
     void     rdftCalcC (AudioCtx& aud, float* data, bool negativeSign);
@@ -228,12 +249,14 @@ class Video final {
     uint32_t                frameCounter = 0;
 
     // video
-    Bundle                  bundle[BINK_NB_SRC] = {};
-    Tree                    col_high[16];         // trees for decoding high nibble in "colours" data type
-    int                     col_lastval = 0;      // value of last decoded high nibble in "colours" data type
+    PlaneCtx                planeCtx[4];
+    PlaneOffsets            planeOffsets = OFFSET_UNKNOWN;
 
     // sound
     float                   quantTable[96] = {};
+
+    // threads for audio and planes, that are decoded next to luma
+    std::unique_ptr<DecodePool> pool;
   };
 
 }
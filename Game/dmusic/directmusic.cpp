@@ -5,6 +5,7 @@
 
 #include <Tempest/File>
 #include <utils/fileutil.h>
+#include <utils/mappedfile.h>
 
 using namespace Dx8;
 
@@ -16,11 +17,9 @@ PatternList DirectMusic::load(const Segment &s) {
   }
 
 PatternList DirectMusic::load(const char16_t *fsgt) {
-  Tempest::RFile fin = implOpen(fsgt);
-  std::vector<uint8_t> v(size_t(fin.size()));
-  fin.read(&v[0],v.size());
+  MappedFile fin = implOpen(fsgt);
 
-  auto r   = Dx8::Riff(v.data(),v.size());
+  auto r   = Dx8::Riff(fin.data(),fin.size());
   auto sgt = Dx8::Segment(r);
   return load(sgt);
   }
@@ -30,22 +29,20 @@ void DirectMusic::addPath(std::u16string p) {
   }
 
 const Style &DirectMusic::style(const Reference &id) {
-  for(auto& i:styles){
-    if(i.first==id.file)
-      return i.second;
-    }
-
-  Tempest::RFile fin = implOpen(id.file.c_str());
-  const size_t length = fin.size();
-
-  std::vector<uint8_t> data(length);
-  fin.read(&data[0],data.size());
+  {
+    std::lock_guard<std::mutex> guard(sync);
+    auto i = styles.find(id.file);
+    if(i!=styles.end())
+      return i->second;
+  }
 
-  Riff  r{data.data(),data.size()};
-  Style stl(r);
+  // parse outside of lock; if other thread was faster, its copy wins
+  MappedFile fin = implOpen(id.file.c_str());
+  Riff       r{fin.data(),fin.size()};
+  Style      stl(r);
 
-  styles.emplace_back(id.file,std::move(stl));
-  return styles.back().second;
+  std::lock_guard<std::mutex> guard(sync);
+  return styles.emplace(id.file,std::move(stl)).first->second;
   }
 
 const DlsCollection &DirectMusic::dlsCollection(const Reference &id) {
@@ -53,28 +50,26 @@ const DlsCollection &DirectMusic::dlsCollection(const Reference &id) {
   }
 
 const DlsCollection &DirectMusic::dlsCollection(const std::u16string &file) {
-  for(auto& i:dls){
-    if(i->first==file)
+  {
+    std::lock_guard<std::mutex> guard(sync);
+    auto i = dls.find(file);
+    if(i!=dls.end())
       return i->second;
-    }
-  Tempest::RFile fin    = implOpen(file.c_str());
-  const size_t   length = fin.size();
-
-  std::vector<uint8_t> data(length);
-  fin.read(reinterpret_cast<char*>(&data[0]),data.size());
+  }
 
-  Riff          r{data.data(),data.size()};
-  DlsCollection stl(r);
+  MappedFile    fin = implOpen(file.c_str());
+  Riff          r{fin.data(),fin.size()};
+  DlsCollection col(r);
 
-  dls.emplace_back(new std::pair<std::u16string,DlsCollection>(file,std::move(stl)));
-  return dls.back()->second;
+  std::lock_guard<std::mutex> guard(sync);
+  return dls.emplace(file,std::move(col)).first->second;
   }
 
-Tempest::RFile DirectMusic::implOpen(const char16_t *file) {
+MappedFile DirectMusic::implOpen(const char16_t *file) {
   for(auto& pt:path) {
     try {
       std::u16string filepath = FileUtil::nestedPath(pt, {file}, Tempest::Dir::FT_File);
-      Tempest::RFile fin(filepath);
+      MappedFile fin(filepath);
       return fin;
       }
     catch(std::system_error&){
@@ -5,20 +5,26 @@
 #include "segment.h"
 #include "style.h"
 
-#include <Tempest/File>
+#include <unordered_map>
 #include <vector>
+#include <mutex>
+
+class MappedFile;
 
 namespace Dx8 {
 
 /**
  * http://doc.51windows.net/Directx9_SDK/htm/directmusicfilestructures.htm
+ *
+ * Styles and dls collections are cached by file name; loading is thread-safe,
+ * so segments can be prepared on worker threads, while mixer plays current one.
  */
 class DirectMusic final {
   public:
     DirectMusic();
 
-    using StyleList = std::vector<std::pair<std::u16string,Style>>;
-    using DlsList   = std::vector<std::unique_ptr<std::pair<std::u16string,DlsCollection>>>;
+    using StyleList = std::unordered_map<std::u16string,Style>;
+    using DlsList   = std::unordered_map<std::u16string,DlsCollection>;
 
     PatternList          load(const Segment& s);
     PatternList          load(const char16_t* fsgt);
@@ -33,11 +39,12 @@ class DirectMusic final {
     const DlsList&       dlsCollection() { return dls;    }
 
   private:
+    std::mutex                  sync;
     StyleList                   styles;
     DlsList                     dls;
     std::vector<std::u16string> path;
 
-    Tempest::RFile              implOpen(const char16_t* file);
+    MappedFile                  implOpen(const char16_t* file);
   };
 
 }
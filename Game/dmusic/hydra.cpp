@@ -2,6 +2,8 @@
 
 #include "dlscollection.h"
 
+#include <new>
+
 #define TSF_IMPLEMENTATION
 // #define TSF_STATIC
 
@@ -296,6 +298,53 @@ bool Hydra::hasNotes(tsf *tsf) {
   return false;
   }
 
+void Hydra::reserveVoices(tsf* tsf, int count) {
+  if(tsf->voiceNum>=count)
+    return;
+  auto v = reinterpret_cast<tsf_voice*>(TSF_REALLOC(tsf->voices,size_t(count)*sizeof(tsf_voice)));
+  if(v==nullptr)
+    throw std::bad_alloc();
+  for(int i=tsf->voiceNum; i<count; ++i)
+    v[i].playingPreset = -1;
+  tsf->voices   = v;
+  tsf->voiceNum = count;
+  }
+
+bool Hydra::hasFreeVoices(tsf* tsf, int preset, int key, float vel) {
+  if(preset<0 || preset>=tsf->presetNum)
+    return true;
+
+  // same region match, as in tsf_note_on: one voice per region
+  const short midiVelocity = short(vel*127);
+  int         required     = 0;
+  auto&       p            = tsf->presets[preset];
+  for(auto r=p.regions, rEnd=r+p.regionNum; r!=rEnd; ++r) {
+    if(key<r->lokey || key>r->hikey || midiVelocity<r->lovel || midiVelocity>r->hivel)
+      continue;
+    ++required;
+    }
+
+  tsf_voice *v = tsf->voices, *vEnd = v + tsf->voiceNum;
+  for(; v!=vEnd && required>0; v++)
+    if(v->playingPreset == -1)
+      --required;
+  return required==0;
+  }
+
+void Hydra::render(tsf* tsf, float* out, size_t count, float gain) {
+  // gain is baked into voice at note-on; extra gain is applied the same way, for duration of render
+  const float db = tsf_gainToDecibels(gain);
+  tsf_voice *v = tsf->voices, *vEnd = v + tsf->voiceNum;
+  for(; v!=vEnd; v++) {
+    if(v->playingPreset == -1)
+      continue;
+    const float noteGainDB = v->noteGainDB;
+    v->noteGainDB = noteGainDB + db;
+    tsf_voice_render(tsf,v,out,int(count));
+    v->noteGainDB = noteGainDB;
+    }
+  }
+
 tsf *Hydra::toTsf() {
   tsf_hydra hydra={};
   toTsf(hydra);
@@ -63,6 +63,11 @@ class Hydra {
 
     static void finalize(tsf* tsf);
     static bool hasNotes(tsf* tsf);
+    // voices are preallocated, since tsf_note_on grows voice array on demand
+    static void reserveVoices(tsf* tsf, int count);
+    static bool hasFreeVoices(tsf* tsf, int preset, int key, float vel);
+    // adds playing voices into interleaved stereo 'out', scaled by gain
+    static void render(tsf* tsf, float* out, size_t count, float gain);
 
     tsf* toTsf   ();
     void toTsf   (tsf_hydra& out);
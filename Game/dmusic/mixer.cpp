@@ -5,11 +5,19 @@
 #include <Tempest/Sound>
 #include <Tempest/Log>
 #include <cmath>
-#include <set>
+#include <cstring>
 
 #include "soundfont.h"
 #include "wave.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define DMUSIC_SIMD_SSE 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DMUSIC_SIMD_NEON 1
+#endif
+
 using namespace Dx8;
 using namespace Tempest;
 
@@ -17,17 +25,112 @@ static int64_t toSamples(uint64_t time) {
   return int64_t(time*SoundFont::SampleRate)/1000;
   }
 
+// dst[i] += (src[i]*gain)*(vol[i/2]*vol[i/2]), stereo-interleaved
+static void mixGainCurve(float* dst, const float* src, float gain, const float* vol, size_t cnt) {
+  size_t i = 0;
+#if defined(DMUSIC_SIMD_SSE)
+  const __m128 g = _mm_set1_ps(gain);
+  for(; i+2<=cnt; i+=2) {
+    __m128 v = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(vol+i)));
+    v = _mm_unpacklo_ps(v,v);
+    v = _mm_mul_ps(v,v);
+    _mm_storeu_ps(dst+i*2,_mm_add_ps(_mm_loadu_ps(dst+i*2),_mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(src+i*2),g),v)));
+    }
+#elif defined(DMUSIC_SIMD_NEON)
+  const float32x4_t g = vdupq_n_f32(gain);
+  for(; i+2<=cnt; i+=2) {
+    const float32x2_t v2 = vld1_f32(vol+i);
+    float32x4_t       v  = vcombine_f32(vdup_lane_f32(v2,0),vdup_lane_f32(v2,1));
+    v = vmulq_f32(v,v);
+    vst1q_f32(dst+i*2,vaddq_f32(vld1q_f32(dst+i*2),vmulq_f32(vmulq_f32(vld1q_f32(src+i*2),g),v)));
+    }
+#endif
+  for(; i<cnt; ++i) {
+    const float v = vol[i];
+    dst[i*2+0] += src[i*2+0]*gain*(v*v);
+    dst[i*2+1] += src[i*2+1]*gain*(v*v);
+    }
+  }
+
+static int16_t toPcm16(float v) {
+  return (v < -1.00004566f ? int16_t(-32768) : (v > 1.00001514f ? int16_t(32767) : int16_t(v * 32767.5f)));
+  }
+
+// out[i] = toPcm16(src[i]*volume); pack with saturation gives the same result as clamp in toPcm16
+static void toPcm16(int16_t* out, const float* src, float volume, size_t cnt2) {
+  size_t i = 0;
+#if defined(DMUSIC_SIMD_SSE)
+  const __m128 vl  = _mm_set1_ps(volume);
+  const __m128 sc  = _mm_set1_ps(32767.5f);
+  const __m128 lo  = _mm_set1_ps(-32769.f);
+  const __m128 hi  = _mm_set1_ps( 32768.f);
+  for(; i+8<=cnt2; i+=8) {
+    __m128 a = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(src+i),  vl),sc);
+    __m128 b = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(src+i+4),vl),sc);
+    a = _mm_min_ps(_mm_max_ps(a,lo),hi);
+    b = _mm_min_ps(_mm_max_ps(b,lo),hi);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i),_mm_packs_epi32(_mm_cvttps_epi32(a),_mm_cvttps_epi32(b)));
+    }
+#elif defined(DMUSIC_SIMD_NEON)
+  const float32x4_t vl = vdupq_n_f32(volume);
+  const float32x4_t sc = vdupq_n_f32(32767.5f);
+  for(; i+8<=cnt2; i+=8) {
+    // vcvtq_s32_f32 truncates and saturates
+    const int32x4_t a = vcvtq_s32_f32(vmulq_f32(vmulq_f32(vld1q_f32(src+i),  vl),sc));
+    const int32x4_t b = vcvtq_s32_f32(vmulq_f32(vmulq_f32(vld1q_f32(src+i+4),vl),sc));
+    vst1q_s16(out+i,vcombine_s16(vqmovn_s32(a),vqmovn_s32(b)));
+    }
+#endif
+  for(; i<cnt2; ++i)
+    out[i] = toPcm16(src[i]*volume);
+  }
+
 Mixer::Mixer() {
-  const size_t reserve=2048;
-  pcm.reserve(reserve*2);
-  pcmMix.reserve(reserve*2);
-  vol.reserve(reserve);
-  // uniqInstr.reserve(32);
+  pcm   .resize(MixBlock*2);
+  pcmMix.resize(MixBlock*2);
+  vol   .resize(MixBlock);
+  active.reserve(MaxActive);
+  uniqInstr.reserve(MaxInstr);
+  reaper = std::thread(&Mixer::reaperThread,this);
   }
 
 Mixer::~Mixer() {
   for(auto& i:active)
     SoundFont::noteOff(i.ticket);
+  {
+  std::lock_guard<std::mutex> guard(reaperSync);
+  reaperExit = true;
+  }
+  reaperCv.notify_one();
+  reaper.join();
+  }
+
+template<class T>
+bool Mixer::retire(std::shared_ptr<T>&& p) {
+  // single producer: called from mix() only; reference is moved to the ring, so reaper holds the last one
+  if(p==nullptr)
+    return true;
+  const size_t head = retiredHead.load(std::memory_order_relaxed);
+  if(head-retiredTail.load(std::memory_order_acquire)==MaxRetire)
+    return false;
+  retired[head%MaxRetire] = std::move(p);
+  retiredHead.store(head+1,std::memory_order_release);
+  return true;
+  }
+
+void Mixer::reaperThread() {
+  // waits on reaperCv with timeout: audio thread never notifies it, only destructor does on exit
+  std::unique_lock<std::mutex> guard(reaperSync);
+  while(true) {
+    const bool   exit = reaperCv.wait_for(guard,std::chrono::milliseconds(50),[this](){ return reaperExit; });
+    const size_t head = retiredHead.load(std::memory_order_acquire);
+    size_t       tail = retiredTail.load(std::memory_order_relaxed);
+    for(; tail!=head; ++tail)
+      retired[tail%MaxRetire].reset();
+    retiredTail.store(tail,std::memory_order_release);
+    if(exit)
+      return;
+    }
   }
 
 void Mixer::setMusic(const Music& m,DMUS_EMBELLISHT_TYPES e) {
@@ -88,27 +191,40 @@ void Mixer::noteOn(std::shared_ptr<PatternInternal>& pattern, PatternList::Note
   if(!checkVariation(*r))
     return;
 
+  if(active.size()==MaxActive)
+    return;
+
+  Instr* parent = nullptr;
+  Instr* free   = nullptr;
+  for(auto& i:uniqInstr) {
+    if(i.ptr==r->inst) {
+      parent = &i;
+      break;
+      }
+    if(i.ptr==nullptr && free==nullptr)
+      free = &i;
+    }
+  if(parent==nullptr && free==nullptr && uniqInstr.size()==MaxInstr)
+    return;
+
   Active a;
   a.at      = sampleCursor + toSamples(r->duration);
   a.ticket  = r->inst->font.noteOn(r->note,r->velosity);
   if(a.ticket==nullptr)
     return;
 
-  for(auto& i:uniqInstr)
-    if(i.ptr==r->inst) {
-      a.parent = &i;
-      a.parent->counter++;
-      active.push_back(a);
-      return;
+  if(parent==nullptr) {
+    if(free==nullptr) {
+      uniqInstr.emplace_back();
+      free = &uniqInstr.back();
       }
-  Instr u;
-  u.ptr     = r->inst;
-  u.pattern = pattern;
-  uniqInstr.push_back(u);
+    parent          = free;
+    parent->ptr     = r->inst;
+    parent->pattern = pattern;
+    }
 
-  a.parent = &uniqInstr.back();
+  a.parent = parent;
   a.parent->counter++;
-
   active.push_back(a);
   }
 
@@ -145,6 +261,7 @@ void Mixer::nextPattern() {
   auto mus = current;
   if(mus->pptn.size()==0) {
     // no active music
+    retire(std::move(pattern));
     pattern = nullptr;
     return;
     }
@@ -198,6 +315,11 @@ void Mixer::nextPattern() {
       noteOn(pattern,&i);
       }
   variationCounter.fetch_add(1);
+
+  if(prev!=pattern)
+    retire(std::move(prev));
+  if(mus!=current)
+    retire(std::move(mus));
   }
 
 Mixer::Step Mixer::stepInc(PatternInternal& pptn, int64_t b, int64_t e, int64_t samplesRemain) {
@@ -260,6 +382,8 @@ void Mixer::mix(int16_t *out, size_t samples) {
   const int64_t samplesTotal = toSamples(cur->timeTotal);
   if(samplesTotal==0) {
     current = nextMus;
+    if(cur!=current)
+      retire(std::move(cur));
     return;
     }
 
@@ -268,8 +392,8 @@ void Mixer::mix(int16_t *out, size_t samples) {
   size_t samplesRemain = samples;
   while(samplesRemain>0) {
     if(pat==nullptr)
-      return;
-    const int64_t remain = std::min(patEnd-sampleCursor,int64_t(samplesRemain));
+      break;
+    const int64_t remain = std::min(std::min(patEnd-sampleCursor,int64_t(samplesRemain)),int64_t(MixBlock));
     const int64_t b      = (sampleCursor       );
     const int64_t e      = (sampleCursor+remain);
 
@@ -291,9 +415,15 @@ void Mixer::mix(int16_t *out, size_t samples) {
       }
     }
 
-  uniqInstr.remove_if([](Instr& i){
-    return i.counter==0 && !i.ptr->font.hasNotes();
-    });
+  // slot is kept for one more round, if pattern can't be retired yet
+  for(auto& i:uniqInstr)
+    if(i.ptr!=nullptr && i.counter==0 && !i.ptr->font.hasNotes() && retire(std::move(i.pattern)))
+      i = Instr();
+
+  if(pat!=pattern)
+    retire(std::move(pat));
+  if(cur!=current)
+    retire(std::move(cur));
   }
 
 void Mixer::setVolume(float v) {
@@ -302,20 +432,19 @@ void Mixer::setVolume(float v) {
 
 void Mixer::implMix(PatternInternal &pptn, float volume, int16_t *out, size_t cnt) {
   const size_t cnt2=cnt*2;
-  pcm   .resize(cnt2);
-  pcmMix.resize(cnt2);
-  vol   .resize(cnt);
+  float*       pcm    = this->pcm.data();
+  float*       pcmMix = this->pcmMix.data();
+  float*       vol    = this->vol.data();
 
-  std::memset(pcmMix.data(),0,cnt2*sizeof(pcmMix[0]));
+  std::memset(pcmMix,0,cnt2*sizeof(pcmMix[0]));
 
   for(auto& i:uniqInstr) {
+    if(i.ptr==nullptr)
+      continue;
     auto& ins = *i.ptr;
     if(!ins.font.hasNotes())
       continue;
 
-    std::memset(pcm.data(),0,cnt2*sizeof(pcm[0]));
-    ins.font.mix(pcm.data(),cnt);
-
     float insVolume = std::pow(ins.volume,2.f);
     if(ins.key==5 || ins.key==6) {
       // HACK
@@ -323,29 +452,24 @@ void Mixer::implMix(PatternInternal &pptn, float volume, int16_t *out, size_t cn
       }
     const bool hasVol = hasVolumeCurves(pptn,i);
     if(hasVol) {
-      volFromCurve(pptn,i,vol);
-      for(size_t r=0;r<cnt2;++r) {
-        float v = vol[r/2];
-        pcmMix[r] += pcm[r]*insVolume*(v*v);
-        }
+      // SoundFont applies gain per voice, so per-sample volume goes through scratch buffer
+      std::memset(pcm,0,cnt2*sizeof(pcm[0]));
+      ins.font.mix(pcm,cnt,1.f);
+      volFromCurve(pptn,i,vol,cnt);
+      mixGainCurve(pcmMix,pcm,insVolume,vol,cnt);
       } else {
-      for(size_t r=0;r<cnt2;++r) {
-        float v = i.volLast;
-        pcmMix[r] += pcm[r]*insVolume*(v*v);
-        }
+      const float v = i.volLast;
+      ins.font.mix(pcmMix,cnt,insVolume*(v*v));
       }
     }
 
-  for(size_t i=0;i<cnt2;++i) {
-    float v = pcmMix[i]*volume;
-    out[i] = (v < -1.00004566f ? int16_t(-32768) : (v > 1.00001514f ? int16_t(32767) : int16_t(v * 32767.5f)));
-    }
+  toPcm16(out,pcmMix,volume,cnt2);
   }
 
-void Mixer::volFromCurve(PatternInternal &part,Instr& inst,std::vector<float> &v) {
+void Mixer::volFromCurve(PatternInternal &part, Instr& inst, float* v, size_t cnt) {
   float& base = inst.volLast;
-  for(auto& i:v)
-    i=base;
+  for(size_t i=0; i<cnt; ++i)
+    v[i]=base;
 
   const int64_t shift = sampleCursor-patStart;
   //const int64_t e = s+v.size();
@@ -358,11 +482,11 @@ void Mixer::volFromCurve(PatternInternal &part,Instr& inst,std::vector<float> &v
 
     int64_t s = toSamples(i.at)-shift;
     int64_t e = toSamples(i.at+i.duration)-shift;
-    if((s>=0 && size_t(s)>v.size()) || e<0)
+    if((s>=0 && size_t(s)>cnt) || e<0)
       continue;
 
     const size_t begin = size_t(std::max<int64_t>(s,0));
-    const size_t size  = std::min(size_t(e),v.size());
+    const size_t size  = std::min(size_t(e),cnt);
     const float  range = float(e-s);
     const float  diffV = i.endV-i.startV;
     const float  shift = i.startV;
@@ -3,11 +3,13 @@
 #include <Tempest/SoundDevice>
 #include <Tempest/SoundEffect>
 
+#include <array>
 #include <vector>
 #include <cstdint>
 #include <thread>
 #include <atomic>
-#include <list>
+#include <mutex>
+#include <condition_variable>
 
 #include "patternlist.h"
 #include "music.h"
@@ -27,6 +29,14 @@ class Mixer final {
     int64_t  currentPlayTime() const;
 
   private:
+    // audio callback doesn't allocate: buffers and pools are created upfront, with fixed capacity
+    enum : size_t {
+      MixBlock  = 2048, // max samples per implMix call
+      MaxInstr  = 128,
+      MaxActive = 512,
+      MaxRetire = 256,
+      };
+
     struct Instr;
 
     struct Active {
@@ -41,6 +51,7 @@ class Mixer final {
       int64_t samples=0;
       };
 
+    // ptr==nullptr for free slot
     struct Instr {
       PatternList::InsInternal* ptr=nullptr;
       float                     volLast=1.f;
@@ -65,12 +76,16 @@ class Mixer final {
     void     nextPattern();
 
     bool     hasVolumeCurves(PatternInternal &part, Instr &ins) const;
-    void     volFromCurve(PatternInternal &part, Instr &ins, std::vector<float> &v);
+    void     volFromCurve(PatternInternal &part, Instr &ins, float* v, size_t cnt);
 
     template<class T>
     bool     checkVariation(const T& item) const;
     int      getGroove() const;
 
+    template<class T>
+    bool     retire(std::shared_ptr<T>&& p);
+    void     reaperThread();
+
     std::shared_ptr<Music::Internal>   current=nullptr;
     std::shared_ptr<Music::Internal>   nextMus=nullptr;
     std::atomic<DMUS_EMBELLISHT_TYPES> embellishment = {DMUS_EMBELLISHT_NORMAL};
@@ -84,8 +99,17 @@ class Mixer final {
 
     std::atomic<float>                 volume={1.f};
     std::vector<Active>                active;
-    std::list<Instr>                   uniqInstr;
+    std::vector<Instr>                 uniqInstr;
     std::vector<float>                 pcm, vol, pcmMix;
+
+    // last references to music and patterns are dropped on reaper thread, not in audio callback
+    std::array<std::shared_ptr<const void>,MaxRetire> retired;
+    std::atomic<size_t>                retiredHead={};
+    std::atomic<size_t>                retiredTail={};
+    std::mutex                         reaperSync;
+    std::condition_variable            reaperCv;
+    bool                               reaperExit=false;
+    std::thread                        reaper;
   };
 
 }
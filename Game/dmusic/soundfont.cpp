@@ -145,6 +145,10 @@ struct SoundFont::Data {
   };
 
 struct SoundFont::Instance {
+  enum {
+    MaxVoices = 32
+    };
+
   Instance(std::shared_ptr<Data> &shData,uint32_t dwPatch){
     uint8_t bankHi = uint8_t((dwPatch & 0x00FF0000) >> 0x10);
     uint8_t bankLo = uint8_t((dwPatch & 0x0000FF00) >> 0x8);
@@ -154,6 +158,7 @@ struct SoundFont::Instance {
     fnt    = shData->hydra.toTsf();
     preset = tsf_get_presetindex(fnt, bank, patch);
     tsf_set_output(fnt,TSF_STEREO_INTERLEAVED,44100,0);
+    Hydra::reserveVoices(fnt,MaxVoices);
     }
 
   ~Instance(){
@@ -173,8 +178,11 @@ struct SoundFont::Instance {
     if(alloc[note]) {
       return false;
       }
+    const float vel = (velosity+0.5f)/127.f;
+    if(!Hydra::hasFreeVoices(fnt,preset,note,vel))
+      return false;
     alloc[note]=true;
-    tsf_note_on(fnt,preset,note,(velosity+0.5f)/127.f);
+    tsf_note_on(fnt,preset,note,vel);
     return true;
     }
 
@@ -192,8 +200,16 @@ struct SoundFont::Instance {
   };
 
 struct SoundFont::Impl {
+  // mixer plays notes from audio thread: instances are created upfront, note that doesn't fit is dropped
+  enum {
+    MaxInstances = 2
+    };
+
   Impl(std::shared_ptr<Data> &shData,uint32_t dwPatch)
-    :shData(shData), dwPatch(dwPatch) {
+    :shData(shData) {
+    inst.reserve(MaxInstances);
+    for(int i=0; i<MaxInstances; ++i)
+      inst.emplace_back(std::make_shared<Instance>(shData,dwPatch));
     }
 
   ~Impl() {
@@ -202,7 +218,6 @@ struct SoundFont::Impl {
   void setPan(float p){
     for(auto& i:inst)
       i->setPan(p);
-    pan = p;
     }
 
   std::shared_ptr<Instance> noteOn(uint8_t note, uint8_t velosity){
@@ -210,21 +225,9 @@ struct SoundFont::Impl {
       if(i->noteOn(note,velosity))
         return i;
       }
-    auto fnt = std::make_shared<Instance>(shData,dwPatch);
-    fnt->setPan(pan);
-    fnt->noteOn(note,velosity);
-    inst.emplace_back(fnt);
-    return inst.back();
+    return nullptr;
     }
 
-  /*
-  void noteOff(uint8_t note){
-    for(auto& i:inst){
-      if(i->noteOff(note))
-        return;
-      }
-    }*/
-
   bool hasNotes() {
     for(auto& i:inst)
       if(i->hasNotes())
@@ -232,14 +235,12 @@ struct SoundFont::Impl {
     return false;
     }
 
-  void mix(float *samples, size_t count) {
+  void mix(float *samples, size_t count, float gain) {
     for(auto& i:inst)
-      tsf_render_float(i->fnt,samples,int(count),true);
+      Hydra::render(i->fnt,samples,count,gain);
     }
 
-  std::shared_ptr<Data>                  shData;
-  uint32_t                               dwPatch=0;
-  float                                  pan=0.5f;
+  std::shared_ptr<Data>                  shData; // owns samples of instances
   std::vector<std::shared_ptr<Instance>> inst;
   };
 
@@ -273,10 +274,10 @@ void SoundFont::setPan(float p) {
   impl->setPan(p);
   }
 
-void SoundFont::mix(float *samples, size_t count) {
+void SoundFont::mix(float *samples, size_t count, float gain) {
   if(impl==nullptr)
     return;
-  impl->mix(samples,count);
+  impl->mix(samples,count,gain);
   }
 
 SoundFont::Ticket SoundFont::noteOn(uint8_t note, uint8_t velosity) {
@@ -42,7 +42,7 @@ class SoundFont final {
     bool hasNotes() const;
     void setVolume(float v);
     void setPan(float p);
-    void mix(float* samples,size_t count);
+    void mix(float* samples,size_t count,float gain);
 
     Ticket      noteOn(uint8_t note, uint8_t velosity);
     static void noteOff(Ticket& t);
@@ -0,0 +1,90 @@
+#include "conditionscan.h"
+
+#include <unordered_set>
+
+ConditionScan::ConditionScan(const std::vector<Daedalus::PARSymbol>& sym, size_t self, size_t other,
+                             const std::vector<uint8_t>& safeExt)
+  :sym(sym), self(self), other(other), safeExt(safeExt) {
+  }
+
+bool ConditionScan::isLocal(size_t id) const {
+  // locals and arguments are named FUNC.VAR
+  return id<sym.size() && sym[id].name.find('.')!=std::string::npos;
+  }
+
+bool ConditionScan::exec(size_t address, const Fetch& code, std::vector<size_t>& globals) const {
+  std::vector<size_t>        stack = {address};
+  std::unordered_set<size_t> visited;
+  while(!stack.empty()) {
+    size_t pc = stack.back();
+    stack.pop_back();
+
+    // assignment target is the last pushed variable
+    bool localPushed = false;
+    while(visited.insert(pc).second) {
+      const auto op = code(pc);
+      if(op.op==Daedalus::EParOp_Ret)
+        break;
+
+      bool local = false;
+      switch(op.op) {
+        case Daedalus::EParOp_Jump:
+          pc = size_t(op.address);
+          continue;
+        case Daedalus::EParOp_JumpIf:
+          stack.push_back(size_t(op.address));
+          break;
+        case Daedalus::EParOp_Call:
+          stack.push_back(size_t(op.address));
+          break;
+        case Daedalus::EParOp_CallExternal:
+          if(size_t(op.symbol)>=safeExt.size() || safeExt[size_t(op.symbol)]==0)
+            return false;
+          break;
+        case Daedalus::EParOp_SetInstance:
+          // members of instance, that is neither self nor other
+          if(size_t(op.symbol)!=self && size_t(op.symbol)!=other)
+            return false;
+          break;
+        case Daedalus::EParOp_PushInstance:
+          local = isLocal(size_t(op.symbol));
+          break;
+        case Daedalus::EParOp_PushVar:
+        case Daedalus::EParOp_PushArrayVar: {
+          auto& s = sym[size_t(op.symbol)];
+          if((s.properties.elemProps.flags & Daedalus::EParFlag::EParFlag_ClassVar)!=0)
+            break;
+          if(isLocal(size_t(op.symbol))) {
+            local = true;
+            break;
+            }
+          if((s.properties.elemProps.flags & Daedalus::EParFlag::EParFlag_Const)!=0)
+            break;
+          if(s.properties.elemProps.type==Daedalus::EParType::EParType_Int ||
+             s.properties.elemProps.type==Daedalus::EParType::EParType_Float)
+            globals.push_back(size_t(op.symbol));
+          break;
+          }
+        case Daedalus::EParOp_Assign:
+        case Daedalus::EParOp_AssignAdd:
+        case Daedalus::EParOp_AssignSubtract:
+        case Daedalus::EParOp_AssignMultiply:
+        case Daedalus::EParOp_AssignDivide:
+        case Daedalus::EParOp_AssignString:
+        case Daedalus::EParOp_AssignStringRef:
+        case Daedalus::EParOp_AssignFunc:
+        case Daedalus::EParOp_AssignFloat:
+        case Daedalus::EParOp_AssignInstance:
+          // anything but local is written (globals, aivar's and other members of self/other): side effect
+          if(!localPushed)
+            return false;
+          break;
+        default:
+          break;
+        }
+      localPushed = local;
+      pc += op.opSize;
+      }
+    }
+  return true;
+  }
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <daedalus/DATFile.h>
+
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+// Static check of C_Info condition bytecode: walks every path of condition and functions it calls.
+// Result of condition can be cached, if only safe externals are reachable, every instance member is read
+// through self/other and nothing but locals is written.
+class ConditionScan final {
+  public:
+    using Fetch = std::function<Daedalus::PARStackOpCode(size_t pc)>;
+
+    ConditionScan(const std::vector<Daedalus::PARSymbol>& sym, size_t self, size_t other,
+                  const std::vector<uint8_t>& safeExt);
+
+    // int/float globals, read on the way, are appended to globals
+    bool exec(size_t address, const Fetch& code, std::vector<size_t>& globals) const;
+
+  private:
+    bool isLocal(size_t id) const;
+
+    const std::vector<Daedalus::PARSymbol>& sym;
+    const size_t                            self;
+    const size_t                            other;
+    const std::vector<uint8_t>&             safeExt;
+  };
@@ -5,14 +5,17 @@
 
 #include <fstream>
 #include <cctype>
+#include <cstring>
 
 #include "game/definitions/spelldefinitions.h"
 #include "game/serialize.h"
 #include "game/globaleffects.h"
+#include "game/conditionscan.h"
 #include "world/objects/npc.h"
 #include "world/objects/item.h"
 #include "world/objects/interactive.h"
 #include "graphics/visualfx.h"
+#include "utils/perfcounters.h"
 #include "gothic.h"
 
 using namespace Tempest;
@@ -90,217 +93,246 @@ GameScript::~GameScript() {
   vm.clearReferences(Daedalus::IC_Info);
   }
 
+void GameScript::bindExternal(const char* name, std::function<void(Daedalus::DaedalusVM&)> fn) {
+  const size_t id = symbols.find(name);
+  if(id!=size_t(-1) && isDialogSafe(name)) {
+    if(dlgSafeExt.size()<=id)
+      dlgSafeExt.resize(id+1,0);
+    dlgSafeExt[id] = 1;
+    }
+  vm.registerExternalFunction(name,[this,id,fn](Daedalus::DaedalusVM& vm){
+    ScriptProfiler::Scope prof(this->prof,ScriptProfiler::External,id);
+    fn(vm);
+    });
+  }
+
+bool GameScript::isDialogSafe(const char* name) {
+  // externals, that only read state covered by dialogStamp; every npc they touch is passed to dialogRead
+  static const char* safe[] = {
+    "hlp_isvalidnpc", "hlp_isvaliditem", "hlp_isitem", "hlp_getnpc", "hlp_getinstanceid",
+    "npc_knowsinfo", "npc_isplayer", "npc_isdead", "npc_hasitems",
+    "npc_gettalentskill", "npc_gettalentvalue",
+    "npc_hasequippedarmor", "npc_hasequippedweapon", "npc_hasequippedmeleeweapon", "npc_hasequippedrangedweapon",
+    };
+  for(auto i:safe)
+    if(std::strcmp(i,name)==0)
+      return true;
+  return false;
+  }
+
 void GameScript::initCommon() {
-  vm.registerExternalFunction("hlp_random",          [this](Daedalus::DaedalusVM& vm){ hlp_random(vm);         });
-  vm.registerExternalFunction("hlp_isvalidnpc",      [this](Daedalus::DaedalusVM& vm){ hlp_isvalidnpc(vm);     });
-  vm.registerExternalFunction("hlp_isvaliditem",     [this](Daedalus::DaedalusVM& vm){ hlp_isvaliditem(vm);    });
-  vm.registerExternalFunction("hlp_isitem",          [this](Daedalus::DaedalusVM& vm){ hlp_isitem(vm);         });
-  vm.registerExternalFunction("hlp_getnpc",          [this](Daedalus::DaedalusVM& vm){ hlp_getnpc(vm);         });
-  vm.registerExternalFunction("hlp_getinstanceid",   [this](Daedalus::DaedalusVM& vm){ hlp_getinstanceid(vm);  });
-
-  vm.registerExternalFunction("wld_insertnpc",       [this](Daedalus::DaedalusVM& vm){ wld_insertnpc(vm);  });
-  vm.registerExternalFunction("wld_insertitem",      [this](Daedalus::DaedalusVM& vm){ wld_insertitem(vm); });
-  vm.registerExternalFunction("wld_settime",         [this](Daedalus::DaedalusVM& vm){ wld_settime(vm);    });
-  vm.registerExternalFunction("wld_getday",          [this](Daedalus::DaedalusVM& vm){ wld_getday(vm);     });
-  vm.registerExternalFunction("wld_playeffect",      [this](Daedalus::DaedalusVM& vm){ wld_playeffect(vm); });
-  vm.registerExternalFunction("wld_stopeffect",      [this](Daedalus::DaedalusVM& vm){ wld_stopeffect(vm); });
-  vm.registerExternalFunction("wld_getplayerportalguild",
-                                                     [this](Daedalus::DaedalusVM& vm){ wld_getplayerportalguild(vm); });
-  vm.registerExternalFunction("wld_setguildattitude",[this](Daedalus::DaedalusVM& vm){ wld_setguildattitude(vm);     });
-  vm.registerExternalFunction("wld_getguildattitude",[this](Daedalus::DaedalusVM& vm){ wld_getguildattitude(vm);     });
-  vm.registerExternalFunction("wld_istime",          [this](Daedalus::DaedalusVM& vm){ wld_istime(vm);               });
-  vm.registerExternalFunction("wld_isfpavailable",   [this](Daedalus::DaedalusVM& vm){ wld_isfpavailable(vm);        });
-  vm.registerExternalFunction("wld_isnextfpavailable",
-                                                     [this](Daedalus::DaedalusVM& vm){ wld_isnextfpavailable(vm);    });
-  vm.registerExternalFunction("wld_ismobavailable",  [this](Daedalus::DaedalusVM& vm){ wld_ismobavailable(vm);       });
-  vm.registerExternalFunction("wld_setmobroutine",   [this](Daedalus::DaedalusVM& vm){ wld_setmobroutine(vm);        });
-  vm.registerExternalFunction("wld_getmobstate",     [this](Daedalus::DaedalusVM& vm){ wld_getmobstate(vm);          });
-  vm.registerExternalFunction("wld_assignroomtoguild",
-                                                     [this](Daedalus::DaedalusVM& vm){ wld_assignroomtoguild(vm);    });
-  vm.registerExternalFunction("wld_detectnpc",       [this](Daedalus::DaedalusVM& vm){ wld_detectnpc(vm);            });
-  vm.registerExternalFunction("wld_detectnpcex",     [this](Daedalus::DaedalusVM& vm){ wld_detectnpcex(vm);          });
-  vm.registerExternalFunction("wld_detectitem",      [this](Daedalus::DaedalusVM& vm){ wld_detectitem(vm);           });
-  vm.registerExternalFunction("wld_spawnnpcrange",   [this](Daedalus::DaedalusVM& vm){ wld_spawnnpcrange(vm);        });
-
-  vm.registerExternalFunction("mdl_setvisual",       [this](Daedalus::DaedalusVM& vm){ mdl_setvisual(vm);        });
-  vm.registerExternalFunction("mdl_setvisualbody",   [this](Daedalus::DaedalusVM& vm){ mdl_setvisualbody(vm);    });
-  vm.registerExternalFunction("mdl_setmodelfatness", [this](Daedalus::DaedalusVM& vm){ mdl_setmodelfatness(vm);  });
-  vm.registerExternalFunction("mdl_applyoverlaymds", [this](Daedalus::DaedalusVM& vm){ mdl_applyoverlaymds(vm);  });
-  vm.registerExternalFunction("mdl_applyoverlaymdstimed",
-                                                     [this](Daedalus::DaedalusVM& vm){ mdl_applyoverlaymdstimed(vm); });
-  vm.registerExternalFunction("mdl_removeoverlaymds",[this](Daedalus::DaedalusVM& vm){ mdl_removeoverlaymds(vm); });
-  vm.registerExternalFunction("mdl_setmodelscale",   [this](Daedalus::DaedalusVM& vm){ mdl_setmodelscale(vm);    });
-  vm.registerExternalFunction("mdl_startfaceani",    [this](Daedalus::DaedalusVM& vm){ mdl_startfaceani(vm);     });
-  vm.registerExternalFunction("mdl_applyrandomani",  [this](Daedalus::DaedalusVM& vm){ mdl_applyrandomani(vm);   });
-  vm.registerExternalFunction("mdl_applyrandomanifreq",
-                                                     [this](Daedalus::DaedalusVM& vm){ mdl_applyrandomanifreq(vm);});
-
-  vm.registerExternalFunction("npc_settofightmode",  [this](Daedalus::DaedalusVM& vm){ npc_settofightmode(vm);   });
-  vm.registerExternalFunction("npc_settofistmode",   [this](Daedalus::DaedalusVM& vm){ npc_settofistmode(vm);    });
-  vm.registerExternalFunction("npc_isinstate",       [this](Daedalus::DaedalusVM& vm){ npc_isinstate(vm);        });
-  vm.registerExternalFunction("npc_wasinstate",      [this](Daedalus::DaedalusVM& vm){ npc_wasinstate(vm);       });
-  vm.registerExternalFunction("npc_getdisttowp",     [this](Daedalus::DaedalusVM& vm){ npc_getdisttowp(vm);      });
-  vm.registerExternalFunction("npc_exchangeroutine", [this](Daedalus::DaedalusVM& vm){ npc_exchangeroutine(vm);  });
-  vm.registerExternalFunction("npc_isdead",          [this](Daedalus::DaedalusVM& vm){ npc_isdead(vm);           });
-  vm.registerExternalFunction("npc_knowsinfo",       [this](Daedalus::DaedalusVM& vm){ npc_knowsinfo(vm);        });
-  vm.registerExternalFunction("npc_settalentskill",  [this](Daedalus::DaedalusVM& vm){ npc_settalentskill(vm);   });
-  vm.registerExternalFunction("npc_gettalentskill",  [this](Daedalus::DaedalusVM& vm){ npc_gettalentskill(vm);   });
-  vm.registerExternalFunction("npc_settalentvalue",  [this](Daedalus::DaedalusVM& vm){ npc_settalentvalue(vm);   });
-  vm.registerExternalFunction("npc_gettalentvalue",  [this](Daedalus::DaedalusVM& vm){ npc_gettalentvalue(vm);   });
-  vm.registerExternalFunction("npc_setrefusetalk",   [this](Daedalus::DaedalusVM& vm){ npc_setrefusetalk(vm);    });
-  vm.registerExternalFunction("npc_refusetalk",      [this](Daedalus::DaedalusVM& vm){ npc_refusetalk(vm);       });
-  vm.registerExternalFunction("npc_hasitems",        [this](Daedalus::DaedalusVM& vm){ npc_hasitems(vm);         });
-  vm.registerExternalFunction("npc_getinvitem",      [this](Daedalus::DaedalusVM& vm){ npc_getinvitem(vm);       });
-  vm.registerExternalFunction("npc_removeinvitem",   [this](Daedalus::DaedalusVM& vm){ npc_removeinvitem(vm);    });
-  vm.registerExternalFunction("npc_removeinvitems",  [this](Daedalus::DaedalusVM& vm){ npc_removeinvitems(vm);   });
-  vm.registerExternalFunction("npc_getbodystate",    [this](Daedalus::DaedalusVM& vm){ npc_getbodystate(vm);     });
-  vm.registerExternalFunction("npc_getlookattarget", [this](Daedalus::DaedalusVM& vm){ npc_getlookattarget(vm);  });
-  vm.registerExternalFunction("npc_getdisttonpc",    [this](Daedalus::DaedalusVM& vm){ npc_getdisttonpc(vm);     });
-  vm.registerExternalFunction("npc_hasequippedarmor",[this](Daedalus::DaedalusVM& vm){ npc_hasequippedarmor(vm); });
-  vm.registerExternalFunction("npc_setperctime",     [this](Daedalus::DaedalusVM& vm){ npc_setperctime(vm);      });
-  vm.registerExternalFunction("npc_percenable",      [this](Daedalus::DaedalusVM& vm){ npc_percenable(vm);       });
-  vm.registerExternalFunction("npc_percdisable",     [this](Daedalus::DaedalusVM& vm){ npc_percdisable(vm);      });
-  vm.registerExternalFunction("npc_getnearestwp",    [this](Daedalus::DaedalusVM& vm){ npc_getnearestwp(vm);     });
-  vm.registerExternalFunction("npc_clearaiqueue",    [this](Daedalus::DaedalusVM& vm){ npc_clearaiqueue(vm);     });
-  vm.registerExternalFunction("npc_isplayer",        [this](Daedalus::DaedalusVM& vm){ npc_isplayer(vm);         });
-  vm.registerExternalFunction("npc_getstatetime",    [this](Daedalus::DaedalusVM& vm){ npc_getstatetime(vm);     });
-  vm.registerExternalFunction("npc_setstatetime",    [this](Daedalus::DaedalusVM& vm){ npc_setstatetime(vm);     });
-  vm.registerExternalFunction("npc_changeattribute", [this](Daedalus::DaedalusVM& vm){ npc_changeattribute(vm);  });
-  vm.registerExternalFunction("npc_isonfp",          [this](Daedalus::DaedalusVM& vm){ npc_isonfp(vm);           });
-  vm.registerExternalFunction("npc_getheighttonpc",  [this](Daedalus::DaedalusVM& vm){ npc_getheighttonpc(vm);   });
-  vm.registerExternalFunction("npc_getequippedmeleeweapon",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_getequippedmeleeweapon(vm); });
-  vm.registerExternalFunction("npc_getequippedrangedweapon",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_getequippedrangedweapon(vm); });
-  vm.registerExternalFunction("npc_getequippedarmor",[this](Daedalus::DaedalusVM& vm){ npc_getequippedarmor(vm); });
-  vm.registerExternalFunction("npc_canseenpc",       [this](Daedalus::DaedalusVM& vm){ npc_canseenpc(vm);        });
-  vm.registerExternalFunction("npc_hasequippedweapon",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_hasequippedweapon(vm); });
-  vm.registerExternalFunction("npc_hasequippedmeleeweapon",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_hasequippedmeleeweapon(vm); });
-  vm.registerExternalFunction("npc_hasequippedrangedweapon",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_hasequippedrangedweapon(vm); });
-  vm.registerExternalFunction("npc_getactivespell",  [this](Daedalus::DaedalusVM& vm){ npc_getactivespell(vm);   });
-  vm.registerExternalFunction("npc_getactivespellisscroll",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_getactivespellisscroll(vm); });
-  vm.registerExternalFunction("npc_getactivespellcat",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_getactivespellcat(vm); });
-  vm.registerExternalFunction("npc_setactivespellinfo",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_setactivespellinfo(vm); });
-  vm.registerExternalFunction("npc_getactivespelllevel",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_getactivespelllevel(vm); });
-
-  vm.registerExternalFunction("npc_canseenpcfreelos",[this](Daedalus::DaedalusVM& vm){ npc_canseenpcfreelos(vm); });
-  vm.registerExternalFunction("npc_isinfightmode",   [this](Daedalus::DaedalusVM& vm){ npc_isinfightmode(vm);    });
-  vm.registerExternalFunction("npc_settarget",       [this](Daedalus::DaedalusVM& vm){ npc_settarget(vm);        });
-  vm.registerExternalFunction("npc_gettarget",       [this](Daedalus::DaedalusVM& vm){ npc_gettarget(vm);        });
-  vm.registerExternalFunction("npc_getnexttarget",   [this](Daedalus::DaedalusVM& vm){ npc_getnexttarget(vm);    });
-  vm.registerExternalFunction("npc_sendpassiveperc", [this](Daedalus::DaedalusVM& vm){ npc_sendpassiveperc(vm);  });
-  vm.registerExternalFunction("npc_checkinfo",       [this](Daedalus::DaedalusVM& vm){ npc_checkinfo(vm);        });
-  vm.registerExternalFunction("npc_getportalguild",  [this](Daedalus::DaedalusVM& vm){ npc_getportalguild(vm);   });
-  vm.registerExternalFunction("npc_isinplayersroom", [this](Daedalus::DaedalusVM& vm){ npc_isinplayersroom(vm);  });
-  vm.registerExternalFunction("npc_getreadiedweapon",[this](Daedalus::DaedalusVM& vm){ npc_getreadiedweapon(vm); });
-  vm.registerExternalFunction("npc_hasreadiedmeleeweapon",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_hasreadiedmeleeweapon(vm); });
-  vm.registerExternalFunction("npc_isdrawingspell",  [this](Daedalus::DaedalusVM& vm){ npc_isdrawingspell(vm);   });
-  vm.registerExternalFunction("npc_isdrawingweapon", [this](Daedalus::DaedalusVM& vm){ npc_isdrawingweapon(vm);  });
-  vm.registerExternalFunction("npc_perceiveall",     [this](Daedalus::DaedalusVM& vm){ npc_perceiveall(vm);      });
-  vm.registerExternalFunction("npc_stopani",         [this](Daedalus::DaedalusVM& vm){ npc_stopani(vm);          });
-  vm.registerExternalFunction("npc_settrueguild",    [this](Daedalus::DaedalusVM& vm){ npc_settrueguild(vm);     });
-  vm.registerExternalFunction("npc_gettrueguild",    [this](Daedalus::DaedalusVM& vm){ npc_gettrueguild(vm);     });
-  vm.registerExternalFunction("npc_clearinventory",  [this](Daedalus::DaedalusVM& vm){ npc_clearinventory(vm);   });
-  vm.registerExternalFunction("npc_getattitude",     [this](Daedalus::DaedalusVM& vm){ npc_getattitude(vm);      });
-  vm.registerExternalFunction("npc_getpermattitude", [this](Daedalus::DaedalusVM& vm){ npc_getpermattitude(vm);  });
-  vm.registerExternalFunction("npc_setattitude",     [this](Daedalus::DaedalusVM& vm){ npc_setattitude(vm);      });
-  vm.registerExternalFunction("npc_settempattitude", [this](Daedalus::DaedalusVM& vm){ npc_settempattitude(vm);  });
-  vm.registerExternalFunction("npc_hasbodyflag",     [this](Daedalus::DaedalusVM& vm){ npc_hasbodyflag(vm);      });
-  vm.registerExternalFunction("npc_getlasthitspellid",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_getlasthitspellid(vm);});
-  vm.registerExternalFunction("npc_getlasthitspellcat",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_getlasthitspellcat(vm);});
-  vm.registerExternalFunction("npc_playani",         [this](Daedalus::DaedalusVM& vm){ npc_playani(vm);          });
-
-  vm.registerExternalFunction("npc_isdetectedmobownedbynpc",
-                                                     [this](Daedalus::DaedalusVM& vm){ npc_isdetectedmobownedbynpc(vm);});
-  vm.registerExternalFunction("npc_getdetectedmob",  [this](Daedalus::DaedalusVM& vm){ npc_getdetectedmob(vm);   });
-  vm.registerExternalFunction("npc_ownedbynpc",      [this](Daedalus::DaedalusVM& vm){ npc_ownedbynpc(vm);       });
-  vm.registerExternalFunction("npc_canseesource",    [this](Daedalus::DaedalusVM& vm){ npc_canseesource(vm);     });
-  vm.registerExternalFunction("npc_getdisttoitem",   [this](Daedalus::DaedalusVM& vm){ npc_getdisttoitem(vm);    });
-  vm.registerExternalFunction("npc_getheighttoitem", [this](Daedalus::DaedalusVM& vm){ npc_getheighttoitem(vm);  });
-
-  vm.registerExternalFunction("ai_output",           [this](Daedalus::DaedalusVM& vm){ ai_output(vm);            });
-  vm.registerExternalFunction("ai_stopprocessinfos", [this](Daedalus::DaedalusVM& vm){ ai_stopprocessinfos(vm);  });
-  vm.registerExternalFunction("ai_processinfos",     [this](Daedalus::DaedalusVM& vm){ ai_processinfos(vm);      });
-  vm.registerExternalFunction("ai_standup",          [this](Daedalus::DaedalusVM& vm){ ai_standup(vm);           });
-  vm.registerExternalFunction("ai_standupquick",     [this](Daedalus::DaedalusVM& vm){ ai_standupquick(vm);      });
-  vm.registerExternalFunction("ai_continueroutine",  [this](Daedalus::DaedalusVM& vm){ ai_continueroutine(vm);   });
-  vm.registerExternalFunction("ai_stoplookat",       [this](Daedalus::DaedalusVM& vm){ ai_stoplookat(vm);        });
-  vm.registerExternalFunction("ai_lookatnpc",        [this](Daedalus::DaedalusVM& vm){ ai_lookatnpc(vm);         });
-  vm.registerExternalFunction("ai_removeweapon",     [this](Daedalus::DaedalusVM& vm){ ai_removeweapon(vm);      });
-  vm.registerExternalFunction("ai_turntonpc",        [this](Daedalus::DaedalusVM& vm){ ai_turntonpc(vm);         });
-  vm.registerExternalFunction("ai_outputsvm",        [this](Daedalus::DaedalusVM& vm){ ai_outputsvm(vm);         });
-  vm.registerExternalFunction("ai_outputsvm_overlay",[this](Daedalus::DaedalusVM& vm){ ai_outputsvm_overlay(vm); });
-  vm.registerExternalFunction("ai_startstate",       [this](Daedalus::DaedalusVM& vm){ ai_startstate(vm);        });
-  vm.registerExternalFunction("ai_playani",          [this](Daedalus::DaedalusVM& vm){ ai_playani(vm);           });
-  vm.registerExternalFunction("ai_setwalkmode",      [this](Daedalus::DaedalusVM& vm){ ai_setwalkmode(vm);       });
-  vm.registerExternalFunction("ai_wait",             [this](Daedalus::DaedalusVM& vm){ ai_wait(vm);              });
-  vm.registerExternalFunction("ai_waitms",           [this](Daedalus::DaedalusVM& vm){ ai_waitms(vm);            });
-  vm.registerExternalFunction("ai_aligntowp",        [this](Daedalus::DaedalusVM& vm){ ai_aligntowp(vm);         });
-  vm.registerExternalFunction("ai_gotowp",           [this](Daedalus::DaedalusVM& vm){ ai_gotowp(vm);            });
-  vm.registerExternalFunction("ai_gotofp",           [this](Daedalus::DaedalusVM& vm){ ai_gotofp(vm);            });
-  vm.registerExternalFunction("ai_playanibs",        [this](Daedalus::DaedalusVM& vm){ ai_playanibs(vm);         });
-  vm.registerExternalFunction("ai_equiparmor",       [this](Daedalus::DaedalusVM& vm){ ai_equiparmor(vm);        });
-  vm.registerExternalFunction("ai_equipbestarmor",   [this](Daedalus::DaedalusVM& vm){ ai_equipbestarmor(vm);    });
-  vm.registerExternalFunction("ai_equipbestmeleeweapon",
-                                                     [this](Daedalus::DaedalusVM& vm){ ai_equipbestmeleeweapon(vm);  });
-  vm.registerExternalFunction("ai_equipbestrangedweapon",
-                                                     [this](Daedalus::DaedalusVM& vm){ ai_equipbestrangedweapon(vm); });
-  vm.registerExternalFunction("ai_usemob",           [this](Daedalus::DaedalusVM& vm){ ai_usemob(vm);            });
-  vm.registerExternalFunction("ai_teleport",         [this](Daedalus::DaedalusVM& vm){ ai_teleport(vm);          });
-  vm.registerExternalFunction("ai_stoppointat",      [this](Daedalus::DaedalusVM& vm){ ai_stoppointat(vm);       });
-  vm.registerExternalFunction("ai_drawweapon",       [this](Daedalus::DaedalusVM& vm){ ai_drawweapon(vm);  });
-  vm.registerExternalFunction("ai_readymeleeweapon", [this](Daedalus::DaedalusVM& vm){ ai_readymeleeweapon(vm);  });
-  vm.registerExternalFunction("ai_readyrangedweapon",[this](Daedalus::DaedalusVM& vm){ ai_readyrangedweapon(vm); });
-  vm.registerExternalFunction("ai_readyspell",       [this](Daedalus::DaedalusVM& vm){ ai_readyspell(vm);        });
-  vm.registerExternalFunction("ai_attack",           [this](Daedalus::DaedalusVM& vm){ ai_atack(vm);             });
-  vm.registerExternalFunction("ai_flee",             [this](Daedalus::DaedalusVM& vm){ ai_flee(vm);              });
-  vm.registerExternalFunction("ai_dodge",            [this](Daedalus::DaedalusVM& vm){ ai_dodge(vm);             });
-  vm.registerExternalFunction("ai_unequipweapons",   [this](Daedalus::DaedalusVM& vm){ ai_unequipweapons(vm);    });
-  vm.registerExternalFunction("ai_unequiparmor",     [this](Daedalus::DaedalusVM& vm){ ai_unequiparmor(vm);      });
-  vm.registerExternalFunction("ai_gotonpc",          [this](Daedalus::DaedalusVM& vm){ ai_gotonpc(vm);           });
-  vm.registerExternalFunction("ai_gotonextfp",       [this](Daedalus::DaedalusVM& vm){ ai_gotonextfp(vm);        });
-  vm.registerExternalFunction("ai_aligntofp",        [this](Daedalus::DaedalusVM& vm){ ai_aligntofp(vm);         });
-  vm.registerExternalFunction("ai_useitem",          [this](Daedalus::DaedalusVM& vm){ ai_useitem(vm);           });
-  vm.registerExternalFunction("ai_useitemtostate",   [this](Daedalus::DaedalusVM& vm){ ai_useitemtostate(vm);    });
-  vm.registerExternalFunction("ai_setnpcstostate",   [this](Daedalus::DaedalusVM& vm){ ai_setnpcstostate(vm);    });
-  vm.registerExternalFunction("ai_finishingmove",    [this](Daedalus::DaedalusVM& vm){ ai_finishingmove(vm);     });
-  vm.registerExternalFunction("ai_takeitem",         [this](Daedalus::DaedalusVM& vm){ ai_takeitem(vm);          });
-  vm.registerExternalFunction("ai_gotoitem",         [this](Daedalus::DaedalusVM& vm){ ai_gotoitem(vm);          });
-
-  vm.registerExternalFunction("mob_hasitems",        [this](Daedalus::DaedalusVM& vm){ mob_hasitems(vm);         });
-
-  vm.registerExternalFunction("ta_min",              [this](Daedalus::DaedalusVM& vm){ ta_min(vm);               });
-
-  vm.registerExternalFunction("log_createtopic",     [this](Daedalus::DaedalusVM& vm){ log_createtopic(vm);      });
-  vm.registerExternalFunction("log_settopicstatus",  [this](Daedalus::DaedalusVM& vm){ log_settopicstatus(vm);   });
-  vm.registerExternalFunction("log_addentry",        [this](Daedalus::DaedalusVM& vm){ log_addentry(vm);         });
-
-  vm.registerExternalFunction("equipitem",           [this](Daedalus::DaedalusVM& vm){ equipitem(vm);            });
-  vm.registerExternalFunction("createinvitem",       [this](Daedalus::DaedalusVM& vm){ createinvitem(vm);        });
-  vm.registerExternalFunction("createinvitems",      [this](Daedalus::DaedalusVM& vm){ createinvitems(vm);       });
-
-  vm.registerExternalFunction("info_addchoice",      [this](Daedalus::DaedalusVM& vm){ info_addchoice(vm);       });
-  vm.registerExternalFunction("info_clearchoices",   [this](Daedalus::DaedalusVM& vm){ info_clearchoices(vm);    });
-  vm.registerExternalFunction("infomanager_hasfinished",
-                                                     [this](Daedalus::DaedalusVM& vm){ infomanager_hasfinished(vm); });
-
-  vm.registerExternalFunction("snd_play",            [this](Daedalus::DaedalusVM& vm){ snd_play(vm);             });
-  vm.registerExternalFunction("snd_play3d",          [this](Daedalus::DaedalusVM& vm){ snd_play3d(vm);           });
-
-  vm.registerExternalFunction("game_initgerman",     [this](Daedalus::DaedalusVM& vm){ game_initgerman(vm);      });
-  vm.registerExternalFunction("game_initenglish",    [this](Daedalus::DaedalusVM& vm){ game_initenglish(vm);     });
-
-  vm.registerExternalFunction("exitsession",         [this](Daedalus::DaedalusVM& vm){ exitsession(vm);          });
+  symbols.build(vm.getDATFile());
+
+  bindExternal("hlp_random",          [this](Daedalus::DaedalusVM& vm){ hlp_random(vm);         });
+  bindExternal("hlp_isvalidnpc",      [this](Daedalus::DaedalusVM& vm){ hlp_isvalidnpc(vm);     });
+  bindExternal("hlp_isvaliditem",     [this](Daedalus::DaedalusVM& vm){ hlp_isvaliditem(vm);    });
+  bindExternal("hlp_isitem",          [this](Daedalus::DaedalusVM& vm){ hlp_isitem(vm);         });
+  bindExternal("hlp_getnpc",          [this](Daedalus::DaedalusVM& vm){ hlp_getnpc(vm);         });
+  bindExternal("hlp_getinstanceid",   [this](Daedalus::DaedalusVM& vm){ hlp_getinstanceid(vm);  });
+
+  bindExternal("wld_insertnpc",       [this](Daedalus::DaedalusVM& vm){ wld_insertnpc(vm);  });
+  bindExternal("wld_insertitem",      [this](Daedalus::DaedalusVM& vm){ wld_insertitem(vm); });
+  bindExternal("wld_settime",         [this](Daedalus::DaedalusVM& vm){ wld_settime(vm);    });
+  bindExternal("wld_getday",          [this](Daedalus::DaedalusVM& vm){ wld_getday(vm);     });
+  bindExternal("wld_playeffect",      [this](Daedalus::DaedalusVM& vm){ wld_playeffect(vm); });
+  bindExternal("wld_stopeffect",      [this](Daedalus::DaedalusVM& vm){ wld_stopeffect(vm); });
+  bindExternal("wld_getplayerportalguild",
+                                      [this](Daedalus::DaedalusVM& vm){ wld_getplayerportalguild(vm); });
+  bindExternal("wld_setguildattitude",[this](Daedalus::DaedalusVM& vm){ wld_setguildattitude(vm);     });
+  bindExternal("wld_getguildattitude",[this](Daedalus::DaedalusVM& vm){ wld_getguildattitude(vm);     });
+  bindExternal("wld_istime",          [this](Daedalus::DaedalusVM& vm){ wld_istime(vm);               });
+  bindExternal("wld_isfpavailable",   [this](Daedalus::DaedalusVM& vm){ wld_isfpavailable(vm);        });
+  bindExternal("wld_isnextfpavailable",
+                                      [this](Daedalus::DaedalusVM& vm){ wld_isnextfpavailable(vm);    });
+  bindExternal("wld_ismobavailable",  [this](Daedalus::DaedalusVM& vm){ wld_ismobavailable(vm);       });
+  bindExternal("wld_setmobroutine",   [this](Daedalus::DaedalusVM& vm){ wld_setmobroutine(vm);        });
+  bindExternal("wld_getmobstate",     [this](Daedalus::DaedalusVM& vm){ wld_getmobstate(vm);          });
+  bindExternal("wld_assignroomtoguild",
+                                      [this](Daedalus::DaedalusVM& vm){ wld_assignroomtoguild(vm);    });
+  bindExternal("wld_detectnpc",       [this](Daedalus::DaedalusVM& vm){ wld_detectnpc(vm);            });
+  bindExternal("wld_detectnpcex",     [this](Daedalus::DaedalusVM& vm){ wld_detectnpcex(vm);          });
+  bindExternal("wld_detectitem",      [this](Daedalus::DaedalusVM& vm){ wld_detectitem(vm);           });
+  bindExternal("wld_spawnnpcrange",   [this](Daedalus::DaedalusVM& vm){ wld_spawnnpcrange(vm);        });
+
+  bindExternal("mdl_setvisual",       [this](Daedalus::DaedalusVM& vm){ mdl_setvisual(vm);        });
+  bindExternal("mdl_setvisualbody",   [this](Daedalus::DaedalusVM& vm){ mdl_setvisualbody(vm);    });
+  bindExternal("mdl_setmodelfatness", [this](Daedalus::DaedalusVM& vm){ mdl_setmodelfatness(vm);  });
+  bindExternal("mdl_applyoverlaymds", [this](Daedalus::DaedalusVM& vm){ mdl_applyoverlaymds(vm);  });
+  bindExternal("mdl_applyoverlaymdstimed",
+                                      [this](Daedalus::DaedalusVM& vm){ mdl_applyoverlaymdstimed(vm); });
+  bindExternal("mdl_removeoverlaymds",[this](Daedalus::DaedalusVM& vm){ mdl_removeoverlaymds(vm); });
+  bindExternal("mdl_setmodelscale",   [this](Daedalus::DaedalusVM& vm){ mdl_setmodelscale(vm);    });
+  bindExternal("mdl_startfaceani",    [this](Daedalus::DaedalusVM& vm){ mdl_startfaceani(vm);     });
+  bindExternal("mdl_applyrandomani",  [this](Daedalus::DaedalusVM& vm){ mdl_applyrandomani(vm);   });
+  bindExternal("mdl_applyrandomanifreq",
+                                      [this](Daedalus::DaedalusVM& vm){ mdl_applyrandomanifreq(vm);});
+
+  bindExternal("npc_settofightmode",  [this](Daedalus::DaedalusVM& vm){ npc_settofightmode(vm);   });
+  bindExternal("npc_settofistmode",   [this](Daedalus::DaedalusVM& vm){ npc_settofistmode(vm);    });
+  bindExternal("npc_isinstate",       [this](Daedalus::DaedalusVM& vm){ npc_isinstate(vm);        });
+  bindExternal("npc_wasinstate",      [this](Daedalus::DaedalusVM& vm){ npc_wasinstate(vm);       });
+  bindExternal("npc_getdisttowp",     [this](Daedalus::DaedalusVM& vm){ npc_getdisttowp(vm);      });
+  bindExternal("npc_exchangeroutine", [this](Daedalus::DaedalusVM& vm){ npc_exchangeroutine(vm);  });
+  bindExternal("npc_isdead",          [this](Daedalus::DaedalusVM& vm){ npc_isdead(vm);           });
+  bindExternal("npc_knowsinfo",       [this](Daedalus::DaedalusVM& vm){ npc_knowsinfo(vm);        });
+  bindExternal("npc_settalentskill",  [this](Daedalus::DaedalusVM& vm){ npc_settalentskill(vm);   });
+  bindExternal("npc_gettalentskill",  [this](Daedalus::DaedalusVM& vm){ npc_gettalentskill(vm);   });
+  bindExternal("npc_settalentvalue",  [this](Daedalus::DaedalusVM& vm){ npc_settalentvalue(vm);   });
+  bindExternal("npc_gettalentvalue",  [this](Daedalus::DaedalusVM& vm){ npc_gettalentvalue(vm);   });
+  bindExternal("npc_setrefusetalk",   [this](Daedalus::DaedalusVM& vm){ npc_setrefusetalk(vm);    });
+  bindExternal("npc_refusetalk",      [this](Daedalus::DaedalusVM& vm){ npc_refusetalk(vm);       });
+  bindExternal("npc_hasitems",        [this](Daedalus::DaedalusVM& vm){ npc_hasitems(vm);         });
+  bindExternal("npc_getinvitem",      [this](Daedalus::DaedalusVM& vm){ npc_getinvitem(vm);       });
+  bindExternal("npc_removeinvitem",   [this](Daedalus::DaedalusVM& vm){ npc_removeinvitem(vm);    });
+  bindExternal("npc_removeinvitems",  [this](Daedalus::DaedalusVM& vm){ npc_removeinvitems(vm);   });
+  bindExternal("npc_getbodystate",    [this](Daedalus::DaedalusVM& vm){ npc_getbodystate(vm);     });
+  bindExternal("npc_getlookattarget", [this](Daedalus::DaedalusVM& vm){ npc_getlookattarget(vm);  });
+  bindExternal("npc_getdisttonpc",    [this](Daedalus::DaedalusVM& vm){ npc_getdisttonpc(vm);     });
+  bindExternal("npc_hasequippedarmor",[this](Daedalus::DaedalusVM& vm){ npc_hasequippedarmor(vm); });
+  bindExternal("npc_setperctime",     [this](Daedalus::DaedalusVM& vm){ npc_setperctime(vm);      });
+  bindExternal("npc_percenable",      [this](Daedalus::DaedalusVM& vm){ npc_percenable(vm);       });
+  bindExternal("npc_percdisable",     [this](Daedalus::DaedalusVM& vm){ npc_percdisable(vm);      });
+  bindExternal("npc_getnearestwp",    [this](Daedalus::DaedalusVM& vm){ npc_getnearestwp(vm);     });
+  bindExternal("npc_clearaiqueue",    [this](Daedalus::DaedalusVM& vm){ npc_clearaiqueue(vm);     });
+  bindExternal("npc_isplayer",        [this](Daedalus::DaedalusVM& vm){ npc_isplayer(vm);         });
+  bindExternal("npc_getstatetime",    [this](Daedalus::DaedalusVM& vm){ npc_getstatetime(vm);     });
+  bindExternal("npc_setstatetime",    [this](Daedalus::DaedalusVM& vm){ npc_setstatetime(vm);     });
+  bindExternal("npc_changeattribute", [this](Daedalus::DaedalusVM& vm){ npc_changeattribute(vm);  });
+  bindExternal("npc_isonfp",          [this](Daedalus::DaedalusVM& vm){ npc_isonfp(vm);           });
+  bindExternal("npc_getheighttonpc",  [this](Daedalus::DaedalusVM& vm){ npc_getheighttonpc(vm);   });
+  bindExternal("npc_getequippedmeleeweapon",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_getequippedmeleeweapon(vm); });
+  bindExternal("npc_getequippedrangedweapon",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_getequippedrangedweapon(vm); });
+  bindExternal("npc_getequippedarmor",[this](Daedalus::DaedalusVM& vm){ npc_getequippedarmor(vm); });
+  bindExternal("npc_canseenpc",       [this](Daedalus::DaedalusVM& vm){ npc_canseenpc(vm);        });
+  bindExternal("npc_hasequippedweapon",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_hasequippedweapon(vm); });
+  bindExternal("npc_hasequippedmeleeweapon",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_hasequippedmeleeweapon(vm); });
+  bindExternal("npc_hasequippedrangedweapon",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_hasequippedrangedweapon(vm); });
+  bindExternal("npc_getactivespell",  [this](Daedalus::DaedalusVM& vm){ npc_getactivespell(vm);   });
+  bindExternal("npc_getactivespellisscroll",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_getactivespellisscroll(vm); });
+  bindExternal("npc_getactivespellcat",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_getactivespellcat(vm); });
+  bindExternal("npc_setactivespellinfo",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_setactivespellinfo(vm); });
+  bindExternal("npc_getactivespelllevel",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_getactivespelllevel(vm); });
+
+  bindExternal("npc_canseenpcfreelos",[this](Daedalus::DaedalusVM& vm){ npc_canseenpcfreelos(vm); });
+  bindExternal("npc_isinfightmode",   [this](Daedalus::DaedalusVM& vm){ npc_isinfightmode(vm);    });
+  bindExternal("npc_settarget",       [this](Daedalus::DaedalusVM& vm){ npc_settarget(vm);        });
+  bindExternal("npc_gettarget",       [this](Daedalus::DaedalusVM& vm){ npc_gettarget(vm);        });
+  bindExternal("npc_getnexttarget",   [this](Daedalus::DaedalusVM& vm){ npc_getnexttarget(vm);    });
+  bindExternal("npc_sendpassiveperc", [this](Daedalus::DaedalusVM& vm){ npc_sendpassiveperc(vm);  });
+  bindExternal("npc_checkinfo",       [this](Daedalus::DaedalusVM& vm){ npc_checkinfo(vm);        });
+  bindExternal("npc_getportalguild",  [this](Daedalus::DaedalusVM& vm){ npc_getportalguild(vm);   });
+  bindExternal("npc_isinplayersroom", [this](Daedalus::DaedalusVM& vm){ npc_isinplayersroom(vm);  });
+  bindExternal("npc_getreadiedweapon",[this](Daedalus::DaedalusVM& vm){ npc_getreadiedweapon(vm); });
+  bindExternal("npc_hasreadiedmeleeweapon",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_hasreadiedmeleeweapon(vm); });
+  bindExternal("npc_isdrawingspell",  [this](Daedalus::DaedalusVM& vm){ npc_isdrawingspell(vm);   });
+  bindExternal("npc_isdrawingweapon", [this](Daedalus::DaedalusVM& vm){ npc_isdrawingweapon(vm);  });
+  bindExternal("npc_perceiveall",     [this](Daedalus::DaedalusVM& vm){ npc_perceiveall(vm);      });
+  bindExternal("npc_stopani",         [this](Daedalus::DaedalusVM& vm){ npc_stopani(vm);          });
+  bindExternal("npc_settrueguild",    [this](Daedalus::DaedalusVM& vm){ npc_settrueguild(vm);     });
+  bindExternal("npc_gettrueguild",    [this](Daedalus::DaedalusVM& vm){ npc_gettrueguild(vm);     });
+  bindExternal("npc_clearinventory",  [this](Daedalus::DaedalusVM& vm){ npc_clearinventory(vm);   });
+  bindExternal("npc_getattitude",     [this](Daedalus::DaedalusVM& vm){ npc_getattitude(vm);      });
+  bindExternal("npc_getpermattitude", [this](Daedalus::DaedalusVM& vm){ npc_getpermattitude(vm);  });
+  bindExternal("npc_setattitude",     [this](Daedalus::DaedalusVM& vm){ npc_setattitude(vm);      });
+  bindExternal("npc_settempattitude", [this](Daedalus::DaedalusVM& vm){ npc_settempattitude(vm);  });
+  bindExternal("npc_hasbodyflag",     [this](Daedalus::DaedalusVM& vm){ npc_hasbodyflag(vm);      });
+  bindExternal("npc_getlasthitspellid",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_getlasthitspellid(vm);});
+  bindExternal("npc_getlasthitspellcat",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_getlasthitspellcat(vm);});
+  bindExternal("npc_playani",         [this](Daedalus::DaedalusVM& vm){ npc_playani(vm);          });
+
+  bindExternal("npc_isdetectedmobownedbynpc",
+                                      [this](Daedalus::DaedalusVM& vm){ npc_isdetectedmobownedbynpc(vm);});
+  bindExternal("npc_getdetectedmob",  [this](Daedalus::DaedalusVM& vm){ npc_getdetectedmob(vm);   });
+  bindExternal("npc_ownedbynpc",      [this](Daedalus::DaedalusVM& vm){ npc_ownedbynpc(vm);       });
+  bindExternal("npc_canseesource",    [this](Daedalus::DaedalusVM& vm){ npc_canseesource(vm);     });
+  bindExternal("npc_getdisttoitem",   [this](Daedalus::DaedalusVM& vm){ npc_getdisttoitem(vm);    });
+  bindExternal("npc_getheighttoitem", [this](Daedalus::DaedalusVM& vm){ npc_getheighttoitem(vm);  });
+
+  bindExternal("ai_output",           [this](Daedalus::DaedalusVM& vm){ ai_output(vm);            });
+  bindExternal("ai_stopprocessinfos", [this](Daedalus::DaedalusVM& vm){ ai_stopprocessinfos(vm);  });
+  bindExternal("ai_processinfos",     [this](Daedalus::DaedalusVM& vm){ ai_processinfos(vm);      });
+  bindExternal("ai_standup",          [this](Daedalus::DaedalusVM& vm){ ai_standup(vm);           });
+  bindExternal("ai_standupquick",     [this](Daedalus::DaedalusVM& vm){ ai_standupquick(vm);      });
+  bindExternal("ai_continueroutine",  [this](Daedalus::DaedalusVM& vm){ ai_continueroutine(vm);   });
+  bindExternal("ai_stoplookat",       [this](Daedalus::DaedalusVM& vm){ ai_stoplookat(vm);        });
+  bindExternal("ai_lookatnpc",        [this](Daedalus::DaedalusVM& vm){ ai_lookatnpc(vm);         });
+  bindExternal("ai_removeweapon",     [this](Daedalus::DaedalusVM& vm){ ai_removeweapon(vm);      });
+  bindExternal("ai_turntonpc",        [this](Daedalus::DaedalusVM& vm){ ai_turntonpc(vm);         });
+  bindExternal("ai_outputsvm",        [this](Daedalus::DaedalusVM& vm){ ai_outputsvm(vm);         });
+  bindExternal("ai_outputsvm_overlay",[this](Daedalus::DaedalusVM& vm){ ai_outputsvm_overlay(vm); });
+  bindExternal("ai_startstate",       [this](Daedalus::DaedalusVM& vm){ ai_startstate(vm);        });
+  bindExternal("ai_playani",          [this](Daedalus::DaedalusVM& vm){ ai_playani(vm);           });
+  bindExternal("ai_setwalkmode",      [this](Daedalus::DaedalusVM& vm){ ai_setwalkmode(vm);       });
+  bindExternal("ai_wait",             [this](Daedalus::DaedalusVM& vm){ ai_wait(vm);              });
+  bindExternal("ai_waitms",           [this](Daedalus::DaedalusVM& vm){ ai_waitms(vm);            });
+  bindExternal("ai_aligntowp",        [this](Daedalus::DaedalusVM& vm){ ai_aligntowp(vm);         });
+  bindExternal("ai_gotowp",           [this](Daedalus::DaedalusVM& vm){ ai_gotowp(vm);            });
+  bindExternal("ai_gotofp",           [this](Daedalus::DaedalusVM& vm){ ai_gotofp(vm);            });
+  bindExternal("ai_playanibs",        [this](Daedalus::DaedalusVM& vm){ ai_playanibs(vm);         });
+  bindExternal("ai_equiparmor",       [this](Daedalus::DaedalusVM& vm){ ai_equiparmor(vm);        });
+  bindExternal("ai_equipbestarmor",   [this](Daedalus::DaedalusVM& vm){ ai_equipbestarmor(vm);    });
+  bindExternal("ai_equipbestmeleeweapon",
+                                      [this](Daedalus::DaedalusVM& vm){ ai_equipbestmeleeweapon(vm);  });
+  bindExternal("ai_equipbestrangedweapon",
+                                      [this](Daedalus::DaedalusVM& vm){ ai_equipbestrangedweapon(vm); });
+  bindExternal("ai_usemob",           [this](Daedalus::DaedalusVM& vm){ ai_usemob(vm);            });
+  bindExternal("ai_teleport",         [this](Daedalus::DaedalusVM& vm){ ai_teleport(vm);          });
+  bindExternal("ai_stoppointat",      [this](Daedalus::DaedalusVM& vm){ ai_stoppointat(vm);       });
+  bindExternal("ai_drawweapon",       [this](Daedalus::DaedalusVM& vm){ ai_drawweapon(vm);  });
+  bindExternal("ai_readymeleeweapon", [this](Daedalus::DaedalusVM& vm){ ai_readymeleeweapon(vm);  });
+  bindExternal("ai_readyrangedweapon",[this](Daedalus::DaedalusVM& vm){ ai_readyrangedweapon(vm); });
+  bindExternal("ai_readyspell",       [this](Daedalus::DaedalusVM& vm){ ai_readyspell(vm);        });
+  bindExternal("ai_attack",           [this](Daedalus::DaedalusVM& vm){ ai_atack(vm);             });
+  bindExternal("ai_flee",             [this](Daedalus::DaedalusVM& vm){ ai_flee(vm);              });
+  bindExternal("ai_dodge",            [this](Daedalus::DaedalusVM& vm){ ai_dodge(vm);             });
+  bindExternal("ai_unequipweapons",   [this](Daedalus::DaedalusVM& vm){ ai_unequipweapons(vm);    });
+  bindExternal("ai_unequiparmor",     [this](Daedalus::DaedalusVM& vm){ ai_unequiparmor(vm);      });
+  bindExternal("ai_gotonpc",          [this](Daedalus::DaedalusVM& vm){ ai_gotonpc(vm);           });
+  bindExternal("ai_gotonextfp",       [this](Daedalus::DaedalusVM& vm){ ai_gotonextfp(vm);        });
+  bindExternal("ai_aligntofp",        [this](Daedalus::DaedalusVM& vm){ ai_aligntofp(vm);         });
+  bindExternal("ai_useitem",          [this](Daedalus::DaedalusVM& vm){ ai_useitem(vm);           });
+  bindExternal("ai_useitemtostate",   [this](Daedalus::DaedalusVM& vm){ ai_useitemtostate(vm);    });
+  bindExternal("ai_setnpcstostate",   [this](Daedalus::DaedalusVM& vm){ ai_setnpcstostate(vm);    });
+  bindExternal("ai_finishingmove",    [this](Daedalus::DaedalusVM& vm){ ai_finishingmove(vm);     });
+  bindExternal("ai_takeitem",         [this](Daedalus::DaedalusVM& vm){ ai_takeitem(vm);          });
+  bindExternal("ai_gotoitem",         [this](Daedalus::DaedalusVM& vm){ ai_gotoitem(vm);          });
+
+  bindExternal("mob_hasitems",        [this](Daedalus::DaedalusVM& vm){ mob_hasitems(vm);         });
+
+  bindExternal("ta_min",              [this](Daedalus::DaedalusVM& vm){ ta_min(vm);               });
+
+  bindExternal("log_createtopic",     [this](Daedalus::DaedalusVM& vm){ log_createtopic(vm);      });
+  bindExternal("log_settopicstatus",  [this](Daedalus::DaedalusVM& vm){ log_settopicstatus(vm);   });
+  bindExternal("log_addentry",        [this](Daedalus::DaedalusVM& vm){ log_addentry(vm);         });
+
+  bindExternal("equipitem",           [this](Daedalus::DaedalusVM& vm){ equipitem(vm);            });
+  bindExternal("createinvitem",       [this](Daedalus::DaedalusVM& vm){ createinvitem(vm);        });
+  bindExternal("createinvitems",      [this](Daedalus::DaedalusVM& vm){ createinvitems(vm);       });
+
+  bindExternal("info_addchoice",      [this](Daedalus::DaedalusVM& vm){ info_addchoice(vm);       });
+  bindExternal("info_clearchoices",   [this](Daedalus::DaedalusVM& vm){ info_clearchoices(vm);    });
+  bindExternal("infomanager_hasfinished",
+                                      [this](Daedalus::DaedalusVM& vm){ infomanager_hasfinished(vm); });
+
+  bindExternal("snd_play",            [this](Daedalus::DaedalusVM& vm){ snd_play(vm);             });
+  bindExternal("snd_play3d",          [this](Daedalus::DaedalusVM& vm){ snd_play3d(vm);           });
+
+  bindExternal("game_initgerman",     [this](Daedalus::DaedalusVM& vm){ game_initgerman(vm);      });
+  bindExternal("game_initenglish",    [this](Daedalus::DaedalusVM& vm){ game_initenglish(vm);     });
+
+  bindExternal("exitsession",         [this](Daedalus::DaedalusVM& vm){ exitsession(vm);          });
 
   // vm.validateExternals();
 
@@ -318,6 +350,21 @@ void GameScript::initCommon() {
   ZS_Attack            = getAiState(getSymbolIndex("ZS_Attack")).funcIni;
   ZS_MM_Attack         = getAiState(getSymbolIndex("ZS_MM_Attack")).funcIni;
 
+  fnCanNotUse               = getSymbolIndex("G_CanNotUse");
+  fnCanNotCast              = getSymbolIndex("G_CanNotCast");
+  fnPickLock                = getSymbolIndex("G_PickLock");
+  fnTradeNotEnoughGold      = getSymbolIndex("player_trade_not_enough_gold");
+  fnMobMissingItem          = getSymbolIndex("player_mob_missing_item");
+  fnMobMissingKey           = getSymbolIndex("player_mob_missing_key");
+  fnMobAnotherIsUsing       = getSymbolIndex("player_mob_another_is_using");
+  fnMobMissingKeyOrLockpick = getSymbolIndex("player_mob_missing_key_or_lockpick");
+  fnMobMissingLockpick      = getSymbolIndex("player_mob_missing_lockpick");
+  fnMobTooFar               = getSymbolIndex("player_mob_too_far_away");
+  fnPlunderIsEmpty          = getSymbolIndex("player_plunder_is_empty");
+  fnHotkeyScreenMap         = getSymbolIndex("player_hotkey_screen_map");
+  fnProcessMana             = getSymbolIndex("Spell_ProcessMana");
+  fnCanNpcCollideWithSpell  = getSymbolIndex("C_CanNpcCollideWithSpell");
+
   auto& dat            = vm.getDATFile();
 
   spellFxInstanceNames = dat.getSymbolIndexByName("spellFxInstanceNames");
@@ -405,8 +452,9 @@ void GameScript::initCommon() {
       }
     }
 
-  if(hasSymbolName("startup_global"))
-    runFunction("startup_global");
+  auto startup = getSymbolIndex("startup_global");
+  if(startup!=size_t(-1))
+    runFunction(startup);
   }
 
 void GameScript::initDialogs(Gothic& gothic) {
@@ -419,6 +467,7 @@ void GameScript::initDialogs(Gothic& gothic) {
     ++count;
     });
   dialogsInfo.resize(count);
+  dlgVolatile.assign(count,0);
 
   count=0;
   vm.getDATFile().iterateSymbolsOfClass("C_Info", [this,&count](size_t i,Daedalus::PARSymbol&){
@@ -426,6 +475,23 @@ void GameScript::initDialogs(Gothic& gothic) {
     vm.initializeInstance(h, i, Daedalus::IC_Info);
     ++count;
     });
+
+  dialogsByNpc.clear();
+  dialogsCache.clear();
+  dlgGlobals.clear();
+  for(size_t i=0; i<dialogsInfo.size(); ++i) {
+    dialogsByNpc[dialogsInfo[i].npc].push_back(uint32_t(i));
+    if(dialogsInfo[i].condition!=0 && !scanCondition(dialogsInfo[i].condition,dlgGlobals))
+      dlgVolatile[i] = 1;
+    }
+  std::sort(dlgGlobals.begin(),dlgGlobals.end());
+  dlgGlobals.erase(std::unique(dlgGlobals.begin(),dlgGlobals.end()),dlgGlobals.end());
+  }
+
+bool GameScript::scanCondition(size_t fn, std::vector<size_t>& globals) {
+  auto&         dat = vm.getDATFile();
+  ConditionScan scan(dat.getSymTable().symbols,symbols.find("SELF"),symbols.find("OTHER"),dlgSafeExt);
+  return scan.exec(dat.getSymbolByIndex(fn).address,[&dat](size_t pc){ return dat.getStackOpCode(pc); },globals);
   }
 
 void GameScript::loadDialogOU(Gothic &gothic) {
@@ -455,7 +521,8 @@ void GameScript::initializeInstance(Daedalus::GEngineClasses::C_Npc &n, size_t i
   vm.initializeInstance(n,instance,Daedalus::IC_Npc);
 
   if(n.daily_routine!=0) {
-    ScopeVar self(vm,vm.globalSelf(),&n,Daedalus::IC_Npc);
+    ScopeVar              self(vm,vm.globalSelf(),&n,Daedalus::IC_Npc);
+    ScriptProfiler::Scope prof(this->prof,ScriptProfiler::Function,size_t(n.daily_routine));
     vm.runFunctionBySymIndex(n.daily_routine);
     }
   }
@@ -630,7 +697,7 @@ World &GameScript::world() {
 
 Daedalus::GEngineClasses::C_Focus GameScript::getFocus(const char *name) {
   Daedalus::GEngineClasses::C_Focus ret={};
-  auto id = vm.getDATFile().getSymbolIndexByName(name);
+  auto id = symbols.find(name);
   if(id==size_t(-1))
     return ret;
   vm.initializeInstance(ret, id, Daedalus::IC_Focus);
@@ -656,11 +723,11 @@ Daedalus::PARSymbol &GameScript::getSymbol(const size_t s) {
   }
 
 size_t GameScript::getSymbolIndex(const char* s) {
-  return vm.getDATFile().getSymbolIndexByName(s);
+  return symbols.find(s);
   }
 
 size_t GameScript::getSymbolIndex(const std::string &s) {
-  return vm.getDATFile().getSymbolIndexByName(s.c_str());
+  return symbols.find(s);
   }
 
 const AiState &GameScript::getAiState(ScriptFn id) {
@@ -705,21 +772,20 @@ std::vector<GameScript::DlgChoise> GameScript::dialogChoises(Daedalus::GEngineCl
   auto& npc = *hnpc;
   auto& pl  = *player;
 
+  auto  hDialog = dialogCandidates(npc);
+  if(hDialog==nullptr)
+    return {};
+
   ScopeVar self (vm, vm.globalSelf(),  hnpc,   Daedalus::IC_Npc);
   ScopeVar other(vm, vm.globalOther(), player, Daedalus::IC_Npc);
 
-  std::vector<Daedalus::GEngineClasses::C_Info*> hDialog;
-  for(auto& info : dialogsInfo) {
-    if(info.npc==int32_t(npc.instanceSymbol)) {
-      hDialog.push_back(&info);
-      }
-    }
-
+  auto&    cache = dialogCache(npc,pl,hDialog->size());
   std::vector<DlgChoise> choise;
 
   for(int important=includeImp ? 1 : 0;important>=0;--important){
-    for(auto& i:hDialog) {
-      const Daedalus::GEngineClasses::C_Info& info = *i;
+    for(size_t r=0;r<hDialog->size();++r) {
+      const size_t                            id   = (*hDialog)[r];
+      const Daedalus::GEngineClasses::C_Info& info = dialogsInfo[id];
       if(info.important!=important)
         continue;
       bool npcKnowsInfo = doesNpcKnowInfo(pl,info.instanceSymbol);
@@ -737,29 +803,167 @@ std::vector<GameScript::DlgChoise> GameScript::dialogChoises(Daedalus::GEngineCl
           continue;
         }
 
-      bool valid=true;
-      if(info.condition)
-        valid = runFunction(info.condition)!=0;
-      if(!valid)
+      if(!dialogCondition(id,cache,r))
         continue;
 
       DlgChoise ch;
       ch.title    = info.description.c_str();
       ch.scriptFn = info.information;
-      ch.handle   = i;
+      ch.handle   = &dialogsInfo[id];
       ch.isTrade  = info.trade!=0;
       ch.sort     = info.nr;
       choise.emplace_back(std::move(ch));
       }
-    if(!choise.empty()){
-      sort(choise);
-      return choise;
-      }
+    if(!choise.empty())
+      break;
     }
+  endDialogPass(cache,npc,pl);
   sort(choise);
   return choise;
   }
 
+void GameScript::prefetchDialog(Npc& player, Npc& npc) {
+  auto& hnpc    = *npc.handle();
+  auto& pl      = *player.handle();
+  auto  hDialog = dialogCandidates(hnpc);
+  if(hDialog==nullptr)
+    return;
+
+  ScopeVar self (vm, vm.globalSelf(),  &hnpc, Daedalus::IC_Npc);
+  ScopeVar other(vm, vm.globalOther(), &pl,   Daedalus::IC_Npc);
+
+  auto& cache = dialogCache(hnpc,pl,hDialog->size());
+  for(size_t r=0;r<hDialog->size();++r) {
+    const size_t id   = (*hDialog)[r];
+    auto&        info = dialogsInfo[id];
+    if(!info.permanent && doesNpcKnowInfo(pl,info.instanceSymbol))
+      continue;
+    // only conditions, that reach nothing but safe externals: focus must not trigger script side effects
+    if(!dlgVolatile[id])
+      dialogCondition(id,cache,r);
+    }
+  endDialogPass(cache,hnpc,pl);
+  }
+
+auto GameScript::dialogCandidates(const Daedalus::GEngineClasses::C_Npc& npc) const -> const std::vector<uint32_t>* {
+  auto it = dialogsByNpc.find(int32_t(npc.instanceSymbol));
+  if(it==dialogsByNpc.end())
+    return nullptr;
+  return &it->second;
+  }
+
+GameScript::DlgCache& GameScript::dialogCache(const Daedalus::GEngineClasses::C_Npc& npc,
+                                              const Daedalus::GEngineClasses::C_Npc& pl, size_t count) {
+  auto&          c     = dialogsCache[std::make_pair(npc.instanceSymbol,pl.instanceSymbol)];
+  const uint64_t stamp = dialogStamp(npc,pl,c);
+  if(c.stamp!=stamp || c.cond.size()!=count) {
+    c.stamp = stamp;
+    c.cond.assign(count,0);
+    }
+  dlgSelf  = &npc;
+  dlgOther = &pl;
+  return c;
+  }
+
+void GameScript::endDialogPass(DlgCache& c, const Daedalus::GEngineClasses::C_Npc& npc,
+                               const Daedalus::GEngineClasses::C_Npc& pl) {
+  // side effect of condition or npc, that is newly read: results of this pass don't match their stamp
+  if(dialogStamp(npc,pl,c)!=c.stamp)
+    std::fill(c.cond.begin(),c.cond.end(),uint8_t(0));
+  dlgSelf  = nullptr;
+  dlgOther = nullptr;
+  }
+
+bool GameScript::dialogCondition(size_t id, DlgCache& c, size_t slot) {
+  auto& info = dialogsInfo[id];
+  if(info.condition==0)
+    return true;
+  if(dlgVolatile[id])
+    return runFunction(info.condition)!=0;
+  if(c.cond[slot]!=0)
+    return c.cond[slot]==2;
+
+  dlgPass        = &c;
+  const bool ret = runFunction(info.condition)!=0;
+  dlgPass        = nullptr;
+
+  c.cond[slot] = ret ? 2 : 1;
+  return ret;
+  }
+
+void GameScript::dialogRead(const Npc* npc) {
+  // npc, reachable by condition, other than self/other: track it in stamp from now on
+  if(dlgPass==nullptr || npc==nullptr)
+    return;
+  auto h = npc->handle();
+  if(h==dlgSelf || h==dlgOther)
+    return;
+  auto& extra = dlgPass->extra;
+  if(std::find(extra.begin(),extra.end(),h->instanceSymbol)==extra.end())
+    extra.push_back(h->instanceSymbol);
+  }
+
+uint64_t GameScript::dialogStamp(const Daedalus::GEngineClasses::C_Npc& npc, const Daedalus::GEngineClasses::C_Npc& pl,
+                                 const DlgCache& c) {
+  uint64_t h = 14695981039346656037ull;
+  auto mix = [&h](uint64_t v) {
+    h = (h^v)*1099511628211ull;
+    };
+
+  // script globals, that are read by conditions
+  auto& sym = vm.getDATFile().getSymTable().symbols;
+  for(auto id:dlgGlobals) {
+    auto& s = sym[id];
+    for(auto v:s.intData)
+      mix(uint64_t(int64_t(v)));
+    for(auto v:s.floatData) {
+      uint32_t bits = 0;
+      std::memcpy(&bits,&v,sizeof(bits));
+      mix(bits);
+      }
+    }
+
+  // npc's, as seen by conditions and safe externals
+  auto mixNpc = [&](const Daedalus::GEngineClasses::C_Npc& hnpc) {
+    for(auto v:hnpc.attribute)
+      mix(uint64_t(int64_t(v)));
+    for(auto v:hnpc.aivar)
+      mix(uint64_t(int64_t(v)));
+    mix(uint64_t(int64_t(hnpc.guild)));
+    mix(uint64_t(int64_t(hnpc.level)));
+    mix(uint64_t(int64_t(hnpc.exp)));
+    mix(uint64_t(int64_t(hnpc.flags)));
+    mix(uint64_t(int64_t(hnpc.npcType)));
+
+    auto n = reinterpret_cast<const Npc*>(hnpc.userPtr);
+    if(n==nullptr)
+      return;
+    for(size_t t=0; t<Npc::TALENT_MAX_G2; ++t) {
+      mix(uint64_t(int64_t(n->talentSkill(Npc::Talent(t)))));
+      mix(uint64_t(int64_t(n->talentValue(Npc::Talent(t)))));
+      }
+    auto& inv = n->inventory();
+    for(size_t i=0; i<inv.recordsCount(); ++i) {
+      auto& it = inv.at(i);
+      mix(it.clsId());
+      mix(it.count());
+      mix(it.isEquiped() ? 1 : 0);
+      }
+    };
+  mixNpc(npc);
+  mixNpc(pl);
+  for(auto i:c.extra) {
+    // npc can be removed or respawned
+    auto n = getNpcById(i);
+    mix(n!=nullptr ? 1 : 0);
+    if(n!=nullptr)
+      mixNpc(*n->handle());
+    }
+
+  mix(dlgKnownVersion);
+  return h;
+  }
+
 std::vector<GameScript::DlgChoise> GameScript::updateDialog(const GameScript::DlgChoise &dlg, Npc& player,Npc& npc) {
   if(dlg.handle==nullptr)
     return {};
@@ -806,86 +1010,76 @@ void GameScript::exec(const GameScript::DlgChoise &dlg,Npc& player, Npc& npc) {
   }
 
 int GameScript::printCannotUseError(Npc& npc, int32_t atr, int32_t nValue) {
-  auto id = vm.getDATFile().getSymbolIndexByName("G_CanNotUse");
-  if(id==size_t(-1))
+  if(!fnCanNotUse.isValid())
     return 0;
   vm.pushInt(npc.isPlayer() ? 1 : 0);
   vm.pushInt(atr);
   vm.pushInt(nValue);
   ScopeVar self(vm, vm.globalSelf(), npc.handle(), Daedalus::IC_Npc);
-  return runFunction(id);
+  return runFunction(fnCanNotUse.ptr);
   }
 
 int GameScript::printCannotCastError(Npc &npc, int32_t plM, int32_t itM) {
-  auto id = vm.getDATFile().getSymbolIndexByName("G_CanNotCast");
-  if(id==size_t(-1))
+  if(!fnCanNotCast.isValid())
     return 0;
   vm.pushInt(npc.isPlayer() ? 1 : 0);
   vm.pushInt(itM);
   vm.pushInt(plM);
   ScopeVar self(vm, vm.globalSelf(), npc.handle(), Daedalus::IC_Npc);
-  return runFunction(id);
+  return runFunction(fnCanNotCast.ptr);
   }
 
 int GameScript::printCannotBuyError(Npc &npc) {
-  auto id = vm.getDATFile().getSymbolIndexByName("player_trade_not_enough_gold");
-  if(id==size_t(-1))
+  if(!fnTradeNotEnoughGold.isValid())
     return 0;
   ScopeVar self(vm, vm.globalSelf(), npc.handle(), Daedalus::IC_Npc);
-  return runFunction(id);
+  return runFunction(fnTradeNotEnoughGold.ptr);
   }
 
 int GameScript::printMobMissingItem(Npc &npc) {
-  auto id = vm.getDATFile().getSymbolIndexByName("player_mob_missing_item");
-  if(id==size_t(-1))
+  if(!fnMobMissingItem.isValid())
     return 0;
   ScopeVar self(vm, vm.globalSelf(), npc.handle(), Daedalus::IC_Npc);
-  return runFunction(id);
+  return runFunction(fnMobMissingItem.ptr);
   }
 
 int GameScript::printMobMissingKey(Npc& npc) {
-  auto id = vm.getDATFile().getSymbolIndexByName("player_mob_missing_key");
-  if(id==size_t(-1))
+  if(!fnMobMissingKey.isValid())
     return 0;
   ScopeVar self(vm, vm.globalSelf(), npc.handle(), Daedalus::IC_Npc);
-  return runFunction(id);
+  return runFunction(fnMobMissingKey.ptr);
   }
 
 int GameScript::printMobAnotherIsUsing(Npc &npc) {
-  auto id = vm.getDATFile().getSymbolIndexByName("player_mob_another_is_using");
-  if(id==size_t(-1))
+  if(!fnMobAnotherIsUsing.isValid())
     return 0;
   ScopeVar self(vm, vm.globalSelf(), npc.handle(), Daedalus::IC_Npc);
-  return runFunction(id);
+  return runFunction(fnMobAnotherIsUsing.ptr);
   }
 
 int GameScript::printMobMissingKeyOrLockpick(Npc& npc) {
-  auto id = vm.getDATFile().getSymbolIndexByName("player_mob_missing_key_or_lockpick");
-  if(id==size_t(-1))
+  if(!fnMobMissingKeyOrLockpick.isValid())
     return 0;
   ScopeVar self(vm, vm.globalSelf(), npc.handle(), Daedalus::IC_Npc);
-  return runFunction(id);
+  return runFunction(fnMobMissingKeyOrLockpick.ptr);
   }
 
 int GameScript::printMobMissingLockpick(Npc& npc) {
-  auto id = vm.getDATFile().getSymbolIndexByName("player_mob_missing_lockpick");
-  if(id==size_t(-1))
+  if(!fnMobMissingLockpick.isValid())
     return 0;
   ScopeVar self(vm, vm.globalSelf(), npc.handle(), Daedalus::IC_Npc);
-  return runFunction(id);
+  return runFunction(fnMobMissingLockpick.ptr);
   }
 
 int GameScript::printMobTooFar(Npc& npc) {
-  auto id = vm.getDATFile().getSymbolIndexByName("player_mob_too_far_away");
-  if(id==size_t(-1))
+  if(!fnMobTooFar.isValid())
     return 0;
   ScopeVar self(vm, vm.globalSelf(), npc.handle(), Daedalus::IC_Npc);
-  return runFunction(id);
+  return runFunction(fnMobTooFar.ptr);
   }
 
 int GameScript::invokeState(Daedalus::GEngineClasses::C_Npc* hnpc, Daedalus::GEngineClasses::C_Npc* oth, const char *name) {
-  auto& dat = vm.getDATFile();
-  auto  id  = dat.getSymbolIndexByName(name);
+  auto  id  = symbols.find(name);
   if(id==size_t(-1))
     return 0;
 
@@ -932,16 +1126,14 @@ int GameScript::invokeItem(Npc *npc, ScriptFn fn) {
   }
 
 int GameScript::invokeMana(Npc &npc, Npc* target, Item &) {
-  auto& dat = vm.getDATFile();
-  auto fn   = dat.getSymbolIndexByName("Spell_ProcessMana");
-  if(fn==size_t(-1))
+  if(!fnProcessMana.isValid())
     return Npc::SpellCode::SPL_SENDSTOP;
 
   ScopeVar self (vm, vm.globalSelf(),  npc);
   ScopeVar other(vm, vm.globalOther(), target);
 
   vm.pushInt(npc.attribute(Npc::ATR_MANA));
-  return runFunction(fn);
+  return runFunction(fnProcessMana.ptr);
   }
 
 int GameScript::invokeSpell(Npc &npc, Npc* target, Item &it) {
@@ -950,8 +1142,7 @@ int GameScript::invokeSpell(Npc &npc, Npc* target, Item &it) {
   char  str[256]={};
   std::snprintf(str,sizeof(str),"Spell_Cast_%s",tag.c_str());
 
-  auto& dat = vm.getDATFile();
-  auto  fn  = dat.getSymbolIndexByName(str);
+  auto  fn  = symbols.find(str);
   if(fn==size_t(-1))
     return 0;
 
@@ -976,37 +1167,31 @@ int GameScript::invokeCond(Npc &,const char* func) {
   }
 
 void GameScript::invokePickLock(Npc& npc, int bSuccess, int bBrokenOpen) {
-  auto& dat = vm.getDATFile();
-  auto fn   = dat.getSymbolIndexByName("G_PickLock");
-  if(fn==size_t(-1))
+  if(!fnPickLock.isValid())
     return;
   ScopeVar self(vm, vm.globalSelf(),  npc);
   vm.pushInt(bSuccess);
   vm.pushInt(bBrokenOpen);
-  runFunction(fn);
+  runFunction(fnPickLock.ptr);
   }
 
 CollideMask GameScript::canNpcCollideWithSpell(Npc& npc, Npc* shooter, int32_t spellId) {
-  auto& dat = vm.getDATFile();
-  auto fn   = dat.getSymbolIndexByName("C_CanNpcCollideWithSpell");
-  if(fn==size_t(-1))
+  if(!fnCanNpcCollideWithSpell.isValid())
     return COLL_DOEVERYTHING;
 
   ScopeVar self (vm, vm.globalSelf(),  npc);
   ScopeVar other(vm, vm.globalOther(), shooter);
   vm.pushInt(spellId);
-  int v = runFunction(fn);
+  int v = runFunction(fnCanNpcCollideWithSpell.ptr);
   return CollideMask(v);
   }
 
 int GameScript::playerHotKeyScreenMap(Npc& pl) {
-  auto& dat = vm.getDATFile();
-  auto fn   = dat.getSymbolIndexByName("player_hotkey_screen_map");
-  if(fn==size_t(-1))
+  if(!fnHotkeyScreenMap.isValid())
     return -1;
 
   ScopeVar self(vm, vm.globalSelf(), pl);
-  int map = runFunction(fn);
+  int map = runFunction(fnHotkeyScreenMap.ptr);
   if(map>=0)
     pl.useItem(size_t(map));
   return map;
@@ -1086,21 +1271,20 @@ uint32_t GameScript::messageTime(const Daedalus::ZString& id) const {
   }
 
 int GameScript::printNothingToGet() {
-  auto id = vm.getDATFile().getSymbolIndexByName("player_plunder_is_empty");
-  if(id==size_t(-1))
+  if(!fnPlunderIsEmpty.isValid())
     return 0;
   ScopeVar self(vm, vm.globalSelf(), owner.player());
-  return runFunction(id);
+  return runFunction(fnPlunderIsEmpty.ptr);
   }
 
 void GameScript::useInteractive(Daedalus::GEngineClasses::C_Npc* hnpc,const std::string& func) {
-  auto& dat = vm.getDATFile();
-  if(!dat.hasSymbolName(func.c_str()))
+  auto fn = symbols.find(func);
+  if(fn==size_t(-1))
     return;
 
   ScopeVar self(vm,vm.globalSelf(),hnpc,Daedalus::IC_Npc);
   try {
-    runFunction(func.c_str());
+    runFunction(fn);
     }
   catch (...) {
     Log::i("unable to use interactive [",func,"]");
@@ -1157,11 +1341,11 @@ bool GameScript::searchScheme(const char* sc, const char* listName) {
   }
 
 bool GameScript::hasSymbolName(const char* fn) {
-  return vm.getDATFile().hasSymbolName(fn);
+  return symbols.has(fn);
   }
 
 int32_t GameScript::runFunction(const char *fname) {
-  auto id = vm.getDATFile().getSymbolIndexByName(fname);
+  auto id = symbols.find(fname);
   if(id==size_t(-1))
     throw std::runtime_error("script bad call");
   return runFunction(id);
@@ -1172,10 +1356,17 @@ int32_t GameScript::runFunction(const size_t fid) {
   auto&       sym  = dat.getSymbolByIndex(fid);
   const char* call = sym.name.c_str();(void)call; //for debuging
 
+  PerfCounters::Scope   perf(PerfCounters::Script);
+  ScriptProfiler::Scope prof(this->prof,ScriptProfiler::Function,fid);
   int32_t ret = vm.runFunctionBySymIndex(fid);
   return ret;
   }
 
+bool GameScript::writeProfile(const std::string& report, const std::string& trace) {
+  auto& dat = vm.getDATFile();
+  return prof.writeReport(report,dat) && prof.writeTrace(trace,dat);
+  }
+
 uint64_t GameScript::tickCount() const {
   return owner.tickCount();
   }
@@ -1260,7 +1451,7 @@ void GameScript::removeItem(Item &it) {
   }
 
 void GameScript::setInstanceNPC(const char *name, Npc &npc) {
-  assert(vm.getDATFile().hasSymbolName(name));
+  assert(symbols.has(name));
   vm.setInstance(name,npc.handle(),Daedalus::EInstanceClass::IC_Npc);
   }
 
@@ -1279,7 +1470,7 @@ AiOuputPipe *GameScript::openDlgOuput(Npc &player, Npc &npc) {
   }
 
 ScriptFn GameScript::playerPercAssessMagic() {
-  size_t id = vm.getDATFile().getSymbolIndexByName("PLAYER_PERC_ASSESSMAGIC");
+  size_t id = symbols.find("PLAYER_PERC_ASSESSMAGIC");
   if(id==size_t(-1))
     return ScriptFn();
   auto& var = vm.getDATFile().getSymbolByIndex(id);
@@ -1290,7 +1481,7 @@ ScriptFn GameScript::playerPercAssessMagic() {
   }
 
 int GameScript::npcDamDiveTime() {
-  size_t id = vm.getDATFile().getSymbolIndexByName("NPC_DAM_DIVE_TIME");
+  size_t id = symbols.find("NPC_DAM_DIVE_TIME");
   if(id==size_t(-1))
     return 0;
   auto& var = vm.getDATFile().getSymbolByIndex(id);
@@ -1812,7 +2003,7 @@ void GameScript::npc_exchangeroutine(Daedalus::DaedalusVM &vm) {
     auto& v = *npc->handle();
     char buf[256]={};
     std::snprintf(buf,sizeof(buf),"Rtn_%s_%d",rname.c_str(),v.id);
-    size_t d = vm.getDATFile().getSymbolIndexByName(buf);
+    size_t d = symbols.find(buf);
     if(d>0)
       npc->excRoutine(d);
     }
@@ -1820,6 +2011,7 @@ void GameScript::npc_exchangeroutine(Daedalus::DaedalusVM &vm) {
 
 void GameScript::npc_isdead(Daedalus::DaedalusVM &vm) {
   auto npc = popInstance(vm);
+  dialogRead(npc);
   if(npc==nullptr || isDead(*npc))
     vm.setReturn(1); else
     vm.setReturn(0);
@@ -1849,6 +2041,7 @@ void GameScript::npc_settalentskill(Daedalus::DaedalusVM &vm) {
 void GameScript::npc_gettalentskill(Daedalus::DaedalusVM &vm) {
   uint32_t skillId = uint32_t(vm.popInt());
   auto     npc     = popInstance(vm);
+  dialogRead(npc);
 
   int32_t  skill   = npc==nullptr ? 0 : npc->talentSkill(Npc::Talent(skillId));
   vm.setReturn(skill);
@@ -1865,6 +2058,7 @@ void GameScript::npc_settalentvalue(Daedalus::DaedalusVM &vm) {
 void GameScript::npc_gettalentvalue(Daedalus::DaedalusVM &vm) {
   uint32_t skillId = uint32_t(vm.popInt());
   auto     npc     = popInstance(vm);
+  dialogRead(npc);
 
   int32_t  skill   = npc==nullptr ? 0 : npc->talentValue(Npc::Talent(skillId));
   vm.setReturn(skill);
@@ -1887,6 +2081,7 @@ void GameScript::npc_refusetalk(Daedalus::DaedalusVM &vm) {
 void GameScript::npc_hasitems(Daedalus::DaedalusVM &vm) {
   uint32_t itemId = uint32_t(vm.popInt());
   auto     npc    = popInstance(vm);
+  dialogRead(npc);
   if(npc!=nullptr)
     vm.setReturn(int32_t(npc->hasItem(itemId))); else
     vm.setReturn(0);
@@ -1952,6 +2147,7 @@ void GameScript::npc_getdisttonpc(Daedalus::DaedalusVM &vm) {
 
 void GameScript::npc_hasequippedarmor(Daedalus::DaedalusVM &vm) {
   auto npc = popInstance(vm);
+  dialogRead(npc);
   if(npc!=nullptr && npc->currentArmour()!=nullptr)
     vm.setReturn(1); else
     vm.setReturn(0);
@@ -2087,6 +2283,7 @@ void GameScript::npc_canseenpc(Daedalus::DaedalusVM &vm) {
 
 void GameScript::npc_hasequippedweapon(Daedalus::DaedalusVM &vm) {
   auto npc = popInstance(vm);
+  dialogRead(npc);
   if(npc!=nullptr &&
      (npc->currentMeleWeapon()!=nullptr ||
       npc->currentRangeWeapon()!=nullptr))
@@ -2096,6 +2293,7 @@ void GameScript::npc_hasequippedweapon(Daedalus::DaedalusVM &vm) {
 
 void GameScript::npc_hasequippedmeleeweapon(Daedalus::DaedalusVM &vm) {
   auto npc = popInstance(vm);
+  dialogRead(npc);
   if(npc!=nullptr && npc->currentMeleWeapon()!=nullptr)
     vm.setReturn(1); else
     vm.setReturn(0);
@@ -2103,6 +2301,7 @@ void GameScript::npc_hasequippedmeleeweapon(Daedalus::DaedalusVM &vm) {
 
 void GameScript::npc_hasequippedrangedweapon(Daedalus::DaedalusVM &vm) {
   auto npc = popInstance(vm);
+  dialogRead(npc);
   if(npc!=nullptr && npc->currentRangeWeapon()!=nullptr)
     vm.setReturn(1); else
     vm.setReturn(0);
@@ -2267,8 +2466,16 @@ void GameScript::npc_checkinfo(Daedalus::DaedalusVM &vm) {
   auto& pl   = *(hpl);
   auto& npc  = *(n->handle());
 
-  for(auto& info:dialogsInfo) {
-    if(info.npc!=int32_t(npc.instanceSymbol) || info.important!=imp)
+  auto hDialog = dialogCandidates(npc);
+  if(hDialog==nullptr) {
+    vm.setReturn(0);
+    return;
+    }
+
+  // called from perception handlers very often: only index is used here, stamp would cost more than conditions
+  for(auto id:*hDialog) {
+    auto& info = dialogsInfo[id];
+    if(info.important!=imp)
       continue;
     bool npcKnowsInfo = doesNpcKnowInfo(pl,info.instanceSymbol);
     if(npcKnowsInfo && !info.permanent)
@@ -3062,8 +3269,10 @@ void GameScript::hlp_isvaliditem(Daedalus::DaedalusVM &vm) {
 void GameScript::hlp_getnpc(Daedalus::DaedalusVM &vm) {
   uint32_t instanceSymbol = vm.popUInt();
   auto&    handle         = vm.getDATFile().getSymbolByIndex(instanceSymbol);(void)handle;
+  auto     npc            = getNpcById(instanceSymbol);
+  dialogRead(npc);
 
-  if(nullptr != getNpcById(instanceSymbol))
+  if(nullptr != npc)
     vm.setReturn(int32_t(instanceSymbol)); else
     vm.setReturn(-1);
   }
@@ -3126,7 +3335,8 @@ void GameScript::sort(std::vector<GameScript::DlgChoise> &dlg) {
 
 void GameScript::setNpcInfoKnown(const Daedalus::GEngineClasses::C_Npc& npc, const Daedalus::GEngineClasses::C_Info &info) {
   auto id = std::make_pair(npc.instanceSymbol,info.instanceSymbol);
-  dlgKnownInfos.insert(id);
+  if(dlgKnownInfos.insert(id).second)
+    dlgKnownVersion++;
   }
 
 bool GameScript::doesNpcKnowInfo(const Daedalus::GEngineClasses::C_Npc& npc, size_t infoInstance) const {
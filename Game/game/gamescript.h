@@ -4,6 +4,8 @@
 #include <daedalus/DaedalusVM.h>
 #include <zenload/zCCSLib.h>
 
+#include <functional>
+#include <map>
 #include <memory>
 #include <unordered_set>
 #include <random>
@@ -18,6 +20,8 @@
 #include "game/constants.h"
 #include "game/aistate.h"
 #include "game/questlog.h"
+#include "game/scriptprofiler.h"
+#include "game/symboltable.h"
 #include "graphics/pfx/pfxobjects.h"
 #include "ui/documentmenu.h"
 
@@ -63,6 +67,9 @@ class GameScript final {
     int32_t      runFunction  (const char*  fname);
     int32_t      runFunction  (const size_t fid);
 
+    ScriptProfiler& profiler() { return prof; }
+    bool         writeProfile(const std::string& report, const std::string& trace);
+
     void         initDialogs (Gothic &gothic);
     void         loadDialogOU(Gothic &gothic);
 
@@ -117,6 +124,7 @@ class GameScript final {
 
     auto dialogChoises(Daedalus::GEngineClasses::C_Npc *self, Daedalus::GEngineClasses::C_Npc *npc, const std::vector<uint32_t> &except, bool includeImp) -> std::vector<DlgChoise>;
     auto updateDialog (const GameScript::DlgChoise &dlg, Npc &player, Npc &npc) -> std::vector<GameScript::DlgChoise>;
+    void prefetchDialog(Npc &player, Npc &npc);
     void exec(const DlgChoise &dlg, Npc &player, Npc &npc);
 
     int  printCannotUseError         (Npc &npc, int32_t atr, int32_t nValue);
@@ -161,6 +169,8 @@ class GameScript final {
 
   private:
     void               initCommon();
+    void               bindExternal(const char* name, std::function<void(Daedalus::DaedalusVM&)> fn);
+    static bool        isDialogSafe(const char* name);
 
     struct GlobalOutput : AiOuputPipe {
       GlobalOutput(GameScript& owner):owner(owner){}
@@ -391,6 +401,21 @@ class GameScript final {
 
     void exitsession         (Daedalus::DaedalusVM &vm);
 
+    // cached results of C_Info conditions for one npc/player pair; valid while stamp of script state is same
+    struct DlgCache final {
+      uint64_t             stamp = 0;
+      std::vector<uint8_t> cond;  // per candidate: 0 - unknown, 1 - false, 2 - true
+      std::vector<size_t>  extra; // instance symbols of npcs, other than self/other, read by conditions
+      };
+
+    DlgCache& dialogCache(const Daedalus::GEngineClasses::C_Npc& npc, const Daedalus::GEngineClasses::C_Npc& pl, size_t count);
+    void      endDialogPass(DlgCache& c, const Daedalus::GEngineClasses::C_Npc& npc, const Daedalus::GEngineClasses::C_Npc& pl);
+    bool      dialogCondition(size_t info, DlgCache& c, size_t slot);
+    void      dialogRead(const Npc* npc);
+    uint64_t  dialogStamp(const Daedalus::GEngineClasses::C_Npc& npc, const Daedalus::GEngineClasses::C_Npc& pl, const DlgCache& c);
+    bool      scanCondition(size_t fn, std::vector<size_t>& globals);
+    auto      dialogCandidates(const Daedalus::GEngineClasses::C_Npc& npc) const -> const std::vector<uint32_t>*;
+
     void sort(std::vector<DlgChoise>& dlg);
     void setNpcInfoKnown(const Daedalus::GEngineClasses::C_Npc& npc, const Daedalus::GEngineClasses::C_Info& info);
     bool doesNpcKnowInfo(const Daedalus::GEngineClasses::C_Npc& npc, size_t infoInstance) const;
@@ -401,6 +426,8 @@ class GameScript final {
 
     Daedalus::DaedalusVM                                        vm;
     GameSession&                                                owner;
+    SymbolTable                                                 symbols;
+    ScriptProfiler                                              prof;
     std::mt19937                                                randGen;
 
     std::unique_ptr<SpellDefinitions>                           spells;
@@ -409,6 +436,15 @@ class GameScript final {
 
     std::set<std::pair<size_t,size_t>>                          dlgKnownInfos;
     std::vector<Daedalus::GEngineClasses::C_Info>               dialogsInfo;
+    std::unordered_map<int32_t,std::vector<uint32_t>>           dialogsByNpc;
+    std::map<std::pair<size_t,size_t>,DlgCache>                 dialogsCache;
+    std::vector<uint8_t>                                        dlgVolatile; // condition reaches state, that is not in stamp
+    std::vector<uint8_t>                                        dlgSafeExt;  // per symbol: external is dialog-safe
+    std::vector<size_t>                                         dlgGlobals;  // int/float globals, read by conditions
+    uint64_t                                                    dlgKnownVersion=0;
+    const Daedalus::GEngineClasses::C_Npc*                      dlgSelf =nullptr;
+    const Daedalus::GEngineClasses::C_Npc*                      dlgOther=nullptr;
+    DlgCache*                                                   dlgPass =nullptr;
     std::unique_ptr<ZenLoad::zCCSLib>                           dialogs;
     std::unordered_map<size_t,AiState>                          aiStates;
     std::unique_ptr<AiOuputPipe>                                aiDefaultPipe;
@@ -430,6 +466,12 @@ class GameScript final {
     size_t                                                      ZS_Attack=0;
     size_t                                                      ZS_MM_Attack=0;
 
+    ScriptFn                                                    fnCanNotUse, fnCanNotCast, fnPickLock;
+    ScriptFn                                                    fnTradeNotEnoughGold, fnPlunderIsEmpty, fnHotkeyScreenMap;
+    ScriptFn                                                    fnMobMissingItem, fnMobMissingKey, fnMobAnotherIsUsing;
+    ScriptFn                                                    fnMobMissingKeyOrLockpick, fnMobMissingLockpick, fnMobTooFar;
+    ScriptFn                                                    fnProcessMana, fnCanNpcCollideWithSpell;
+
     Daedalus::GEngineClasses::C_Focus                           cFocusNorm,cFocusMele,cFocusRange,cFocusMage;
     Daedalus::GEngineClasses::C_GilValues                       cGuildVal;
   };
@@ -437,15 +437,14 @@ void GameSession::initScripts(bool firstTime) {
   auto dot    = wname.rfind('.');
   auto name   = (dot==std::string::npos ? wname : wname.substr(0,dot));
   if( firstTime ) {
-    std::string startup = "startup_"+name;
-
-    if(vm->hasSymbolName(startup.c_str()))
-      vm->runFunction(startup.c_str());
+    const size_t startup = vm->getSymbolIndex("startup_"+name);
+    if(startup!=size_t(-1))
+      vm->runFunction(startup);
     }
 
-  std::string init = "init_"+name;
-  if(vm->hasSymbolName(init.c_str()))
-    vm->runFunction(init.c_str());
+  const size_t init = vm->getSymbolIndex("init_"+name);
+  if(init!=size_t(-1))
+    vm->runFunction(init);
 
   wrld->resetPositionToTA();
   }
@@ -154,8 +154,11 @@ void PlayerControl::onRotateMouseDy(float dAngle) {
   }
 
 void PlayerControl::tickFocus() {
+  auto prev = currentFocus.npc;
   currentFocus = findFocus(&currentFocus);
   setTarget(currentFocus.npc);
+  if(currentFocus.npc!=nullptr && currentFocus.npc!=prev)
+    prefetchDialog(*currentFocus.npc);
 
   if(!ctrl[Action::ActionGeneric])
     return;
@@ -309,6 +312,17 @@ void PlayerControl::marvinF8() {
   pl.setAnim(AnimationSolver::Idle);
   }
 
+void PlayerControl::prefetchDialog(Npc& npc) {
+  // evaluate dialog conditions, while player approaches npc, so dialog opens without stall
+  auto w = world();
+  if(w==nullptr || dlg.isActive() || npc.isDown())
+    return;
+  auto pl = w->player();
+  if(pl==nullptr || pl==&npc || pl->weaponState()!=WeaponState::NoWeapon)
+    return;
+  w->script().prefetchDialog(*pl,npc);
+  }
+
 Focus PlayerControl::findFocus(Focus* prev) {
   auto w = world();
   if(w==nullptr)
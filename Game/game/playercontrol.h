@@ -98,6 +98,7 @@ class PlayerControl final {
     void           toogleWalkMode();
     void           toggleSneakMode();
     Focus          findFocus(Focus *prev);
+    void           prefetchDialog(Npc& npc);
 
     World*         world() const;
     void           clrDraw();
@@ -0,0 +1,143 @@
+#include "scriptprofiler.h"
+
+#include <Tempest/File>
+#include <Tempest/Log>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+using namespace Tempest;
+
+const size_t ScriptProfiler::maxTraceEvents = 1<<20;
+
+ScriptProfiler::Scope::Scope(ScriptProfiler& p, Kind k, size_t symbol) {
+  if(!p.enabled || symbol==size_t(-1))
+    return;
+  owner = &p;
+  owner->push(k,symbol);
+  }
+
+ScriptProfiler::Scope::~Scope() {
+  if(owner!=nullptr)
+    owner->pop();
+  }
+
+void ScriptProfiler::setEnabled(bool e) {
+  if(enabled==e)
+    return;
+  enabled = e;
+  if(enabled && epoch==0)
+    epoch = now();
+  }
+
+void ScriptProfiler::reset() {
+  stats.clear();
+  trace.clear();
+  epoch = enabled ? now() : 0;
+  }
+
+void ScriptProfiler::push(Kind k, size_t symbol) {
+  if(symbol>=stats.size())
+    stats.resize(symbol+1);
+  auto& st = stats[symbol];
+  st.kind = k;
+  st.active++;
+
+  Frame f;
+  f.symbol = symbol;
+  f.start  = now();
+  stack.push_back(f);
+  }
+
+void ScriptProfiler::pop() {
+  const Frame    f    = stack.back();
+  const uint64_t time = now()-f.start;
+  stack.pop_back();
+  if(f.symbol>=stats.size())
+    return; // reset, while script was running
+
+  auto& st = stats[f.symbol];
+  st.active--;
+  st.calls++;
+  st.excl += time-std::min(time,f.child);
+  // recursive calls are already covered by outermost one
+  if(st.active==0)
+    st.incl += time;
+  if(!stack.empty())
+    stack.back().child += time;
+
+  if(trace.size()<maxTraceEvents) {
+    Event e;
+    e.symbol   = uint32_t(f.symbol);
+    e.start    = f.start-epoch;
+    e.duration = time;
+    trace.push_back(e);
+    }
+  }
+
+bool ScriptProfiler::writeReport(const std::string& path, Daedalus::DATFile& dat) const {
+  std::vector<size_t> order;
+  for(size_t i=0; i<stats.size(); ++i)
+    if(stats[i].calls>0)
+      order.push_back(i);
+  std::sort(order.begin(),order.end(),[this](size_t a, size_t b){
+    return stats[a].excl>stats[b].excl;
+    });
+
+  std::string out;
+  char        buf[512] = {};
+  std::snprintf(buf,sizeof(buf),"%-8s %10s %12s %12s %10s  %s\n","kind","calls","incl_ms","excl_ms","avg_us","symbol");
+  out += buf;
+  for(auto i:order) {
+    auto& st = stats[i];
+    std::snprintf(buf,sizeof(buf),"%-8s %10llu %12.3f %12.3f %10.2f  %s\n",
+                  st.kind==External ? "extern" : "script",
+                  (unsigned long long)st.calls,
+                  double(st.incl)/1000000.0, double(st.excl)/1000000.0,
+                  double(st.incl)/1000.0/double(st.calls),
+                  dat.getSymbolByIndex(i).name.c_str());
+    out += buf;
+    }
+
+  try {
+    WFile fout(path);
+    fout.write(out.data(),out.size());
+    }
+  catch(std::exception& e) {
+    Log::e("script profiler: unable to write \"",path.c_str(),"\": ",e.what());
+    return false;
+    }
+  return true;
+  }
+
+bool ScriptProfiler::writeTrace(const std::string& path, Daedalus::DATFile& dat) const {
+  std::string out = "{\"traceEvents\":[\n";
+  char        buf[512] = {};
+  for(size_t i=0; i<trace.size(); ++i) {
+    auto& e = trace[i];
+    std::snprintf(buf,sizeof(buf),
+                  "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":0}%s\n",
+                  dat.getSymbolByIndex(e.symbol).name.c_str(),
+                  stats[e.symbol].kind==External ? "extern" : "script",
+                  double(e.start)/1000.0, double(e.duration)/1000.0,
+                  i+1<trace.size() ? "," : "");
+    out += buf;
+    }
+  out += "]}\n";
+
+  try {
+    WFile fout(path);
+    fout.write(out.data(),out.size());
+    }
+  catch(std::exception& e) {
+    Log::e("script profiler: unable to write \"",path.c_str(),"\": ",e.what());
+    return false;
+    }
+  return true;
+  }
+
+uint64_t ScriptProfiler::now() {
+  auto t = std::chrono::steady_clock::now().time_since_epoch();
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t).count());
+  }
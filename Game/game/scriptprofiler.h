@@ -0,0 +1,71 @@
+#pragma once
+
+#include <daedalus/DATFile.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Instrumenting profiler of daedalus code: counts calls of script entry points and engine externals,
+// with inclusive and exclusive time per symbol. Time of nested calls is excluded from caller.
+// Script is executed on main thread only, so profiler is not synchronized.
+class ScriptProfiler final {
+  public:
+    enum Kind : uint8_t {
+      Function,
+      External,
+      };
+
+    void     setEnabled(bool e);
+    bool     isEnabled() const { return enabled; }
+    void     reset();
+
+    class Scope final {
+      public:
+        Scope(ScriptProfiler& p, Kind k, size_t symbol);
+        Scope(const Scope&) = delete;
+        ~Scope();
+
+      private:
+        ScriptProfiler* owner = nullptr;
+      };
+
+    // text table, sorted by exclusive time
+    bool     writeReport(const std::string& path, Daedalus::DATFile& dat) const;
+    // chrome://tracing json
+    bool     writeTrace (const std::string& path, Daedalus::DATFile& dat) const;
+
+  private:
+    struct Stat {
+      Kind     kind   = Function;
+      uint32_t active = 0;
+      uint64_t calls  = 0;
+      uint64_t incl   = 0;
+      uint64_t excl   = 0;
+      };
+
+    struct Frame {
+      size_t   symbol = 0;
+      uint64_t start  = 0;
+      uint64_t child  = 0;
+      };
+
+    struct Event {
+      uint32_t symbol   = 0;
+      uint64_t start    = 0;
+      uint64_t duration = 0;
+      };
+
+    void     push(Kind k, size_t symbol);
+    void     pop();
+
+    static uint64_t now();
+
+    bool               enabled = false;
+    uint64_t           epoch   = 0;
+    std::vector<Stat>  stats;
+    std::vector<Frame> stack;
+    std::vector<Event> trace;
+
+    static const size_t maxTraceEvents;
+  };
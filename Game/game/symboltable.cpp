@@ -0,0 +1,46 @@
+#include "symboltable.h"
+
+#include "utils/nameinterner.h"
+
+void SymbolTable::build(Daedalus::DATFile& d) {
+  dat = &d;
+  auto& sym = d.getSymTable().symbols;
+
+  size_t sz = 64;
+  while(sz<sym.size()*2)
+    sz *= 2;
+  table.assign(sz,Slot());
+
+  const size_t mask = table.size()-1;
+  for(size_t id=0; id<sym.size(); ++id) {
+    const char*    name = sym[id].name.c_str();
+    const uint32_t h    = NameInterner::hash(name);
+    size_t         i    = h&mask;
+    while(table[i].index!=uint32_t(-1)) {
+      auto& s = table[i];
+      if(s.hash==h && NameInterner::equals(name,sym[s.index].name.c_str()))
+        break; // duplicated name - keep first one
+      i = (i+1)&mask;
+      }
+    if(table[i].index==uint32_t(-1)) {
+      table[i].hash  = h;
+      table[i].index = uint32_t(id);
+      }
+    }
+  }
+
+size_t SymbolTable::find(const char* name) const {
+  if(table.empty())
+    return size_t(-1);
+
+  auto&          sym  = dat->getSymTable().symbols;
+  const uint32_t h    = NameInterner::hash(name);
+  const size_t   mask = table.size()-1;
+  for(size_t i=h&mask;;i=(i+1)&mask) {
+    auto& s = table[i];
+    if(s.index==uint32_t(-1))
+      return size_t(-1);
+    if(s.hash==h && NameInterner::equals(name,sym[s.index].name.c_str()))
+      return s.index;
+    }
+  }
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <daedalus/DATFile.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Name -> index lookup for symbols of compiled daedalus script. Built once at script load,
+// open addressing over upper-case hash of the name; unlike DATFile::getSymbolIndexByName, lookup doesn't allocate.
+class SymbolTable final {
+  public:
+    void   build(Daedalus::DATFile& dat);
+
+    // size_t(-1), if symbol is not found
+    size_t find(const char* name) const;
+    size_t find(const std::string& name) const { return find(name.c_str()); }
+    bool   has (const char* name) const { return find(name)!=size_t(-1); }
+
+  private:
+    struct Slot {
+      uint32_t hash  = 0;
+      uint32_t index = uint32_t(-1);
+      };
+
+    std::vector<Slot>        table;
+    Daedalus::DATFile*       dat = nullptr;
+  };
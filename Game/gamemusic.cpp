@@ -200,6 +200,16 @@ void GameMusic::setMusic(const Daedalus::GEngineClasses::C_MusicTheme &theme, Ta
   impl->setMusic(theme,tags);
   }
 
+bool GameMusic::preload(const Daedalus::GEngineClasses::C_MusicTheme& theme) {
+  if(!isEnabled())
+    return false;
+  return Resources::preloadDxMusic(theme.file.c_str());
+  }
+
+void GameMusic::release(const Daedalus::GEngineClasses::C_MusicTheme& theme) {
+  Resources::releaseDxMusic(theme.file.c_str());
+  }
+
 void GameMusic::stopMusic() {
   setEnabled(false);
   }
@@ -38,6 +38,9 @@ class GameMusic final {
     bool      isEnabled() const;
     void      setMusic(Music m);
     void      setMusic(const Daedalus::GEngineClasses::C_MusicTheme &theme, Tags t);
+    // prepares theme in background, so later setMusic doesn't stall mixer; theme is kept until release
+    bool      preload (const Daedalus::GEngineClasses::C_MusicTheme &theme);
+    void      release (const Daedalus::GEngineClasses::C_MusicTheme &theme);
     void      stopMusic();
 
   private:
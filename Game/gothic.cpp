@@ -4,6 +4,8 @@
 #include <Tempest/TextCodec>
 
 #include <zenload/zCMesh.h>
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <cctype>
 
@@ -15,6 +17,7 @@
 #include "game/definitions/particlesdefinitions.h"
 
 #include "game/serialize.h"
+#include "graphics/mesh/animsamples.h"
 #include "utils/installdetect.h"
 #include "utils/fileutil.h"
 #include "utils/inifile.h"
@@ -65,6 +68,40 @@ Gothic::Gothic(const int argc, const char **argv) {
     else if(std::strcmp(argv[i],"-validation")==0 || std::strcmp(argv[i],"-v")==0){
       isDebug=true;
       }
+    else if(std::strcmp(argv[i],"-benchmark")==0){
+      bench.enabled = true;
+      if(i+1<argc && std::isdigit(static_cast<unsigned char>(argv[i+1][0]))) {
+        ++i;
+        bench.ticks = uint32_t(std::atoi(argv[i]));
+        }
+      }
+    else if(std::strcmp(argv[i],"-benchmark-dt")==0){
+      ++i;
+      if(i<argc)
+        bench.dt = uint32_t(std::max(1,std::atoi(argv[i])));
+      }
+    else if(std::strcmp(argv[i],"-benchmark-out")==0){
+      ++i;
+      if(i<argc)
+        bench.report = argv[i];
+      }
+    else if(std::strcmp(argv[i],"-anim-tolerance")==0){
+      if(i+2<argc) {
+        AnimSamples::Tolerance tol;
+        tol.rotation = std::max(0.f,float(std::atof(argv[i+1])));
+        tol.position = std::max(0.f,float(std::atof(argv[i+2])));
+        AnimSamples::setTolerance(tol);
+        }
+      i+=2;
+      }
+    else if(std::strcmp(argv[i],"-anim-report")==0){
+      animReport = true;
+      }
+    else if(std::strcmp(argv[i],"-video-bench")==0){
+      ++i;
+      if(i<argc)
+        videoBench = TextCodec::toUtf16(argv[i]);
+      }
     }
 
   if(gpath.empty()){
@@ -43,12 +43,23 @@ class Gothic final {
       DirectX12
       };
 
+    struct BenchmarkSettings {
+      bool        enabled = false;
+      uint32_t    ticks   = 1000;
+      uint32_t    dt      = 16;
+      std::string report  = "benchmark.json";
+      };
+
     auto         version() const -> const VersionInfo&;
     auto         graphicsApi() const -> GraphicBackend;
 
     bool         isInGame() const;
     bool         doStartMenu() const { return !noMenu; }
     bool         doFrate() const { return !noFrate; }
+    bool         isHeadless() const { return bench.enabled || animReport || !videoBench.empty(); }
+    bool         doAnimReport() const { return animReport; }
+    auto         videoBenchFile() const -> const std::u16string& { return videoBench; }
+    auto         benchmarkSettings() const -> const BenchmarkSettings& { return bench; }
 
     void         setGame(std::unique_ptr<GameSession> &&w);
     auto         clearGame() -> std::unique_ptr<GameSession>;
@@ -158,6 +169,9 @@ class Gothic final {
     bool                                    noFrate=false;
     bool                                    isWindow=false;
     GraphicBackend                          graphics = GraphicBackend::Vulkan;
+    BenchmarkSettings                       bench;
+    bool                                    animReport=false;
+    std::u16string                          videoBench;
     uint16_t                                pauseSum=0;
     bool                                    isDebug=false;
     bool                                    isRambo=false;
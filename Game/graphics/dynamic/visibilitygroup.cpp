@@ -58,6 +58,8 @@ VisibilityGroup::Token VisibilityGroup::get() {
     } else {
     tokens.emplace_back();
     }
+  for(auto& v:tokens[id].visible)
+    v = true;
   // auto& t = tokens[id];
   // t.pos  = at;
   // t.bbox = bbox;
@@ -40,7 +40,7 @@ class VisibilityGroup {
     struct Tok {
       Tempest::Matrix4x4 pos;
       Bounds             bbox;
-      bool               visible[SceneGlobals::V_Count] = {};
+      bool               visible[SceneGlobals::V_Count] = {true,true,true}; // visible, until first pass tells otherwise
       };
 
     std::vector<Tok>    tokens;
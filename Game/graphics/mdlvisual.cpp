@@ -431,7 +431,7 @@ void MdlVisual::setTorch(bool t, World& owner) {
   //bind(torch,"ZS_LEFTHAND");
   }
 
-bool MdlVisual::updateAnimation(Npc* npc, World& world) {
+bool MdlVisual::updateAnimation(Npc* npc, World& world, Pose::Lod lod) {
   Pose&    pose      = *skInst;
   uint64_t tickCount = world.tickCount();
   auto     pos3      = Vec3{pos.at(3,0), pos.at(3,1), pos.at(3,2)};
@@ -451,7 +451,7 @@ bool MdlVisual::updateAnimation(Npc* npc, World& world) {
     }
 
   solver.update(tickCount);
-  const bool changed = pose.update(tickCount);
+  const bool changed = pose.update(tickCount,lod);
 
   if(changed) {
     syncAttaches();
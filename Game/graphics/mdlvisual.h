@@ -4,6 +4,7 @@
 #include <Tempest/Matrix4x4>
 
 #include "graphics/mesh/animationsolver.h"
+#include "graphics/mesh/pose.h"
 #include "graphics/pfx/pfxobjects.h"
 #include "game/constants.h"
 #include "meshobjects.h"
@@ -69,7 +70,8 @@ class MdlVisual final {
     void                           setTorch(bool t, World& owner);
 
     const Pose&                    pose() const { return *skInst; }
-    bool                           updateAnimation(Npc* npc, World& world);
+    bool                           updateAnimation(Npc* npc, World& world, Pose::Lod lod = Pose::LodFull);
+    bool                           isVisible(SceneGlobals::VisCamera c) const { return view.isVisible(c); }
     void                           processLayers  (World& world);
     auto                           mapBone(const size_t boneId) const -> Tempest::Vec3;
     auto                           mapWeaponBone() const -> Tempest::Vec3;
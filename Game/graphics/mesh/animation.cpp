@@ -311,7 +311,7 @@ Animation::Sequence::Sequence(const std::string &fname) {
         }
       case ZenLoad::ModelAnimationParser::CHUNK_RAWDATA:
         data->nodeIndex = std::move(p.getNodeIndex());
-        data->samples   = p.getSamples();
+        data->samples.assign(p.getSamples(),data->nodeIndex.size());
         break;
       case ZenLoad::ModelAnimationParser::CHUNK_ERROR:
         throw std::runtime_error("animation load error");
@@ -627,23 +627,17 @@ void Animation::Sequence::setupMoveTr() {
   }
 
 void Animation::AnimData::setupMoveTr() {
-  size_t sz = nodeIndex.size();
-
-  if(samples.size()>0 && samples.size()>=sz) {
-    auto& a = samples[0].position;
-    auto& b = samples[samples.size()-sz].position;
-    moveTr.x = b.x-a.x;
-    moveTr.y = b.y-a.y;
-    moveTr.z = b.z-a.z;
-
-    tr.resize(samples.size()/sz);
-    for(size_t i=0,r=0;i<samples.size();i+=sz,++r){
-      auto& p  = tr[r];
-      auto& bi = samples[i].position;
-      p.x = bi.x-a.x;
-      p.y = bi.y-a.y;
-      p.z = bi.z-a.z;
-      }
+  const size_t frames = samples.frameCount();
+
+  if(frames>0) {
+    auto a = samples.position(0,0);
+    auto b = samples.position(frames-1,0);
+    moveTr = b-a;
+
+    tr.resize(frames);
+    for(size_t r=0;r<frames;++r)
+      tr[r] = samples.position(r,0)-a;
+
     static const float eps = 0.4f;
     for(auto& i:tr) {
       if(std::fabs(i.x)<eps && std::fabs(i.y)<eps && std::fabs(i.z)<eps)
@@ -651,12 +645,7 @@ void Animation::AnimData::setupMoveTr() {
       hasMoveTr = true;
       break;
       }
-    }
-
-  if(samples.size()>0){
-    translate.x = samples[0].position.x;
-    translate.y = samples[0].position.y;
-    translate.z = samples[0].position.z;
+    translate = a;
     }
   }
 
@@ -4,6 +4,8 @@
 #include <Tempest/Vec>
 #include <memory>
 
+#include "animsamples.h"
+
 class Npc;
 class MdlVisual;
 class World;
@@ -49,7 +51,7 @@ class Animation final {
       Tempest::Vec3                               translate={};
       Tempest::Vec3                               moveTr={};
 
-      std::vector<ZenLoad::zCModelAniSample>      samples;
+      AnimSamples                                 samples;
       std::vector<uint32_t>                       nodeIndex;
       std::vector<Tempest::Vec3>                  tr;
       bool                                        hasMoveTr=false;
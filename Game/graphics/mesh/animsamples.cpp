@@ -0,0 +1,631 @@
+#include "animsamples.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "animmath.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define ANIM_SIMD_SSE 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ANIM_SIMD_NEON 1
+#endif
+
+using namespace Tempest;
+
+namespace {
+
+#if defined(ANIM_SIMD_SSE)
+using f4 = __m128;
+
+inline f4   load4 (const float* p)    { return _mm_loadu_ps(p);      }
+inline void store4(float* p, f4 v)    { _mm_storeu_ps(p,v);          }
+inline f4   splat4(float v)           { return _mm_set1_ps(v);       }
+inline f4   add4  (f4 a, f4 b)        { return _mm_add_ps(a,b);      }
+inline f4   sub4  (f4 a, f4 b)        { return _mm_sub_ps(a,b);      }
+inline f4   mul4  (f4 a, f4 b)        { return _mm_mul_ps(a,b);      }
+inline f4   div4  (f4 a, f4 b)        { return _mm_div_ps(a,b);      }
+inline f4   sqrt4 (f4 a)              { return _mm_sqrt_ps(a);       }
+// negates lanes of v, where s<0
+inline f4   negIfLess(f4 v, f4 s)    {
+  const f4 mask = _mm_and_ps(_mm_cmplt_ps(s,_mm_setzero_ps()),_mm_set1_ps(-0.f));
+  return _mm_xor_ps(v,mask);
+  }
+// bit per lane, where a<b
+inline int  lessMask(f4 a, f4 b)     { return _mm_movemask_ps(_mm_cmplt_ps(a,b)); }
+
+using u4 = __m128i;
+using m4 = __m128;
+
+inline f4   max4  (f4 a, f4 b)        { return _mm_max_ps(a,b);      }
+inline u4   loadu4(const uint32_t* p) { return _mm_load_si128(reinterpret_cast<const __m128i*>(p)); }
+inline u4   splatu4(uint32_t v)       { return _mm_set1_epi32(int(v)); }
+inline u4   and4  (u4 a, u4 b)        { return _mm_and_si128(a,b);   }
+inline u4   or4   (u4 a, u4 b)        { return _mm_or_si128(a,b);    }
+inline u4   shr15 (u4 a)              { return _mm_srli_epi32(a,15); }
+inline u4   shl1  (u4 a)              { return _mm_slli_epi32(a,1);  }
+inline f4   cvt4  (u4 a)              { return _mm_cvtepi32_ps(a);   } // lanes are 16 bit at most
+inline m4   eq4   (u4 a, uint32_t v)  { return _mm_castsi128_ps(_mm_cmpeq_epi32(a,splatu4(v))); }
+inline f4   select4(m4 m, f4 a, f4 b) { return _mm_or_ps(_mm_and_ps(m,a),_mm_andnot_ps(m,b)); }
+#elif defined(ANIM_SIMD_NEON)
+using f4 = float32x4_t;
+
+inline f4   load4 (const float* p)    { return vld1q_f32(p);         }
+inline void store4(float* p, f4 v)    { vst1q_f32(p,v);              }
+inline f4   splat4(float v)           { return vdupq_n_f32(v);       }
+inline f4   add4  (f4 a, f4 b)        { return vaddq_f32(a,b);       }
+inline f4   sub4  (f4 a, f4 b)        { return vsubq_f32(a,b);       }
+inline f4   mul4  (f4 a, f4 b)        { return vmulq_f32(a,b);       }
+inline f4   div4  (f4 a, f4 b)        { return vdivq_f32(a,b);       }
+inline f4   sqrt4 (f4 a)              { return vsqrtq_f32(a);        }
+inline f4   negIfLess(f4 v, f4 s)    {
+  const uint32x4_t mask = vcltq_f32(s,vdupq_n_f32(0.f));
+  return vbslq_f32(mask,vnegq_f32(v),v);
+  }
+inline int  lessMask(f4 a, f4 b)     {
+  static const uint32_t bits[4] = {1,2,4,8};
+  const uint32x4_t m = vandq_u32(vcltq_f32(a,b),vld1q_u32(bits));
+  return int(vaddvq_u32(m));
+  }
+
+using u4 = uint32x4_t;
+using m4 = uint32x4_t;
+
+inline f4   max4  (f4 a, f4 b)        { return vmaxq_f32(a,b);       }
+inline u4   loadu4(const uint32_t* p) { return vld1q_u32(p);         }
+inline u4   splatu4(uint32_t v)       { return vdupq_n_u32(v);       }
+inline u4   and4  (u4 a, u4 b)        { return vandq_u32(a,b);       }
+inline u4   or4   (u4 a, u4 b)        { return vorrq_u32(a,b);       }
+inline u4   shr15 (u4 a)              { return vshrq_n_u32(a,15);    }
+inline u4   shl1  (u4 a)              { return vshlq_n_u32(a,1);     }
+inline f4   cvt4  (u4 a)              { return vcvtq_f32_u32(a);     }
+inline m4   eq4   (u4 a, uint32_t v)  { return vceqq_u32(a,splatu4(v)); }
+inline f4   select4(m4 m, f4 a, f4 b) { return vbslq_f32(m,a,b);     }
+#endif
+
+using Quat = ZMath::float4;
+
+// smallest three components of unit quaternion are within [-1/sqrt(2), 1/sqrt(2)]
+const float    rotRange = 0.70710678f;
+const float    rotQuant = 32767.f;
+const float    posQuant = 65535.f;
+// longest interval between key frames; bounds cost of key reduction
+const size_t   maxSpan  = 64;
+
+Quat quat(float x, float y, float z, float w) {
+  Quat q;
+  q.x = x;
+  q.y = y;
+  q.z = z;
+  q.w = w;
+  return q;
+  }
+
+void encodeRot(const Quat& q, uint16_t* v) {
+  const float c[4] = {q.x, q.y, q.z, q.w};
+  int big = 0;
+  for(int i=1; i<4; ++i)
+    if(std::abs(c[i])>std::abs(c[big]))
+      big = i;
+
+  // q and -q are same rotation: largest component is stored positive, so it's sign is implied
+  const float sgn = c[big]<0 ? -1.f : 1.f;
+  int         r   = 0;
+  for(int i=0; i<4; ++i) {
+    if(i==big)
+      continue;
+    const float x = std::max(-1.f,std::min(1.f,c[i]*sgn/rotRange));
+    v[r] = uint16_t(std::lround((x*0.5f+0.5f)*rotQuant));
+    ++r;
+    }
+  v[0] = uint16_t(v[0] | ((big&1)<<15));
+  v[1] = uint16_t(v[1] | ((big>>1)<<15));
+  }
+
+Quat decodeRot(const uint16_t* v) {
+  const int big = (v[0]>>15) | ((v[1]>>15)<<1);
+  float     c[4] = {};
+  float     sum  = 0;
+  int       r    = 0;
+  for(int i=0; i<4; ++i) {
+    if(i==big)
+      continue;
+    const float x = (float(v[r]&0x7FFF)/rotQuant*2.f-1.f)*rotRange;
+    c[i] = x;
+    sum += x*x;
+    ++r;
+    }
+  c[big] = std::sqrt(std::max(0.f,1.f-sum));
+  return quat(c[0],c[1],c[2],c[3]);
+  }
+
+float dot(const Quat& a, const Quat& b) {
+  return a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
+  }
+
+Quat nlerp(const Quat& a, const Quat& b, float t) {
+  const float t1 = 1.f-t;
+  const float tb = dot(a,b)<0 ? -t : t;
+  Quat q = quat(a.x*t1+b.x*tb, a.y*t1+b.y*tb, a.z*t1+b.z*tb, a.w*t1+b.w*tb);
+  const float l = std::sqrt(dot(q,q));
+  return quat(q.x/l, q.y/l, q.z/l, q.w/l);
+  }
+
+float rotError(const Quat& a, const Quat& b) {
+  const float s = dot(a,b)<0 ? -1.f : 1.f;
+  return std::max(std::max(std::abs(a.x-b.x*s),std::abs(a.y-b.y*s)),
+                  std::max(std::abs(a.z-b.z*s),std::abs(a.w-b.w*s)));
+  }
+
+float component(const ZMath::float3& v, int c) {
+  return c==0 ? v.x : (c==1 ? v.y : v.z);
+  }
+
+float posError(const Vec3& a, const ZMath::float3& b) {
+  return std::max(std::abs(a.x-b.x),std::max(std::abs(a.y-b.y),std::abs(a.z-b.z)));
+  }
+
+// greedy key reduction: every key interval is extended, while frames inside of it can be interpolated
+template<class Fits>
+void reduceKeys(size_t frames, std::vector<uint16_t>& keys, Fits fits) {
+  keys.push_back(0);
+  size_t k0 = 0;
+  while(k0+1<frames) {
+    size_t k1 = k0+1;
+    while(k1+1<frames && k1+1-k0<=maxSpan && fits(k0,k1+1))
+      ++k1;
+    keys.push_back(uint16_t(k1));
+    k0 = k1;
+    }
+  }
+
+// finds key interval of frame: keys[k]<=frame<keys[k+1];
+// search starts from interval of previous update, playback rarely moves further than a few keys
+size_t locate(const uint16_t* keys, uint32_t count, size_t frame, uint16_t& cur, float& t) {
+  size_t k = cur<count ? cur : 0;
+  if(keys[k]<=frame) {
+    for(int i=0; i<4 && k+1<count && keys[k+1]<=frame; ++i)
+      ++k;
+    if(k+1<count && keys[k+1]<=frame)
+      k = size_t(std::upper_bound(keys+k+1,keys+count,frame)-keys)-1;
+    }
+  else if(k>0 && keys[k-1]<=frame) {
+    // reversed playback
+    --k;
+    }
+  else {
+    // first key is always frame 0
+    k = size_t(std::upper_bound(keys,keys+k,frame)-keys)-1;
+    }
+  cur = uint16_t(k);
+
+  if(k+1>=count) {
+    t = 0;
+    return k;
+    }
+  t = float(frame-keys[k])/float(keys[k+1]-keys[k]);
+  return k;
+  }
+
+#if defined(ANIM_SIMD_SSE) || defined(ANIM_SIMD_NEON)
+// smallest-three decoding of four keys at once, see decodeRot
+void decodeRot4(const uint32_t (&v)[3][AnimSamples::Lanes], f4& x, f4& y, f4& z, f4& w) {
+  const u4 v0  = loadu4(v[0]), v1 = loadu4(v[1]), v2 = loadu4(v[2]);
+  const u4 big = or4(shr15(v0),shl1(shr15(v1)));
+  const u4 low = splatu4(0x7FFF);
+  const f4 q   = splat4(rotQuant), rg = splat4(rotRange);
+  const f4 one = splat4(1.f),      two = splat4(2.f);
+
+  const f4 c0  = mul4(sub4(mul4(div4(cvt4(and4(v0,low)),q),two),one),rg);
+  const f4 c1  = mul4(sub4(mul4(div4(cvt4(and4(v1,low)),q),two),one),rg);
+  const f4 c2  = mul4(sub4(mul4(div4(cvt4(v2),q),two),one),rg);
+  const f4 sum = add4(add4(mul4(c0,c0),mul4(c1,c1)),mul4(c2,c2));
+  const f4 cb  = sqrt4(max4(splat4(0.f),sub4(one,sum)));
+
+  const m4 b0 = eq4(big,0), b1 = eq4(big,1), b2 = eq4(big,2), b3 = eq4(big,3);
+  x = select4(b0,cb,c0);
+  y = select4(b0,c0,select4(b1,cb,c1));
+  z = select4(b2,cb,select4(b3,c2,c1));
+  w = select4(b3,cb,c2);
+  }
+#endif
+
+ZenLoad::zCModelAniSample sampleAt(const float* soa, size_t stride, size_t i) {
+  ZenLoad::zCModelAniSample s;
+  s.rotation.x = soa[AnimSamples::RotX*stride+i];
+  s.rotation.y = soa[AnimSamples::RotY*stride+i];
+  s.rotation.z = soa[AnimSamples::RotZ*stride+i];
+  s.rotation.w = soa[AnimSamples::RotW*stride+i];
+  s.position.x = soa[AnimSamples::PosX*stride+i];
+  s.position.y = soa[AnimSamples::PosY*stride+i];
+  s.position.z = soa[AnimSamples::PosZ*stride+i];
+  return s;
+  }
+
+}
+
+AnimSamples::Tolerance AnimSamples::tol;
+
+void AnimSamples::setTolerance(const Tolerance& t) {
+  tol = t;
+  }
+
+const AnimSamples::Tolerance& AnimSamples::tolerance() {
+  return tol;
+  }
+
+void AnimSamples::assign(const std::vector<ZenLoad::zCModelAniSample>& src, size_t nodeCnt) {
+  rotTracks.clear();
+  posTracks.clear();
+  posRange .clear();
+  rotFrames.clear();
+  posFrames.clear();
+  rotKeys  .clear();
+  posKeys  .clear();
+
+  nodes    = nodeCnt;
+  frames   = nodeCnt==0 ? 0 : src.size()/nodeCnt;
+  frames   = std::min<size_t>(frames,0x10000); // key frame number is 16 bit
+  if(frames==0)
+    return;
+
+  rotTracks.resize(nodes);
+  posTracks.resize(nodes);
+  posRange .resize(nodes);
+
+  std::vector<Key>      qk(frames), pk(frames);
+  std::vector<Quat>     q (frames);
+  std::vector<Vec3>     p (frames);
+  std::vector<uint16_t> keep;
+  for(size_t n=0; n<nodes; ++n) {
+    auto smp = [&](size_t f) -> const ZenLoad::zCModelAniSample& { return src[f*nodes+n]; };
+
+    // rotation
+    for(size_t f=0; f<frames; ++f) {
+      encodeRot(smp(f).rotation,qk[f].v);
+      q[f] = decodeRot(qk[f].v);
+      }
+    bool constant = true;
+    for(size_t f=1; f<frames && constant; ++f)
+      constant = rotError(q[0],smp(f).rotation)<=tol.rotation;
+    keep.clear();
+    if(constant) {
+      keep.push_back(0);
+      } else {
+      reduceKeys(frames,keep,[&](size_t k0, size_t k1){
+        for(size_t f=k0+1; f<k1; ++f) {
+          const float t = float(f-k0)/float(k1-k0);
+          if(rotError(nlerp(q[k0],q[k1],t),smp(f).rotation)>tol.rotation)
+            return false;
+          }
+        return true;
+        });
+      }
+    rotTracks[n].first = uint32_t(rotKeys.size());
+    rotTracks[n].count = uint32_t(keep.size());
+    for(auto k:keep) {
+      rotFrames.push_back(k);
+      rotKeys  .push_back(qk[k]);
+      }
+
+    // translation
+    auto& rg = posRange[n];
+    for(int c=0; c<3; ++c) {
+      float mn = component(smp(0).position,c), mx = mn;
+      for(size_t f=1; f<frames; ++f) {
+        const float v = component(smp(f).position,c);
+        mn = std::min(mn,v);
+        mx = std::max(mx,v);
+        }
+      rg.min  [c] = mn;
+      rg.scale[c] = (mx-mn)/posQuant;
+      }
+    for(size_t f=0; f<frames; ++f) {
+      for(int c=0; c<3; ++c) {
+        const float v = component(smp(f).position,c);
+        pk[f].v[c] = rg.scale[c]>0 ? uint16_t(std::lround((v-rg.min[c])/rg.scale[c])) : 0;
+        }
+      p[f] = translation(n,pk[f]);
+      }
+    constant = true;
+    for(size_t f=1; f<frames && constant; ++f)
+      constant = posError(p[0],smp(f).position)<=tol.position;
+    keep.clear();
+    if(constant) {
+      keep.push_back(0);
+      } else {
+      reduceKeys(frames,keep,[&](size_t k0, size_t k1){
+        for(size_t f=k0+1; f<k1; ++f) {
+          const float t = float(f-k0)/float(k1-k0);
+          if(posError(p[k0]+(p[k1]-p[k0])*t,smp(f).position)>tol.position)
+            return false;
+          }
+        return true;
+        });
+      }
+    posTracks[n].first = uint32_t(posKeys.size());
+    posTracks[n].count = uint32_t(keep.size());
+    for(auto k:keep) {
+      posFrames.push_back(k);
+      posKeys  .push_back(pk[k]);
+      }
+    }
+
+  rotFrames.shrink_to_fit();
+  posFrames.shrink_to_fit();
+  rotKeys  .shrink_to_fit();
+  posKeys  .shrink_to_fit();
+  }
+
+size_t AnimSamples::memoryUsage() const {
+  return rotTracks.capacity()*sizeof(Track) + posTracks.capacity()*sizeof(Track) +
+         posRange .capacity()*sizeof(Range) +
+         rotFrames.capacity()*sizeof(uint16_t) + posFrames.capacity()*sizeof(uint16_t) +
+         rotKeys  .capacity()*sizeof(Key) + posKeys.capacity()*sizeof(Key);
+  }
+
+ZenLoad::zCModelAniSample AnimSamples::at(size_t f, size_t node) const {
+  const Vec3 pos = translation(node,f);
+  ZenLoad::zCModelAniSample s;
+  s.rotation   = rotation(node,f);
+  s.position.x = pos.x;
+  s.position.y = pos.y;
+  s.position.z = pos.z;
+  return s;
+  }
+
+Vec3 AnimSamples::position(size_t f, size_t node) const {
+  return translation(node,f);
+  }
+
+AnimSamples::Span AnimSamples::span(const Track& tr, const std::vector<uint16_t>& keyFrames, size_t f, uint16_t* cur) {
+  Span ret;
+  ret.k0 = tr.first;
+  ret.k1 = tr.first;
+  if(tr.count==1)
+    return ret;
+  uint16_t     tmp = 0;
+  const size_t k   = locate(keyFrames.data()+tr.first,tr.count,f,cur!=nullptr ? *cur : tmp,ret.t);
+  ret.k0 = tr.first+uint32_t(k);
+  ret.k1 = ret.t>0 ? ret.k0+1 : ret.k0;
+  return ret;
+  }
+
+ZMath::float4 AnimSamples::rotation(size_t node, size_t f) const {
+  const Span sp = span(rotTracks[node],rotFrames,f,nullptr);
+  if(sp.k0==sp.k1)
+    return decodeRot(rotKeys[sp.k0].v);
+  return nlerp(decodeRot(rotKeys[sp.k0].v),decodeRot(rotKeys[sp.k1].v),sp.t);
+  }
+
+Vec3 AnimSamples::translation(size_t node, size_t f) const {
+  const Span sp = span(posTracks[node],posFrames,f,nullptr);
+  const Vec3 a  = translation(node,posKeys[sp.k0]);
+  if(sp.k0==sp.k1)
+    return a;
+  const Vec3 b  = translation(node,posKeys[sp.k1]);
+  return a+(b-a)*sp.t;
+  }
+
+Vec3 AnimSamples::translation(size_t node, const Key& k) const {
+  auto& rg = posRange[node];
+  return Vec3(rg.min[0]+float(k.v[0])*rg.scale[0],
+              rg.min[1]+float(k.v[1])*rg.scale[1],
+              rg.min[2]+float(k.v[2])*rg.scale[2]);
+  }
+
+void AnimSamples::decodeBlock(size_t f, size_t begin, const uint8_t* use, uint16_t* rotCur, uint16_t* posCur,
+                              float* soa) const {
+#if defined(ANIM_SIMD_SSE) || defined(ANIM_SIMD_NEON)
+  // gather key pairs of each lane, dequantization and interpolation run on all lanes at once
+  alignas(16) uint32_t ra[3][Lanes] = {}, rb[3][Lanes] = {};
+  alignas(16) uint32_t pa[3][Lanes] = {}, pb[3][Lanes] = {};
+  alignas(16) float    mn[3][Lanes] = {}, sc[3][Lanes] = {};
+  alignas(16) float    rt[Lanes]    = {}, pt[Lanes]    = {};
+
+  for(size_t r=0; r<Lanes; ++r) {
+    const size_t n = begin+r;
+    if(n>=nodes || !use[r])
+      continue;
+    const Span rs = span(rotTracks[n],rotFrames,f,rotCur!=nullptr ? rotCur+n : nullptr);
+    const Span ps = span(posTracks[n],posFrames,f,posCur!=nullptr ? posCur+n : nullptr);
+    auto&      rg = posRange[n];
+    for(size_t c=0; c<3; ++c) {
+      ra[c][r] = rotKeys[rs.k0].v[c];
+      rb[c][r] = rotKeys[rs.k1].v[c];
+      pa[c][r] = posKeys[ps.k0].v[c];
+      pb[c][r] = posKeys[ps.k1].v[c];
+      mn[c][r] = rg.min[c];
+      sc[c][r] = rg.scale[c];
+      }
+    rt[r] = rs.t;
+    pt[r] = ps.t;
+    }
+
+  f4 ax, ay, az, aw, bx, by, bz, bw;
+  decodeRot4(ra,ax,ay,az,aw);
+  decodeRot4(rb,bx,by,bz,bw);
+
+  // nlerp inside of track, same as scalar one
+  const f4 t   = load4(rt);
+  const f4 t1  = sub4(splat4(1.f),t);
+  const f4 dot = add4(add4(add4(mul4(ax,bx),mul4(ay,by)),mul4(az,bz)),mul4(aw,bw));
+  bx = negIfLess(bx,dot);
+  by = negIfLess(by,dot);
+  bz = negIfLess(bz,dot);
+  bw = negIfLess(bw,dot);
+  f4 x = add4(mul4(ax,t1),mul4(bx,t));
+  f4 y = add4(mul4(ay,t1),mul4(by,t));
+  f4 z = add4(mul4(az,t1),mul4(bz,t));
+  f4 w = add4(mul4(aw,t1),mul4(bw,t));
+  const f4 l = sqrt4(add4(add4(add4(mul4(x,x),mul4(y,y)),mul4(z,z)),mul4(w,w)));
+  store4(soa+RotX*Lanes,div4(x,l));
+  store4(soa+RotY*Lanes,div4(y,l));
+  store4(soa+RotZ*Lanes,div4(z,l));
+  store4(soa+RotW*Lanes,div4(w,l));
+
+  const f4 tp = load4(pt);
+  for(size_t c=0; c<3; ++c) {
+    const f4 m = load4(mn[c]), s = load4(sc[c]);
+    const f4 a = add4(m,mul4(cvt4(loadu4(pa[c])),s));
+    const f4 b = add4(m,mul4(cvt4(loadu4(pb[c])),s));
+    store4(soa+(PosX+c)*Lanes,add4(a,mul4(sub4(b,a),tp)));
+    }
+#else
+  for(size_t r=0; r<Lanes; ++r) {
+    const size_t n = begin+r;
+    if(n>=nodes || !use[r])
+      continue;
+    const Span rs = span(rotTracks[n],rotFrames,f,rotCur!=nullptr ? rotCur+n : nullptr);
+    const Span ps = span(posTracks[n],posFrames,f,posCur!=nullptr ? posCur+n : nullptr);
+    Quat q = decodeRot(rotKeys[rs.k0].v);
+    if(rs.k0!=rs.k1)
+      q = nlerp(q,decodeRot(rotKeys[rs.k1].v),rs.t);
+    Vec3 p = translation(n,posKeys[ps.k0]);
+    if(ps.k0!=ps.k1)
+      p = p+(translation(n,posKeys[ps.k1])-p)*ps.t;
+    soa[RotX*Lanes+r] = q.x;
+    soa[RotY*Lanes+r] = q.y;
+    soa[RotZ*Lanes+r] = q.z;
+    soa[RotW*Lanes+r] = q.w;
+    soa[PosX*Lanes+r] = p.x;
+    soa[PosY*Lanes+r] = p.y;
+    soa[PosZ*Lanes+r] = p.z;
+    }
+#endif
+
+  // unused lanes hold identity
+  for(size_t r=0; r<Lanes; ++r) {
+    if(begin+r<nodes && use[r])
+      continue;
+    for(size_t c=0; c<ChannelCount; ++c)
+      soa[c*Lanes+r] = (c==RotW ? 1.f : 0.f);
+    }
+  }
+
+void AnimSamples::mix(size_t frameA, size_t frameB, float a, const uint32_t* nodeIndex, const uint8_t* skip,
+                      Matrix4x4* out, Cursor* cursor) const {
+  if(frames==0)
+    return;
+  frameA = std::min(frameA,frames-1);
+  frameB = std::min(frameB,frames-1);
+
+  uint16_t* rotCur = nullptr;
+  uint16_t* posCur = nullptr;
+  if(cursor!=nullptr) {
+    if(cursor->owner!=this || cursor->rot.size()!=nodes) {
+      cursor->owner = this;
+      cursor->rot.assign(nodes,0);
+      cursor->pos.assign(nodes,0);
+      }
+    rotCur = cursor->rot.data();
+    posCur = cursor->pos.data();
+    }
+
+  alignas(16) float da[ChannelCount*Lanes];
+  alignas(16) float db[ChannelCount*Lanes];
+
+  for(size_t i=0; i<nodes; i+=Lanes) {
+    const size_t cnt  = std::min<size_t>(Lanes,nodes-i);
+    uint8_t      use[Lanes] = {};
+    size_t       used = 0;
+    for(size_t r=0; r<cnt; ++r) {
+      use[r] = (skip==nullptr || !skip[nodeIndex[i+r]]) ? 1 : 0;
+      used  += use[r];
+      }
+    if(used==0)
+      continue;
+
+    // only lanes in use are decoded
+    decodeBlock(frameA,i,use,rotCur,posCur,da);
+    const float* sa = da;
+    const float* sb = da;
+    if(frameB!=frameA) {
+      decodeBlock(frameB,i,use,rotCur,posCur,db);
+      sb = db;
+      }
+
+#if defined(ANIM_SIMD_SSE) || defined(ANIM_SIMD_NEON)
+    const f4 t  = splat4(a);
+    const f4 t1 = splat4(1.f-a);
+    const f4 th = splat4(0.95f);
+    const f4 two= splat4(2.f);
+
+    const f4 ax = load4(sa+RotX*Lanes), ay = load4(sa+RotY*Lanes);
+    const f4 az = load4(sa+RotZ*Lanes), aw = load4(sa+RotW*Lanes);
+    f4       bx = load4(sb+RotX*Lanes), by = load4(sb+RotY*Lanes);
+    f4       bz = load4(sb+RotZ*Lanes), bw = load4(sb+RotW*Lanes);
+
+    // shortest path: flip second quaternion, if they are more than 90 degrees apart
+    const f4 dot = add4(add4(add4(mul4(ax,bx),mul4(ay,by)),mul4(az,bz)),mul4(aw,bw));
+    bx = negIfLess(bx,dot);
+    by = negIfLess(by,dot);
+    bz = negIfLess(bz,dot);
+    bw = negIfLess(bw,dot);
+    const f4 adot = negIfLess(dot,dot);
+
+    // nlerp; lanes with large angle are redone with scalar slerp below
+    f4 x = add4(mul4(ax,t1),mul4(bx,t));
+    f4 y = add4(mul4(ay,t1),mul4(by,t));
+    f4 z = add4(mul4(az,t1),mul4(bz,t));
+    f4 w = add4(mul4(aw,t1),mul4(bw,t));
+    const f4 l = sqrt4(add4(add4(add4(mul4(x,x),mul4(y,y)),mul4(z,z)),mul4(w,w)));
+    x = div4(x,l);
+    y = div4(y,l);
+    z = div4(z,l);
+    w = div4(w,l);
+
+    const f4 pa_x = load4(sa+PosX*Lanes), pa_y = load4(sa+PosY*Lanes), pa_z = load4(sa+PosZ*Lanes);
+    const f4 px   = add4(pa_x,mul4(sub4(load4(sb+PosX*Lanes),pa_x),t));
+    const f4 py   = add4(pa_y,mul4(sub4(load4(sb+PosY*Lanes),pa_y),t));
+    const f4 pz   = add4(pa_z,mul4(sub4(load4(sb+PosZ*Lanes),pa_z),t));
+
+    const f4 xx = mul4(x,x), yy = mul4(y,y), zz = mul4(z,z), ww = mul4(w,w);
+    const f4 xy = mul4(x,y), xz = mul4(x,z), yz = mul4(y,z);
+    const f4 wx = mul4(w,x), wy = mul4(w,y), wz = mul4(w,z);
+
+    // same element order as mkMatrix
+    alignas(16) float m[12][Lanes];
+    store4(m[ 0], sub4(sub4(add4(ww,xx),yy),zz));
+    store4(m[ 1], mul4(two,sub4(xy,wz)));
+    store4(m[ 2], mul4(two,add4(xz,wy)));
+    store4(m[ 3], mul4(two,add4(xy,wz)));
+    store4(m[ 4], sub4(add4(sub4(ww,xx),yy),zz));
+    store4(m[ 5], mul4(two,sub4(yz,wx)));
+    store4(m[ 6], mul4(two,sub4(xz,wy)));
+    store4(m[ 7], mul4(two,add4(yz,wx)));
+    store4(m[ 8], add4(sub4(sub4(ww,xx),yy),zz));
+    store4(m[ 9], px);
+    store4(m[10], py);
+    store4(m[11], pz);
+
+    const int slerpLanes = lessMask(adot,th);
+    for(size_t r=0; r<cnt; ++r) {
+      if(!use[r])
+        continue;
+      if(slerpLanes&(1<<r)) {
+        mixScalar(sa,sb,a,r,nodeIndex[i+r],out);
+        continue;
+        }
+      const float v[16] = {
+        m[0][r], m[1][r], m[2][r],  0,
+        m[3][r], m[4][r], m[5][r],  0,
+        m[6][r], m[7][r], m[8][r],  0,
+        m[9][r], m[10][r],m[11][r], 1
+        };
+      out[nodeIndex[i+r]] = Matrix4x4(v);
+      }
+#else
+    for(size_t r=0; r<cnt; ++r)
+      if(use[r])
+        mixScalar(sa,sb,a,r,nodeIndex[i+r],out);
+#endif
+    }
+  }
+
+void AnimSamples::mixScalar(const float* sa, const float* sb, float a, size_t lane, uint32_t node, Matrix4x4* out) {
+  auto smp = ::mix(sampleAt(sa,Lanes,lane),sampleAt(sb,Lanes,lane),a);
+  out[node] = mkMatrix(smp);
+  }
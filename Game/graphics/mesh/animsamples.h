@@ -0,0 +1,104 @@
+#pragma once
+
+#include <zenload/zTypes.h>
+#include <Tempest/Matrix4x4>
+#include <Tempest/Point>
+
+#include <vector>
+#include <cstdint>
+
+// Key frames of all animated nodes, stored compressed:
+//  * rotations are quantized with smallest-three encoding, 48 bits per key;
+//  * positions are quantized to 16 bit per component, within range of each track;
+//  * track, that doesn't change, is stored as single key; other tracks keep only key frames,
+//    that can't be interpolated from their neighbours within tolerance.
+// Frames are decoded on demand, 'Lanes' nodes at once, into SoA block of channels (rotation xyzw, position xyz).
+class AnimSamples final {
+  public:
+    enum Channel : uint8_t {
+      RotX,
+      RotY,
+      RotZ,
+      RotW,
+      PosX,
+      PosY,
+      PosZ,
+      ChannelCount
+      };
+
+    enum : size_t {
+      Lanes = 4
+      };
+
+    struct Tolerance {
+      float rotation = 0.0005f; // quaternion component
+      float position = 0.05f;   // cm
+      };
+
+    // per-caller playback state: key interval of every track, found on previous update
+    struct Cursor {
+      const AnimSamples*    owner = nullptr;
+      std::vector<uint16_t> rot, pos;
+      };
+
+    static void             setTolerance(const Tolerance& t);
+    static const Tolerance& tolerance();
+
+    void   assign(const std::vector<ZenLoad::zCModelAniSample>& src, size_t nodes);
+
+    bool   empty()      const { return frames==0; }
+    size_t nodeCount()  const { return nodes;     }
+    size_t frameCount() const { return frames;    }
+    size_t keyCount()   const { return rotKeys.size()+posKeys.size(); }
+    size_t memoryUsage() const;
+
+    ZenLoad::zCModelAniSample at(size_t frame, size_t node) const;
+    Tempest::Vec3             position(size_t frame, size_t node) const;
+
+    // out[nodeIndex[i]] = mkMatrix(mix(frameA[i],frameB[i],a)), several nodes at once;
+    // optional skip is indexed by out-node, nodes with non-zero flag are neither decoded nor written;
+    // optional cursor speeds up key search of sequential updates
+    void   mix(size_t frameA, size_t frameB, float a, const uint32_t* nodeIndex, const uint8_t* skip,
+               Tempest::Matrix4x4* out, Cursor* cursor = nullptr) const;
+
+  private:
+    struct Key {
+      uint16_t v[3] = {};
+      };
+
+    struct Track {
+      uint32_t first = 0; // index of first key
+      uint32_t count = 0; // 1, if track is constant
+      };
+
+    struct Range {
+      float    min  [3] = {};
+      float    scale[3] = {};
+      };
+
+    // frame is interpolated between keys k0 and k1; k0==k1 if frame is a key
+    struct Span {
+      uint32_t k0 = 0;
+      uint32_t k1 = 0;
+      float    t  = 0;
+      };
+
+    ZMath::float4 rotation(size_t node, size_t frame) const;
+    Tempest::Vec3 translation(size_t node, size_t frame) const;
+    Tempest::Vec3 translation(size_t node, const Key& k) const;
+
+    static Span   span(const Track& tr, const std::vector<uint16_t>& keyFrames, size_t frame, uint16_t* cur);
+    // writes ChannelCount*Lanes floats, nodes [begin,begin+Lanes)
+    void          decodeBlock(size_t frame, size_t begin, const uint8_t* use, uint16_t* rotCur, uint16_t* posCur,
+                              float* soa) const;
+    static void   mixScalar(const float* sa, const float* sb, float a, size_t lane, uint32_t node, Tempest::Matrix4x4* out);
+
+    std::vector<Track>    rotTracks, posTracks;
+    std::vector<Range>    posRange;
+    std::vector<uint16_t> rotFrames, posFrames;
+    std::vector<Key>      rotKeys,   posKeys;
+    size_t                nodes    = 0;
+    size_t                frames   = 0;
+
+    static Tolerance      tol;
+  };
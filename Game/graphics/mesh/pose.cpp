@@ -5,8 +5,8 @@
 #include "world/objects/npc.h"
 #include "world/world.h"
 #include "game/serialize.h"
+#include "utils/perfcounters.h"
 #include "skeleton.h"
-#include "animmath.h"
 
 #include <cmath>
 
@@ -263,7 +263,10 @@ void Pose::processLayers(AnimationSolver& solver, uint64_t tickCount) {
     }
   }
 
-bool Pose::update(uint64_t tickCount) {
+bool Pose::update(uint64_t tickCount, Lod lod) {
+  // update interval in ms, for each lod
+  static const uint64_t lodInterval[] = {0, 50, 100, 0};
+
   if(lay.size()==0){
     if(lastUpdate==0){
       zeroSkeleton();
@@ -277,14 +280,25 @@ bool Pose::update(uint64_t tickCount) {
     return ret;
     }
 
+  if(lastUpdate!=0 && lod==LodFrozen) {
+    PerfCounters::count(PerfCounters::PoseFrozen);
+    return false;
+    }
+  if(lastUpdate!=0 && tickCount<lastUpdate+lodInterval[lod]) {
+    PerfCounters::count(PerfCounters::PoseThrottled);
+    return false;
+    }
+
   if(lastUpdate!=tickCount) {
+    // fingers and toes are not visible at distance: keep their last local transform
+    const uint8_t* skip = (lod>=LodFar && skeleton!=nullptr) ? skeleton->detail.data() : nullptr;
     for(auto& i:lay) {
       const Animation::Sequence* seq = i.seq;
       if(0<i.comb && i.comb<=i.seq->comb.size()) {
         if(auto sx = i.seq->comb[size_t(i.comb-1)])
           seq = sx;
         }
-      needToUpdate |= updateFrame(*seq,lastUpdate,i.sAnim,tickCount);
+      needToUpdate |= updateFrame(*seq,lastUpdate,i.sAnim,tickCount,skip,i.cursor);
       }
     lastUpdate = tickCount;
     }
@@ -292,17 +306,19 @@ bool Pose::update(uint64_t tickCount) {
   if(needToUpdate) {
     mkSkeleton(*lay[0].seq,lay[0].bs);
     needToUpdate = false;
+    PerfCounters::count(PerfCounters::Event(PerfCounters::PoseFull+std::min<uint8_t>(lod,LodFar)));
     return true;
     }
   return false;
   }
 
 bool Pose::updateFrame(const Animation::Sequence &s,
-                       uint64_t barrier, uint64_t sTime, uint64_t now) {
+                       uint64_t barrier, uint64_t sTime, uint64_t now, const uint8_t* skip,
+                       AnimSamples::Cursor& cursor) {
   auto&        d         = *s.data;
   const size_t numFrames = d.numFrames;
   const size_t idSize    = d.nodeIndex.size();
-  if(numFrames==0 || idSize==0 || d.samples.size()%idSize!=0)
+  if(numFrames==0 || idSize==0 || d.samples.nodeCount()!=idSize || d.samples.frameCount()<numFrames)
     return false;
   if(numFrames==1 && !needToUpdate)
     return false;
@@ -330,13 +346,7 @@ bool Pose::updateFrame(const Animation::Sequence &s,
     frameB = d.numFrames-1-frameB;
     }
 
-  auto* sampleA = &d.samples[size_t(frameA*idSize)];
-  auto* sampleB = &d.samples[size_t(frameB*idSize)];
-
-  for(size_t i=0;i<idSize;++i) {
-    auto smp = mix(sampleA[i],sampleB[i],a);
-    base[d.nodeIndex[i]] = mkMatrix(smp);
-    }
+  d.samples.mix(size_t(frameA),size_t(frameB),a,d.nodeIndex.data(),skip,base.data(),&cursor);
   return true;
   }
 
@@ -344,16 +354,14 @@ void Pose::mkSkeleton(const Animation::Sequence &s, BodyState bs) {
   if(skeleton==nullptr)
     return;
   Matrix4x4 m = mkBaseTranslation(&s,bs);
-  if(skeleton->ordered)
-    mkSkeleton(m); else
-    mkSkeleton(m,size_t(-1));
+  mkSkeleton(m);
   }
 
 void Pose::mkSkeleton(const Matrix4x4 &mt) {
   if(skeleton==nullptr)
     return;
   auto& nodes=skeleton->nodes;
-  for(size_t i=0; i<nodes.size(); ++i) {
+  for(auto i:skeleton->order) {
     if(nodes[i].parent==size_t(-1)) {
       tr[i] = mt*base[i];
       } else {
@@ -362,18 +370,6 @@ void Pose::mkSkeleton(const Matrix4x4 &mt) {
     }
   }
 
-void Pose::mkSkeleton(const Tempest::Matrix4x4 &mt, size_t parent) {
-  if(skeleton==nullptr)
-    return;
-  auto& nodes=skeleton->nodes;
-  for(size_t i=0;i<nodes.size();++i){
-    if(nodes[i].parent!=parent)
-      continue;
-    tr[i] = mt*base[i];
-    mkSkeleton(tr[i],i);
-    }
-  }
-
 const Animation::Sequence* Pose::getNext(const AnimationSolver &solver, const Layer& lay) {
   auto sq = lay.seq;
 
@@ -22,6 +22,14 @@ class Pose final {
       NoTranslation = 1, // usefull for mobsi
       };
 
+    // animation level of detail: far poses are sampled less often, occluded ones are not sampled at all
+    enum Lod : uint8_t {
+      LodFull,
+      LodReduced,
+      LodFar,
+      LodFrozen,
+      };
+
     enum StartHint {
       NoHint     = 0x0,
       Force      = 0x1,
@@ -44,7 +52,7 @@ class Pose final {
     bool               stopWalkAnim();
     void               interrupt();
     void               stopAllAnim();
-    bool               update(uint64_t tickCount);
+    bool               update(uint64_t tickCount, Lod lod = LodFull);
 
     void               processLayers(AnimationSolver &solver, uint64_t tickCount);
     void               processEvents(uint64_t& barrier, uint64_t now, Animation::EvCount &ev) const;
@@ -86,15 +94,16 @@ class Pose final {
       uint64_t                   sAnim   = 0;
       uint8_t                    comb    = 0;
       BodyState                  bs      = BS_NONE;
+      AnimSamples::Cursor        cursor;
       };
 
     auto mkBaseTranslation(const Animation::Sequence *s, BodyState bs) -> Tempest::Matrix4x4;
     void mkSkeleton(const Animation::Sequence &s, BodyState bs);
     void mkSkeleton(const Tempest::Matrix4x4 &mt);
-    void mkSkeleton(const Tempest::Matrix4x4 &mt, size_t parent);
     void zeroSkeleton();
 
-    bool updateFrame(const Animation::Sequence &s, uint64_t barrier, uint64_t sTime, uint64_t now);
+    bool updateFrame(const Animation::Sequence &s, uint64_t barrier, uint64_t sTime, uint64_t now, const uint8_t* skip,
+                     AnimSamples::Cursor& cursor);
 
     const Animation::Sequence* getNext(const AnimationSolver& solver, const Layer& lay);
 
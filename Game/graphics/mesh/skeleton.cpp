@@ -25,15 +25,16 @@ Skeleton::Skeleton(const ZenLoad::zCModelMeshLib &src, std::string meshLib)
   for(auto& i:tr)
     i.identity();
 
-  for(size_t i=0;i<nodes.size();++i) {
-    if(nodes[i].parent>=i && nodes[i].parent!=size_t(-1)) {
-      ordered=false;
-      break;
-      }
-    }
   for(size_t i=0;i<nodes.size();++i)
     if(nodes[i].parent==size_t(-1))
       rootNodes.push_back(i);
+  mkOrder();
+
+  detail.resize(nodes.size());
+  for(size_t i=0;i<nodes.size();++i) {
+    auto& n = nodes[i].name;
+    detail[i] = (n.find("FINGER")!=std::string::npos || n.find("TOE")!=std::string::npos) ? 1 : 0;
+    }
 
   anim = Resources::loadAnimation(this->meshLib);
 
@@ -81,18 +82,41 @@ float Skeleton::colisionRadius() const {
   return std::max(x,y); //TODO
   }
 
-void Skeleton::mkSkeleton() {
-  Matrix4x4 m;
-  m.identity();
-  mkSkeleton(m,size_t(-1));
+void Skeleton::mkOrder() {
+  order.clear();
+  order.reserve(nodes.size());
+
+  bool ordered = true;
+  for(size_t i=0;i<nodes.size();++i) {
+    if(nodes[i].parent>=i && nodes[i].parent!=size_t(-1)) {
+      ordered=false;
+      break;
+      }
+    }
+  if(ordered) {
+    for(size_t i=0;i<nodes.size();++i)
+      order.push_back(i);
+    return;
+    }
+
+  // breadth-first from roots; nodes, not reachable from any root, are left out
+  std::vector<std::vector<size_t>> child(nodes.size());
+  for(size_t i=0;i<nodes.size();++i)
+    if(nodes[i].parent<nodes.size())
+      child[nodes[i].parent].push_back(i);
+  order = rootNodes;
+  for(size_t i=0;i<order.size();++i)
+    for(auto c:child[order[i]])
+      order.push_back(c);
   }
 
-void Skeleton::mkSkeleton(const Tempest::Matrix4x4 &mt, size_t parent) {
-  for(size_t i=0;i<nodes.size();++i){
-    if(nodes[i].parent!=parent)
-      continue;
-    tr[i] = mt;
+void Skeleton::mkSkeleton() {
+  for(auto i:order) {
+    if(nodes[i].parent==size_t(-1)) {
+      tr[i].identity();
+      } else {
+      tr[i] = tr[nodes[i].parent];
+      }
     tr[i].mul(nodes[i].tr);
-    mkSkeleton(tr[i],i);
     }
   }
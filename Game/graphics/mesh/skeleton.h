@@ -18,8 +18,9 @@ class Skeleton final {
       std::string        name;
       };
 
-    bool                            ordered=true;
     std::vector<Node>               nodes;
+    std::vector<size_t>             order;  // topological: parent goes before it's children
+    std::vector<uint8_t>            detail; // small nodes (fingers, toes), that far animation lod can skip
     std::vector<size_t>             rootNodes;
     std::vector<Tempest::Matrix4x4> tr;
     std::array<float,3>             rootTr={};
@@ -41,6 +42,6 @@ class Skeleton final {
     std::string      meshLib;
     const Animation* anim=nullptr;
 
+    void mkOrder();
     void mkSkeleton();
-    void mkSkeleton(const Tempest::Matrix4x4& mt,size_t parent);
   };
@@ -29,6 +29,7 @@ class PackedMesh {
     std::vector<SubMesh>       subMeshes;
     ZMath::float3              bbox[2] = {};
 
+    PackedMesh() = default;
     PackedMesh(const ZenLoad::zCMesh& mesh, PkgType type);
 
   private:
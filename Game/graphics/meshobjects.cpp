@@ -81,6 +81,15 @@ Bounds MeshObjects::Mesh::bounds() const {
   return b;
   }
 
+bool MeshObjects::Mesh::isVisible(SceneGlobals::VisCamera c) const {
+  if(subCount==0)
+    return true; // nothing to test against
+  for(size_t i=0; i<subCount; ++i)
+    if(sub[i].isVisible(c))
+      return true;
+  return false;
+  }
+
 const PfxEmitterMesh* MeshObjects::Mesh::toMeshEmitter() const {
   if(auto p = proto)
     return Resources::loadEmiterMesh(p->fname.c_str());
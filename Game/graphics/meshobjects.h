@@ -64,6 +64,7 @@ class MeshObjects final {
         Node   node(size_t i) const { return Node(&sub[i]); }
 
         Bounds bounds() const;
+        bool   isVisible(SceneGlobals::VisCamera c) const;
         const ProtoMesh* protoMesh() const { return proto; }
 
         const PfxEmitterMesh* toMeshEmitter() const;
@@ -61,6 +61,12 @@ void ObjectsBucket::Item::setAsGhost(bool g) {
   oldOw->free(oldId);
   }
 
+bool ObjectsBucket::Item::isVisible(SceneGlobals::VisCamera c) const {
+  if(owner!=nullptr)
+    return owner->isVisible(id,c);
+  return false;
+  }
+
 void ObjectsBucket::Item::startMMAnim(const char* anim, float intensity, uint64_t timeUntil) {
   if(owner!=nullptr)
     owner->startMMAnim(id,anim,intensity,timeUntil);
@@ -512,6 +518,11 @@ const Bounds& ObjectsBucket::bounds(size_t i) const {
   return val[i].visibility.bounds();
   }
 
+bool ObjectsBucket::isVisible(size_t i, SceneGlobals::VisCamera c) const {
+  auto& v = val[i];
+  return v.vboType==VboMorph || v.visibility.isVisible(c);
+  }
+
 bool ObjectsBucket::Storage::commitUbo(uint8_t fId) {
   return mat.commitUbo(fId);
   }
@@ -73,6 +73,7 @@ class ObjectsBucket final {
         void   startMMAnim (const char* anim, float intensity, uint64_t timeUntil);
 
         const Bounds& bounds() const;
+        bool   isVisible(SceneGlobals::VisCamera c) const;
 
         void   draw(Tempest::Encoder<Tempest::CommandBuffer>& p, uint8_t fId) const;
 
@@ -196,6 +197,7 @@ class ObjectsBucket final {
     void    drawCommon(Tempest::Encoder<Tempest::CommandBuffer>& cmd, uint8_t fId, const Tempest::RenderPipeline& shader, SceneGlobals::VisCamera c);
 
     const Bounds& bounds(size_t i) const;
+    bool          isVisible(size_t i, SceneGlobals::VisCamera c) const;
 
     VisualObjects&            owner;
     Descriptors               uboShared;
@@ -8,7 +8,12 @@
 #include <Tempest/DirectX12Api>
 #endif
 
+#include <cstring>
+
 #include "utils/crashlog.h"
+#include "animreport.h"
+#include "benchmark.h"
+#include "videobench.h"
 #include "gothic.h"
 #include "mainwindow.h"
 
@@ -48,17 +53,43 @@ std::unique_ptr<Tempest::AbstractGraphicsApi> mkApi(Gothic& g) {
   return std::make_unique<Tempest::VulkanApi>(flg);
   }
 
+bool isHeadless(int argc,const char** argv) {
+  for(int i=1;i<argc;++i)
+    if(std::strcmp(argv[i],"-benchmark")==0 || std::strcmp(argv[i],"-anim-report")==0 ||
+       std::strcmp(argv[i],"-video-bench")==0)
+      return true;
+  return false;
+  }
+
 int main(int argc,const char** argv) {
   CrashLog::setup();
   VDFS::FileIndex::initVDFS(argv[0]);
+  if(isHeadless(argc,argv))
+    Benchmark::setupNullSound();
 
   Gothic               gothic{argc,argv};
+  if(!gothic.videoBenchFile().empty()) {
+    VideoBench bench(gothic.videoBenchFile());
+    return bench.exec();
+    }
+
   auto                 api = mkApi(gothic);
 
   Tempest::Device      device{*api,selectDevice(*api),Resources::MaxFramesInFlight};
   Resources            resources{gothic,device};
   GameMusic            music(gothic);
 
+  if(gothic.doAnimReport()) {
+    AnimReport report;
+    return report.exec();
+    }
+
+  if(gothic.isHeadless()) {
+    // no window and swapchain: simulation only
+    Benchmark bench(gothic);
+    return bench.exec();
+    }
+
   MainWindow           wx(gothic,device);
   Tempest::Application app;
   return app.exec();
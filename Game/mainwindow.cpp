@@ -177,7 +177,7 @@ void MainWindow::paintEvent(PaintEvent& event) {
       if(world->player()->hasCollision())
         info="[c]";
       else
-        info = world->roomAt(world->player()->position()).c_str();
+        info = world->roomName(world->roomAt(world->player()->position())).c_str();
       }
     }
 
@@ -858,6 +858,8 @@ void MainWindow::render(){
       once=false;
       }
 
+    // assets, requested by loadTextureAsync/loadMeshAsync, become resident before world tick
+    Resources::commitAsync();
     video.tick();
     uint64_t dt = 0;
     if(!video.isActive())
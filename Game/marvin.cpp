@@ -1,9 +1,12 @@
 #include "marvin.h"
 
+#include <Tempest/Log>
+
 #include <initializer_list>
 #include <cstdint>
 
 #include "world/objects/npc.h"
+#include "world/world.h"
 #include "camera.h"
 #include "gothic.h"
 
@@ -15,6 +18,12 @@ Marvin::Marvin() {
     {"camera mode",       C_CamMode},
     {"toogle camdebug",   C_ToogleCamDebug},
     {"toogle camera",     C_ToogleCamera},
+
+    {"benchmark waynet",  C_BenchmarkWaynet},
+
+    {"profile script start", C_ProfileScriptStart},
+    {"profile script stop",  C_ProfileScriptStop},
+    {"profile script dump",  C_ProfileScriptDump},
     };
   }
 
@@ -130,6 +139,31 @@ bool Marvin::exec(Gothic& gothic, const std::string& v) {
         c->setToogleEnable(!c->isToogleEnabled());
       return true;
       }
+    case C_BenchmarkWaynet: {
+      if(auto w = gothic.world())
+        w->benchmarkWaynet();
+      return true;
+      }
+    case C_ProfileScriptStart: {
+      if(auto w = gothic.world()) {
+        auto& p = w->script().profiler();
+        p.reset();
+        p.setEnabled(true);
+        }
+      return true;
+      }
+    case C_ProfileScriptStop: {
+      if(auto w = gothic.world())
+        w->script().profiler().setEnabled(false);
+      return true;
+      }
+    case C_ProfileScriptDump: {
+      if(auto w = gothic.world()) {
+        if(w->script().writeProfile("script_profile.txt","script_profile.json"))
+          Tempest::Log::i("script profile written to \"script_profile.txt\" and \"script_profile.json\"");
+        }
+      return true;
+      }
     }
 
   return true;
@@ -25,6 +25,11 @@ class Marvin {
       C_CamMode,
       C_ToogleCamDebug,
       C_ToogleCamera,
+      // debug
+      C_BenchmarkWaynet,
+      C_ProfileScriptStart,
+      C_ProfileScriptStop,
+      C_ProfileScriptDump,
       };
 
     struct Cmd {
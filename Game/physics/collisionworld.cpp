@@ -26,13 +26,13 @@ struct CollisionWorld::Broadphase : btDbvtBroadphase {
       }
     };
 
-  Broadphase() {
-    m_deferedcollide = true;
-    rayTestStk.reserve(btDbvt::DOUBLE_STACKSIZE);
-    }
-
+  // traversal stack is per-thread, so ray queries can run on workers, as long as nothing moves
   void rayTest(const btVector3& rayFrom, const btVector3& rayTo, btBroadphaseRayCallback& rayCallback,
-               const btVector3& aabbMin, const btVector3& aabbMax) {
+               const btVector3& aabbMin, const btVector3& aabbMax) override {
+    static thread_local btAlignedObjectArray<const btDbvtNode*> rayTestStk;
+    if(rayTestStk.capacity()<btDbvt::DOUBLE_STACKSIZE)
+      rayTestStk.reserve(btDbvt::DOUBLE_STACKSIZE);
+
     BroadphaseRayTester callback(rayCallback);
     btAlignedObjectArray<const btDbvtNode*>* stack = &rayTestStk;
 
@@ -58,8 +58,6 @@ struct CollisionWorld::Broadphase : btDbvtBroadphase {
         *stack,
         callback);
     }
-
-  btAlignedObjectArray<const btDbvtNode*> rayTestStk;
   };
 
 struct CollisionWorld::ContructInfo {
@@ -70,7 +68,7 @@ struct CollisionWorld::ContructInfo {
     //auto disp = new btCollisionDispatcherMt(conf.get());
     disp .reset(new btCollisionDispatcher(conf.get()));
     disp->setDispatcherFlags(btCollisionDispatcher::CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION);
-    broad.reset(new btDbvtBroadphase());
+    broad.reset(new Broadphase());
     }
   std::unique_ptr<btCollisionConfiguration>   conf;
   std::unique_ptr<btCollisionDispatcher>      disp;
@@ -42,6 +42,7 @@
 #include "graphics/mesh/submesh/packedmesh.h"
 #include "world/objects/item.h"
 #include "world/bullet.h"
+#include "utils/workers.h"
 
 const float DynamicWorld::ghostPadding=50-22.5f;
 const float DynamicWorld::ghostHeight =140;
@@ -444,11 +445,11 @@ struct DynamicWorld::BBoxList final {
   DynamicWorld&        wrld;
   };
 
-DynamicWorld::DynamicWorld(World&,const ZenLoad::zCMesh& worldMesh) {
+DynamicWorld::DynamicWorld(World&, WorldCache& cache) {
   //solver.reset(new btSequentialImpulseConstraintSolver());
   world.reset(new CollisionWorld());
 
-  PackedMesh pkg(worldMesh,PackedMesh::PK_PhysicZoned);
+  const PackedMesh& pkg = cache.physic;
   sectors.resize(pkg.subMeshes.size());
   for(size_t i=0;i<sectors.size();++i)
     sectors[i] = pkg.subMeshes[i].material.matName;
@@ -466,20 +467,21 @@ DynamicWorld::DynamicWorld(World&,const ZenLoad::zCMesh& worldMesh) {
     auto& sm = pkg.subMeshes[i];
     if(!sm.material.noCollDet && sm.indices.size()>0) {
       if(sm.material.matGroup==ZenLoad::MaterialGroup::WATER) {
-        waterMesh->addIndex(std::move(sm.indices),sm.material.matGroup);
+        waterMesh->addIndex(std::vector<uint32_t>(sm.indices),sm.material.matGroup);
         } else {
-        landMesh ->addIndex(std::move(sm.indices),sm.material.matGroup,sectors[i].c_str());
+        landMesh ->addIndex(std::vector<uint32_t>(sm.indices),sm.material.matGroup,sectors[i].c_str());
         }
       }
     }
 
+  bvhFile = cache.file;
   if(!landMesh->isEmpty()) {
-    landShape.reset(new btMultimaterialTriangleMeshShape(landMesh.get(),landMesh->useQuantization(),true));
+    landShape.reset(meshShape(*landMesh,cache.landBvh));
     landBody = landObj();
     }
 
   if(!waterMesh->isEmpty()) {
-    waterShape.reset(new btMultimaterialTriangleMeshShape(waterMesh.get(),waterMesh->useQuantization(),true));
+    waterShape.reset(meshShape(*waterMesh,cache.waterBvh));
     waterBody = waterObj();
     }
 
@@ -557,60 +559,66 @@ DynamicWorld::RayWaterResult DynamicWorld::implWaterRay(float x0, float y0, floa
   return ret;
   }
 
-DynamicWorld::RayLandResult DynamicWorld::ray(float x0, float y0, float z0, float x1, float y1, float z1) const {
-  struct CallBack:btCollisionWorld::ClosestRayResultCallback {
-    using ClosestRayResultCallback::ClosestRayResultCallback;
-    uint8_t     matId  = 0;
-    const char* sector = nullptr;
-    Category    colCat = C_Null;
+struct DynamicWorld::RayCallback:btCollisionWorld::ClosestRayResultCallback {
+  RayCallback(const btVector3& s, const btVector3& e)
+    :ClosestRayResultCallback(s,e) {
+    m_flags = btTriangleRaycastCallback::kF_KeepUnflippedNormal | btTriangleRaycastCallback::kF_FilterBackfaces;
+    }
 
-    bool needsCollision(btBroadphaseProxy* proxy0) const override {
-      auto obj=reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
-      if(obj->getUserIndex()==C_Landscape || obj->getUserIndex()==C_Object)
-        return ClosestRayResultCallback::needsCollision(proxy0);
-      return false;
-      }
+  uint8_t     matId  = 0;
+  const char* sector = nullptr;
+  Category    colCat = C_Null;
 
-    btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace) override {
-      auto shape = rayResult.m_collisionObject->getCollisionShape();
-      if(shape) {
-        auto s  = reinterpret_cast<const btMultimaterialTriangleMeshShape*>(shape);
-        auto mt = reinterpret_cast<const PhysicVbo*>(s->getMeshInterface());
-
-        size_t id = size_t(rayResult.m_localShapeInfo->m_shapePart);
-        matId  = mt->getMaterialId(id);
-        sector = mt->getSectorName(id);
-        }
-      colCat = Category(rayResult.m_collisionObject->getUserIndex());
-      return ClosestRayResultCallback::addSingleResult(rayResult,normalInWorldSpace);
-      }
-    };
+  bool needsCollision(btBroadphaseProxy* proxy0) const override {
+    auto obj=reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
+    if(obj->getUserIndex()==C_Landscape || obj->getUserIndex()==C_Object)
+      return ClosestRayResultCallback::needsCollision(proxy0);
+    return false;
+    }
 
-  btVector3 s(x0,y0,z0), e(x1,y1,z1);
-  CallBack callback{s,e};
-  callback.m_flags = btTriangleRaycastCallback::kF_KeepUnflippedNormal | btTriangleRaycastCallback::kF_FilterBackfaces;
+  btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace) override {
+    auto shape = rayResult.m_collisionObject->getCollisionShape();
+    if(shape) {
+      auto s  = reinterpret_cast<const btMultimaterialTriangleMeshShape*>(shape);
+      auto mt = reinterpret_cast<const PhysicVbo*>(s->getMeshInterface());
 
-  rayTest(s,e,callback);
+      size_t id = size_t(rayResult.m_localShapeInfo->m_shapePart);
+      matId  = mt->getMaterialId(id);
+      sector = mt->getSectorName(id);
+      }
+    colCat = Category(rayResult.m_collisionObject->getUserIndex());
+    return ClosestRayResultCallback::addSingleResult(rayResult,normalInWorldSpace);
+    }
 
-  float nx=0,ny=1,nz=0;
-  if(callback.hasHit()){
-    x1 = callback.m_hitPointWorld.x();
-    y1 = callback.m_hitPointWorld.y();
-    z1 = callback.m_hitPointWorld.z();
-    if(callback.colCat==DynamicWorld::C_Landscape) {
-      nx = callback.m_hitNormalWorld.x();
-      ny = callback.m_hitNormalWorld.y();
-      nz = callback.m_hitNormalWorld.z();
+  RayLandResult result() const {
+    RayLandResult ret;
+    ret.v      = Tempest::Vec3(m_rayToWorld.x(),m_rayToWorld.y(),m_rayToWorld.z());
+    ret.n      = Tempest::Vec3(0,1,0);
+    ret.mat    = matId;
+    ret.hasCol = hasHit();
+    ret.sector = sector;
+    if(hasHit()) {
+      ret.v = Tempest::Vec3(m_hitPointWorld.x(),m_hitPointWorld.y(),m_hitPointWorld.z());
+      if(colCat==DynamicWorld::C_Landscape)
+        ret.n = Tempest::Vec3(m_hitNormalWorld.x(),m_hitNormalWorld.y(),m_hitNormalWorld.z());
       }
+    return ret;
     }
+  };
 
-  RayLandResult ret;
-  ret.v      = Tempest::Vec3(x1,y1,z1);
-  ret.n      = Tempest::Vec3(nx,ny,nz);
-  ret.mat    = callback.matId;
-  ret.hasCol = callback.hasHit();
-  ret.sector = callback.sector;
-  return ret;
+DynamicWorld::RayLandResult DynamicWorld::ray(float x0, float y0, float z0, float x1, float y1, float z1) const {
+  btVector3 s(x0,y0,z0), e(x1,y1,z1);
+  RayCallback callback{s,e};
+  rayTest(s,e,callback);
+  return callback.result();
+  }
+
+void DynamicWorld::ray(const RaySegment* rays, RayLandResult* out, size_t count) const {
+  // bvh and broadphase traversal are read-only: safe to run on workers, while nothing moves
+  Workers::parallelFor(out,out+count,[this,rays,out](RayLandResult& r){
+    auto& src = rays[size_t(std::distance(out,&r))];
+    r = ray(src.from.x,src.from.y,src.from.z, src.to.x,src.to.y,src.to.z);
+    });
   }
 
 float DynamicWorld::soundOclusion(float x0, float y0, float z0, float x1, float y1, float z1) const {
@@ -659,6 +667,36 @@ float DynamicWorld::soundOclusion(float x0, float y0, float z0, float x1, float
   return (tlen*fr)/150.f;
   }
 
+void DynamicWorld::soundOclusion(const RaySegment* rays, float* out, size_t count) const {
+  Workers::parallelFor(out,out+count,[this,rays,out](float& occ){
+    auto& src = rays[size_t(std::distance(out,&occ))];
+    occ = soundOclusion(src.from.x,src.from.y,src.from.z, src.to.x,src.to.y,src.to.z);
+    });
+  }
+
+btCollisionShape* DynamicWorld::meshShape(PhysicVbo& mesh, WorldCache::Bvh& bvh) {
+  const bool quantized = mesh.useQuantization();
+  if(bvh.data!=nullptr) {
+    // bvh is deserialized in-place, inside of mapped cache file
+    auto tree = btOptimizedBvh::deSerializeInPlace(bvh.data,unsigned(bvh.size),false);
+    if(tree!=nullptr && tree->isQuantized()==quantized) {
+      auto shape = new btMultimaterialTriangleMeshShape(&mesh,quantized,false);
+      shape->setOptimizedBvh(tree);
+      return shape;
+      }
+    bvh.data = nullptr;
+    bvh.size = 0;
+    }
+
+  auto shape = new btMultimaterialTriangleMeshShape(&mesh,quantized,true);
+  auto tree  = shape->getOptimizedBvh();
+  auto size  = tree->calculateSerializeBufferSize();
+  bvh.blob.resize((size+sizeof(bvh.blob[0])-1)/sizeof(bvh.blob[0]));
+  if(!tree->serializeInPlace(bvh.blob.data(),unsigned(bvh.blob.size()*sizeof(bvh.blob[0])),false))
+    bvh.blob.clear();
+  return shape;
+  }
+
 std::unique_ptr<btRigidBody> DynamicWorld::landObj() {
   btRigidBody::btRigidBodyConstructionInfo rigidBodyCI(
         0,                  // mass, in kg. 0 -> Static object, will never move.
@@ -746,6 +784,7 @@ DynamicWorld::Item DynamicWorld::createObj(btCollisionShape* shape, bool ownShap
     case IT_Movable:
     case IT_Static:
       world->addCollisionObject(obj.get());
+      geometryVer++;
       break;
     case IT_Dynamic:
       world->addRigidBody(obj.get());
@@ -991,6 +1030,7 @@ void DynamicWorld::deleteObj(btCollisionObject *obj) {
       return;
       }
   world->removeCollisionObject(obj);
+  geometryVer++;
   }
 
 bool DynamicWorld::hasCollision(const NpcItem& it,Tempest::Vec3& normal) {
@@ -1178,6 +1218,8 @@ void DynamicWorld::Item::setObjMatrix(const Tempest::Matrix4x4 &m) {
       return;
     obj->setWorldTransform(trans);
     owner->updateSingleAabb(obj);
+    if(obj->getUserIndex()==C_Object)
+      owner->geometryVer++;
     }
   }
 
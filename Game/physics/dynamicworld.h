@@ -7,6 +7,8 @@
 #include <memory>
 #include <limits>
 
+#include "world/worldcache.h"
+
 class btTriangleIndexVertexArray;
 class btCollisionShape;
 class btCollisionObject;
@@ -32,6 +34,7 @@ class DynamicWorld final {
     struct NpcBodyList;
     struct BulletsList;
     struct BBoxList;
+    struct RayCallback;
 
   public:
     static constexpr float gravityMS   = 9.8f; // meters per second^2
@@ -40,7 +43,7 @@ class DynamicWorld final {
     static constexpr float spellSpeed  = 1000; // per sec
     static const     float ghostPadding;
 
-    DynamicWorld(World &world, const ZenLoad::zCMesh& mesh);
+    DynamicWorld(World &world, WorldCache& cache);
     DynamicWorld(const DynamicWorld&)=delete;
     ~DynamicWorld();
 
@@ -125,6 +128,11 @@ class DynamicWorld final {
       const char*         sector  = nullptr;
       };
 
+    struct RaySegment {
+      Tempest::Vec3       from={};
+      Tempest::Vec3       to  ={};
+      };
+
     struct RayWaterResult {
       float               wdepth  = 0.f;
       bool                hasCol = false;
@@ -200,6 +208,12 @@ class DynamicWorld final {
     RayLandResult  ray        (float x0, float y0, float z0, float x1, float y1, float z1) const;
     float          soundOclusion(float x0, float y0, float z0, float x1, float y1, float z1) const;
 
+    // batched queries, executed on worker threads; out must have count elements
+    void           ray          (const RaySegment* rays, RayLandResult* out, size_t count) const;
+    void           soundOclusion(const RaySegment* rays, float*         out, size_t count) const;
+    // changes, when static or movable object is added, removed or moved: ray results may differ since then
+    uint64_t       geometryVersion() const { return geometryVer; }
+
     NpcItem        ghostObj  (const char* visual);
     Item           staticObj (const PhysicMeshShape *src, const Tempest::Matrix4x4& m);
     Item           movableObj(const PhysicMeshShape *src, const Tempest::Matrix4x4& m);
@@ -242,12 +256,14 @@ class DynamicWorld final {
     std::unique_ptr<btRigidBody> waterObj();
 
     void           updateSingleAabb(btCollisionObject* obj);
+    static btCollisionShape* meshShape(PhysicVbo& mesh, WorldCache::Bvh& bvh);
 
     std::unique_ptr<CollisionWorld>             world;
 
     std::vector<std::string>                    sectors;
 
     std::vector<btVector3>                      landVbo;
+    std::shared_ptr<MappedFile>                 bvhFile; // in-place bvh from cache, must outlive shapes
     std::unique_ptr<PhysicVbo>                  landMesh;
     std::unique_ptr<btCollisionShape>           landShape;
     std::unique_ptr<btRigidBody>                landBody;
@@ -261,6 +277,7 @@ class DynamicWorld final {
     std::unique_ptr<BBoxList>                   bboxList;
 
     std::vector<btRigidBody*>                   dynItems;
+    uint64_t                                    geometryVer = 0;
 
     static const float                          ghostHeight;
     static const float                          worldHeight;
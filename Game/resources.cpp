@@ -18,6 +18,7 @@
 #include <zenload/ztex2dds.h>
 
 #include <fstream>
+#include <algorithm>
 
 #include "graphics/mesh/submesh/staticmesh.h"
 #include "graphics/mesh/submesh/animmesh.h"
@@ -31,7 +32,9 @@
 #include "dmusic/music.h"
 #include "dmusic/directmusic.h"
 #include "utils/fileext.h"
+#include "utils/fileutil.h"
 #include "utils/gthfont.h"
+#include "utils/workers.h"
 
 #include "gothic.h"
 
@@ -39,6 +42,9 @@ using namespace Tempest;
 
 Resources* Resources::inst=nullptr;
 
+// per-thread scratch buffers: decoding runs in parallel, outside of Resources::sync
+static thread_local std::vector<uint8_t> fBuff, ddsBuf;
+
 static void emplaceTag(char* buf, char tag){
   for(size_t i=1;buf[i];++i){
     if(buf[i]==tag && buf[i-1]=='_' && buf[i+1]=='0'){
@@ -86,9 +92,6 @@ Resources::Resources(Gothic &gothic, Tempest::Device &device)
   dxMusic->addPath(gothic.nestedPath({u"_work",u"Data",u"Music",u"menu_men"}, Dir::FT_Dir));
   dxMusic->addPath(gothic.nestedPath({u"_work",u"Data",u"Music",u"orchestra"},Dir::FT_Dir));
 
-  fBuff .reserve(8*1024*1024);
-  ddsBuf.reserve(8*1024*1024);
-
   {
   Pixmap pm(1,1,Pixmap::Format::RGBA);
   uint8_t* pix = reinterpret_cast<uint8_t*>(pm.data());
@@ -113,8 +116,16 @@ Resources::Resources(Gothic &gothic, Tempest::Device &device)
            std::make_tuple(bIsMod,b.time,int(b.ord));
     });
 
-  for(auto& i:archives)
+  for(auto& i:archives) {
     gothicAssets.loadVDF(i.name);
+    // any added, removed or rebuilt archive changes the key;
+    // mod tools often keep vdf-header timestamp, so file size and mtime are accounted too
+    uint64_t size = 0, mtime = 0;
+    FileUtil::fileInfo(i.name,size,mtime);
+    gothicAssetsTime = gothicAssetsTime*31 + uint64_t(i.time);
+    gothicAssetsTime = gothicAssetsTime*31 + size;
+    gothicAssetsTime = gothicAssetsTime*31 + mtime;
+    }
   gothicAssets.finalizeLoad();
 
   //for(auto& i:gothicAssets.getKnownFiles())
@@ -126,6 +137,10 @@ Resources::Resources(Gothic &gothic, Tempest::Device &device)
   }
 
 Resources::~Resources() {
+  // async decoding jobs refer to this
+  std::unique_lock<std::mutex> g(asyncSync);
+  asyncCv.wait(g,[this](){ return asyncJobs==0; });
+  g.unlock();
   inst=nullptr;
   }
 
@@ -197,6 +212,10 @@ VDFS::FileIndex& Resources::vdfsIndex() {
   return inst->gothicAssets;
   }
 
+uint64_t Resources::vdfsTimestamp() {
+  return inst->gothicAssetsTime;
+  }
+
 const Tempest::VertexBuffer<Resources::VertexFsq> &Resources::fsqVbo() {
   return inst->fsq;
   }
@@ -224,98 +243,318 @@ int64_t Resources::vdfTimestamp(const std::u16string& name) {
     }
   }
 
-Tempest::Texture2d* Resources::implLoadTexture(TextureCache& cache,const char* cname) {
-  std::string name = cname;
-  if(name.size()==0)
-    return nullptr;
-
-  auto it=cache.find(name);
-  if(it!=cache.end())
-    return it->second.get();
-
-  if(FileExt::hasExt(name,"TGA")){
+bool Resources::decodeTexture(const std::string& cname, Pixmap& out) {
+  if(FileExt::hasExt(cname,"TGA")){
+    std::string name = cname;
     name.resize(name.size()+2);
     std::memcpy(&name[0]+name.size()-6,"-C.TEX",6);
     if(hasFile(name)) {
       if(!getFileData(name.c_str(),fBuff)) {
         Log::e("unable to load texture \"",name,"\"");
-        return nullptr;
+        return false;
         }
       ddsBuf.clear();
       ZenLoad::convertZTEX2DDS(fBuff,ddsBuf);
-      auto t = implLoadTexture(cache,cname,ddsBuf);
-      if(t!=nullptr) {
-        return t;
-        }
+      if(decodePixmap(ddsBuf,out))
+        return true;
       }
     }
 
-  if(getFileData(cname,fBuff))
-    return implLoadTexture(cache,cname,fBuff);
-
-  cache[name]=nullptr;
-  return nullptr;
+  if(getFileData(cname.c_str(),fBuff))
+    return decodePixmap(fBuff,out);
+  return false;
   }
 
-Texture2d *Resources::implLoadTexture(TextureCache& cache,std::string&& name,const std::vector<uint8_t> &data) {
+bool Resources::decodePixmap(const std::vector<uint8_t>& data, Pixmap& out) {
   try {
     Tempest::MemReader rd(data.data(),data.size());
-    Tempest::Pixmap    pm(rd);
-
-    std::unique_ptr<Texture2d> t{new Texture2d(dev.loadTexture(pm))};
-    Texture2d* ret=t.get();
-    cache[std::move(name)] = std::move(t);
-    return ret;
+    out = Tempest::Pixmap(rd);
+    return true;
     }
   catch(...){
+    return false;
+    }
+  }
+
+void Resources::decodeMesh(DecodedMesh& m) {
+  try {
+    m.code = loadMesh(m.packed,m.aniList,m.library,m.name);
+    }
+  catch(...) {
+    m.code = MeshLoadCode::Error;
+    }
+  }
+
+Tempest::Texture2d* Resources::implLoadTexture(const char* cname) {
+  std::string name = cname;
+  if(name.size()==0)
     return nullptr;
+
+  {
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto it=texCache.find(name);
+    if(it!=texCache.end())
+      return it->second.get();
+  }
+
+  Pixmap     pm;
+  const bool valid = decodeTexture(name,pm);
+
+  std::lock_guard<std::recursive_mutex> g(sync);
+  return implCommitTexture(std::move(name),valid ? &pm : nullptr);
+  }
+
+Texture2d* Resources::implCommitTexture(std::string&& name, const Pixmap* pm) {
+  auto it=texCache.find(name);
+  if(it!=texCache.end()) {
+    // loaded by another thread in meantime
+    return it->second.get();
     }
+
+  std::unique_ptr<Texture2d> t;
+  if(pm!=nullptr) {
+    try {
+      t.reset(new Texture2d(dev.loadTexture(*pm)));
+      }
+    catch(...){
+      Log::e("unable to upload texture \"",name,"\"");
+      }
+    }
+  Texture2d* ret=t.get();
+  texCache[std::move(name)] = std::move(t);
+  return ret;
   }
 
 ProtoMesh* Resources::implLoadMesh(const std::string &name) {
   if(name.size()==0)
     return nullptr;
 
-  auto it=aniMeshCache.find(name);
-  if(it!=aniMeshCache.end())
-    return it->second.get();
+  {
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto it=aniMeshCache.find(name);
+    if(it!=aniMeshCache.end())
+      return it->second.get();
+  }
 
   if(FileExt::hasExt(name,"TGA")){
     Log::e("decals should be loaded by Resources::implDecalMesh instead");
     return nullptr;
     }
 
+  DecodedMesh m;
+  m.name = name;
+  decodeMesh(m);
+
+  std::lock_guard<std::recursive_mutex> g(sync);
+  return implCommitMesh(m);
+  }
+
+ProtoMesh* Resources::implCommitMesh(DecodedMesh& m) {
+  auto it=aniMeshCache.find(m.name);
+  if(it!=aniMeshCache.end())
+    return it->second.get();
+
   try {
-    std::vector<ZenLoad::zCMorphMesh::Animation> aniList;
-    ZenLoad::PackedMesh        packed;
-    ZenLoad::zCModelMeshLib    library;
-    auto                       code=loadMesh(packed,aniList,library,name);
     std::unique_ptr<ProtoMesh> t;
-    switch(code) {
+    switch(m.code) {
       case MeshLoadCode::Error:
         break;
       case MeshLoadCode::Static:
-        t.reset(new ProtoMesh(std::move(packed),name));
+        t.reset(new ProtoMesh(std::move(m.packed),m.name));
         break;
       case MeshLoadCode::Morph:
-        t.reset(new ProtoMesh(std::move(packed),aniList,name));
+        t.reset(new ProtoMesh(std::move(m.packed),m.aniList,m.name));
         break;
       case MeshLoadCode::Dynamic:
-        t.reset(new ProtoMesh(library,name));
+        t.reset(new ProtoMesh(m.library,m.name));
         break;
       }
     ProtoMesh* ret=t.get();
-    aniMeshCache[name] = std::move(t);
-    if(code==MeshLoadCode::Error)
+    aniMeshCache[m.name] = std::move(t);
+    if(m.code==MeshLoadCode::Error)
       throw std::runtime_error("load failed");
     return ret;
     }
   catch(...){
-    Log::e("unable to load mesh \"",name,"\"");
+    Log::e("unable to load mesh \"",m.name,"\"");
     return nullptr;
     }
   }
 
+static bool isMeshName(const std::string& name) {
+  static const char* ext[] = {"3DS","MMS","ASC","MRM","MMB","MDMS","MDS","MDL","MDM"};
+  for(auto e:ext)
+    if(FileExt::hasExt(name,e))
+      return true;
+  return false;
+  }
+
+void Resources::implPreload(std::vector<std::string>& visuals) {
+  std::sort(visuals.begin(),visuals.end());
+  visuals.erase(std::unique(visuals.begin(),visuals.end()),visuals.end());
+
+  std::vector<std::string> meshNames, texNames;
+  {
+    std::lock_guard<std::recursive_mutex> g(sync);
+    for(auto& i:visuals) {
+      if(FileExt::hasExt(i,"TGA")) {
+        if(texCache.find(i)==texCache.end())
+          texNames.push_back(i);
+        }
+      else if(isMeshName(i)) {
+        if(aniMeshCache.find(i)==aniMeshCache.end())
+          meshNames.push_back(i);
+        }
+      }
+  }
+
+  std::vector<DecodedMesh> mesh(meshNames.size());
+  for(size_t i=0; i<mesh.size(); ++i)
+    mesh[i].name = std::move(meshNames[i]);
+  Workers::parallelFor(mesh,[this](DecodedMesh& m){
+    decodeMesh(m);
+    });
+
+  // textures of static meshes, otherwise ProtoMesh would load them one by one
+  for(auto& m:mesh)
+    for(auto& s:m.packed.subMeshes)
+      if(!s.material.texture.empty())
+        texNames.push_back(s.material.texture);
+  std::sort(texNames.begin(),texNames.end());
+  texNames.erase(std::unique(texNames.begin(),texNames.end()),texNames.end());
+
+  {
+    std::lock_guard<std::recursive_mutex> g(sync);
+    texNames.erase(std::remove_if(texNames.begin(),texNames.end(),[this](const std::string& n){
+      return texCache.find(n)!=texCache.end();
+      }),texNames.end());
+  }
+
+  std::vector<DecodedTexture> tex(texNames.size());
+  for(size_t i=0; i<tex.size(); ++i)
+    tex[i].name = std::move(texNames[i]);
+  Workers::parallelFor(tex,[](DecodedTexture& t){
+    t.valid = decodeTexture(t.name,t.pm);
+    });
+
+  std::lock_guard<std::recursive_mutex> g(sync);
+  for(auto& t:tex)
+    implCommitTexture(std::move(t.name),t.valid ? &t.pm : nullptr);
+  for(auto& m:mesh)
+    implCommitMesh(m);
+  }
+
+template<class T>
+static std::shared_future<T> readyFuture(T v) {
+  std::promise<T> p;
+  p.set_value(v);
+  return p.get_future().share();
+  }
+
+auto Resources::implLoadTextureAsync(const std::string& name) -> std::shared_future<const Texture2d*> {
+  if(name.size()==0)
+    return readyFuture<const Texture2d*>(nullptr);
+
+  {
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto it=texCache.find(name);
+    if(it!=texCache.end())
+      return readyFuture<const Texture2d*>(it->second.get());
+  }
+
+  std::lock_guard<std::mutex> g(asyncSync);
+  auto it=asyncTex.find(name);
+  if(it!=asyncTex.end())
+    return it->second;
+
+  std::unique_ptr<AsyncTexture> t(new AsyncTexture());
+  t->tex.name = name;
+  auto ret = t->ret.get_future().share();
+  asyncTex[name] = ret;
+  asyncJobs++;
+  Workers::async([this,t=std::move(t)]() mutable {
+    t->tex.valid = decodeTexture(t->tex.name,t->tex.pm);
+    std::lock_guard<std::mutex> g(asyncSync);
+    uploadTex.push_back(std::move(t));
+    asyncJobs--;
+    asyncCv.notify_all();
+    });
+  return ret;
+  }
+
+auto Resources::implLoadMeshAsync(const std::string& name) -> std::shared_future<const ProtoMesh*> {
+  if(name.size()==0 || FileExt::hasExt(name,"TGA"))
+    return readyFuture<const ProtoMesh*>(nullptr);
+
+  {
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto it=aniMeshCache.find(name);
+    if(it!=aniMeshCache.end())
+      return readyFuture<const ProtoMesh*>(it->second.get());
+  }
+
+  std::lock_guard<std::mutex> g(asyncSync);
+  auto it=asyncMesh.find(name);
+  if(it!=asyncMesh.end())
+    return it->second;
+
+  std::unique_ptr<AsyncMesh> m(new AsyncMesh());
+  m->mesh.name = name;
+  auto ret = m->ret.get_future().share();
+  asyncMesh[name] = ret;
+  asyncJobs++;
+  Workers::async([this,m=std::move(m)]() mutable {
+    decodeMesh(m->mesh);
+    // textures of static mesh are decoded here as well, otherwise ProtoMesh would load them on render thread
+    for(auto& s:m->mesh.packed.subMeshes) {
+      auto& tname = s.material.texture;
+      if(tname.empty())
+        continue;
+      if(std::any_of(m->tex.begin(),m->tex.end(),[&tname](const DecodedTexture& t){ return t.name==tname; }))
+        continue;
+      DecodedTexture t;
+      t.name  = tname;
+      t.valid = decodeTexture(t.name,t.pm);
+      m->tex.push_back(std::move(t));
+      }
+    std::lock_guard<std::mutex> g(asyncSync);
+    uploadMesh.push_back(std::move(m));
+    asyncJobs--;
+    asyncCv.notify_all();
+    });
+  return ret;
+  }
+
+void Resources::implCommitAsync() {
+  std::vector<std::unique_ptr<AsyncTexture>> tex;
+  std::vector<std::unique_ptr<AsyncMesh>>    mesh;
+  {
+    std::lock_guard<std::mutex> g(asyncSync);
+    if(uploadTex.empty() && uploadMesh.empty())
+      return;
+    std::swap(tex, uploadTex);
+    std::swap(mesh,uploadMesh);
+  }
+
+  {
+    std::lock_guard<std::recursive_mutex> g(sync);
+    for(auto& t:tex)
+      t->ret.set_value(implCommitTexture(std::string(t->tex.name),t->tex.valid ? &t->tex.pm : nullptr));
+    for(auto& m:mesh) {
+      for(auto& t:m->tex)
+        implCommitTexture(std::move(t.name),t.valid ? &t.pm : nullptr);
+      m->ret.set_value(implCommitMesh(m->mesh));
+      }
+  }
+
+  // resources are in cache now: next request for them doesn't need to wait
+  std::lock_guard<std::mutex> g(asyncSync);
+  for(auto& t:tex)
+    asyncTex.erase(t->tex.name);
+  for(auto& m:mesh)
+    asyncMesh.erase(m->mesh.name);
+  }
+
 ProtoMesh* Resources::implDecalMesh(const ZenLoad::zCVobData& vob) {
   DecalK key;
   key.mat         = Material(vob);
@@ -426,10 +665,63 @@ Animation* Resources::implLoadAnimation(std::string name) {
   }
 
 Dx8::PatternList Resources::implLoadDxMusic(const char* name) {
+  std::shared_future<Dx8::PatternList> ret;
+  {
+    std::lock_guard<std::mutex> g(dxMusicSync);
+    auto i = dxMusicCache.find(name);
+    if(i!=dxMusicCache.end()) {
+      i->second.lastUse = ++dxMusicTick;
+      ret = i->second.data;
+      }
+  }
+  // preloaded or still in progress - waiting is cheaper, than parsing same files twice
+  if(ret.valid())
+    return ret.get();
+
   auto u = Tempest::TextCodec::toUtf16(name);
   return dxMusic->load(u.c_str());
   }
 
+bool Resources::implPreloadDxMusic(const char* name) {
+  std::lock_guard<std::mutex> g(dxMusicSync);
+  auto i = dxMusicCache.find(name);
+  if(i!=dxMusicCache.end()) {
+    i->second.lastUse = ++dxMusicTick;
+    i->second.users++;
+    return true;
+    }
+
+  if(dxMusicCache.size()>=MaxDxMusic) {
+    // only segments, that nobody keeps, can be evicted: otherwise preloads would evict each other
+    auto lru = dxMusicCache.end();
+    for(auto it=dxMusicCache.begin(); it!=dxMusicCache.end(); ++it)
+      if(it->second.users==0 && (lru==dxMusicCache.end() || it->second.lastUse<lru->second.lastUse))
+        lru = it;
+    if(lru==dxMusicCache.end())
+      return false;
+    // in-progress parse runs to the end, result is dropped with last future
+    dxMusicCache.erase(lru);
+    }
+
+  std::string file = name;
+  auto ret = Workers::async([this,file]() {
+    auto u = Tempest::TextCodec::toUtf16(file);
+    return dxMusic->load(u.c_str());
+    }).share();
+  auto& e   = dxMusicCache[file];
+  e.data    = ret;
+  e.lastUse = ++dxMusicTick;
+  e.users   = 1;
+  return true;
+  }
+
+void Resources::implReleaseDxMusic(const char* name) {
+  std::lock_guard<std::mutex> g(dxMusicSync);
+  auto i = dxMusicCache.find(name);
+  if(i!=dxMusicCache.end() && i->second.users>0)
+    i->second.users--;
+  }
+
 Tempest::Sound Resources::implLoadSoundBuffer(const char *name) {
   if(name[0]=='\0')
     return Tempest::Sound();
@@ -526,18 +818,35 @@ PfxEmitterMesh* Resources::implLoadEmiterMesh(const char* name) {
   }
 
 bool Resources::hasFile(const std::string &fname) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  // index is immutable after finalizeLoad - no lock required
   return inst->gothicAssets.hasFile(fname);
   }
 
 const Texture2d *Resources::loadTexture(const char *name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
-  return inst->implLoadTexture(inst->texCache,name);
+  return inst->implLoadTexture(name);
   }
 
 const Tempest::Texture2d* Resources::loadTexture(const std::string &name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
-  return inst->implLoadTexture(inst->texCache,name.c_str());
+  return inst->implLoadTexture(name.c_str());
+  }
+
+std::shared_future<const Texture2d*> Resources::loadTextureAsync(const std::string& name) {
+  return inst->implLoadTextureAsync(name);
+  }
+
+std::shared_future<const ProtoMesh*> Resources::loadMeshAsync(const std::string& name) {
+  return inst->implLoadMeshAsync(name);
+  }
+
+const Texture2d& Resources::textureOrFallback(const std::shared_future<const Texture2d*>& tex) {
+  if(!tex.valid() || tex.wait_for(std::chrono::seconds(0))!=std::future_status::ready)
+    return inst->fallback;
+  auto* ret = tex.get();
+  return ret==nullptr ? inst->fallback : *ret;
+  }
+
+void Resources::commitAsync() {
+  inst->implCommitAsync();
   }
 
 const Texture2d *Resources::loadTexture(const std::string &name, int32_t iv, int32_t ic) {
@@ -606,10 +915,13 @@ Material Resources::loadMaterial(const ZenLoad::zCMaterialData& src, bool enable
   }
 
 const ProtoMesh *Resources::loadMesh(const std::string &name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
   return inst->implLoadMesh(name);
   }
 
+void Resources::preload(std::vector<std::string> visuals) {
+  inst->implPreload(visuals);
+  }
+
 const PfxEmitterMesh* Resources::loadEmiterMesh(const char* name) {
   if(name==nullptr || name[0]=='\0')
     return nullptr;
@@ -640,10 +952,22 @@ Tempest::Sound Resources::loadSoundBuffer(const char *name) {
   }
 
 Dx8::PatternList Resources::loadDxMusic(const char* name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  // DirectMusic is synchronized on its own, no need to stall other resources
   return inst->implLoadDxMusic(name);
   }
 
+bool Resources::preloadDxMusic(const char* name) {
+  if(name==nullptr || name[0]=='\0')
+    return true;
+  return inst->implPreloadDxMusic(name);
+  }
+
+void Resources::releaseDxMusic(const char* name) {
+  if(name==nullptr || name[0]=='\0')
+    return;
+  inst->implReleaseDxMusic(name);
+  }
+
 const ProtoMesh* Resources::decalMesh(const ZenLoad::zCVobData& vob) {
   std::lock_guard<std::recursive_mutex> g(inst->sync);
   return inst->implDecalMesh(vob);
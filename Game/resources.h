@@ -3,6 +3,7 @@
 #include <Tempest/Assets>
 #include <Tempest/Font>
 #include <Tempest/Texture2d>
+#include <Tempest/Pixmap>
 #include <Tempest/Device>
 #include <Tempest/SoundDevice>
 
@@ -12,7 +13,9 @@
 #include <zenload/zCMorphMesh.h>
 #include <zenload/zTypes.h>
 
+#include <condition_variable>
 #include <tuple>
+#include <future>
 
 #include "graphics/material.h"
 #include "sound/soundfx.h"
@@ -98,6 +101,17 @@ class Resources final {
     static       Tempest::Texture2d  loadTexture(const Tempest::Pixmap& pm);
     static       Material            loadMaterial(const ZenLoad::zCMaterialData& src, bool enableAlphaTest);
 
+    // decoding runs on worker pool, gpu upload is done on render thread by commitAsync;
+    // textureOrFallback gives placeholder, until texture is uploaded
+    static auto                      loadTextureAsync(const std::string& name) -> std::shared_future<const Tempest::Texture2d*>;
+    static auto                      loadMeshAsync   (const std::string& name) -> std::shared_future<const ProtoMesh*>;
+    static const Tempest::Texture2d& textureOrFallback(const std::shared_future<const Tempest::Texture2d*>& tex);
+    // uploads everything, decoded since last call, in one batch; called by render thread once per frame
+    static void                      commitAsync();
+
+    // decodes meshes and textures in parallel, gpu upload is done in one batch
+    static void                      preload(std::vector<std::string> visuals);
+
     static const AttachBinder*       bindMesh      (const ProtoMesh& anim,const Skeleton& s);
     static const ProtoMesh*          loadMesh      (const std::string& name);
     static const PfxEmitterMesh*     loadEmiterMesh(const char*        name);
@@ -108,6 +122,10 @@ class Resources final {
     static Tempest::Sound            loadSoundBuffer(const char*        name);
 
     static Dx8::PatternList          loadDxMusic(const char *name);
+    // parses segment with styles and dls on worker pool; loadDxMusic picks up result, once it's ready.
+    // Segment is kept in cache until releaseDxMusic; false, if cache is full of kept segments
+    static bool                      preloadDxMusic(const char *name);
+    static void                      releaseDxMusic(const char *name);
     static const ProtoMesh*          decalMesh(const ZenLoad::zCVobData& vob);
 
     static ZenLoad::oCWorldData      loadVobBundle(const std::string& name);
@@ -126,12 +144,17 @@ class Resources final {
 
     static bool                      hasFile(const std::string& fname);
     static VDFS::FileIndex&          vdfsIndex();
+    static uint64_t                  vdfsTimestamp();
 
     static const Tempest::VertexBuffer<VertexFsq>& fsqVbo();
 
   private:
     static Resources* inst;
 
+    enum {
+      MaxDxMusic = 32, // preloaded segments, least recently used are evicted
+      };
+
     enum class MeshLoadCode : uint8_t {
       Error,
       Static,
@@ -159,19 +182,61 @@ class Resources final {
         }
       };
 
+    struct DxMusic {
+      std::shared_future<Dx8::PatternList> data;
+      uint64_t                             lastUse = 0;
+      uint32_t                             users   = 0;
+      };
+
+    struct DecodedTexture {
+      std::string     name;
+      Tempest::Pixmap pm;
+      bool            valid = false;
+      };
+
+    struct DecodedMesh {
+      std::string                                  name;
+      MeshLoadCode                                 code = MeshLoadCode::Error;
+      ZenLoad::PackedMesh                          packed;
+      std::vector<ZenLoad::zCMorphMesh::Animation> aniList;
+      ZenLoad::zCModelMeshLib                      library;
+      };
+
+    struct AsyncTexture {
+      DecodedTexture                          tex;
+      std::promise<const Tempest::Texture2d*> ret;
+      };
+
+    struct AsyncMesh {
+      DecodedMesh                             mesh;
+      std::vector<DecodedTexture>             tex;
+      std::promise<const ProtoMesh*>          ret;
+      };
+
     using TextureCache = std::unordered_map<std::string,std::unique_ptr<Tempest::Texture2d>>;
 
     int64_t               vdfTimestamp(const std::u16string& name);
     void                  detectVdf(std::vector<Archive>& ret, const std::u16string& root);
 
-    Tempest::Texture2d*   implLoadTexture(TextureCache& cache, const char* cname);
-    Tempest::Texture2d*   implLoadTexture(TextureCache& cache, std::string &&name, const std::vector<uint8_t> &data);
+    static bool           decodeTexture(const std::string& name, Tempest::Pixmap& out);
+    static bool           decodePixmap (const std::vector<uint8_t>& data, Tempest::Pixmap& out);
+    void                  decodeMesh   (DecodedMesh& m);
+
+    Tempest::Texture2d*   implLoadTexture(const char* cname);
+    Tempest::Texture2d*   implCommitTexture(std::string&& name, const Tempest::Pixmap* pm);
     ProtoMesh*            implLoadMesh(const std::string &name);
+    ProtoMesh*            implCommitMesh(DecodedMesh& m);
+    void                  implPreload(std::vector<std::string>& visuals);
+    auto                  implLoadTextureAsync(const std::string& name) -> std::shared_future<const Tempest::Texture2d*>;
+    auto                  implLoadMeshAsync(const std::string& name) -> std::shared_future<const ProtoMesh*>;
+    void                  implCommitAsync();
     ProtoMesh*            implDecalMesh(const ZenLoad::zCVobData& vob);
     Skeleton*             implLoadSkeleton(std::string name);
     Animation*            implLoadAnimation(std::string name);
     Tempest::Sound        implLoadSoundBuffer(const char* name);
     Dx8::PatternList      implLoadDxMusic(const char *name);
+    bool                  implPreloadDxMusic(const char *name);
+    void                  implReleaseDxMusic(const char *name);
     GthFont&              implLoadFont(const char* fname, FontType type);
     PfxEmitterMesh*       implLoadEmiterMesh(const char* name);
     ZenLoad::oCWorldData& implLoadVobBundle(const std::string& name);
@@ -206,12 +271,22 @@ class Resources final {
     Tempest::SoundDevice              sound;
     std::recursive_mutex              sync;
     std::unique_ptr<Dx8::DirectMusic> dxMusic;
+    std::mutex                        dxMusicSync;
+    uint64_t                          dxMusicTick = 0;
     Gothic&                           gothic;
     VDFS::FileIndex                   gothicAssets;
+    uint64_t                          gothicAssetsTime = 0;
 
-    std::vector<uint8_t>              fBuff, ddsBuf;
     Tempest::VertexBuffer<VertexFsq>  fsq;
 
+    std::mutex                                                            asyncSync;
+    std::condition_variable                                               asyncCv;
+    size_t                                                                asyncJobs = 0;
+    std::unordered_map<std::string,std::shared_future<const Tempest::Texture2d*>> asyncTex;
+    std::unordered_map<std::string,std::shared_future<const ProtoMesh*>>  asyncMesh;
+    std::vector<std::unique_ptr<AsyncTexture>>                            uploadTex;
+    std::vector<std::unique_ptr<AsyncMesh>>                               uploadMesh;
+
     TextureCache                                                          texCache;
 
     std::unordered_map<std::string,std::unique_ptr<ProtoMesh>>            aniMeshCache;
@@ -222,4 +297,5 @@ class Resources final {
     std::unordered_map<std::string,std::unique_ptr<PfxEmitterMesh>>       emiMeshCache;
     std::unordered_map<FontK,std::unique_ptr<GthFont>,Hash>               gothicFnt;
     std::unordered_map<std::string,ZenLoad::oCWorldData>                  zenCache;
+    std::unordered_map<std::string,DxMusic>                               dxMusicCache;
   };
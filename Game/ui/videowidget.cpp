@@ -5,6 +5,9 @@
 #include <Tempest/Log>
 #include <Tempest/Application>
 
+#include <condition_variable>
+#include <thread>
+
 #include "bink/video.h"
 #include "utils/fileutil.h"
 #include "gamemusic.h"
@@ -81,7 +84,27 @@ void VideoWidget::Sound::renderSound(int16_t *out, size_t n) {
   ctx.samples.erase(ctx.samples.begin(),ctx.samples.begin()+n);
   }
 
+// Frames are decoded on own thread into a small queue; render thread only picks up newest frame, that is due.
+// Playback time is wall-clock from start of the video, so slow decoding drops frames instead of stalling ui.
 struct VideoWidget::Context {
+  enum {
+    QueueSize = 3
+    };
+
+  enum State : uint8_t {
+    Free,
+    Decoding,
+    Ready,
+    Shown,
+    };
+
+  struct Slot {
+    Pixmap   pm;
+    size_t   frame = 0;
+    uint64_t pts   = 0;
+    State    state = Free;
+    };
+
   Context(Gothic& gothic, const std::u16string& path) : fin(path), input(fin), vid(&input) {
     sndCtx.resize(vid.audioCount());
     for(size_t i=0; i<sndCtx.size(); ++i) {
@@ -92,66 +115,120 @@ struct VideoWidget::Context {
     const float volume = gothic.settingsGetF("SOUND","soundVolume");
     sndDev.setGlobalVolume(volume);
     frameTime = Application::tickCount();
+    decoder   = std::thread([this]() noexcept { decodeLoop(); });
     }
 
   ~Context() {
+    {
+    std::lock_guard<std::mutex> guard(sync);
+    stop = true;
+    }
+    cv.notify_all();
+    decoder.join();
     }
 
-  void advance() {
-    auto& f = vid.nextFrame();
-    if(pm.w()!=f.width() || pm.h()!=f.height())
-      pm = Pixmap(f.width(),f.height(),Pixmap::Format::RGBA);
+  void decodeLoop() {
+    while(true) {
+      Slot* s = nullptr;
+      {
+      std::unique_lock<std::mutex> guard(sync);
+      cv.wait(guard,[this,&s](){
+        s = findSlot(Free);
+        return stop || s!=nullptr;
+        });
+      if(stop)
+        return;
+      if(vid.currentFrame()>=vid.frameCount()) {
+        eof = true;
+        return;
+        }
+      s->state = Decoding;
+      }
 
-    yuvToRgba(f,pm);
-    for(size_t i=0; i<vid.audioCount(); ++i)
-      sndCtx[i]->pushSamples(f.audio(uint8_t(i)).samples);
+      bool ok = decode(*s);
 
-    uint64_t destTick = frameTime+(1000*vid.fps().den*vid.currentFrame())/vid.fps().num;
-    uint64_t tick     = Application::tickCount();
-    if(tick<destTick) {
-      Application::sleep(uint32_t(destTick-tick));
+      std::lock_guard<std::mutex> guard(sync);
+      if(!ok && failed) {
+        s->state = Free;
+        eof      = true;
+        return;
+        }
+      s->state = ok ? Ready : Free;
       }
     }
 
-  void yuvToRgba(const Bink::Frame& f,Pixmap& pm) {
-    auto planeY = f.plane(0);
-    auto planeU = f.plane(1);
-    auto planeV = f.plane(2);
-    auto dst    = reinterpret_cast<uint8_t*>(pm.data());
-
-    const uint32_t w = pm.w();
-    for(uint32_t y=0; y<pm.h(); ++y)
-      for(uint32_t x=0; x<w; ++x) {
-        uint8_t* rgb = &dst[(x+y*w)*4];
-        float Y = planeY.at(x,  y  );
-        float U = planeU.at(x/2,y/2);
-        float V = planeV.at(x/2,y/2);
-
-        float r = 1.164f * (Y - 16.f) + 1.596f * (V - 128.f);
-        float g = 1.164f * (Y - 16.f) - 0.813f * (V - 128.f) - 0.391f * (U - 128.f);
-        float b = 1.164f * (Y - 16.f) + 2.018f * (U - 128.f);
-
-        r = std::max(0.f,std::min(r,255.f));
-        g = std::max(0.f,std::min(g,255.f));
-        b = std::max(0.f,std::min(b,255.f));
-
-        rgb[0] = uint8_t(r);
-        rgb[1] = uint8_t(g);
-        rgb[2] = uint8_t(b);
-        rgb[3] = 255;
-        }
+  bool decode(Slot& s) {
+    const size_t id = vid.currentFrame();
+    try {
+      auto& f = vid.nextFrame();
+      if(s.pm.w()!=f.width() || s.pm.h()!=f.height())
+        s.pm = Pixmap(f.width(),f.height(),Pixmap::Format::RGBA);
+      f.toRgba(reinterpret_cast<uint8_t*>(s.pm.data()));
+      for(size_t i=0; i<vid.audioCount(); ++i)
+        sndCtx[i]->pushSamples(f.audio(uint8_t(i)).samples);
+      s.frame = id;
+      s.pts   = frameTime+(1000*vid.fps().den*id)/vid.fps().num;
+      return true;
+      }
+    catch(const Bink::VideoDecodingException& e) { // video exception is recoverable
+      Log::e("video decoding error. frame: ",id,", what: \"", e.what(), "\"");
+      return false;
+      }
+    catch(...) {
+      Log::e("video decoding error. frame: ",id);
+      std::lock_guard<std::mutex> guard(sync);
+      failed = true;
+      return false;
+      }
     }
 
-  bool isEof() const {
-    return vid.currentFrame()>=vid.frameCount();
+  // newest frame, that is due now; nullptr before first frame
+  const Slot* present() {
+    std::lock_guard<std::mutex> guard(sync);
+    const uint64_t tick = Application::tickCount();
+
+    Slot* next = nullptr;
+    for(auto& i:slots)
+      if(i.state==Ready && i.pts<=tick && (next==nullptr || i.frame>next->frame))
+        next = &i;
+    if(next==nullptr)
+      return findSlot(Shown);
+
+    for(auto& i:slots)
+      if(i.state==Shown || (i.state==Ready && i.frame<next->frame))
+        i.state = Free; // displayed before or late - drop
+    next->state = Shown;
+    cv.notify_one();
+    return next;
+    }
+
+  bool isEof() {
+    std::lock_guard<std::mutex> guard(sync);
+    if(failed)
+      return true;
+    return eof && findSlot(Ready)==nullptr;
+    }
+
+  Slot* findSlot(State st) {
+    for(auto& i:slots)
+      if(i.state==st)
+        return &i;
+    return nullptr;
     }
 
   Tempest::RFile       fin;
   Input                input;
   Bink::Video          vid;
-  Pixmap               pm;
   uint64_t             frameTime = 0;
 
+  std::mutex              sync;
+  std::condition_variable cv;
+  Slot                    slots[QueueSize];
+  bool                    stop   = false;
+  bool                    eof    = false;
+  bool                    failed = false;
+  std::thread             decoder;
+
   Tempest::SoundDevice      sndDev;
   std::vector<std::unique_ptr<SoundContext>> sndCtx;
   };
@@ -228,6 +305,9 @@ void VideoWidget::keyUpEvent(KeyEvent&) {
 
 void VideoWidget::stopVideo() {
   ctx.reset();
+  frame = nullptr;
+  for(auto& i:texFrame)
+    i = size_t(-1);
   if(!hasPendingVideo) {
     if(restoreMusic && !GameMusic::inst().isEnabled())
       GameMusic::inst().setEnabled(true);
@@ -239,19 +319,17 @@ void VideoWidget::stopVideo() {
 void VideoWidget::paint(Tempest::Device& device, uint8_t fId) {
   if(ctx==nullptr)
     return;
-  try {
-    ctx->advance();
-    tex[fId] = device.loadTexture(ctx->pm,false);
-    frame    = &tex[fId];
-    update();
-    }
-  catch(const Bink::VideoDecodingException& e) { // video exception is recoverable
-    Log::e("video decoding error. frame: ",ctx->vid.currentFrame(),", what: \"", e.what(), "\"");
-    }
-  catch(...) {
-    Log::e("video decoding error. frame: ",ctx->vid.currentFrame());
-    ctx.reset();
+  update();
+
+  auto s = ctx->present();
+  if(s==nullptr)
+    return;
+  // each frame in flight owns a texture; upload only, if it holds a different video frame
+  if(texFrame[fId]!=s->frame || tex[fId].isEmpty()) {
+    tex[fId]      = device.loadTexture(s->pm,false);
+    texFrame[fId] = s->frame;
     }
+  frame = &tex[fId];
   }
 
 void VideoWidget::paintEvent(PaintEvent& e) {
@@ -35,6 +35,7 @@ class VideoWidget : public Tempest::Widget {
     Gothic&                       gothic;
     std::unique_ptr<Context>      ctx;
     Tempest::Texture2d            tex[Resources::MaxFramesInFlight];
+    size_t                        texFrame[Resources::MaxFramesInFlight] = {};
     Tempest::Texture2d*           frame  = nullptr;
     bool                          active = false;
     bool                          restoreMusic = false;
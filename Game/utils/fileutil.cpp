@@ -22,6 +22,36 @@ bool FileUtil::exists(const std::u16string &path) {
 #endif
   }
 
+bool FileUtil::fileInfo(const std::u16string& path, uint64_t& size, uint64_t& mtime) {
+#ifdef __WINDOWS__
+  WIN32_FILE_ATTRIBUTE_DATA attr = {};
+  if(!GetFileAttributesExW(reinterpret_cast<const WCHAR*>(path.c_str()),GetFileExInfoStandard,&attr))
+    return false;
+  size  = (uint64_t(attr.nFileSizeHigh)<<32) | uint64_t(attr.nFileSizeLow);
+  mtime = (uint64_t(attr.ftLastWriteTime.dwHighDateTime)<<32) | uint64_t(attr.ftLastWriteTime.dwLowDateTime);
+  return true;
+#else
+  std::string p=Tempest::TextCodec::toUtf8(path);
+  struct stat  buffer={};
+  if(stat(p.c_str(),&buffer)!=0)
+    return false;
+  size  = uint64_t(buffer.st_size);
+  mtime = uint64_t(buffer.st_mtime);
+  return true;
+#endif
+  }
+
+bool FileUtil::createDirectory(const std::u16string& path) {
+  if(exists(path))
+    return true;
+#ifdef __WINDOWS__
+  return CreateDirectoryW(reinterpret_cast<const WCHAR*>(path.c_str()),nullptr)!=FALSE;
+#else
+  std::string p=Tempest::TextCodec::toUtf8(path);
+  return mkdir(p.c_str(),0755)==0;
+#endif
+  }
+
 std::u16string FileUtil::caseInsensitiveSegment(const std::u16string& path,const char16_t* segment,Dir::FileType type) {
   std::u16string next=path+segment;
   if(FileUtil::exists(next)) {
@@ -0,0 +1,114 @@
+#include "mappedfile.h"
+
+#include <Tempest/Platform>
+#include <Tempest/TextCodec>
+
+#include <system_error>
+
+#ifdef __WINDOWS__
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#ifdef __WINDOWS__
+MappedFile::MappedFile(const std::u16string& path, Mode mode) {
+  HANDLE fd = CreateFileW(reinterpret_cast<const WCHAR*>(path.c_str()),GENERIC_READ,FILE_SHARE_READ,
+                          nullptr,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr);
+  if(fd==INVALID_HANDLE_VALUE)
+    throw std::system_error(int(GetLastError()),std::system_category());
+
+  LARGE_INTEGER length = {};
+  if(!GetFileSizeEx(fd,&length)) {
+    DWORD err = GetLastError();
+    CloseHandle(fd);
+    throw std::system_error(int(err),std::system_category());
+    }
+  if(length.QuadPart==0) {
+    CloseHandle(fd);
+    return;
+    }
+
+  // view keeps file mapped, after both handles are closed
+  const bool cow  = (mode==CopyOnWrite);
+  HANDLE     map  = CreateFileMappingW(fd,nullptr,cow ? PAGE_WRITECOPY : PAGE_READONLY,0,0,nullptr);
+  void*      view = map!=nullptr ? MapViewOfFile(map,cow ? FILE_MAP_COPY : FILE_MAP_READ,0,0,0) : nullptr;
+  DWORD      err  = GetLastError();
+  if(map!=nullptr)
+    CloseHandle(map);
+  CloseHandle(fd);
+  if(view==nullptr)
+    throw std::system_error(int(err),std::system_category());
+
+  ptr = reinterpret_cast<uint8_t*>(view);
+  sz  = size_t(length.QuadPart);
+  }
+
+void MappedFile::close() {
+  if(ptr!=nullptr)
+    UnmapViewOfFile(ptr);
+  ptr = nullptr;
+  sz  = 0;
+  }
+#else
+MappedFile::MappedFile(const std::u16string& path, Mode mode) {
+  std::string p  = Tempest::TextCodec::toUtf8(path);
+  int         fd = ::open(p.c_str(),O_RDONLY);
+  if(fd<0)
+    throw std::system_error(errno,std::generic_category());
+
+  struct stat st = {};
+  if(fstat(fd,&st)!=0) {
+    int err = errno;
+    ::close(fd);
+    throw std::system_error(err,std::generic_category());
+    }
+  if(st.st_size==0) {
+    ::close(fd);
+    return;
+    }
+
+  // mapping stays valid, after descriptor is closed
+  const int prot = (mode==CopyOnWrite) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+  void*     view = mmap(nullptr,size_t(st.st_size),prot,MAP_PRIVATE,fd,0);
+  int       err  = errno;
+  ::close(fd);
+  if(view==MAP_FAILED)
+    throw std::system_error(err,std::generic_category());
+
+  ptr = reinterpret_cast<uint8_t*>(view);
+  sz  = size_t(st.st_size);
+  }
+
+void MappedFile::close() {
+  if(ptr!=nullptr)
+    munmap(ptr,sz);
+  ptr = nullptr;
+  sz  = 0;
+  }
+#endif
+
+MappedFile::MappedFile(MappedFile&& other)
+  :ptr(other.ptr), sz(other.sz) {
+  other.ptr = nullptr;
+  other.sz  = 0;
+  }
+
+MappedFile::~MappedFile() {
+  close();
+  }
+
+MappedFile& MappedFile::operator = (MappedFile&& other) {
+  if(this==&other)
+    return *this;
+  close();
+  ptr       = other.ptr;
+  sz        = other.sz;
+  other.ptr = nullptr;
+  other.sz  = 0;
+  return *this;
+  }
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// View of whole file, mapped into memory. Throws std::system_error, if file can't be opened.
+// Copy-on-write mapping can be modified in place: touched pages become private, file is never written.
+class MappedFile final {
+  public:
+    enum Mode : uint8_t {
+      ReadOnly,
+      CopyOnWrite,
+      };
+
+    explicit MappedFile(const std::u16string& path, Mode mode = ReadOnly);
+    MappedFile(MappedFile&& other);
+    MappedFile(const MappedFile&) = delete;
+    ~MappedFile();
+
+    MappedFile& operator = (MappedFile&& other);
+
+    const uint8_t* data() const { return ptr; }
+    uint8_t*       data()       { return ptr; } // writable for CopyOnWrite only
+    size_t         size() const { return sz;  }
+
+  private:
+    void           close();
+
+    uint8_t*       ptr = nullptr;
+    size_t         sz  = 0;
+  };
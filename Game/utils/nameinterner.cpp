@@ -0,0 +1,73 @@
+#include "nameinterner.h"
+
+#include <cctype>
+
+static char upper(char c) {
+  return char(std::toupper(uint8_t(c)));
+  }
+
+uint32_t NameInterner::hash(const char* name) {
+  // FNV-1a
+  uint32_t h = 2166136261u;
+  for(; *name; ++name) {
+    h ^= uint8_t(upper(*name));
+    h *= 16777619u;
+    }
+  return h;
+  }
+
+bool NameInterner::equals(const char* name, const char* up) {
+  for(; *name && *up; ++name, ++up)
+    if(upper(*name)!=*up)
+      return false;
+  return *name==*up;
+  }
+
+const char* NameInterner::intern(const char* name) {
+  if(2*(strings.size()+1)>table.size())
+    grow();
+
+  const uint32_t h = hash(name);
+  const size_t   i = slot(name,h);
+  if(table[i].str!=nullptr)
+    return table[i].str;
+
+  std::string s = name;
+  for(auto& c:s)
+    c = upper(c);
+  strings.emplace_back(std::move(s));
+  table[i].hash = h;
+  table[i].str  = strings.back().c_str();
+  return table[i].str;
+  }
+
+const char* NameInterner::find(const char* name) const {
+  if(table.empty())
+    return nullptr;
+  return table[slot(name,hash(name))].str;
+  }
+
+size_t NameInterner::slot(const char* name, uint32_t h) const {
+  const size_t mask = table.size()-1;
+  for(size_t i=h&mask;;i=(i+1)&mask) {
+    auto& s = table[i];
+    if(s.str==nullptr || (s.hash==h && equals(name,s.str)))
+      return i;
+    }
+  }
+
+void NameInterner::grow() {
+  std::vector<Slot> prev = std::move(table);
+  table.clear();
+  table.resize(prev.empty() ? 64 : prev.size()*2);
+
+  const size_t mask = table.size()-1;
+  for(auto& s:prev) {
+    if(s.str==nullptr)
+      continue;
+    size_t i = s.hash&mask;
+    while(table[i].str!=nullptr)
+      i = (i+1)&mask;
+    table[i] = s;
+    }
+  }
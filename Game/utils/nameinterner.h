@@ -0,0 +1,36 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Case-insensitive string interner: names, that are equal ignoring case, are mapped to the same pointer,
+// so interned names can be compared by address. Pointers stay valid for lifetime of the interner.
+class NameInterner final {
+  public:
+    const char*        intern(const char* name);
+    const char*        intern(const std::string& name) { return intern(name.c_str()); }
+
+    // nullptr, if name was never interned
+    const char*        find(const char* name) const;
+    const char*        find(const std::string& name) const { return find(name.c_str()); }
+
+    size_t             size() const { return strings.size(); }
+
+    // hash of upper-case name; same as used by SymbolTable
+    static uint32_t    hash(const char* name);
+    static bool        equals(const char* name, const char* upper);
+
+  private:
+    struct Slot {
+      uint32_t    hash = 0;
+      const char* str  = nullptr;
+      };
+
+    size_t             slot(const char* name, uint32_t h) const;
+    void               grow();
+
+    std::vector<Slot>       table;
+    std::deque<std::string> strings;
+  };
@@ -0,0 +1,53 @@
+#include "perfcounters.h"
+
+#include <chrono>
+
+std::atomic_bool           PerfCounters::enabled{false};
+std::atomic<uint64_t>      PerfCounters::time[Count] = {};
+std::atomic<uint64_t>      PerfCounters::events[EventCount] = {};
+thread_local uint32_t      PerfCounters::depth[Count] = {};
+
+void PerfCounters::setEnabled(bool e) {
+  enabled.store(e);
+  }
+
+void PerfCounters::reset() {
+  for(auto& i:time)
+    i.store(0);
+  for(auto& i:events)
+    i.store(0);
+  }
+
+uint64_t PerfCounters::get(Counter c) {
+  return time[c].load();
+  }
+
+void PerfCounters::count(Event e) {
+  if(isEnabled())
+    events[e].fetch_add(1,std::memory_order_relaxed);
+  }
+
+uint64_t PerfCounters::get(Event e) {
+  return events[e].load();
+  }
+
+uint64_t PerfCounters::now() {
+  auto t = std::chrono::steady_clock::now().time_since_epoch();
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t).count());
+  }
+
+PerfCounters::Scope::Scope(Counter c)
+  :counter(c) {
+  if(!isEnabled())
+    return;
+  tracked = true;
+  if(depth[c]++==0)
+    start = now();
+  }
+
+PerfCounters::Scope::~Scope() {
+  if(!tracked)
+    return;
+  if(--depth[counter]==0)
+    time[counter].fetch_add(now()-start);
+  }
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Accumulated wall-time of game subsystems, in nanoseconds, and event counts. Counters are inclusive:
+// script time spent inside of npc tick is reported by both Script and WorldObjects.
+// Collection is off by default and enabled by headless benchmark.
+class PerfCounters final {
+  public:
+    enum Counter : uint8_t {
+      WorldObjects,
+      Physics,
+      Script,
+      Animation,
+      Count
+      };
+
+    // number of skeletal poses, processed by each animation lod per frame
+    enum Event : uint8_t {
+      PoseFull,
+      PoseReduced,
+      PoseFar,
+      PoseThrottled,
+      PoseFrozen,
+      EventCount
+      };
+
+    static void     setEnabled(bool e);
+    static bool     isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static void     reset();
+    static uint64_t get(Counter c);
+
+    static void     count(Event e);
+    static uint64_t get(Event e);
+
+    // measures scope; nested scopes of same counter on same thread are not counted twice
+    class Scope final {
+      public:
+        Scope(Counter c);
+        Scope(const Scope&) = delete;
+        ~Scope();
+
+      private:
+        Counter  counter;
+        bool     tracked = false;
+        uint64_t start   = 0;
+      };
+
+  private:
+    static uint64_t                   now();
+
+    static std::atomic_bool           enabled;
+    static std::atomic<uint64_t>      time[Count];
+    static std::atomic<uint64_t>      events[EventCount];
+    static thread_local uint32_t      depth[Count];
+  };
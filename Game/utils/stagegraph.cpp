@@ -0,0 +1,112 @@
+#include "stagegraph.h"
+
+#include <Tempest/Application>
+#include <Tempest/Log>
+
+#include <stdexcept>
+
+using namespace Tempest;
+
+StageGraph::Id StageGraph::add(const char* name, Affinity a, std::initializer_list<Id> deps, std::function<void()> fn, int weight) {
+  Stage s;
+  s.name     = name;
+  s.affinity = a;
+  s.deps     = deps;
+  s.fn       = std::move(fn);
+  s.weight   = weight;
+  for(auto i:s.deps)
+    if(i>=stages.size())
+      throw std::logic_error("stage dependency must be added first");
+  stages.emplace_back(std::move(s));
+  return stages.size()-1;
+  }
+
+void StageGraph::exec(const std::function<void(int)>& progress, int begin, int end) {
+  int total = 0;
+  for(auto& s:stages)
+    total += s.weight;
+
+  Workers::TaskGroup workers;
+  int                reported = -1;
+
+  std::unique_lock<std::mutex> lck(sync);
+  while(true) {
+    Stage* caller = nullptr;
+    if(error==nullptr) {
+      for(auto& s:stages) {
+        if(s.started || !isReady(s))
+          continue;
+        if(s.affinity==Caller) {
+          if(caller==nullptr)
+            caller = &s;
+          continue;
+          }
+        s.started = true;
+        running++;
+        workers.run([this,&s](){ implRun(s); });
+        }
+      }
+
+    if(caller!=nullptr) {
+      caller->started = true;
+      running++;
+      lck.unlock();
+      implRun(*caller);
+      lck.lock();
+      }
+    else if(running==0) {
+      break;
+      }
+    else {
+      cv.wait(lck);
+      }
+
+    int done = 0;
+    for(auto& s:stages)
+      if(s.done)
+        done += s.weight;
+    const int pr = total>0 ? begin+(end-begin)*done/total : end;
+    if(pr!=reported) {
+      reported = pr;
+      lck.unlock();
+      progress(pr);
+      lck.lock();
+      }
+    }
+  lck.unlock();
+  workers.wait();
+
+  if(error!=nullptr)
+    std::rethrow_exception(error);
+  for(auto& s:stages)
+    if(!s.done)
+      throw std::logic_error("cyclic dependency in stage graph");
+  }
+
+bool StageGraph::isReady(const Stage& s) const {
+  for(auto i:s.deps)
+    if(!stages[i].done)
+      return false;
+  return true;
+  }
+
+void StageGraph::implRun(Stage& s) {
+  std::exception_ptr err;
+  const uint64_t     time = Application::tickCount();
+  try {
+    s.fn();
+    }
+  catch(...) {
+    err = std::current_exception();
+    }
+  Log::i("load stage [",s.name,"]: ",uint32_t(Application::tickCount()-time)," ms");
+
+  {
+    std::lock_guard<std::mutex> g(sync);
+    s.done = true;
+    running--;
+    if(err!=nullptr && error==nullptr)
+      error = err;
+  }
+  cv.notify_all();
+  }
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+#include "workers.h"
+
+// Dependency graph of loading stages: stage starts, once all of it's dependencies are done.
+// Worker-stages are executed on Workers pool; Caller-stages (gpu objects and other thread-unsafe work)
+// are executed on thread, that called exec.
+class StageGraph final {
+  public:
+    enum Affinity : uint8_t {
+      Worker,
+      Caller,
+      };
+    using Id = size_t;
+
+    StageGraph() = default;
+    StageGraph(const StageGraph&) = delete;
+
+    Id   add(const char* name, Affinity a, std::initializer_list<Id> deps, std::function<void()> fn, int weight = 1);
+    // runs all stages; progress is reported in range [begin,end] by completed weight
+    void exec(const std::function<void(int)>& progress, int begin, int end);
+
+  private:
+    struct Stage {
+      const char*           name     = "";
+      Affinity              affinity = Worker;
+      std::vector<Id>       deps;
+      std::function<void()> fn;
+      int                   weight   = 1;
+      bool                  started  = false;
+      bool                  done     = false;
+      };
+
+    std::vector<Stage>      stages;
+    std::mutex              sync;
+    std::condition_variable cv;
+    size_t                  running = 0;
+    std::exception_ptr      error;
+
+    bool isReady(const Stage& s) const;
+    void implRun(Stage& s);
+  };
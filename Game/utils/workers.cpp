@@ -4,20 +4,29 @@
 
 using namespace Tempest;
 
+thread_local size_t Workers::threadId = size_t(-1);
+const        size_t Workers::maxSpin  = 64;
+
 Workers::Workers() {
-  size_t id=0;
-  for(auto& i:th) {
-    i = std::thread([this,id]() noexcept {
+  // calling thread participates in parallelFor, so one thread less
+  size_t cnt = std::max(1u,std::thread::hardware_concurrency());
+  cnt = std::max<size_t>(1,cnt-1);
+
+  queue.reset(new Queue[cnt]);
+  th.resize(cnt);
+  for(size_t id=0; id<cnt; ++id) {
+    th[id] = std::thread([this,id]() noexcept {
       threadFunc(id);
       });
-    ++id;
     }
   }
 
 Workers::~Workers() {
-  running   = false;
-  workTasks = MAX_THREADS;
-  execWork();
+  {
+    std::lock_guard<std::mutex> lck(sleepSync);
+    running.store(false);
+  }
+  sleepCv.notify_all();
   for(auto& i:th)
     i.join();
   }
@@ -27,46 +36,100 @@ Workers &Workers::inst() {
   return w;
   }
 
+size_t Workers::threadCount() {
+  return inst().th.size()+1;
+  }
+
 void Workers::threadFunc(size_t id) {
+  threadId = id;
   while(true) {
-    {
-    std::unique_lock<std::mutex> lck(sync);
-    while(!workInc[id])
-      workWait.wait(lck);
-    workInc[id]=false;
-    }
+    Job job;
+    if(pop(id,job)) {
+      exec(job);
+      continue;
+      }
 
-    if(!running) {
-      workDone.fetch_add(1);
+    std::unique_lock<std::mutex> lck(sleepSync);
+    sleepCv.wait(lck,[this](){ return pending.load()>0 || !running.load(); });
+    if(!running.load())
       return;
-      }
+    }
+  }
 
-    size_t b = std::min((id  )*batchSize, workSize);
-    size_t e = std::min((id+1)*batchSize, workSize);
-    // Log::d("worker: id = ",id," [",b, ", ",e,"]");
+void Workers::push(const Job& j) {
+  size_t id = threadId;
+  if(id>=th.size())
+    id = nextQueue.fetch_add(1)%th.size();
+  {
+    std::lock_guard<std::mutex> lck(queue[id].sync);
+    queue[id].jobs.push_back(j);
+  }
+  pending.fetch_add(1);
+  {
+    // pairs with predicate check in threadFunc, to not lose wakeup
+    std::lock_guard<std::mutex> lck(sleepSync);
+  }
+  sleepCv.notify_one();
+  notifyWaiters();
+  }
 
-    if(b!=e) {
-      void* d = &workSet[b*workEltSize];
-      workFunc(d,e-b);
+bool Workers::pop(size_t id, Job& out) {
+  if(pending.load()==0)
+    return false;
+  const size_t cnt = th.size();
+  if(id<cnt) {
+    // own queue: LIFO, to keep nested work hot in cache
+    auto& q = queue[id];
+    std::lock_guard<std::mutex> lck(q.sync);
+    if(!q.jobs.empty()) {
+      out = q.jobs.back();
+      q.jobs.pop_back();
+      pending.fetch_sub(1);
+      return true;
       }
-
-    workDone.fetch_add(1);
     }
+  // steal: FIFO, takes oldest(biggest) work from other threads
+  const size_t start = (id<cnt ? id+1 : nextQueue.load());
+  for(size_t i=0; i<cnt; ++i) {
+    auto& q = queue[(start+i)%cnt];
+    std::lock_guard<std::mutex> lck(q.sync);
+    if(!q.jobs.empty()) {
+      out = q.jobs.front();
+      q.jobs.pop_front();
+      pending.fetch_sub(1);
+      return true;
+      }
+    }
+  return false;
   }
 
-void Workers::execWork() {
+bool Workers::runOne() {
+  Job job;
+  if(!pop(threadId,job))
+    return false;
+  exec(job);
+  return true;
+  }
+
+void Workers::exec(Job& j) {
+  auto counter = j.counter;
+  j.exec(j.ctx,j.begin,j.end);
+  if(counter!=nullptr)
+    counter->fetch_sub(1,std::memory_order_acq_rel);
+  // job may have completed a counter or a future
+  notifyWaiters();
+  }
+
+void Workers::notifyWaiters() {
   {
-    std::unique_lock<std::mutex> lck(sync);
-    for(size_t i=0; i<workTasks; ++i)
-      workInc[i]=true;
-    workWait.notify_all();
+    // pairs with predicate check in waitUntil, to not lose wakeup
+    std::lock_guard<std::mutex> lck(waitSync);
+  }
+  waitCv.notify_all();
   }
-  std::this_thread::yield();
 
-  while(true) {
-    int expect = int(workTasks);
-    if(workDone.compare_exchange_strong(expect,0,std::memory_order::memory_order_acq_rel))
-      break;
-    std::this_thread::yield();
-    }
+void Workers::waitFor(std::atomic<size_t>& counter) {
+  waitUntil([&counter]() {
+    return counter.load(std::memory_order_acquire)==0;
+    });
   }
@@ -3,25 +3,28 @@
 #include <thread>
 #include <mutex>
 #include <vector>
-#include <functional>
+#include <deque>
+#include <memory>
+#include <future>
 #include <atomic>
 #include <algorithm>
-
-#include "semaphore.h"
+#include <condition_variable>
 
 class Workers final {
   public:
     Workers();
     ~Workers();
 
+    class TaskGroup;
+
     template<class T,class F>
     static void parallelFor(T* b, T* e, const F& func) {
-      inst().runParallelFor(b,std::distance(b,e),std::thread::hardware_concurrency(),func);
+      inst().runParallelFor(b,size_t(std::distance(b,e)),size_t(-1),func);
       }
 
     template<class T,class F>
     static void parallelFor(std::vector<T>& data, const F& func) {
-      inst().runParallelFor(data.data(),data.size(),std::thread::hardware_concurrency(),func);
+      inst().runParallelFor(data.data(),data.size(),size_t(-1),func);
       }
 
     template<class T,class F>
@@ -29,44 +32,140 @@ class Workers final {
       inst().runParallelFor(data.data(),data.size(),maxTh,func);
       }
 
+    // runs f on worker pool; result can be obtained with Workers::get
+    template<class F>
+    static auto async(F f) -> std::future<decltype(f())> {
+      using R = decltype(f());
+      auto* task = new std::packaged_task<R()>(std::move(f));
+      auto  ret  = task->get_future();
+      inst().push(Job{[](void* ctx, size_t, size_t) {
+        auto* t = reinterpret_cast<std::packaged_task<R()>*>(ctx);
+        (*t)();
+        delete t;
+        },task,0,0,nullptr});
+      return ret;
+      }
+
+    // waits for future, executing pending tasks in meantime - safe to call from worker thread
+    template<class R>
+    static R get(std::future<R>& f) {
+      inst().waitUntil([&f]() {
+        return f.wait_for(std::chrono::seconds(0))==std::future_status::ready;
+        });
+      return f.get();
+      }
+
+    static size_t threadCount();
+
   private:
-    enum { MAX_THREADS=16 };
+    struct Job {
+      void  (*exec)(void* ctx, size_t begin, size_t end) = nullptr;
+      void*                ctx     = nullptr;
+      size_t               begin   = 0;
+      size_t               end     = 0;
+      std::atomic<size_t>* counter = nullptr;
+      };
+
+    struct Queue {
+      std::mutex      sync;
+      std::deque<Job> jobs;
+      };
 
     void threadFunc(size_t id);
-    void execWork();
     static Workers& inst();
 
+    void push(const Job& j);
+    bool pop (size_t id, Job& out);
+    bool runOne();
+    void exec(Job& j);
+    void waitFor(std::atomic<size_t>& counter);
+    void notifyWaiters();
+
+    // helps with pending jobs; after short spin without work, sleeps until some job is done or pushed
+    template<class F>
+    void waitUntil(const F& ready) {
+      size_t spin = 0;
+      while(!ready()) {
+        if(runOne()) {
+          spin = 0;
+          continue;
+          }
+        if(spin<maxSpin) {
+          ++spin;
+          std::this_thread::yield();
+          continue;
+          }
+        std::unique_lock<std::mutex> lck(waitSync);
+        waitCv.wait(lck,[this,&ready](){ return pending.load()>0 || ready(); });
+        spin = 0;
+        }
+      }
+
     template<class T,class F>
     void runParallelFor(T* data, size_t sz, size_t maxTh, const F& func) {
-      workSet     = reinterpret_cast<uint8_t*>(data);
-      workSize    = sz;
-      workEltSize = sizeof(T);
-
-      workFunc = [&func](void* data,size_t sz) {
-        T* tdata = reinterpret_cast<T*>(data);
-        for(size_t i=0;i<sz;++i)
-          func(tdata[i]);
+      struct Ctx {
+        T*       data;
+        const F* func;
+        };
+      auto body = [](void* ctx, size_t b, size_t e) {
+        auto& c = *reinterpret_cast<Ctx*>(ctx);
+        for(size_t i=b; i<e; ++i)
+          (*c.func)(c.data[i]);
         };
 
-      if(maxTh>MAX_THREADS)
-        workTasks = MAX_THREADS; else
-        workTasks = maxTh;
-
-      batchSize = std::max<size_t>(16,(sz+workTasks-1)/workTasks);
-      execWork();
+      Ctx    ctx   = {data,&func};
+      size_t tasks = std::min(maxTh,th.size()+1);
+      if(tasks<=1 || sz<=1) {
+        body(&ctx,0,sz);
+        return;
+        }
+
+      // few batches per thread, so idle threads can steal remaining work from slow ones
+      const size_t batchSize = std::max<size_t>(1,(sz+tasks*4-1)/(tasks*4));
+      const size_t batchCnt  = (sz+batchSize-1)/batchSize;
+
+      std::atomic<size_t> counter{batchCnt-1};
+      for(size_t i=1; i<batchCnt; ++i)
+        push(Job{body,&ctx,i*batchSize,std::min((i+1)*batchSize,sz),&counter});
+      body(&ctx,0,std::min(batchSize,sz));
+      waitFor(counter);
       }
 
-    std::thread                       th     [MAX_THREADS];
-    bool                              workInc[MAX_THREADS];
+    std::vector<std::thread>            th;
+    std::unique_ptr<Queue[]>            queue;
+    std::atomic<size_t>                 nextQueue{0};
 
-    bool                              running=true;
+    std::atomic_bool                    running{true};
+    std::atomic<size_t>                 pending{0};
+    std::mutex                          sleepSync;
+    std::condition_variable             sleepCv;
+    std::mutex                          waitSync;
+    std::condition_variable             waitCv;
 
-    uint8_t*                          workSet=nullptr;
-    size_t                            workSize=0, batchSize=0, workEltSize=0;
-    size_t                            workTasks=0;
-    std::function<void(void*,size_t)> workFunc;
+    static const size_t                 maxSpin;
 
-    std::mutex                        sync;
-    std::condition_variable           workWait;
-    std::atomic_int                   workDone{0};
+    static thread_local size_t          threadId;
+  };
+
+class Workers::TaskGroup final {
+  public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup&) = delete;
+    ~TaskGroup() { wait(); }
+
+    template<class F>
+    void run(F f) {
+      pending.fetch_add(1);
+      inst().push(Job{[](void* ctx, size_t, size_t) {
+        auto* fn = reinterpret_cast<F*>(ctx);
+        (*fn)();
+        delete fn;
+        },new F(std::move(f)),0,0,&pending});
+      }
+
+    // waits for all tasks of this group, executing pending tasks in meantime
+    void wait() { inst().waitFor(pending); }
+
+  private:
+    std::atomic<size_t> pending{0};
   };
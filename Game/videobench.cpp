@@ -0,0 +1,109 @@
+#include "videobench.h"
+
+#include <Tempest/File>
+#include <Tempest/Log>
+#include <Tempest/TextCodec>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "bink/video.h"
+
+using namespace Tempest;
+
+// whole file is in memory, so file i/o is not measured
+struct VideoBench::Input : Bink::Video::Input {
+  Input(std::vector<uint8_t>&& data):data(std::move(data)) {}
+
+  void read(void* dest, size_t count) override {
+    if(at+count>data.size())
+      throw std::runtime_error("i/o error");
+    std::memcpy(dest,data.data()+at,count);
+    at+=count;
+    }
+  void skip(size_t count) override {
+    at+=count;
+    }
+  void seek(size_t pos) override {
+    at = pos;
+    }
+
+  std::vector<uint8_t> data;
+  size_t               at=0;
+  };
+
+VideoBench::VideoBench(std::u16string file)
+  :file(std::move(file)) {
+  }
+
+int VideoBench::exec() {
+  const auto name = TextCodec::toUtf8(file);
+
+  std::vector<uint8_t> data;
+  try {
+    RFile fin(file);
+    data.resize(fin.size());
+    fin.read(data.data(),data.size());
+    }
+  catch(...) {
+    Log::e("video-bench: unable to open \"",name.c_str(),"\"");
+    return -1;
+    }
+
+  try {
+    Input input(std::move(data));
+    return exec(input,name);
+    }
+  catch(std::exception& e) {
+    Log::e("video-bench: unable to decode \"",name.c_str(),"\": ",e.what());
+    return -1;
+    }
+  }
+
+int VideoBench::exec(Input& input, const std::string& name) {
+  using clock = std::chrono::steady_clock;
+  Bink::Video vid(&input);
+
+  std::vector<uint8_t> rgba;
+  uint64_t             decodeNs = 0, convertNs = 0;
+  size_t               errors   = 0;
+  uint32_t             w = 0, h = 0;
+
+  for(size_t i=0; i<vid.frameCount(); ++i) {
+    auto t0 = clock::now();
+    const Bink::Frame* f = nullptr;
+    try {
+      f = &vid.nextFrame();
+      }
+    catch(const Bink::VideoDecodingException&) {
+      errors++;
+      continue;
+      }
+    auto t1 = clock::now();
+    w = f->width();
+    h = f->height();
+    rgba.resize(size_t(w)*h*4);
+    f->toRgba(rgba.data());
+    auto t2 = clock::now();
+
+    decodeNs  += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count());
+    convertNs += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t2-t1).count());
+    }
+
+  const double frames = double(vid.frameCount()-errors);
+  auto fps = [frames](uint64_t ns) {
+    return ns==0 ? 0.0 : frames*1e9/double(ns);
+    };
+
+  char buf[512] = {};
+  std::snprintf(buf,sizeof(buf),"%ux%u, %u frames (%u errors), video fps %.2f",
+                w,h,uint32_t(vid.frameCount()),uint32_t(errors),double(vid.fps().num)/double(vid.fps().den));
+  Log::i("video-bench: ",name.c_str()," ",buf);
+  std::snprintf(buf,sizeof(buf),"decode %.1f frames/sec, decode+rgba %.1f frames/sec, rgba %.3f ms/frame",
+                fps(decodeNs),fps(decodeNs+convertNs),frames>0 ? double(convertNs)/1e6/frames : 0.0);
+  Log::i("video-bench: ",buf);
+  return 0;
+  }
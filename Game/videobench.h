@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+// Headless tool: decodes every frame of a bink video as fast as possible, without presentation,
+// and prints decoding speed - with and without conversion to RGBA.
+class VideoBench final {
+  public:
+    VideoBench(std::u16string file);
+    VideoBench(const VideoBench&) = delete;
+
+    int  exec();
+
+  private:
+    struct Input;
+
+    int  exec(Input& input, const std::string& name);
+
+    std::u16string file;
+  };
@@ -0,0 +1,152 @@
+#include "bsptree.h"
+
+#include <algorithm>
+
+using namespace Tempest;
+
+void BspTree::build(const ZenLoad::zCBspTreeData& bsp) {
+  nodes.clear();
+  leafs.clear();
+  names.clear();
+  nameId.clear();
+
+  // node, that is claimed more than once, belongs to no sector
+  std::vector<uint32_t> nodeSector(bsp.nodes.size(),NoSector);
+  std::vector<uint8_t>  claims    (bsp.nodes.size(),0);
+  for(auto& s:bsp.sectors) {
+    const uint32_t id = intern(s.name);
+    for(auto r:s.bspNodeIndices) {
+      if(r>=bsp.leafIndices.size())
+        continue;
+      const size_t idx = bsp.leafIndices[r];
+      if(idx>=bsp.nodes.size())
+        continue;
+      nodeSector[idx] = id;
+      if(claims[idx]<2)
+        claims[idx]++;
+      }
+    }
+
+  if(bsp.nodes.empty())
+    return;
+
+  // depth-first order: front child directly follows it's parent
+  const size_t          srcCount = bsp.nodes.size();
+  std::vector<uint32_t> remap(srcCount,NoNode);
+  std::vector<uint32_t> order;
+  std::vector<uint32_t> stk = {0};
+  order.reserve(srcCount);
+  while(!stk.empty()) {
+    const uint32_t i = stk.back();
+    stk.pop_back();
+    if(remap[i]!=NoNode)
+      continue;
+    remap[i] = uint32_t(order.size());
+    order.push_back(i);
+
+    auto& n = bsp.nodes[i];
+    if(n.back<srcCount)
+      stk.push_back(n.back);
+    if(n.front<srcCount)
+      stk.push_back(n.front);
+    }
+
+  nodes.resize(order.size());
+  leafs.resize(order.size());
+  for(size_t i=0; i<order.size(); ++i) {
+    auto& src = bsp.nodes[order[i]];
+    auto& n   = nodes[i];
+    auto& l   = leafs[i];
+    for(int r=0; r<4; ++r)
+      n.plane[r] = src.plane.v[r];
+    n.front  = src.front<srcCount ? remap[src.front] : NoNode;
+    n.back   = src.back <srcCount ? remap[src.back ] : NoNode;
+    l.bmin   = Vec3(src.bbox3dMin.x,src.bbox3dMin.y,src.bbox3dMin.z);
+    l.bmax   = Vec3(src.bbox3dMax.x,src.bbox3dMax.y,src.bbox3dMax.z);
+    l.sector = claims[order[i]]==1 ? nodeSector[order[i]] : NoSector;
+    }
+  }
+
+uint32_t BspTree::sectorAt(const Vec3& p) const {
+  if(nodes.empty())
+    return NoSector;
+
+  uint32_t id = 0;
+  while(true) {
+    auto&    n    = nodes[id];
+    float    sgn  = n.plane[0]*p.x + n.plane[1]*p.y + n.plane[2]*p.z - n.plane[3];
+    uint32_t next = (sgn>0) ? n.front : n.back;
+    if(next==NoNode)
+      break;
+    id = next;
+    }
+  return leafSector(id,p);
+  }
+
+void BspTree::sectorAt(const Vec3* p, uint32_t* out, size_t count) const {
+  if(nodes.empty()) {
+    std::fill(out,out+count,uint32_t(NoSector));
+    return;
+    }
+
+  // traversals of several points are interleaved, so their cache misses overlap
+  enum { Lanes = 8 };
+  for(size_t b=0; b<count; b+=Lanes) {
+    const size_t len            = std::min<size_t>(Lanes,count-b);
+    uint32_t     cursor[Lanes]  = {};
+    bool         done  [Lanes]  = {};
+    size_t       active         = len;
+    while(active>0) {
+      for(size_t i=0; i<len; ++i) {
+        if(done[i])
+          continue;
+        auto&    pt   = p[b+i];
+        auto&    n    = nodes[cursor[i]];
+        float    sgn  = n.plane[0]*pt.x + n.plane[1]*pt.y + n.plane[2]*pt.z - n.plane[3];
+        uint32_t next = (sgn>0) ? n.front : n.back;
+        if(next==NoNode) {
+          done[i] = true;
+          active--;
+          } else {
+          cursor[i] = next;
+          }
+        }
+      }
+    for(size_t i=0; i<len; ++i)
+      out[b+i] = leafSector(cursor[i],p[b+i]);
+    }
+  }
+
+uint32_t BspTree::findSector(const std::string& name) const {
+  auto it = nameId.find(name);
+  if(it==nameId.end())
+    return NoSector;
+  return it->second;
+  }
+
+const std::string& BspTree::sectorName(uint32_t id) const {
+  static std::string empty;
+  if(id>=names.size())
+    return empty;
+  return names[id];
+  }
+
+uint32_t BspTree::leafSector(uint32_t id, const Vec3& p) const {
+  auto& l = leafs[id];
+  if(l.bmin.x <= p.x && p.x <l.bmax.x &&
+     l.bmin.y <= p.y && p.y <l.bmax.y &&
+     l.bmin.z <= p.z && p.z <l.bmax.z) {
+    return l.sector;
+    }
+  return NoSector;
+  }
+
+uint32_t BspTree::intern(const std::string& name) {
+  auto it = nameId.find(name);
+  if(it!=nameId.end())
+    return it->second;
+  const uint32_t id = uint32_t(names.size());
+  names.push_back(name);
+  nameId[name] = id;
+  return id;
+  }
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Tempest/Vec>
+#include <zenload/zTypes.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+// Flattened zen bsp-tree: nodes are stored in depth-first order, with split planes separated from
+// rarely used leaf data. Every node knows it's sector (room) as interned id, so room queries don't touch strings.
+class BspTree final {
+  public:
+    BspTree() = default;
+    BspTree(const BspTree&) = delete;
+
+    enum : uint32_t {
+      NoSector = uint32_t(-1),
+      };
+
+    void               build(const ZenLoad::zCBspTreeData& bsp);
+
+    uint32_t           sectorAt(const Tempest::Vec3& p) const;
+    void               sectorAt(const Tempest::Vec3* p, uint32_t* out, size_t count) const;
+
+    size_t             sectorCount() const { return names.size(); }
+    uint32_t           findSector(const std::string& name) const;
+    const std::string& sectorName(uint32_t id) const;
+
+  private:
+    enum : uint32_t {
+      NoNode = uint32_t(-1),
+      };
+
+    struct Node {
+      float    plane[4] = {};
+      uint32_t front    = NoNode;
+      uint32_t back     = NoNode;
+      };
+
+    struct Leaf {
+      Tempest::Vec3 bmin, bmax;
+      uint32_t      sector = NoSector;
+      };
+
+    std::vector<Node>                        nodes;
+    std::vector<Leaf>                        leafs;
+    std::vector<std::string>                 names;
+    std::unordered_map<std::string,uint32_t> nameId;
+
+    uint32_t           leafSector(uint32_t id, const Tempest::Vec3& p) const;
+    uint32_t           intern(const std::string& name);
+  };
@@ -8,13 +8,13 @@ FpLock::FpLock() {
 
 FpLock::FpLock(const WayPoint &p)
   :pt(&p){
-  pt->useCount++;
+  pt->lock();
   }
 
 FpLock::FpLock(const WayPoint *p)
   :pt(p){
   if(pt)
-    pt->useCount++;
+    pt->lock();
   }
 
 FpLock::FpLock(FpLock &&other)
@@ -24,12 +24,12 @@ FpLock::FpLock(FpLock &&other)
 
 FpLock::~FpLock() {
   if(pt)
-    pt->useCount--;
+    pt->unlock();
   }
 
 FpLock &FpLock::operator=(FpLock &&other) {
   if(pt)
-    pt->useCount--;
+    pt->unlock();
   pt = other.pt;
   other.pt=nullptr;
   return *this;
@@ -38,7 +38,7 @@ FpLock &FpLock::operator=(FpLock &&other) {
 void FpLock::load(Serialize &fin) {
   fin.read(pt);
   if(pt)
-    pt->useCount++;
+    pt->lock();
   }
 
 void FpLock::save(Serialize &fout) const {
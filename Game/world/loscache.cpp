@@ -0,0 +1,115 @@
+#include "loscache.h"
+
+#include <functional>
+
+#include "world/objects/npc.h"
+#include "world.h"
+
+using namespace Tempest;
+
+const uint64_t LosCache::ttl           = 200;
+const float    LosCache::moveThreshold = 20.f;
+const float    LosCache::eyeHeight     = 180.f; // same as in Npc::canSenseNpc
+
+size_t LosCache::KeyHash::operator()(const Key& k) const {
+  const size_t a = std::hash<const Npc*>()(k.from);
+  const size_t b = std::hash<const Npc*>()(k.to);
+  return a ^ (b + 0x9e3779b9 + (a<<6) + (a>>2));
+  }
+
+LosCache::LosCache(World& owner)
+  :owner(owner) {
+  }
+
+bool LosCache::lineOfSight(const Npc& from, const Npc& to) {
+  const Vec3     a   = eyePos(from);
+  const Vec3     b   = eyePos(to);
+  const uint64_t geo = owner.physic()->geometryVersion();
+  const uint64_t now = owner.tickCount();
+
+  const Key key = {&from,&to};
+  auto      it  = cache.find(key);
+  if(it!=cache.end() && isValid(it->second,a,b,geo,now))
+    return it->second.visible;
+
+  auto& e = cache[key];
+  e.from     = a;
+  e.to       = b;
+  e.time     = now;
+  e.geometry = geo;
+  e.visible  = !owner.physic()->ray(a.x,a.y,a.z, b.x,b.y,b.z).hasCol;
+  return e.visible;
+  }
+
+void LosCache::prefetch(const std::vector<std::pair<const Npc*,const Npc*>>& pairs) {
+  const uint64_t now = owner.tickCount();
+  const uint64_t geo = owner.physic()->geometryVersion();
+
+  pending.clear();
+  rays.clear();
+  for(auto& p:pairs) {
+    if(p.first==nullptr || p.second==nullptr || p.first==p.second)
+      continue;
+    const Key  key = {p.first,p.second};
+    const Vec3 a   = eyePos(*p.first);
+    const Vec3 b   = eyePos(*p.second);
+    auto       it  = cache.find(key);
+    if(it!=cache.end() && isValid(it->second,a,b,geo,now))
+      continue;
+
+    // entry is filled right away, so duplicated pairs are traced only once
+    auto& e = cache[key];
+    e.from     = a;
+    e.to       = b;
+    e.time     = now;
+    e.geometry = geo;
+
+    DynamicWorld::RaySegment r;
+    r.from = a;
+    r.to   = b;
+    pending.push_back(key);
+    rays.push_back(r);
+    }
+
+  if(rays.empty())
+    return;
+
+  hits.resize(rays.size());
+  owner.physic()->ray(rays.data(),hits.data(),rays.size());
+  for(size_t i=0; i<pending.size(); ++i)
+    cache[pending[i]].visible = !hits[i].hasCol;
+  }
+
+void LosCache::tick() {
+  const uint64_t now = owner.tickCount();
+  for(auto i=cache.begin(); i!=cache.end();) {
+    if(i->second.time+ttl<now)
+      i = cache.erase(i); else
+      ++i;
+    }
+  }
+
+void LosCache::remove(const Npc& npc) {
+  for(auto i=cache.begin(); i!=cache.end();) {
+    if(i->first.from==&npc || i->first.to==&npc)
+      i = cache.erase(i); else
+      ++i;
+    }
+  }
+
+void LosCache::clear() {
+  cache.clear();
+  }
+
+bool LosCache::isValid(const Entry& e, const Vec3& from, const Vec3& to, uint64_t geometry, uint64_t now) const {
+  if(e.time+ttl<now || e.geometry!=geometry)
+    return false;
+  const float q = moveThreshold*moveThreshold;
+  return (e.from-from).quadLength()<q && (e.to-to).quadLength()<q;
+  }
+
+Vec3 LosCache::eyePos(const Npc& npc) {
+  auto p = npc.position();
+  p.y += eyeHeight;
+  return p;
+  }
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Tempest/Point>
+
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+#include "physics/dynamicworld.h"
+
+class Npc;
+class World;
+
+// Short-living cache of npc-to-npc line of sight. Entry is reused, until it expires,
+// until one of npc's moved noticeably, or until collision geometry changed.
+// Missing entries can be resolved in one batched ray query.
+class LosCache final {
+  public:
+    LosCache(World& owner);
+    LosCache(const LosCache&) = delete;
+
+    static const uint64_t ttl;
+    static const float    moveThreshold;
+    static const float    eyeHeight;
+
+    bool lineOfSight(const Npc& from, const Npc& to);
+    void prefetch(const std::vector<std::pair<const Npc*,const Npc*>>& pairs);
+
+    void tick();
+    void remove(const Npc& npc);
+    void clear();
+
+  private:
+    struct Key {
+      const Npc* from = nullptr;
+      const Npc* to   = nullptr;
+      bool operator == (const Key& k) const { return from==k.from && to==k.to; }
+      };
+
+    struct KeyHash {
+      size_t operator()(const Key& k) const;
+      };
+
+    struct Entry {
+      Tempest::Vec3 from, to;
+      uint64_t      time     = 0;
+      uint64_t      geometry = 0;
+      bool          visible  = false;
+      };
+
+    World&                                    owner;
+    std::unordered_map<Key,Entry,KeyHash>     cache;
+
+    std::vector<Key>                          pending;
+    std::vector<DynamicWorld::RaySegment>     rays;
+    std::vector<DynamicWorld::RayLandResult>  hits;
+
+    bool          isValid(const Entry& e, const Tempest::Vec3& from, const Tempest::Vec3& to, uint64_t geometry, uint64_t now) const;
+    static auto   eyePos(const Npc& npc) -> Tempest::Vec3;
+  };
@@ -0,0 +1,178 @@
+#include "npcindex.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "world/objects/npc.h"
+
+using namespace Tempest;
+
+const float NpcIndex::cellSize = 1000.f;
+
+void NpcIndex::clear() {
+  cells.clear();
+  entries.clear();
+  byInstance.clear();
+  deferred.clear();
+  hasHoles = false;
+  }
+
+void NpcIndex::add(Npc& npc) {
+  if(entries.find(&npc)!=entries.end())
+    return;
+  auto& e = entries[&npc];
+  byInstance[npc.handle()->instanceSymbol].push_back(&npc);
+  if(iterating>0) {
+    deferred.push_back(&npc);
+    return;
+    }
+  place(npc,e);
+  }
+
+void NpcIndex::del(const Npc& npc) {
+  auto it = entries.find(&npc);
+  if(it==entries.end())
+    return;
+  if(it->second.placed)
+    eraseFromCell(npc,it->second);
+  entries.erase(it);
+
+  auto inst = byInstance.find(npc.handle()->instanceSymbol);
+  if(inst!=byInstance.end()) {
+    erase(inst->second,&npc);
+    if(inst->second.empty())
+      byInstance.erase(inst);
+    }
+  }
+
+void NpcIndex::update(Npc& npc) {
+  auto it = entries.find(&npc);
+  if(it==entries.end())
+    return;
+  if(iterating>0) {
+    deferred.push_back(&npc);
+    return;
+    }
+  auto& e = it->second;
+  if(!e.placed) {
+    place(npc,e);
+    return;
+    }
+  const uint64_t key = cellKey(npc.position());
+  if(e.key==key)
+    return;
+  eraseFromCell(npc,e);
+  place(npc,e);
+  }
+
+bool NpcIndex::hasObject(const Npc* npc) const {
+  // NOTE: pointer can be dangling, no dereference here
+  return entries.find(npc)!=entries.end();
+  }
+
+const std::vector<Npc*>* NpcIndex::findByInstance(size_t instance) const {
+  auto it = byInstance.find(instance);
+  if(it==byInstance.end())
+    return nullptr;
+  return &it->second;
+  }
+
+int32_t NpcIndex::cellCoord(float v) {
+  return int32_t(std::floor(v/cellSize));
+  }
+
+uint64_t NpcIndex::cellKey(int32_t x, int32_t z) {
+  return (uint64_t(uint32_t(x))<<32) | uint64_t(uint32_t(z));
+  }
+
+uint64_t NpcIndex::cellKey(const Vec3& p) {
+  return cellKey(cellCoord(p.x),cellCoord(p.z));
+  }
+
+void NpcIndex::erase(std::vector<Npc*>& v, const Npc* npc) {
+  // keep order of insertion: lookups must be deterministic
+  for(size_t i=0; i<v.size(); ++i)
+    if(v[i]==npc) {
+      v.erase(v.begin()+int(i));
+      return;
+      }
+  }
+
+void NpcIndex::place(Npc& npc, Entry& e) {
+  e.key    = cellKey(npc.position());
+  e.placed = true;
+  cells[e.key].push_back(&npc);
+  }
+
+void NpcIndex::eraseFromCell(const Npc& npc, const Entry& e) {
+  auto c = cells.find(e.key);
+  if(c==cells.end())
+    return;
+  if(iterating>0) {
+    // cell is walked right now: leave a hole, compacted by flush
+    std::replace(c->second.begin(),c->second.end(),const_cast<Npc*>(&npc),static_cast<Npc*>(nullptr));
+    hasHoles = true;
+    return;
+    }
+  erase(c->second,&npc);
+  if(c->second.empty())
+    cells.erase(c);
+  }
+
+void NpcIndex::flush() {
+  if(hasHoles) {
+    hasHoles = false;
+    for(auto i=cells.begin(); i!=cells.end();) {
+      auto& c = i->second;
+      c.erase(std::remove(c.begin(),c.end(),static_cast<Npc*>(nullptr)),c.end());
+      if(c.empty())
+        i = cells.erase(i); else
+        ++i;
+      }
+    }
+
+  auto upd = std::move(deferred);
+  deferred.clear();
+  for(auto npc:upd) {
+    // removed meanwhile - pointer is not dereferenced
+    if(entries.find(npc)==entries.end())
+      continue;
+    update(*npc);
+    }
+  }
+
+void NpcIndex::implFind(const Vec3& p, float R, const void* ctx, void (*func)(const void*, Npc&)) {
+  struct Guard {
+    NpcIndex& self;
+    explicit Guard(NpcIndex& s):self(s) { self.iterating++; }
+    ~Guard() {
+      self.iterating--;
+      if(self.iterating==0)
+        self.flush();
+      }
+    } guard(*this);
+
+  const int32_t x0 = cellCoord(p.x-R), x1 = cellCoord(p.x+R);
+  const int32_t z0 = cellCoord(p.z-R), z1 = cellCoord(p.z+R);
+
+  // index based loops: npc removed by callback becomes nullptr, cells are not reallocated until flush
+  const uint64_t area = uint64_t(x1-x0+1)*uint64_t(z1-z0+1);
+  if(area>cells.size()) {
+    // huge radius - cheaper to visit every non-empty cell
+    for(auto& c:cells)
+      for(size_t i=0; i<c.second.size(); ++i)
+        if(auto npc = c.second[i])
+          func(ctx,*npc);
+    return;
+    }
+
+  for(int32_t x=x0; x<=x1; ++x)
+    for(int32_t z=z0; z<=z1; ++z) {
+      auto c = cells.find(cellKey(x,z));
+      if(c==cells.end())
+        continue;
+      for(size_t i=0; i<c->second.size(); ++i)
+        if(auto npc = c->second[i])
+          func(ctx,*npc);
+      }
+  }
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Tempest/Point>
+
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+class Npc;
+
+// Uniform hashed grid over npc positions (XZ plane) + instance lookup table.
+// Callback of find may insert, remove or move npcs (scripts do): grid changes are deferred until outermost find returns,
+// removed npcs are not reported anymore.
+class NpcIndex final {
+  public:
+    NpcIndex() = default;
+    NpcIndex(const NpcIndex&) = delete;
+
+    void clear();
+    void add   (Npc& npc);
+    void del   (const Npc& npc);
+    void update(Npc& npc);
+
+    bool hasObject(const Npc* npc) const;
+    // all npcs of instance, in order of insertion
+    auto findByInstance(size_t instance) const -> const std::vector<Npc*>*;
+
+    // calls f for every npc in cells, overlapping the sphere; exact distance test is up to caller
+    template<class F>
+    void find(const Tempest::Vec3& p, float R, const F& f) {
+      implFind(p,R,&f,[](const void* ctx, Npc& n){
+        (*reinterpret_cast<const F*>(ctx))(n);
+        });
+      }
+
+  private:
+    using Cell = std::vector<Npc*>;
+
+    struct Entry {
+      uint64_t key    = 0;
+      bool     placed = false;
+      };
+
+    static const float cellSize;
+
+    std::unordered_map<uint64_t,Cell>              cells;
+    std::unordered_map<const Npc*,Entry>           entries;
+    std::unordered_map<size_t,std::vector<Npc*>>   byInstance;
+
+    uint32_t                                       iterating = 0;
+    bool                                           hasHoles  = false;
+    std::vector<Npc*>                              deferred;
+
+    static int32_t  cellCoord(float v);
+    static uint64_t cellKey(int32_t x, int32_t z);
+    static uint64_t cellKey(const Tempest::Vec3& p);
+    static void     erase(std::vector<Npc*>& v, const Npc* npc);
+
+    void place(Npc& npc, Entry& e);
+    void eraseFromCell(const Npc& npc, const Entry& e);
+    void flush();
+    void implFind(const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Npc&));
+  };
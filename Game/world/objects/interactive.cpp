@@ -57,6 +57,7 @@ Interactive::Interactive(Vob* parent, World &world, ZenLoad::zCVobData& vob, boo
         }
       }
     }
+  resolveSymbols();
   visual.setYTranslationEnable(false);
   setVisual(mdlVisual);
   world.addInteractive(this);
@@ -81,6 +82,7 @@ void Interactive::load(Serialize &fin) {
 
   fin.read(stateNum,triggerTarget,useWithItem,conditionFunc,onStateFunc);
   fin.read(locked,keyInstance,pickLockStr);
+  resolveSymbols();
   invent.load(*this,world,fin);
   fin.read(pos,state,reverseState,loopState);
   if(fin.version()>=12)
@@ -115,6 +117,11 @@ void Interactive::load(Serialize &fin) {
     }
   }
 
+void Interactive::resolveSymbols() {
+  useWithItemId = useWithItem.empty() ? size_t(-1) : world.getSymbolIndex(useWithItem.c_str());
+  keyInstanceId = keyInstance.empty() ? size_t(-1) : world.getSymbolIndex(keyInstance.c_str());
+  }
+
 void Interactive::save(Serialize &fout) const {
   fout.write(uint8_t(vobType),vobName,focName,mdlVisual);
   fout.write(bbox[0].x,bbox[0].y,bbox[0].z,bbox[1].x,bbox[1].y,bbox[1].z);
@@ -408,7 +415,7 @@ bool Interactive::isContainer() const {
   }
 
 bool Interactive::needToLockpick(const Npc& pl) const {
-  const size_t keyInst = keyInstance.empty() ? size_t(-1) : world.getSymbolIndex(keyInstance.c_str());
+  const size_t keyInst = keyInstanceId;
   if(keyInst!=size_t(-1) && pl.inventory().itemCount(keyInst)>0)
     return false;
   return !(pickLockStr.empty() || isLockCracked);
@@ -494,7 +501,7 @@ bool Interactive::checkUseConditions(Npc& npc) {
     const size_t lockPickCnt    = npc.inventory().itemCount(ItKE_lockpick);
     const bool   canLockPick    = (npc.talentSkill(Npc::TALENT_PICKLOCK)!=0 && lockPickCnt>0);
 
-    const size_t keyInst        = keyInstance.empty() ? size_t(-1) : world.getSymbolIndex(keyInstance.c_str());
+    const size_t keyInst        = keyInstanceId;
     const bool   needToPicklock = (pickLockStr.size()>0);
 
     if(keyInst!=size_t(-1) && npc.hasItem(keyInst)>0)
@@ -525,7 +532,7 @@ bool Interactive::checkUseConditions(Npc& npc) {
       }
 
     if(!useWithItem.empty()) {
-      size_t it = world.getSymbolIndex(useWithItem.c_str());
+      size_t it = useWithItemId;
       if(it!=size_t(-1) && npc.hasItem(it)==0) {
         sc.printMobMissingItem(npc);
         return false;
@@ -612,7 +619,7 @@ bool Interactive::attach(Npc &npc, Interactive::Pos &to) {
     return false;
 
   if(!useWithItem.empty()) {
-    size_t it = world.getSymbolIndex(useWithItem.c_str());
+    size_t it = useWithItemId;
     if(it!=size_t(-1) && npc.hasItem(it)>0) {
       npc.delItem(it,1);
       }
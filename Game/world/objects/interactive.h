@@ -101,6 +101,7 @@ class Interactive : public Vob {
     void                setDir(Npc& npc,const Tempest::Matrix4x4& mt);
     bool                attach(Npc& npc,Pos& to);
     void                implAddItem(char *name);
+    void                resolveSymbols();
     void                autoDettachNpc();
     void                implChState(bool next);
     bool                checkUseConditions(Npc& npc);
@@ -137,6 +138,9 @@ class Interactive : public Vob {
     std::string                  keyInstance;
     std::string                  pickLockStr;
     Inventory                    invent;
+    // symbols of useWithItem and keyInstance
+    size_t                       useWithItemId = size_t(-1);
+    size_t                       keyInstanceId = size_t(-1);
 
     int                          state         = 0;
     bool                         reverseState  = false;
@@ -111,11 +111,6 @@ void Item::setPhysicsEnable(DynamicWorld& p) {
 
 void Item::setPhysicsDisable() {
   physic = DynamicWorld::Item();
-  world.invalidateVobIndex();
-  }
-
-bool Item::isDynamic() const {
-  return !physic.isEmpty();
   }
 
 const char *Item::displayName() const {
@@ -238,6 +233,3 @@ void Item::updateMatrix() {
   view.setObjMatrix(mat);
   }
 
-void Item::moveEvent() {
-  world.invalidateVobIndex();
-  }
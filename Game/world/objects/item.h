@@ -35,7 +35,6 @@ class Item final : public Vob {
 
     void setPhysicsEnable (DynamicWorld& physic);
     void setPhysicsDisable();
-    bool isDynamic() const override;
 
     uint8_t slot() const       { return itSlot;  }
     void    setSlot(uint8_t s) { itSlot = s;     }
@@ -73,7 +72,6 @@ class Item final : public Vob {
 
   private:
     void                updateMatrix();
-    void                moveEvent() override;
 
     Daedalus::GEngineClasses::C_Item  hitem={};
     MeshObjects::Mesh                 view;
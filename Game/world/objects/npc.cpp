@@ -335,6 +335,7 @@ bool Npc::setPosition(float ix, float iy, float iz) {
 
   physic.setPosition(Vec3{x,y,z});
   visual.setPosition(x,y,z, true);
+  owner.onNpcMove(*this);
   return true;
   }
 
@@ -347,6 +348,7 @@ void Npc::setViewPosition(const Tempest::Vec3& pos) {
   y = pos.y;
   z = pos.z;
   durtyTranform |= TR_Pos;
+  owner.onNpcMove(*this);
   }
 
 int Npc::aiOutputOrderId() const {
@@ -675,7 +677,7 @@ void Npc::updateAnimation() {
     visual.setTarget(currentTarget->position()); else
     visual.setTarget(position());
 
-  bool syncAtt = visual.updateAnimation(this,owner);
+  bool syncAtt = visual.updateAnimation(this,owner,animationLod());
   if(durtyTranform){
     updatePos();
     syncAtt = true;
@@ -686,6 +688,20 @@ void Npc::updateAnimation() {
     visual.syncAttaches();
   }
 
+Pose::Lod Npc::animationLod() const {
+  if(isPlayer())
+    return Pose::LodFull;
+  if(!visual.isVisible(SceneGlobals::V_Main) &&
+     !visual.isVisible(SceneGlobals::V_Shadow0) &&
+     !visual.isVisible(SceneGlobals::V_Shadow1))
+    return Pose::LodFrozen;
+  if(aiPolicy==ProcessPolicy::AiFar2)
+    return Pose::LodFar;
+  if(aiPolicy==ProcessPolicy::AiFar || !visual.isVisible(SceneGlobals::V_Main))
+    return Pose::LodReduced;
+  return Pose::LodFull;
+  }
+
 void Npc::updateTransform() {
   if(durtyTranform){
     updatePos();
@@ -1680,10 +1696,15 @@ Npc* Npc::updateNearestBody() {
   return ret;
   }
 
+void Npc::tickAnimation() {
+  // NOTE: executed in parallel for all npc's - only own pose can be touched here
+  visual.pose().processEvents(lastEventTime,owner.tickCount(),animEvents);
+  visual.processLayers(owner);
+  }
+
 void Npc::tick(uint64_t dt) {
   Animation::EvCount ev;
-  visual.pose().processEvents(lastEventTime,owner.tickCount(),ev);
-  visual.processLayers(owner);
+  std::swap(ev,animEvents);
   visual.setNpcEffect(owner,*this,hnpc.effect,hnpc.flags);
 
   if(ev.groundSounds>0 && isPlayer())
@@ -1743,6 +1764,13 @@ void Npc::tick(uint64_t dt) {
   implAiTick(dt);
   }
 
+WayMatrix::PathRequest* Npc::pendingWay() {
+  // solved path is kept, until AI_GoToPoint picks it up or asks for another one
+  if(wayRequest.end==nullptr || wayRequest.done)
+    return nullptr;
+  return &wayRequest;
+  }
+
 void Npc::nextAiAction(uint64_t dt) {
   if(aiQueue.size()==0)
     return;
@@ -1789,7 +1817,21 @@ void Npc::nextAiAction(uint64_t dt) {
         break;
         }
       if(wayPath.last()!=act.point) {
-        wayPath     = owner.wayTo(*this,*act.point);
+        // solved path is stale, if npc was moved to another waypoint, before it was picked up
+        if(wayRequest.end!=act.point || (wayRequest.done && wayRequest.begin!=owner.wayBegin(*this))) {
+          wayRequest       = WayMatrix::PathRequest();
+          wayRequest.begin = owner.wayBegin(*this);
+          wayRequest.end   = act.point;
+          // nowhere to go from here - no path to solve
+          wayRequest.done  = (wayRequest.begin==nullptr);
+          }
+        if(!wayRequest.done) {
+          // wait for batch solver, see WorldObjects::tick
+          aiQueue.pushFront(std::move(act));
+          break;
+          }
+        wayPath     = std::move(wayRequest.path);
+        wayRequest  = WayMatrix::PathRequest();
         auto wpoint = wayPath.pop();
 
         if(wpoint!=nullptr) {
@@ -3399,10 +3441,27 @@ bool Npc::canSeeNpc(float tx, float ty, float tz, bool freeLos) const {
 
 SensesBit Npc::canSenseNpc(const Npc &oth, bool freeLos, float extRange) const {
   const bool isNoisy = (oth.bodyState()&BodyState::BS_SNEAK)==0;
-  return canSenseNpc(oth.x,oth.y+180,oth.z,freeLos,isNoisy,extRange);
+  return implCanSense(oth.x,oth.y+180,oth.z,&oth,freeLos,isNoisy,extRange);
   }
 
 SensesBit Npc::canSenseNpc(float tx, float ty, float tz, bool freeLos, bool isNoisy, float extRange) const {
+  return implCanSense(tx,ty,tz,nullptr,freeLos,isNoisy,extRange);
+  }
+
+void Npc::setRooms(const Tempest::Vec3& pos, uint32_t feet, uint32_t eye) {
+  roomCacheKey = pos;
+  roomFeet     = feet;
+  roomEye      = eye;
+  }
+
+uint32_t Npc::roomAt(bool eye) const {
+  // npc moved since rooms were resolved (or they never were)
+  if(roomCacheKey.x!=x || roomCacheKey.y!=y || roomCacheKey.z!=z)
+    return owner.roomAt({x,eye ? y+180 : y,z});
+  return eye ? roomEye : roomFeet;
+  }
+
+SensesBit Npc::implCanSense(float tx, float ty, float tz, const Npc* oth, bool freeLos, bool isNoisy, float extRange) const {
   DynamicWorld* w = owner.physic();
   static const double ref = std::cos(100*M_PI/180.0); // spec requires +-100 view angle range
 
@@ -3410,23 +3469,31 @@ SensesBit Npc::canSenseNpc(float tx, float ty, float tz, bool freeLos, bool isNo
   if(qDistTo(tx,ty,tz)>range*range)
     return SensesBit::SENSE_NONE;
 
-  SensesBit ret=SensesBit::SENSE_NONE;
-  if(owner.roomAt({tx,ty,tz})==owner.roomAt({x,y,z})) {
+  SensesBit      ret   = SensesBit::SENSE_NONE;
+  const uint32_t tRoom = oth!=nullptr ? oth->roomAt(true) : owner.roomAt({tx,ty,tz});
+  if(tRoom==roomAt(false)) {
     ret = ret | SensesBit::SENSE_SMELL;
     if(isNoisy)
       ret = ret | SensesBit::SENSE_HEAR;
     }
 
+  // npc-to-npc visibility goes through short-living cache of world
+  auto los = [&]() {
+    if(oth!=nullptr)
+      return owner.lineOfSight(*this,*oth);
+    return !w->ray(x,y+180,z, tx,ty,tz).hasCol;
+    };
+
   if(!freeLos){
     float dx  = x-tx, dz=z-tz;
     float dir = angleDir(dx,dz);
     float da  = float(M_PI)*(visual.viewDirection()-dir)/180.f;
     if(double(std::cos(da))<=ref)
-      if(!w->ray(x,y+180,z, tx,ty,tz).hasCol)
+      if(los())
         ret = ret | SensesBit::SENSE_SEE;
     } else {
     // TODO: npc eyesight height
-    if(!w->ray(x,y+180,z, tx,ty,tz).hasCol)
+    if(los())
       ret = ret | SensesBit::SENSE_SEE;
     }
   return ret & SensesBit(hnpc.senses);
@@ -14,6 +14,7 @@
 #include "world/aiqueue.h"
 #include "world/fplock.h"
 #include "world/waypath.h"
+#include "world/waymatrix.h"
 
 #include <cstdint>
 #include <string>
@@ -213,6 +214,7 @@ class Npc final {
     bool       isPlayer() const;
     void       setWalkMode(WalkBit m);
     auto       walkMode() const { return wlkMode; }
+    void       tickAnimation();
     void       tick(uint64_t dt);
     bool       startClimb(JumpStatus jump);
 
@@ -386,6 +388,8 @@ class Npc final {
 
     void      addRoutine(gtime s, gtime e, uint32_t callback, const WayPoint* point);
     void      excRoutine(size_t callback);
+    size_t    routineCount() const { return routines.size(); }
+    auto      routinePoint(size_t i) const -> const WayPoint* { return routines[i].point; }
     void      multSpeed(float s);
 
     bool      testMove    (const Tempest::Vec3& pos);
@@ -400,7 +404,8 @@ class Npc final {
 
     auto      dialogChoises(Npc &player, const std::vector<uint32_t> &except, bool includeImp) -> std::vector<GameScript::DlgChoise>;
 
-    auto      handle() -> Daedalus::GEngineClasses::C_Npc* { return  &hnpc; }
+    auto      handle()       -> Daedalus::GEngineClasses::C_Npc*       { return  &hnpc; }
+    auto      handle() const -> const Daedalus::GEngineClasses::C_Npc* { return  &hnpc; }
 
     auto      inventory() const -> const Inventory& { return invent; }
     size_t    hasItem    (size_t id) const;
@@ -439,6 +444,8 @@ class Npc final {
 
     auto      currentWayPoint() const -> const WayPoint* { return currentFp; }
     void      attachToPoint(const WayPoint* p);
+    // path, requested by AI_GoToPoint; solved in batch after all npc ticks
+    auto      pendingWay() -> WayMatrix::PathRequest*;
     GoToHint  moveHint() const { return go2.flag; }
     void      clearGoTo();
 
@@ -446,6 +453,8 @@ class Npc final {
     bool      canSeeNpc(float x,float y,float z,bool freeLos) const;
     auto      canSenseNpc(const Npc& oth,bool freeLos, float extRange=0.f) const -> SensesBit;
     auto      canSenseNpc(float x,float y,float z,bool freeLos,bool isNoisy,float extRange=0.f) const -> SensesBit;
+    // rooms at feet and eye height; near npc's get them once per tick from batched World::roomAt
+    void      setRooms(const Tempest::Vec3& pos, uint32_t feet, uint32_t eye);
 
     void      setTarget(Npc* t);
     Npc*      target() const;
@@ -522,6 +531,7 @@ class Npc final {
     void      tickTimedEvt(Animation::EvCount &ev);
     void      tickRegen(int32_t& v,const int32_t max,const int32_t chg, const uint64_t dt);
     void      updatePos();
+    auto      animationLod() const -> Pose::Lod;
     void      setViewPosition(const Tempest::Vec3& pos);
     bool      tickCast();
 
@@ -534,6 +544,8 @@ class Npc final {
     bool      implLookAt (uint64_t dt);
     bool      implLookAt (const Npc& oth, uint64_t dt);
     bool      implLookAt (const Npc& oth, bool noAnim, uint64_t dt);
+    uint32_t  roomAt(bool eye) const;
+    auto      implCanSense(float x, float y, float z, const Npc* oth, bool freeLos, bool isNoisy, float extRange) const -> SensesBit;
     bool      implLookAt (float dx, float dz, bool noAnim, uint64_t dt);
     bool      implGoTo   (uint64_t dt);
     bool      implGoTo   (uint64_t dt, float destDist);
@@ -577,6 +589,10 @@ class Npc final {
     float                          runAng   = 0.f;
     float                          sz[3]={1.f,1.f,1.f};
 
+    // rooms (cache)
+    Tempest::Vec3                  roomCacheKey={std::numeric_limits<float>::infinity(),0.f,0.f};
+    uint32_t                       roomFeet=0, roomEye=0;
+
     // visual props (cache)
     uint8_t                        durtyTranform=0;
     Tempest::Vec3                  lastGroundNormal;
@@ -649,10 +665,12 @@ class Npc final {
     const WayPoint*                currentFp      =nullptr;
     FpLock                         currentFpLock;
     WayPath                        wayPath;
+    WayMatrix::PathRequest         wayRequest;
 
     MoveAlgo                       mvAlgo;
     FightAlgo                      fghAlgo;
     uint64_t                       lastEventTime=0;
+    Animation::EvCount             animEvents;
 
     Sound                          sfxWeapon;
 
@@ -102,8 +102,10 @@ void Sound::setRefDistance(float v) {
 void Sound::setPosition(float x, float y, float z) {
   if(pos.x==x && pos.y==y && pos.z==z)
     return;
-  if(val!=nullptr)
+  if(val!=nullptr) {
     val->eff.setPosition(x,y,z);
+    val->pos = {x,y,z};
+    }
   pos = {x,y,z};
   }
 
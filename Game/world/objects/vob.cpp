@@ -18,6 +18,7 @@
 #include "world/triggers/touchdamage.h"
 #include "world/worldlight.h"
 #include "world/world.h"
+#include "world/spaceindex.h"
 #include "game/serialize.h"
 
 using namespace Tempest;
@@ -42,10 +43,8 @@ Vob::Vob(Vob* parent, World& owner, ZenLoad::zCVobData& vob, bool startup)
 
   for(auto& i:vob.childVobs) {
     auto p = Vob::load(this,owner,std::move(i),startup);
-    if(p!=nullptr) {
-      childContent = ContentBit(p->childContent|childContent);
+    if(p!=nullptr)
       child.emplace_back(std::move(p));
-      }
     }
   vob.childVobs.clear();
   }
@@ -67,6 +66,7 @@ void Vob::setGlobalTransform(const Matrix4x4& p) {
     m.mul(local);
     local = m;
     }
+  updateSpaceIndex();
   }
 
 void Vob::setLocalTransform(const Matrix4x4& p) {
@@ -84,10 +84,6 @@ bool Vob::setMobState(const char* scheme, int32_t st) {
 void Vob::moveEvent() {
   }
 
-bool Vob::isDynamic() const {
-  return false;
-  }
-
 void Vob::recalculateTransform() {
   auto old = position();
   if(parent!=nullptr) {
@@ -96,10 +92,8 @@ void Vob::recalculateTransform() {
     } else {
     pos = local;
     }
-  if(old != position()) {
-    if(childContent!=cbNone)
-      world.invalidateVobIndex();
-    }
+  if(old != position())
+    updateSpaceIndex();
   moveEvent();
   for(auto& i:child) {
     i->recalculateTransform();
@@ -116,22 +110,16 @@ std::unique_ptr<Vob> Vob::load(Vob* parent, World& world, ZenLoad::zCVobData&& v
     case ZenLoad::zCVobData::VT_zCVobLevelCompo:
       return std::unique_ptr<Vob>(new Vob(parent,world,vob,startup));
     case ZenLoad::zCVobData::VT_oCMobFire:
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbMobsi);
       return std::unique_ptr<Vob>(new FirePlace(parent,world,vob,startup));
     case ZenLoad::zCVobData::VT_oCMOB:
       // Irdotar bow-triggers
       // focusOverride=true
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbMobsi);
       return std::unique_ptr<Vob>(new Interactive(parent,world,vob,startup));
     case ZenLoad::zCVobData::VT_oCMobBed:
     case ZenLoad::zCVobData::VT_oCMobDoor:
     case ZenLoad::zCVobData::VT_oCMobInter:
     case ZenLoad::zCVobData::VT_oCMobContainer:
     case ZenLoad::zCVobData::VT_oCMobSwitch:
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbMobsi);
       return std::unique_ptr<Vob>(new Interactive(parent,world,vob,startup));
     case ZenLoad::zCVobData::VT_oCMobLadder:
       //TODO: mob ladder
@@ -141,44 +129,24 @@ std::unique_ptr<Vob> Vob::load(Vob* parent, World& world, ZenLoad::zCVobData&& v
       return std::unique_ptr<Vob>(new StaticObj(parent,world,std::move(vob),startup));
 
     case ZenLoad::zCVobData::VT_zCMover:
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbTrigger);
       return std::unique_ptr<Vob>(new MoveTrigger(parent,world,std::move(vob),startup));
     case ZenLoad::zCVobData::VT_zCCodeMaster:
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbTrigger);
       return std::unique_ptr<Vob>(new CodeMaster(parent,world,std::move(vob),startup));
     case ZenLoad::zCVobData::VT_zCTriggerList:
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbTrigger);
       return std::unique_ptr<Vob>(new TriggerList(parent,world,std::move(vob),startup));
     case ZenLoad::zCVobData::VT_zCTriggerScript:
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbTrigger);
       return std::unique_ptr<Vob>(new TriggerScript(parent,world,std::move(vob),startup));
     case ZenLoad::zCVobData::VT_oCTriggerWorldStart:
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbTrigger);
       return std::unique_ptr<Vob>(new TriggerWorldStart(parent,world,std::move(vob),startup));
     case ZenLoad::zCVobData::VT_oCTriggerChangeLevel:
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbTrigger);
       return std::unique_ptr<Vob>(new ZoneTrigger(parent,world,std::move(vob),startup));
     case ZenLoad::zCVobData::VT_zCTrigger:
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbTrigger);
       return std::unique_ptr<Vob>(new Trigger(parent,world,std::move(vob),startup));
     case ZenLoad::zCVobData::VT_zCMessageFilter:
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbTrigger);
       return std::unique_ptr<Vob>(new MessageFilter(parent,world,std::move(vob),startup));
     case ZenLoad::zCVobData::VT_zCPFXControler:
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbTrigger);
       return std::unique_ptr<Vob>(new PfxController(parent,world,std::move(vob),startup));
     case ZenLoad::zCVobData::VT_oCTouchDamage:
-      if(parent!=nullptr)
-        parent->childContent = ContentBit(parent->childContent|cbTrigger);
       return std::unique_ptr<Vob>(new TouchDamage(parent,world,std::move(vob),startup));
 
     case ZenLoad::zCVobData::VT_zCVobStartpoint: {
@@ -245,5 +213,11 @@ void Vob::load(Serialize& fin) {
   fin.read(type,pos,local);
   if(vobType!=type)
     throw std::logic_error("inconsistent *.sav vs world");
+  updateSpaceIndex();
   moveEvent();
   }
+
+void Vob::updateSpaceIndex() {
+  if(spaceIndex!=nullptr)
+    spaceIndex->refit(this);
+  }
@@ -7,6 +7,7 @@
 
 class World;
 class Serialize;
+class BaseSpaceIndex;
 
 class Vob {
   public:
@@ -29,26 +30,24 @@ class Vob {
     void          setLocalTransform(const Tempest::Matrix4x4& p);
     virtual bool  setMobState(const char* scheme, int32_t st);
 
-    virtual bool  isDynamic() const;
-
   protected:
     World&                            world;
 
     virtual void  moveEvent();
 
   private:
-    enum ContentBit : uint8_t {
-      cbNone    = 0,
-      cbMobsi   = 1 << 0,
-      cbTrigger = 1 << 1,
-      };
     std::vector<std::unique_ptr<Vob>> child;
-    ContentBit                        childContent=cbNone;
 
     uint8_t                           vobType = 0;
     Tempest::Matrix4x4                pos, local;
     Vob*                              parent = nullptr;
 
+    BaseSpaceIndex*                   spaceIndex   = nullptr;
+    uint32_t                          spaceIndexId = uint32_t(-1);
+
     void          recalculateTransform();
+    void          updateSpaceIndex();
+
+  friend class BaseSpaceIndex;
   };
 
@@ -1,131 +1,436 @@
 #include "spaceindex.h"
 
+#include "graphics/dynamic/frustrum.h"
 #include "world/objects/vob.h"
 
-void BaseSpaceIndex::clear() {
-  arr.clear();
-  index.clear();
-  dynamic.clear();
+#include <cmath>
+
+using namespace Tempest;
+
+// leaf bounds are inflated, so small movements (dropped items settling down) doesn't restructure the tree
+static const float leafMargin = 50.f;
+
+static float area(const Vec3& bmin, const Vec3& bmax) {
+  const float dx = bmax.x-bmin.x;
+  const float dy = bmax.y-bmin.y;
+  const float dz = bmax.z-bmin.z;
+  return 2.f*(dx*dy + dy*dz + dz*dx);
+  }
+
+static float unionArea(const Vec3& amin, const Vec3& amax, const Vec3& bmin, const Vec3& bmax) {
+  return area(Vec3(std::min(amin.x,bmin.x),std::min(amin.y,bmin.y),std::min(amin.z,bmin.z)),
+              Vec3(std::max(amax.x,bmax.x),std::max(amax.y,bmax.y),std::max(amax.z,bmax.z)));
+  }
+
+static bool contains(const Vec3& bmin, const Vec3& bmax, const Vec3& p) {
+  return bmin.x<=p.x && p.x<=bmax.x &&
+         bmin.y<=p.y && p.y<=bmax.y &&
+         bmin.z<=p.z && p.z<=bmax.z;
+  }
+
+static bool overlaps(const Vec3& amin, const Vec3& amax, const Vec3& bmin, const Vec3& bmax) {
+  return amin.x<=bmax.x && bmin.x<=amax.x &&
+         amin.y<=bmax.y && bmin.y<=amax.y &&
+         amin.z<=bmax.z && bmin.z<=amax.z;
+  }
+
+static float qDistance(const Vec3& bmin, const Vec3& bmax, const Vec3& p) {
+  const float dx = std::max(0.f,std::max(bmin.x-p.x,p.x-bmax.x));
+  const float dy = std::max(0.f,std::max(bmin.y-p.y,p.y-bmax.y));
+  const float dz = std::max(0.f,std::max(bmin.z-p.z,p.z-bmax.z));
+  return dx*dx+dy*dy+dz*dz;
+  }
+
+BaseSpaceIndex::~BaseSpaceIndex() {
+  // objects can be destroyed ahead of the index (item array vs index, in WorldObjects): no access to them here
   }
 
-void BaseSpaceIndex::invalidate() {
-  index.clear();
-  dynamic.clear();
+void BaseSpaceIndex::clear() {
+  for(auto i:arr) {
+    i->spaceIndex   = nullptr;
+    i->spaceIndexId = uint32_t(-1);
+    }
+  arr.clear();
+  leafs.clear();
+  objects.clear();
+  nodes.clear();
+  root     = NullNode;
+  freeList = NullNode;
   }
 
 void BaseSpaceIndex::add(Vob* v) {
+  if(v->spaceIndex!=nullptr)
+    return;
+  uint32_t leaf = allocNode();
+  auto&    n    = nodes[leaf];
+  n.height = 0;
+  n.vob    = v;
+  setBounds(n,v->position());
+  insertLeaf(leaf);
+
+  v->spaceIndex   = this;
+  v->spaceIndexId = uint32_t(arr.size());
   arr.push_back(v);
-  index.reserve(arr.size());
-  index.clear();
-  dynamic.clear();
+  leafs.push_back(leaf);
+  objects.insert(v);
   }
 
 void BaseSpaceIndex::del(Vob* v) {
-  for(size_t i=0;i<arr.size();++i) {
-    if(arr[i]==v) {
-      arr[i] = arr.back();
-      arr.pop_back();
-      index.clear();
-      dynamic.clear();
-      return;
-      }
-    }
+  if(v==nullptr || v->spaceIndex!=this)
+    return;
+  const uint32_t id   = v->spaceIndexId;
+  const uint32_t leaf = leafs[id];
+  removeLeaf(leaf);
+  freeNode(leaf);
+
+  arr  [id] = arr.back();
+  leafs[id] = leafs.back();
+  arr[id]->spaceIndexId = id;
+  arr.pop_back();
+  leafs.pop_back();
+  objects.erase(v);
+
+  v->spaceIndex   = nullptr;
+  v->spaceIndexId = uint32_t(-1);
   }
 
 bool BaseSpaceIndex::hasObject(const Vob* v) const {
+  // NOTE: pointer can be dangling (focus of deleted item), so no dereference here
   if(v==nullptr)
     return false;
-  for(size_t i=0;i<arr.size();++i)
-    if(arr[i]==v)
-      return true;
-  return false;
-  }
-
-void BaseSpaceIndex::find(const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*)) {
-  if(index.size()==0)
-    buildIndex();
-  for(auto& i:dynamic)
-    (*func)(ctx,i);
-  implFind(index.data(),index.size(),0,p,R,ctx,func);
-  }
-
-void BaseSpaceIndex::buildIndex() {
-  size_t cnt = 0;
-  index.resize(arr.size());
-  dynamic.clear();
-  for(size_t i=0; i<arr.size(); ++i) {
-    if(arr[i]->isDynamic()) {
-      dynamic.push_back(arr[i]);
-      } else {
-      index[cnt] = arr[i];
-      ++cnt;
+  return objects.find(v)!=objects.end();
+  }
+
+void BaseSpaceIndex::refit(Vob* v) {
+  const uint32_t leaf = leafs[v->spaceIndexId];
+  const Vec3     p    = v->position();
+  if(contains(nodes[leaf].bmin,nodes[leaf].bmax,p))
+    return;
+  removeLeaf(leaf);
+  setBounds(nodes[leaf],p);
+  insertLeaf(leaf);
+  }
+
+void BaseSpaceIndex::find(const Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*)) {
+  implFind(root,p,R,ctx,func);
+  }
+
+void BaseSpaceIndex::find(const Vec3& bmin, const Vec3& bmax, const void* ctx, void (*func)(const void*, Vob*)) {
+  implFind(root,bmin,bmax,ctx,func);
+  }
+
+void BaseSpaceIndex::find(const Frustrum& f, const void* ctx, void (*func)(const void*, Vob*)) {
+  implFind(root,f,ctx,func);
+  }
+
+void BaseSpaceIndex::findNearest(const Vec3& p, size_t k, float R, const void* ctx, void (*func)(const void*, Vob*)) {
+  if(k==0)
+    return;
+  std::vector<Nearest> out;
+  out.reserve(k);
+  float qR = R*R;
+  implNearest(root,p,k,qR,out);
+  for(auto& i:out)
+    func(ctx,i.vob);
+  }
+
+uint32_t BaseSpaceIndex::allocNode() {
+  if(freeList!=NullNode) {
+    uint32_t id = freeList;
+    freeList = nodes[id].parent;
+    nodes[id] = Node();
+    return id;
+    }
+  nodes.emplace_back();
+  return uint32_t(nodes.size()-1);
+  }
+
+void BaseSpaceIndex::freeNode(uint32_t id) {
+  auto& n = nodes[id];
+  n.height = -1;
+  n.vob    = nullptr;
+  n.parent = freeList;
+  freeList = id;
+  }
+
+void BaseSpaceIndex::setBounds(Node& n, const Vec3& p) {
+  n.bmin = Vec3(p.x-leafMargin,p.y-leafMargin,p.z-leafMargin);
+  n.bmax = Vec3(p.x+leafMargin,p.y+leafMargin,p.z+leafMargin);
+  }
+
+void BaseSpaceIndex::setBounds(Node& n, const Node& a, const Node& b) {
+  n.bmin = Vec3(std::min(a.bmin.x,b.bmin.x),std::min(a.bmin.y,b.bmin.y),std::min(a.bmin.z,b.bmin.z));
+  n.bmax = Vec3(std::max(a.bmax.x,b.bmax.x),std::max(a.bmax.y,b.bmax.y),std::max(a.bmax.z,b.bmax.z));
+  }
+
+void BaseSpaceIndex::insertLeaf(uint32_t leaf) {
+  if(root==NullNode) {
+    root = leaf;
+    nodes[root].parent = NullNode;
+    return;
+    }
+
+  // find best sibling by surface-area heuristic
+  const Vec3 lmin = nodes[leaf].bmin;
+  const Vec3 lmax = nodes[leaf].bmax;
+  uint32_t   id   = root;
+  while(nodes[id].height>0) {
+    const Node& n   = nodes[id];
+    const float a   = area(n.bmin,n.bmax);
+    const float ua  = unionArea(n.bmin,n.bmax,lmin,lmax);
+    const float inh = 2.f*(ua-a);
+
+    float cost[2] = {};
+    uint32_t ch[2] = {n.left,n.right};
+    for(int i=0; i<2; ++i) {
+      const Node& c = nodes[ch[i]];
+      cost[i] = unionArea(c.bmin,c.bmax,lmin,lmax)+inh;
+      if(c.height>0)
+        cost[i] -= area(c.bmin,c.bmax);
       }
+
+    if(2.f*ua<cost[0] && 2.f*ua<cost[1])
+      break;
+    id = cost[0]<cost[1] ? ch[0] : ch[1];
     }
-  index.resize(cnt);
-  buildIndex(index.data(),index.size(),0);
+
+  const uint32_t sibling   = id;
+  const uint32_t oldParent = nodes[sibling].parent;
+  const uint32_t newParent = allocNode();
+
+  auto& p = nodes[newParent];
+  p.parent = oldParent;
+  p.left   = sibling;
+  p.right  = leaf;
+  p.height = nodes[sibling].height+1;
+  setBounds(p,nodes[sibling],nodes[leaf]);
+
+  if(oldParent!=NullNode) {
+    if(nodes[oldParent].left==sibling)
+      nodes[oldParent].left  = newParent; else
+      nodes[oldParent].right = newParent;
+    } else {
+    root = newParent;
+    }
+  nodes[sibling].parent = newParent;
+  nodes[leaf   ].parent = newParent;
+
+  fixUpwards(newParent);
   }
 
-void BaseSpaceIndex::buildIndex(Vob** v, size_t cnt, uint8_t depth) {
-  depth%=3;
-  sort(v,cnt,depth);
-  size_t mid = cnt/2;
-  if(mid>0) {
-    // [0..mid)
-    buildIndex(v,mid,uint8_t(depth+1u));
+void BaseSpaceIndex::removeLeaf(uint32_t leaf) {
+  if(leaf==root) {
+    root = NullNode;
+    return;
     }
-  if(mid+1<cnt) {
-    // (mid..cnt)
-    buildIndex(v+mid+1,cnt-mid-1,uint8_t(depth+1u));
+
+  const uint32_t parent  = nodes[leaf].parent;
+  const uint32_t grand   = nodes[parent].parent;
+  const uint32_t sibling = (nodes[parent].left==leaf ? nodes[parent].right : nodes[parent].left);
+
+  if(grand!=NullNode) {
+    if(nodes[grand].left==parent)
+      nodes[grand].left  = sibling; else
+      nodes[grand].right = sibling;
+    nodes[sibling].parent = grand;
+    freeNode(parent);
+    fixUpwards(grand);
+    } else {
+    root = sibling;
+    nodes[sibling].parent = NullNode;
+    freeNode(parent);
     }
+  nodes[leaf].parent = NullNode;
   }
 
-void BaseSpaceIndex::sort(Vob** v, size_t cnt, uint8_t component) {
-  bool (*predicate)(const Vob* a, const Vob* b) = nullptr;
-  switch(component) {
-    case 0:
-      predicate = [](const Vob* a, const Vob* b){ return a->position().x < b->position().x; };
-      break;
-    case 1:
-      predicate = [](const Vob* a, const Vob* b){ return a->position().y < b->position().y; };
-      break;
-    case 2:
-      predicate = [](const Vob* a, const Vob* b){ return a->position().z < b->position().z; };
-      break;
+void BaseSpaceIndex::fixUpwards(uint32_t id) {
+  while(id!=NullNode) {
+    id = balance(id);
+
+    auto&       n = nodes[id];
+    const Node& l = nodes[n.left];
+    const Node& r = nodes[n.right];
+    n.height = 1+std::max(l.height,r.height);
+    setBounds(n,l,r);
+
+    id = n.parent;
+    }
+  }
+
+uint32_t BaseSpaceIndex::balance(uint32_t iA) {
+  // AVL-like rotation, same as in Box2D dynamic tree
+  Node& a = nodes[iA];
+  if(a.height<2)
+    return iA;
+
+  const uint32_t iB = a.left;
+  const uint32_t iC = a.right;
+  Node& b = nodes[iB];
+  Node& c = nodes[iC];
+
+  const int32_t bal = c.height - b.height;
+  if(bal>1) {
+    // rotate C up
+    const uint32_t iF = c.left;
+    const uint32_t iG = c.right;
+    Node& f = nodes[iF];
+    Node& g = nodes[iG];
+
+    c.left   = iA;
+    c.parent = a.parent;
+    a.parent = iC;
+    if(c.parent!=NullNode) {
+      if(nodes[c.parent].left==iA)
+        nodes[c.parent].left  = iC; else
+        nodes[c.parent].right = iC;
+      } else {
+      root = iC;
+      }
+
+    if(f.height>g.height) {
+      c.right  = iF;
+      a.right  = iG;
+      g.parent = iA;
+      setBounds(a,b,g);
+      setBounds(c,a,f);
+      a.height = 1+std::max(b.height,g.height);
+      c.height = 1+std::max(a.height,f.height);
+      } else {
+      c.right  = iG;
+      a.right  = iF;
+      f.parent = iA;
+      setBounds(a,b,f);
+      setBounds(c,a,g);
+      a.height = 1+std::max(b.height,f.height);
+      c.height = 1+std::max(a.height,g.height);
+      }
+    return iC;
+    }
+
+  if(bal<-1) {
+    // rotate B up
+    const uint32_t iD = b.left;
+    const uint32_t iE = b.right;
+    Node& d = nodes[iD];
+    Node& e = nodes[iE];
+
+    b.left   = iA;
+    b.parent = a.parent;
+    a.parent = iB;
+    if(b.parent!=NullNode) {
+      if(nodes[b.parent].left==iA)
+        nodes[b.parent].left  = iB; else
+        nodes[b.parent].right = iB;
+      } else {
+      root = iB;
+      }
+
+    if(d.height>e.height) {
+      b.right  = iD;
+      a.left   = iE;
+      e.parent = iA;
+      setBounds(a,c,e);
+      setBounds(b,a,d);
+      a.height = 1+std::max(c.height,e.height);
+      b.height = 1+std::max(a.height,d.height);
+      } else {
+      b.right  = iE;
+      a.left   = iD;
+      d.parent = iA;
+      setBounds(a,c,d);
+      setBounds(b,a,e);
+      a.height = 1+std::max(c.height,d.height);
+      b.height = 1+std::max(a.height,e.height);
+      }
+    return iB;
+    }
+
+  return iA;
+  }
+
+void BaseSpaceIndex::implFind(uint32_t id, const Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*)) {
+  if(id==NullNode)
+    return;
+  const Node& n = nodes[id];
+  if(qDistance(n.bmin,n.bmax,p)>R*R)
+    return;
+  if(n.height==0) {
+    if((n.vob->position()-p).quadLength()<=R*R)
+      func(ctx,n.vob);
+    return;
+    }
+  implFind(n.left, p,R,ctx,func);
+  implFind(n.right,p,R,ctx,func);
+  }
+
+void BaseSpaceIndex::implFind(uint32_t id, const Vec3& bmin, const Vec3& bmax, const void* ctx, void (*func)(const void*, Vob*)) {
+  if(id==NullNode)
+    return;
+  const Node& n = nodes[id];
+  if(!overlaps(n.bmin,n.bmax,bmin,bmax))
+    return;
+  if(n.height==0) {
+    if(contains(bmin,bmax,n.vob->position()))
+      func(ctx,n.vob);
+    return;
     }
-  std::sort(v,v+cnt,predicate);
+  implFind(n.left, bmin,bmax,ctx,func);
+  implFind(n.right,bmin,bmax,ctx,func);
   }
 
-void BaseSpaceIndex::implFind(Vob** v, size_t cnt, uint8_t depth,
-                              const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*)) {
-  if(cnt==0)
+void BaseSpaceIndex::implFind(uint32_t id, const Frustrum& f, const void* ctx, void (*func)(const void*, Vob*)) {
+  if(id==NullNode)
+    return;
+  const Node& n = nodes[id];
+  if(n.height==0) {
+    auto p = n.vob->position();
+    if(f.testPoint(p.x,p.y,p.z))
+      func(ctx,n.vob);
     return;
+    }
+  const Vec3 mid = Vec3((n.bmin.x+n.bmax.x)*0.5f,(n.bmin.y+n.bmax.y)*0.5f,(n.bmin.z+n.bmax.z)*0.5f);
+  const float R   = std::sqrt((n.bmax-mid).quadLength());
+  if(!f.testPoint(mid,R))
+    return;
+  implFind(n.left, f,ctx,func);
+  implFind(n.right,f,ctx,func);
+  }
 
-  auto mid = cnt/2;
-  auto pos = v[mid]->position();
+void BaseSpaceIndex::implNearest(uint32_t id, const Vec3& p, size_t k, float& qR, std::vector<Nearest>& out) {
+  if(id==NullNode)
+    return;
+  const Node& n = nodes[id];
+  if(qDistance(n.bmin,n.bmax,p)>qR)
+    return;
 
-  if((pos-p).quadLength()<=R*R) {
-    func(ctx,v[mid]);
+  if(n.height==0) {
+    const float d = (n.vob->position()-p).quadLength();
+    if(d>qR)
+      return;
+    Nearest e;
+    e.qDist = d;
+    e.vob   = n.vob;
+    auto at = std::upper_bound(out.begin(),out.end(),e,[](const Nearest& l, const Nearest& r){
+      return l.qDist<r.qDist;
+      });
+    out.insert(at,e);
+    if(out.size()>k)
+      out.pop_back();
+    if(out.size()==k)
+      qR = out.back().qDist;
+    return;
     }
 
-  depth%=3;
-  switch(depth) {
-    case 0:
-      if(p.x-R<=pos.x)
-        implFind(v,mid,uint8_t(depth+1u),p,R, ctx,func);
-      if(p.x+R>=pos.x)
-        implFind(v+mid+1,cnt-mid-1,uint8_t(depth+1u),p,R, ctx,func);
-      break;
-    case 1:
-      if(p.y-R<=pos.y)
-        implFind(v,mid,uint8_t(depth+1u),p,R, ctx,func);
-      if(p.y+R>=pos.y)
-        implFind(v+mid+1,cnt-mid-1,uint8_t(depth+1u),p,R, ctx,func);
-      break;
-    case 2:
-      if(p.z-R<=pos.z)
-        implFind(v,mid,uint8_t(depth+1u),p,R, ctx,func);
-      if(p.z+R>=pos.z)
-        implFind(v+mid+1,cnt-mid-1,uint8_t(depth+1u),p,R, ctx,func);
-      break;
+  // visit closest child first, to shrink search radius faster
+  const Node& l  = nodes[n.left];
+  const Node& r  = nodes[n.right];
+  const float dl = qDistance(l.bmin,l.bmax,p);
+  const float dr = qDistance(r.bmin,r.bmax,p);
+  if(dl<=dr) {
+    implNearest(n.left, p,k,qR,out);
+    implNearest(n.right,p,k,qR,out);
+    } else {
+    implNearest(n.right,p,k,qR,out);
+    implNearest(n.left, p,k,qR,out);
     }
   }
@@ -5,17 +5,23 @@
 #include <algorithm>
 #include <array>
 #include <memory>
+#include <unordered_set>
 #include <Tempest/Point>
 
 #include "utils/workers.h"
 
 class Vob;
+class Frustrum;
 
+// Dynamic AABB tree over vob positions.
+// Vob keeps handle to own entry, so add/del/move are O(log n) and index is never rebuilt.
 class BaseSpaceIndex {
   public:
+    BaseSpaceIndex(const BaseSpaceIndex&) = delete;
+    ~BaseSpaceIndex();
+
     void   clear();
     size_t size() const { return arr.size(); }
-    void   invalidate();
 
   protected:
     BaseSpaceIndex() = default;
@@ -24,20 +30,58 @@ class BaseSpaceIndex {
     bool               hasObject(const Vob* v) const;
 
     void               find(const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*));
+    void               find(const Tempest::Vec3& bmin, const Tempest::Vec3& bmax, const void* ctx, void (*func)(const void*, Vob*));
+    void               find(const Frustrum& f, const void* ctx, void (*func)(const void*, Vob*));
+    void               findNearest(const Tempest::Vec3& p, size_t k, float R, const void* ctx, void (*func)(const void*, Vob*));
     template<class Func>
     void               parallelFor(Func f);
     Vob**              data() { return arr.data(); }
     Vob*const*         data() const { return arr.data(); }
 
   private:
-    std::vector<Vob*>  arr;
-    std::vector<Vob*>  index;
-    std::vector<Vob*>  dynamic;
-
-    void               buildIndex();
-    void               buildIndex(Vob** v, size_t cnt, uint8_t depth);
-    void               sort(Vob** v, size_t cnt, uint8_t component);
-    void               implFind(Vob** v, size_t cnt, uint8_t depth, const Tempest::Vec3& p, float R, const void* ctx, void(*func)(const void*, Vob*));
+    enum : uint32_t {
+      NullNode = uint32_t(-1),
+      };
+
+    struct Node {
+      Tempest::Vec3 bmin, bmax;
+      uint32_t      parent = NullNode;
+      uint32_t      left   = NullNode;
+      uint32_t      right  = NullNode;
+      int32_t       height = -1; // 0 - leaf, -1 - free node
+      Vob*          vob    = nullptr;
+      };
+
+    struct Nearest {
+      float qDist = 0;
+      Vob*  vob   = nullptr;
+      };
+
+    std::vector<Vob*>              arr;
+    std::vector<uint32_t>          leafs;    // arr index -> tree node
+    std::unordered_set<const Vob*> objects;
+
+    std::vector<Node>              nodes;
+    uint32_t                       root     = NullNode;
+    uint32_t                       freeList = NullNode;
+
+    void               refit(Vob* v);
+
+    uint32_t           allocNode();
+    void               freeNode(uint32_t id);
+    void               insertLeaf(uint32_t leaf);
+    void               removeLeaf(uint32_t leaf);
+    void               fixUpwards(uint32_t id);
+    uint32_t           balance(uint32_t id);
+    void               setBounds(Node& n, const Tempest::Vec3& p);
+    void               setBounds(Node& n, const Node& a, const Node& b);
+
+    void               implFind(uint32_t id, const Tempest::Vec3& p, float R, const void* ctx, void(*func)(const void*, Vob*));
+    void               implFind(uint32_t id, const Tempest::Vec3& bmin, const Tempest::Vec3& bmax, const void* ctx, void(*func)(const void*, Vob*));
+    void               implFind(uint32_t id, const Frustrum& f, const void* ctx, void(*func)(const void*, Vob*));
+    void               implNearest(uint32_t id, const Tempest::Vec3& p, size_t k, float& qR, std::vector<Nearest>& out);
+
+  friend class Vob;
   };
 
 template<class Func>
@@ -71,15 +115,35 @@ class SpaceIndex final : public BaseSpaceIndex {
 
     template<class Func>
     void find(const Tempest::Vec3& p, float R, const Func& f) {
-      return BaseSpaceIndex::find(p,R,&f,[](const void* ctx, Vob* v){
-        auto& f = *reinterpret_cast<const Func*>(ctx);
-        f(*reinterpret_cast<T*>(v));
-        });
+      return BaseSpaceIndex::find(p,R,&f,&invoke<Func>);
+      }
+
+    template<class Func>
+    void find(const Tempest::Vec3& bmin, const Tempest::Vec3& bmax, const Func& f) {
+      return BaseSpaceIndex::find(bmin,bmax,&f,&invoke<Func>);
+      }
+
+    template<class Func>
+    void find(const Frustrum& fr, const Func& f) {
+      return BaseSpaceIndex::find(fr,&f,&invoke<Func>);
+      }
+
+    // up to k objects within radius R, from nearest to farthest
+    template<class Func>
+    void findNearest(const Tempest::Vec3& p, size_t k, float R, const Func& f) {
+      return BaseSpaceIndex::findNearest(p,k,R,&f,&invoke<Func>);
       }
 
     template<class F>
     void parallelFor(F func) {
       BaseSpaceIndex::parallelFor([&func](Vob* v){ func(*reinterpret_cast<T*>(v)); });
       }
+
+  private:
+    template<class Func>
+    static void invoke(const void* ctx, Vob* v) {
+      auto& f = *reinterpret_cast<const Func*>(ctx);
+      f(*reinterpret_cast<T*>(v));
+      }
   };
 
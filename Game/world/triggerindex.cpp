@@ -0,0 +1,96 @@
+#include "triggerindex.h"
+
+#include <algorithm>
+
+#include "world/triggers/abstracttrigger.h"
+
+using namespace Tempest;
+
+static float axis(const Vec3& v, int a) {
+  return a==0 ? v.x : (a==1 ? v.y : v.z);
+  }
+
+static bool contains(const Vec3& bmin, const Vec3& bmax, const Vec3& p) {
+  return bmin.x<=p.x && p.x<=bmax.x &&
+         bmin.y<=p.y && p.y<=bmax.y &&
+         bmin.z<=p.z && p.z<=bmax.z;
+  }
+
+void TriggerIndex::add(AbstractTrigger& t) {
+  Item it;
+  it.trigger = &t;
+  items.push_back(it);
+  dirty = true;
+  }
+
+void TriggerIndex::rebuild() {
+  dirty = false;
+  nodes.clear();
+  for(auto& i:items)
+    i.trigger->volume(i.bmin,i.bmax);
+  if(items.size()>0)
+    build(0,uint32_t(items.size()));
+  }
+
+uint32_t TriggerIndex::build(uint32_t begin, uint32_t end) {
+  const uint32_t id = uint32_t(nodes.size());
+  nodes.emplace_back();
+
+  Vec3 bmin = items[begin].bmin, bmax = items[begin].bmax;
+  Vec3 cmin = (bmin+bmax)*0.5f,  cmax = cmin;
+  for(uint32_t i=begin+1; i<end; ++i) {
+    auto&      it = items[i];
+    const Vec3 c  = (it.bmin+it.bmax)*0.5f;
+    bmin = Vec3(std::min(bmin.x,it.bmin.x),std::min(bmin.y,it.bmin.y),std::min(bmin.z,it.bmin.z));
+    bmax = Vec3(std::max(bmax.x,it.bmax.x),std::max(bmax.y,it.bmax.y),std::max(bmax.z,it.bmax.z));
+    cmin = Vec3(std::min(cmin.x,c.x),std::min(cmin.y,c.y),std::min(cmin.z,c.z));
+    cmax = Vec3(std::max(cmax.x,c.x),std::max(cmax.y,c.y),std::max(cmax.z,c.z));
+    }
+  nodes[id].bmin = bmin;
+  nodes[id].bmax = bmax;
+
+  if(end-begin<=LeafSize) {
+    nodes[id].first = begin;
+    nodes[id].count = end-begin;
+    return id;
+    }
+
+  // median split of centers, along the longest axis
+  const Vec3 ext = cmax-cmin;
+  const int  a   = (ext.x>=ext.y && ext.x>=ext.z) ? 0 : (ext.y>=ext.z ? 1 : 2);
+  const auto mid = begin+(end-begin)/2;
+  std::nth_element(items.begin()+begin,items.begin()+mid,items.begin()+end,[a](const Item& l, const Item& r){
+    return axis(l.bmin,a)+axis(l.bmax,a) < axis(r.bmin,a)+axis(r.bmax,a);
+    });
+
+  build(begin,mid);
+  const uint32_t right = build(mid,end);
+  nodes[id].right = right;
+  return id;
+  }
+
+void TriggerIndex::implFind(const Vec3& p, const void* ctx, void (*func)(const void*, AbstractTrigger&)) {
+  if(dirty)
+    rebuild();
+  if(nodes.empty())
+    return;
+
+  stack.clear();
+  stack.push_back(0);
+  while(!stack.empty()) {
+    const uint32_t id = stack.back();
+    stack.pop_back();
+
+    auto& n = nodes[id];
+    if(!contains(n.bmin,n.bmax,p))
+      continue;
+    if(n.count>0) {
+      for(uint32_t i=n.first; i<n.first+n.count; ++i)
+        if(contains(items[i].bmin,items[i].bmax,p))
+          func(ctx,*items[i].trigger);
+      continue;
+      }
+    stack.push_back(n.right);
+    stack.push_back(id+1);
+    }
+  }
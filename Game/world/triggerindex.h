@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Tempest/Point>
+
+#include <vector>
+#include <cstdint>
+
+class AbstractTrigger;
+
+// Bounding volume hierarchy over zone-trigger volumes. Zone triggers practically never move,
+// so tree is not updated incrementally: it is rebuilt on next query, after any of volumes has changed.
+class TriggerIndex final {
+  public:
+    TriggerIndex() = default;
+    TriggerIndex(const TriggerIndex&) = delete;
+
+    void   add(AbstractTrigger& t);
+    void   invalidate() { dirty = true; }
+    size_t size() const { return items.size(); }
+
+    // calls f for every trigger, which bbox contains the point; exact test is up to caller
+    template<class F>
+    void find(const Tempest::Vec3& p, const F& f) {
+      implFind(p,&f,[](const void* ctx, AbstractTrigger& t){
+        (*reinterpret_cast<const F*>(ctx))(t);
+        });
+      }
+
+  private:
+    enum : uint32_t {
+      LeafSize = 4,
+      };
+
+    struct Item {
+      Tempest::Vec3    bmin, bmax;
+      AbstractTrigger* trigger = nullptr;
+      };
+
+    // nodes are stored depth-first: left child is next to parent
+    struct Node {
+      Tempest::Vec3    bmin, bmax;
+      uint32_t         first = 0;
+      uint32_t         count = 0; // leaf, if non-zero
+      uint32_t         right = 0;
+      };
+
+    std::vector<Item>     items;
+    std::vector<Node>     nodes;
+    std::vector<uint32_t> stack;
+    bool                  dirty = false;
+
+    void     rebuild();
+    uint32_t build(uint32_t begin, uint32_t end);
+
+    void     implFind(const Tempest::Vec3& p, const void* ctx, void (*func)(const void*, AbstractTrigger&));
+  };
@@ -17,6 +17,7 @@ AbstractTrigger::AbstractTrigger(Vob* parent, World &world, ZenLoad::zCVobData &
   bboxOrigin = bboxOrigin - position();
 
   box        = world.physic()->bboxObj(&callback,data.bbox);
+  tag        = world.internName(this->data.vobName);
   world.addTrigger(this);
   }
 
@@ -91,6 +92,8 @@ void AbstractTrigger::onUntrigger(const TriggerEvent&) {
   }
 
 void AbstractTrigger::moveEvent() {
+  if(hasVolume())
+    world.triggerMoved(*this);
   }
 
 bool AbstractTrigger::hasFlag(ReactFlg flg) const {
@@ -153,6 +156,12 @@ bool AbstractTrigger::checkPos(float x,float y,float z) const {
   return false;
   }
 
+void AbstractTrigger::volume(Vec3& bmin, Vec3& bmax) const {
+  auto c = position() + bboxOrigin;
+  bmin = c - bboxSize;
+  bmax = c + bboxSize;
+  }
+
 void AbstractTrigger::save(Serialize& fout) const {
   Vob::save(fout);
   fout.write(uint32_t(intersect.size()));
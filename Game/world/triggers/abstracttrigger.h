@@ -43,6 +43,8 @@ class AbstractTrigger : public Vob {
 
     ZenLoad::zCVobData::EVobType vobType() const;
     const std::string&           name() const;
+    // interned name: triggers with same name(ignoring case) have same tag
+    const char*                  nameTag() const { return tag; }
     bool                         isEnabled() const;
 
     void                         processOnStart(const TriggerEvent& evt);
@@ -52,6 +54,7 @@ class AbstractTrigger : public Vob {
 
     virtual bool                 hasVolume() const;
     virtual bool                 checkPos(float x,float y,float z) const;
+    void                         volume(Tempest::Vec3& bmin, Tempest::Vec3& bmax) const;
 
     void                         save(Serialize& fout) const override;
     void                         load(Serialize &fin) override;
@@ -87,6 +90,7 @@ class AbstractTrigger : public Vob {
 
   private:
     Cb                           callback;
+    const char*                  tag = nullptr;
     DynamicWorld::BBoxBody*      box = nullptr;
     Tempest::Vec3                bboxSize, bboxOrigin;
 
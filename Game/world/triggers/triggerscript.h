@@ -9,4 +9,7 @@ class TriggerScript : public AbstractTrigger {
     TriggerScript(Vob* parent, World& world, ZenLoad::zCVobData&& data, bool startup);
 
     void onTrigger(const TriggerEvent& evt) override;
+
+  private:
+    size_t scriptFn = size_t(-1);
   };
@@ -0,0 +1,370 @@
+#include "waygraph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "utils/workers.h"
+#include "waypoint.h"
+
+using namespace Tempest;
+
+static constexpr float Infinity = std::numeric_limits<float>::infinity();
+
+// per-thread search state; nodes are considered visited only when stamp matches current generation
+struct WayGraph::Search {
+  struct Entry {
+    float    f    = 0;
+    float    g    = 0;
+    uint32_t node = 0;
+    bool operator < (const Entry& other) const { return f>other.f; }
+    };
+
+  std::vector<float>    g;
+  std::vector<uint32_t> parent;
+  std::vector<uint32_t> stamp;
+  std::vector<Entry>    heap;
+  uint32_t              gen = 0;
+
+  void reset(size_t n) {
+    if(stamp.size()<n) {
+      g     .resize(n);
+      parent.resize(n);
+      stamp .resize(n,0);
+      }
+    gen++;
+    if(gen==0) {
+      std::fill(stamp.begin(),stamp.end(),0);
+      gen = 1;
+      }
+    heap.clear();
+    }
+
+  bool visited(uint32_t i) const { return stamp[i]==gen; }
+  float dist(uint32_t i) const { return stamp[i]==gen ? g[i] : Infinity; }
+
+  bool relax(uint32_t i, float d, uint32_t p) {
+    if(stamp[i]==gen && g[i]<=d)
+      return false;
+    stamp [i] = gen;
+    g     [i] = d;
+    parent[i] = p;
+    return true;
+    }
+
+  void push(uint32_t i, float d, float f) {
+    heap.push_back(Entry{f,d,i});
+    std::push_heap(heap.begin(),heap.end());
+    }
+
+  Entry pop() {
+    std::pop_heap(heap.begin(),heap.end());
+    auto e = heap.back();
+    heap.pop_back();
+    return e;
+    }
+  };
+
+void WayGraph::build(const std::vector<WayPoint>& points) {
+  const size_t n = points.size();
+  pos.resize(n);
+  arcBegin.assign(n+1,0);
+  arcs.clear();
+
+  for(size_t i=0; i<n; ++i) {
+    pos[i] = points[i].position();
+    for(auto& c:points[i].connections()) {
+      Arc a;
+      a.to  = uint32_t(std::distance(points.data(),static_cast<const WayPoint*>(c.point)));
+      if(a.to>=n)
+        continue;
+      a.len = (pos[i]-c.point->position()).length();
+      arcs.push_back(a);
+      }
+    arcBegin[i+1] = uint32_t(arcs.size());
+    }
+
+  buildComponents();
+  buildClusters();
+  buildAbstract();
+  clearCache();
+  }
+
+void WayGraph::buildComponents() {
+  component.assign(pos.size(),NoNode);
+
+  std::vector<uint32_t> stk;
+  uint32_t              id = 0;
+  for(uint32_t i=0; i<pos.size(); ++i) {
+    if(component[i]!=NoNode)
+      continue;
+    component[i] = id;
+    stk.push_back(i);
+    while(!stk.empty()) {
+      auto u = stk.back();
+      stk.pop_back();
+      for(uint32_t r=arcBegin[u]; r<arcBegin[u+1]; ++r) {
+        auto v = arcs[r].to;
+        if(component[v]!=NoNode)
+          continue;
+        component[v] = id;
+        stk.push_back(v);
+        }
+      }
+    ++id;
+    }
+  }
+
+void WayGraph::buildClusters() {
+  std::unordered_map<uint64_t,uint32_t> cells;
+  clusters.clear();
+  cluster.resize(pos.size());
+
+  for(size_t i=0; i<pos.size(); ++i) {
+    auto     cx  = int32_t(std::floor(pos[i].x/float(ClusterSize)));
+    auto     cz  = int32_t(std::floor(pos[i].z/float(ClusterSize)));
+    uint64_t key = (uint64_t(uint32_t(cx))<<32) | uint64_t(uint32_t(cz));
+    auto     it  = cells.find(key);
+    if(it==cells.end()) {
+      it = cells.emplace(key,uint32_t(clusters.size())).first;
+      clusters.emplace_back();
+      }
+    cluster[i] = it->second;
+    }
+
+  portals.clear();
+  portalId.assign(pos.size(),NoNode);
+  for(uint32_t i=0; i<pos.size(); ++i) {
+    for(uint32_t r=arcBegin[i]; r<arcBegin[i+1]; ++r) {
+      if(cluster[arcs[r].to]==cluster[i])
+        continue;
+      portalId[i] = uint32_t(portals.size());
+      portals.push_back(i);
+      clusters[cluster[i]].portals.push_back(i);
+      break;
+      }
+    }
+  }
+
+void WayGraph::buildAbstract() {
+  std::vector<std::vector<Arc>> adj(portals.size());
+
+  Workers::parallelFor(clusters,[this,&adj](Cluster& c) {
+    const uint32_t cl  = uint32_t(std::distance(clusters.data(),&c));
+    const size_t   cnt = c.portals.size();
+    auto&          s   = scratch(0);
+
+    std::vector<float> dist(cnt*cnt);
+    for(size_t i=0; i<cnt; ++i) {
+      search(s,c.portals[i],NoNode,cl);
+      for(size_t r=0; r<cnt; ++r)
+        dist[i*cnt+r] = s.dist(c.portals[r]);
+      }
+
+    for(size_t i=0; i<cnt; ++i) {
+      const uint32_t p   = c.portals[i];
+      auto&          out = adj[portalId[p]];
+      for(uint32_t r=arcBegin[p]; r<arcBegin[p+1]; ++r) {
+        auto& a = arcs[r];
+        if(cluster[a.to]!=cl)
+          out.push_back(Arc{portalId[a.to],a.len});
+        }
+
+      // skip paths, that go through another portal anyway
+      for(size_t r=0; r<cnt; ++r) {
+        const float d = dist[i*cnt+r];
+        if(r==i || d==Infinity)
+          continue;
+        bool redundant = false;
+        for(size_t k=0; k<cnt && !redundant; ++k)
+          redundant = (k!=i && k!=r && dist[i*cnt+k]+dist[k*cnt+r]<=d*1.0001f);
+        if(!redundant)
+          out.push_back(Arc{portalId[c.portals[r]],d});
+        }
+      }
+    });
+
+  absBegin.assign(portals.size()+1,0);
+  absArcs.clear();
+  for(size_t i=0; i<adj.size(); ++i) {
+    absArcs.insert(absArcs.end(),adj[i].begin(),adj[i].end());
+    absBegin[i+1] = uint32_t(absArcs.size());
+    }
+  }
+
+bool WayGraph::findPath(uint32_t begin, uint32_t end, std::vector<uint32_t>& out) const {
+  if(begin>=pos.size() || end>=pos.size() || component[begin]!=component[end]) {
+    out.clear();
+    return false;
+    }
+
+  const uint64_t key = (uint64_t(begin)<<32) | uint64_t(end);
+  {
+    std::lock_guard<std::mutex> guard(cache.sync);
+    auto it = cache.index.find(key);
+    if(it!=cache.index.end()) {
+      cache.lru.splice(cache.lru.begin(),cache.lru,it->second);
+      out = it->second->second;
+      return true;
+      }
+  }
+
+  if(!solve(begin,end,Hierarchical,out))
+    return false;
+
+  std::lock_guard<std::mutex> guard(cache.sync);
+  if(cache.index.find(key)!=cache.index.end())
+    return true;
+  cache.lru.emplace_front(key,out);
+  cache.index[key] = cache.lru.begin();
+  if(cache.lru.size()>CacheSize) {
+    cache.index.erase(cache.lru.back().first);
+    cache.lru.pop_back();
+    }
+  return true;
+  }
+
+bool WayGraph::solve(uint32_t begin, uint32_t end, Strategy st, std::vector<uint32_t>& out) const {
+  out.clear();
+  if(begin>=pos.size() || end>=pos.size() || component[begin]!=component[end])
+    return false;
+  if(st==Flat || cluster[begin]==cluster[end])
+    return searchFlat(begin,end,NoCluster,out);
+  if(searchHierarchical(begin,end,out))
+    return true;
+  out.clear();
+  return searchFlat(begin,end,NoCluster,out);
+  }
+
+float WayGraph::pathLength(const std::vector<uint32_t>& path) const {
+  float len = 0;
+  for(size_t i=1; i<path.size(); ++i)
+    len += (pos[path[i]]-pos[path[i-1]]).length();
+  return len;
+  }
+
+void WayGraph::clearCache() {
+  std::lock_guard<std::mutex> guard(cache.sync);
+  cache.lru.clear();
+  cache.index.clear();
+  }
+
+void WayGraph::search(Search& s, uint32_t from, uint32_t to, uint32_t cl) const {
+  auto h = [this,to](uint32_t i) {
+    return to==NoNode ? 0.f : (pos[i]-pos[to]).length();
+    };
+
+  s.reset(pos.size());
+  s.relax(from,0,NoNode);
+  s.push(from,0,h(from));
+  while(!s.heap.empty()) {
+    auto e = s.pop();
+    auto u = e.node;
+    if(u==to)
+      return;
+    if(e.g>s.g[u])
+      continue;
+    for(uint32_t r=arcBegin[u]; r<arcBegin[u+1]; ++r) {
+      auto& a = arcs[r];
+      if(cl!=NoCluster && cluster[a.to]!=cl)
+        continue;
+      float d = e.g+a.len;
+      if(s.relax(a.to,d,u))
+        s.push(a.to,d,d+h(a.to));
+      }
+    }
+  }
+
+bool WayGraph::searchFlat(uint32_t begin, uint32_t end, uint32_t cl, std::vector<uint32_t>& out) const {
+  auto& s = scratch(0);
+  search(s,begin,end,cl);
+  if(!s.visited(end))
+    return false;
+  // appends path from end to begin; shared node with previous segment is not duplicated
+  uint32_t i = end;
+  if(!out.empty() && out.back()==end)
+    i = s.parent[end];
+  for(; i!=NoNode; i=s.parent[i])
+    out.push_back(i);
+  return true;
+  }
+
+bool WayGraph::searchHierarchical(uint32_t begin, uint32_t end, std::vector<uint32_t>& out) const {
+  const uint32_t clBegin = cluster[begin];
+  const uint32_t clEnd   = cluster[end];
+  auto&          cb      = clusters[clBegin];
+  auto&          ce      = clusters[clEnd];
+
+  std::vector<float> ds, dt;
+  portalDistances(begin,ds);
+  portalDistances(end,  dt);
+
+  auto h = [this,end](uint32_t p) {
+    return (pos[portals[p]]-pos[end]).length();
+    };
+
+  // abstract search over portals; extra node 'goal' stands for end-waypoint
+  auto&          s    = scratch(1);
+  const uint32_t goal = uint32_t(portals.size());
+  s.reset(portals.size()+1);
+  for(size_t i=0; i<cb.portals.size(); ++i) {
+    auto p = portalId[cb.portals[i]];
+    if(ds[i]<Infinity && s.relax(p,ds[i],NoNode))
+      s.push(p,ds[i],ds[i]+h(p));
+    }
+
+  while(!s.heap.empty()) {
+    auto e = s.pop();
+    auto u = e.node;
+    if(u==goal)
+      break;
+    if(e.g>s.g[u])
+      continue;
+    if(cluster[portals[u]]==clEnd) {
+      size_t i = size_t(std::distance(ce.portals.begin(),std::find(ce.portals.begin(),ce.portals.end(),portals[u])));
+      float  d = e.g+dt[i];
+      if(dt[i]<Infinity && s.relax(goal,d,u))
+        s.push(goal,d,d);
+      }
+    for(uint32_t r=absBegin[u]; r<absBegin[u+1]; ++r) {
+      auto& a = absArcs[r];
+      float d = e.g+a.len;
+      if(s.relax(a.to,d,u))
+        s.push(a.to,d,d+h(a.to));
+      }
+    }
+
+  if(!s.visited(goal))
+    return false;
+
+  std::vector<uint32_t> chain;
+  for(uint32_t i=s.parent[goal]; i!=NoNode; i=s.parent[i])
+    chain.push_back(portals[i]);
+
+  // refine abstract path back to way-points, from end to begin
+  if(!searchFlat(chain[0],end,clEnd,out))
+    return false;
+  for(size_t i=1; i<chain.size(); ++i) {
+    const uint32_t p    = chain[i];
+    const uint32_t prev = chain[i-1];
+    if(cluster[p]!=cluster[prev])
+      out.push_back(p); // edge between clusters
+    else if(!searchFlat(p,prev,cluster[p],out))
+      return false;
+    }
+  return searchFlat(begin,chain.back(),clBegin,out);
+  }
+
+void WayGraph::portalDistances(uint32_t from, std::vector<float>& dist) const {
+  auto& c = clusters[cluster[from]];
+  auto& s = scratch(0);
+  search(s,from,NoNode,cluster[from]);
+  dist.resize(c.portals.size());
+  for(size_t i=0; i<c.portals.size(); ++i)
+    dist[i] = s.dist(c.portals[i]);
+  }
+
+WayGraph::Search& WayGraph::scratch(size_t id) {
+  static thread_local Search s[2];
+  return s[id];
+  }
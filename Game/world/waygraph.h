@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Tempest/Vec>
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+class WayPoint;
+
+// Search graph of waynet. Waypoints are grouped into clusters by grid cell; nodes with edges to other clusters
+// are portals. Portal-to-portal distances inside of cluster are precomputed, so long paths are searched over
+// small abstract graph of portals and refined back to waypoints cluster by cluster.
+// Searches keep their state in thread-local storage: findPath can be called from worker threads.
+class WayGraph final {
+  public:
+    WayGraph() = default;
+    WayGraph(const WayGraph&) = delete;
+
+    enum Strategy : uint8_t {
+      Flat,
+      Hierarchical,
+      };
+
+    void     build(const std::vector<WayPoint>& points);
+    size_t   clusterCount() const { return clusters.size(); }
+    size_t   portalCount()  const { return portals.size();  }
+
+    // path as way-point id's from end to begin; result is cached
+    bool     findPath(uint32_t begin, uint32_t end, std::vector<uint32_t>& out) const;
+    // same as findPath, but bypasses the cache
+    bool     solve(uint32_t begin, uint32_t end, Strategy s, std::vector<uint32_t>& out) const;
+    float    pathLength(const std::vector<uint32_t>& path) const;
+    void     clearCache();
+
+  private:
+    enum : uint32_t {
+      NoNode       = uint32_t(-1),
+      NoCluster    = uint32_t(-1),
+      ClusterSize  = 8000,
+      CacheSize    = 512,
+      };
+
+    struct Arc {
+      uint32_t to  = 0;
+      float    len = 0;
+      };
+
+    struct Cluster {
+      std::vector<uint32_t> portals;
+      };
+
+    struct Search;
+    struct Cache {
+      using Entry = std::pair<uint64_t,std::vector<uint32_t>>;
+      std::mutex                                                sync;
+      std::list<Entry>                                          lru;
+      std::unordered_map<uint64_t,std::list<Entry>::iterator>   index;
+      };
+
+    std::vector<Tempest::Vec3> pos;
+    std::vector<uint32_t>      arcBegin;
+    std::vector<Arc>           arcs;
+    std::vector<uint32_t>      component;
+    std::vector<uint32_t>      cluster;
+    std::vector<Cluster>       clusters;
+
+    // abstract graph: arcs are either edges between clusters, or shortest paths inside of one cluster
+    std::vector<uint32_t>      portals;
+    std::vector<uint32_t>      portalId;
+    std::vector<uint32_t>      absBegin;
+    std::vector<Arc>           absArcs;
+
+    mutable Cache              cache;
+
+    void     buildComponents();
+    void     buildClusters();
+    void     buildAbstract();
+
+    void     search(Search& s, uint32_t from, uint32_t to, uint32_t cl) const;
+    bool     searchFlat(uint32_t begin, uint32_t end, uint32_t cl, std::vector<uint32_t>& out) const;
+    bool     searchHierarchical(uint32_t begin, uint32_t end, std::vector<uint32_t>& out) const;
+    void     portalDistances(uint32_t from, std::vector<float>& dist) const;
+
+    static Search& scratch(size_t id);
+  };
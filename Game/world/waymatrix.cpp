@@ -2,11 +2,13 @@
 
 #include <Tempest/Log>
 #include <algorithm>
-#include <limits>
+#include <chrono>
+#include <cmath>
 
 #include "game/movealgo.h"
 #include "utils/gthfont.h"
 #include "utils/dbgpainter.h"
+#include "utils/workers.h"
 #include "world.h"
 
 using namespace Tempest;
@@ -27,9 +29,6 @@ WayMatrix::WayMatrix(World &world, const ZenLoad::zCWayNetData &dat)
   for(auto& i:wayPoints)
     if(i.name.find("START")!=std::string::npos)
       startPoints.push_back(i);
-
-  stk[0].reserve(256);
-  stk[1].reserve(256);
   }
 
 void WayMatrix::buildIndex() {
@@ -41,11 +40,12 @@ void WayMatrix::buildIndex() {
     return a->name<b->name;
     });
 
-  for(auto& i:freePoints)
-    fpInd.push_back(&i);
-  std::sort(fpInd.begin(),fpInd.end(),[](const WayPoint* a,const WayPoint* b){
-    return a->x<b->x;
-    });
+  std::vector<const WayPoint*> pt(wayPoints.size());
+  for(size_t i=0; i<wayPoints.size(); ++i)
+    pt[i] = &wayPoints[i];
+  wayIndex.build(std::move(pt));
+  allIndex.build(std::vector<const WayPoint*>(indexPoints.begin(),indexPoints.end()));
+  fpIndex.clear();
 
   for(auto& i:edges){
     if(i.first<wayPoints.size() && i.second<wayPoints.size()){
@@ -56,45 +56,32 @@ void WayMatrix::buildIndex() {
       b.connect(a);
       }
     }
+  graph.build(wayPoints);
+  Log::i("waynet: ",uint32_t(wayPoints.size())," points, ",uint32_t(graph.clusterCount())," clusters, ",
+         uint32_t(graph.portalCount())," portals");
   }
 
 const WayPoint *WayMatrix::findWayPoint(const Vec3& at, const std::function<bool(const WayPoint&)>& filter) const {
-  const WayPoint* ret =nullptr;
-  float           dist=std::numeric_limits<float>::max();
-  for(auto& w:wayPoints) {
-    if(!filter(w))
-      continue;
-    auto  dp = w.position()-at;
-    float l  = dp.quadLength();
-    if(l<dist){
-      ret  = &w;
-      dist = l;
-      }
-    }
-  return ret;
+  return wayIndex.findNearest(at,WayPointIndex::Unlimited,false,filter);
   }
 
-const WayPoint *WayMatrix::findFreePoint(const Vec3& at, const char *name, const std::function<bool(const WayPoint&)>& filter) const {
-  auto&  index = findFpIndex(name);
-  return findFreePoint(at.x,at.y,at.z,index,filter);
+const WayPoint *WayMatrix::findFreePoint(const Vec3& at, const char *name, bool unlockedOnly,
+                                         const std::function<bool(const WayPoint&)>& filter) const {
+  auto& ind = findFpIndex(name);
+  // float R = 20.f*100.f; // see scripting doc
+  float R = 5.f*100.f; // scripting doc says 20m, but number seems to be incorrect
+  return ind.index->findNearest(at,R,unlockedOnly,[&at,&filter](const WayPoint& w){
+    float dz = w.z-at.z;
+    return dz*dz<300*300 && filter(w);
+    });
   }
 
 const WayPoint *WayMatrix::findNextPoint(const Vec3& at) const {
-  const WayPoint* ret   = nullptr;
-  float           dist  = 20.f*100.f; // see scripting doc
-
-  dist*=dist;
-  for(auto pw:indexPoints){
-    auto& w  = *pw;
-    auto  dp = w.position()-at;
-    float l  = dp.quadLength();
-
-    if(l<dist && dp.z*dp.z<300*300 && !w.isLocked()){
-      ret  = &w;
-      dist = l;
-      }
-    }
-  return ret;
+  float R = 20.f*100.f; // see scripting doc
+  return allIndex.findNearest(at,R,true,[&at](const WayPoint& w){
+    float dz = w.z-at.z;
+    return dz*dz<300*300;
+    });
   }
 
 void WayMatrix::addFreePoint(const Vec3& pos, const Vec3& dir, const char *name) {
@@ -176,55 +163,39 @@ const WayMatrix::FpIndex &WayMatrix::findFpIndex(const char *name) const {
     return *it;
     }
 
-  FpIndex id;
-  id.key = name;
+  std::vector<const WayPoint*> pt;
   for(auto& w:freePoints){
     if(!w.checkName(name))
       continue;
-    id.index.push_back(&w);
+    pt.push_back(&w);
     }
-  // TODO: good index, not sort by 'x' :)
-  std::sort(id.index.begin(),id.index.end(),[](const WayPoint* a,const WayPoint* b){
-    return a->x<b->x;
-    });
+
+  FpIndex id;
+  id.key = name;
+  id.index.reset(new WayPointIndex());
+  id.index->build(std::move(pt));
 
   it = fpIndex.insert(it,std::move(id));
   return *it;
   }
 
-const WayPoint *WayMatrix::findFreePoint(float x, float y, float z, const FpIndex& ind,
-                                         const std::function<bool(const WayPoint&)>& filter) const {
-  // float R = 20.f*100.f; // see scripting doc
-  float R = 5.f*100.f; // scripting doc says 20m, but number seems to be incorrect
-  auto b = std::lower_bound(ind.index.begin(),ind.index.end(), x-R ,[](const WayPoint *a, float b){
-    return a->x<b;
-    });
-  auto e = std::upper_bound(ind.index.begin(),ind.index.end(), x+R ,[](float a,const WayPoint *b){
-    return a<b->x;
-    });
+uint32_t WayMatrix::wayPointId(const WayPoint& wp) const {
+  intptr_t id = std::distance<const WayPoint*>(wayPoints.data(),&wp);
+  if(id<0 || size_t(id)>=wayPoints.size())
+    return uint32_t(-1);
+  return uint32_t(id);
+  }
 
-  const WayPoint *ret=nullptr;
-  auto  count = std::distance(b,e);(void) count;
-  float dist  = R*R;
-  for(auto i=b;i!=e;++i){
-    auto& w  = **i;
-    if(!filter(w))
-      continue;
-    float dx = w.x-x;
-    float dy = w.y-y;
-    float dz = w.z-z;
-    float l=dx*dx+dy*dy+dz*dz;
-    if(l<dist && dz*dz<300*300){
-      ret  = &w;
-      dist = l;
-      }
-    }
+WayPath WayMatrix::toWayPath(const std::vector<uint32_t>& ids) const {
+  WayPath ret;
+  for(auto i:ids)
+    ret.add(wayPoints[i]);
   return ret;
   }
 
 WayPath WayMatrix::wayTo(const WayPoint& begin, const WayPoint& end) const {
-  intptr_t endId = std::distance<const WayPoint*>(&wayPoints[0],&end);
-  if(endId<0 || size_t(endId)>=wayPoints.size()){
+  const uint32_t endId = wayPointId(end);
+  if(endId==uint32_t(-1)){
     if(end.name.find("FP_")==0) {
       WayPath ret;
       ret.add(end);
@@ -233,57 +204,67 @@ WayPath WayMatrix::wayTo(const WayPoint& begin, const WayPoint& end) const {
     return WayPath();
     }
 
-  pathGen++;
-  if(pathGen==1){
-    // new cycle
-    for(auto& i:wayPoints)
-      i.pathGen=0;
-    }
-  begin.pathLen = 0;
-  begin.pathGen = pathGen;
-
-  std::vector<const WayPoint*> *front=&stk[0], *back=&stk[1];
-  stk[0].clear();
-  stk[1].clear();
-
-  front->push_back(&begin);
-
-  while(end.pathGen!=pathGen && front->size()>0){
-    for(auto& wp:*front){
-      int32_t l0 = wp->pathLen;
-
-      for(auto i:wp->connections()){
-        auto& w  = *i.point;
-        int32_t l1 = l0+i.len;
-        if(w.pathGen!=pathGen || w.pathLen>l1){
-          w.pathLen = l1;
-          w.pathGen = pathGen;
-          back->push_back(&w);
-          }
-        }
-      }
-    std::swap(front,back);
-    back->clear();
-    }
+  static thread_local std::vector<uint32_t> ids;
+  if(!graph.findPath(wayPointId(begin),endId,ids))
+    return WayPath();
+  return toWayPath(ids);
+  }
 
-  WayPath ret;
-  ret.add(end);
-  const WayPoint* current = &end;
-  while(current!=&begin) {
-    int32_t l0 = current->pathLen, l1=l0;
-
-    const WayPoint* next=nullptr;
-    for(auto i:current->connections()){
-      if(i.point->pathGen==pathGen && i.point->pathLen+i.len<=l0 && i.point->pathLen<l1){
-        next = i.point;
-        l1   = i.point->pathLen;
-        }
-      }
-    if(next==nullptr)
-      return WayPath();
-    ret.add(*next);
-    current=next;
+void WayMatrix::wayTo(std::vector<PathRequest*>& req) const {
+  Workers::parallelFor(req,[this](PathRequest* r){
+    r->path = wayTo(*r->begin,*r->end);
+    r->done = true;
+    });
+  }
+
+void WayMatrix::benchmark(std::vector<PathRequest>& req) const {
+  // free- and start-points are not part of graph
+  req.erase(std::remove_if(req.begin(),req.end(),[this](const PathRequest& r){
+    return wayPointId(*r.begin)==uint32_t(-1) || wayPointId(*r.end)==uint32_t(-1);
+    }),req.end());
+
+  using Clock = std::chrono::steady_clock;
+  auto rate = [&req](Clock::time_point start) {
+    double sec = std::chrono::duration<double>(Clock::now()-start).count();
+    return uint32_t(sec>0 ? double(req.size())/sec : 0);
+    };
+
+  std::vector<uint32_t> a, b;
+  size_t                mismatch = 0;
+  for(auto& r:req) {
+    graph.solve(wayPointId(*r.begin),wayPointId(*r.end),WayGraph::Flat,        a);
+    graph.solve(wayPointId(*r.begin),wayPointId(*r.end),WayGraph::Hierarchical,b);
+    float la = graph.pathLength(a), lb = graph.pathLength(b);
+    if(a.empty()!=b.empty() || std::abs(la-lb)>0.01f*std::max(1.f,la))
+      mismatch++;
     }
 
-  return ret;
+  auto start = Clock::now();
+  for(auto& r:req)
+    graph.solve(wayPointId(*r.begin),wayPointId(*r.end),WayGraph::Flat,a);
+  const uint32_t flat = rate(start);
+
+  start = Clock::now();
+  for(auto& r:req)
+    graph.solve(wayPointId(*r.begin),wayPointId(*r.end),WayGraph::Hierarchical,a);
+  const uint32_t hierarchical = rate(start);
+
+  std::vector<PathRequest*> batch(req.size());
+  for(size_t i=0; i<req.size(); ++i)
+    batch[i] = &req[i];
+  graph.clearCache();
+  start = Clock::now();
+  wayTo(batch);
+  const uint32_t parallel = rate(start);
+
+  start = Clock::now();
+  for(auto& r:req)
+    r.path = wayTo(*r.begin,*r.end);
+  const uint32_t cached = rate(start);
+
+  Log::i("waynet benchmark: ",uint32_t(req.size())," paths, ",uint32_t(mismatch)," mismatches");
+  Log::i("  flat:         ",flat," paths/sec");
+  Log::i("  hierarchical: ",hierarchical," paths/sec");
+  Log::i("  batch(",uint32_t(Workers::threadCount()),"):     ",parallel," paths/sec");
+  Log::i("  cached:       ",cached," paths/sec");
   }
@@ -6,9 +6,12 @@
 #include <zenload/zTypes.h>
 #include <vector>
 #include <functional>
+#include <memory>
 
+#include "waygraph.h"
 #include "waypath.h"
 #include "waypoint.h"
+#include "waypointindex.h"
 
 class World;
 class DbgPainter;
@@ -18,7 +21,8 @@ class WayMatrix final {
     WayMatrix(World& owner,const ZenLoad::zCWayNetData& dat);
 
     const WayPoint* findWayPoint (const Tempest::Vec3& at, const std::function<bool(const WayPoint&)>& filter) const;
-    const WayPoint* findFreePoint(const Tempest::Vec3& at, const char* name, const std::function<bool(const WayPoint&)>& filter) const;
+    const WayPoint* findFreePoint(const Tempest::Vec3& at, const char* name, bool unlockedOnly,
+                                  const std::function<bool(const WayPoint&)>& filter) const;
     const WayPoint* findNextPoint(const Tempest::Vec3& at) const;
 
     void            addFreePoint (const Tempest::Vec3& pos, const Tempest::Vec3& dir, const char* name);
@@ -30,7 +34,18 @@ class WayMatrix final {
     const WayPoint* findPoint(const char* name, bool inexact) const;
     void            marchPoints(DbgPainter& p) const;
 
+    struct PathRequest final {
+      const WayPoint* begin = nullptr;
+      const WayPoint* end   = nullptr;
+      WayPath         path;
+      bool            done  = false;
+      };
+
     WayPath         wayTo(const WayPoint &begin, const WayPoint& end) const;
+    // solves batch of requests in parallel
+    void            wayTo(std::vector<PathRequest*>& req) const;
+    // replays requests with different strategies and logs paths/sec
+    void            benchmark(std::vector<PathRequest>& req) const;
 
   private:
     World&                 world;
@@ -41,20 +56,19 @@ class WayMatrix final {
     std::vector<WayPoint>  freePoints, startPoints;
     std::vector<WayPoint*> indexPoints;
 
-    std::vector<WayPoint*> fpInd;
+    WayPointIndex          wayIndex;
+    WayPointIndex          allIndex;
+    WayGraph               graph;
 
     struct FpIndex {
-      std::string                  key;
-      std::vector<const WayPoint*> index;
+      std::string                    key;
+      std::unique_ptr<WayPointIndex> index;
       };
     mutable std::vector<FpIndex>          fpIndex;
 
-    mutable uint16_t                      pathGen=0;
-    mutable std::vector<const WayPoint*>  stk[2];
-
     void                   adjustWaypoints(std::vector<WayPoint> &wp);
 
     const FpIndex&         findFpIndex(const char* name) const;
-    const WayPoint*        findFreePoint(float x, float y, float z, const FpIndex &ind,
-                                         const std::function<bool(const WayPoint&)>& filter) const;
+    uint32_t               wayPointId(const WayPoint& wp) const;
+    WayPath                toWayPath(const std::vector<uint32_t>& ids) const;
   };
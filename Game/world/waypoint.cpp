@@ -1,4 +1,5 @@
 #include "waypoint.h"
+#include "waypointindex.h"
 
 #include <cmath>
 #include <cstring>
@@ -70,6 +71,20 @@ void WayPoint::connect(WayPoint &w) {
   conn.push_back(c);
   }
 
+void WayPoint::lock() const {
+  if(useCount==0)
+    for(auto& i:indexRefs)
+      i.index->onLock(i.leaf,true);
+  useCount++;
+  }
+
+void WayPoint::unlock() const {
+  useCount--;
+  if(useCount==0)
+    for(auto& i:indexRefs)
+      i.index->onLock(i.leaf,false);
+  }
+
 std::string WayPoint::upcaseof(const std::string &src) {
   auto ret = src;
   for(auto& i:ret)
@@ -5,6 +5,7 @@
 #include <Tempest/Vec>
 
 class FpLock;
+class WayPointIndex;
 
 class WayPoint final {
   public:
@@ -41,21 +42,27 @@ class WayPoint final {
       int32_t   len  =0;
       };
 
-    // TODO: beautify
-    mutable int32_t  pathLen=std::numeric_limits<int32_t>::max();
-    mutable uint16_t pathGen=0;
-
     float qDistTo(float x,float y,float z) const;
 
     void connect(WayPoint& w);
     const std::vector<Conn>& connections() const { return conn; }
 
   private:
-    mutable uint32_t useCount=0;
+    struct IndexRef final {
+      WayPointIndex* index = nullptr;
+      uint32_t       leaf  = 0;
+      };
+
+    mutable uint32_t              useCount=0;
+    mutable std::vector<IndexRef> indexRefs;
 
     std::vector<Conn> conn;
 
+    void lock() const;
+    void unlock() const;
+
     static std::string upcaseof(const std::string& src);
 
   friend class FpLock;
+  friend class WayPointIndex;
   };
@@ -0,0 +1,153 @@
+#include "waypointindex.h"
+
+#include <algorithm>
+
+#include "waypoint.h"
+
+using namespace Tempest;
+
+constexpr float WayPointIndex::Unlimited;
+
+WayPointIndex::~WayPointIndex() {
+  for(auto p:points) {
+    auto& refs = p->indexRefs;
+    refs.erase(std::remove_if(refs.begin(),refs.end(),[this](const WayPoint::IndexRef& r){
+      return r.index==this;
+      }),refs.end());
+    }
+  }
+
+void WayPointIndex::build(std::vector<const WayPoint*> pt) {
+  points = std::move(pt);
+  nodes.clear();
+  if(points.empty())
+    return;
+  nodes.reserve(2*(points.size()/LeafSize+1));
+  implBuild(0,uint32_t(points.size()),NullNode);
+  }
+
+uint32_t WayPointIndex::implBuild(uint32_t begin, uint32_t end, uint32_t parent) {
+  const uint32_t id = uint32_t(nodes.size());
+  nodes.emplace_back();
+
+  Node n;
+  n.begin  = begin;
+  n.end    = end;
+  n.parent = parent;
+  n.bmin   = points[begin]->position();
+  n.bmax   = n.bmin;
+  for(uint32_t i=begin; i<end; ++i) {
+    auto p = points[i]->position();
+    n.bmin.x = std::min(n.bmin.x,p.x);
+    n.bmin.y = std::min(n.bmin.y,p.y);
+    n.bmin.z = std::min(n.bmin.z,p.z);
+    n.bmax.x = std::max(n.bmax.x,p.x);
+    n.bmax.y = std::max(n.bmax.y,p.y);
+    n.bmax.z = std::max(n.bmax.z,p.z);
+    if(!points[i]->isLocked())
+      n.unlocked++;
+    }
+
+  if(end-begin<=LeafSize) {
+    for(uint32_t i=begin; i<end; ++i)
+      points[i]->indexRefs.push_back(WayPoint::IndexRef{this,id});
+    nodes[id] = n;
+    return id;
+    }
+
+  // split by median of longest axis
+  const Vec3 sz  = n.bmax-n.bmin;
+  const int  ax  = (sz.x>=sz.y && sz.x>=sz.z) ? 0 : (sz.y>=sz.z ? 1 : 2);
+  const auto mid = begin+(end-begin)/2;
+  std::nth_element(points.begin()+begin,points.begin()+mid,points.begin()+end,[ax](const WayPoint* a, const WayPoint* b){
+    switch(ax) {
+      case 0:  return a->x<b->x;
+      case 1:  return a->y<b->y;
+      default: return a->z<b->z;
+      }
+    });
+
+  n.left  = implBuild(begin,mid,id);
+  n.right = implBuild(mid,  end,id);
+  nodes[id] = n;
+  return id;
+  }
+
+size_t WayPointIndex::implNearest(const Vec3& at, size_t k, float R, bool unlockedOnly,
+                                  const void* ctx, bool (*filter)(const void*, const WayPoint&), const WayPoint** out) const {
+  if(nodes.empty() || k==0)
+    return 0;
+
+  struct Entry {
+    float    qDist;
+    uint32_t id;
+    bool     point;
+    bool operator < (const Entry& other) const { return qDist>other.qDist; }
+    };
+
+  const float qR  = (R==Unlimited) ? Unlimited : R*R;
+  size_t      cnt = 0;
+
+  // best-first traversal: points are visited in order of increasing distance
+  std::vector<Entry> heap;
+  heap.reserve(64);
+  heap.push_back(Entry{qDist(nodes[0],at),0,false});
+  while(!heap.empty()) {
+    std::pop_heap(heap.begin(),heap.end());
+    const Entry e = heap.back();
+    heap.pop_back();
+    if(e.qDist>=qR)
+      break;
+
+    if(e.point) {
+      auto& wp = *points[e.id];
+      if(unlockedOnly && wp.isLocked())
+        continue;
+      if(!filter(ctx,wp))
+        continue;
+      out[cnt] = &wp;
+      cnt++;
+      if(cnt==k)
+        break;
+      continue;
+      }
+
+    auto& n = nodes[e.id];
+    if(unlockedOnly && n.unlocked==0)
+      continue;
+    if(n.left==NullNode) {
+      for(uint32_t i=n.begin; i<n.end; ++i) {
+        auto  dp = points[i]->position()-at;
+        float l  = dp.quadLength();
+        if(l<qR) {
+          heap.push_back(Entry{l,i,true});
+          std::push_heap(heap.begin(),heap.end());
+          }
+        }
+      } else {
+      for(auto c:{n.left,n.right}) {
+        float l = qDist(nodes[c],at);
+        if(l<qR) {
+          heap.push_back(Entry{l,c,false});
+          std::push_heap(heap.begin(),heap.end());
+          }
+        }
+      }
+    }
+  return cnt;
+  }
+
+void WayPointIndex::onLock(uint32_t leaf, bool locked) {
+  for(uint32_t i=leaf; i!=NullNode; i=nodes[i].parent) {
+    if(locked)
+      nodes[i].unlocked--; else
+      nodes[i].unlocked++;
+    }
+  }
+
+float WayPointIndex::qDist(const Node& n, const Vec3& p) {
+  float dx = std::max(0.f,std::max(n.bmin.x-p.x,p.x-n.bmax.x));
+  float dy = std::max(0.f,std::max(n.bmin.y-p.y,p.y-n.bmax.y));
+  float dz = std::max(0.f,std::max(n.bmin.z-p.z,p.z-n.bmax.z));
+  return dx*dx+dy*dy+dz*dz;
+  }
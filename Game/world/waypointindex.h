@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Tempest/Point>
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+
+class WayPoint;
+
+// Static kd-tree over way-points. Every node keeps count of unlocked points (see FpLock),
+// so queries for free points skip fully occupied subtrees.
+class WayPointIndex final {
+  public:
+    WayPointIndex() = default;
+    WayPointIndex(const WayPointIndex&) = delete;
+    ~WayPointIndex();
+
+    void   build(std::vector<const WayPoint*> points);
+    size_t size() const { return points.size(); }
+
+    // nearest point within radius R, accepted by filter; filter is evaluated in order of increasing distance
+    template<class F>
+    const WayPoint* findNearest(const Tempest::Vec3& at, float R, bool unlockedOnly, const F& filter) const {
+      const WayPoint* ret = nullptr;
+      implNearest(at,1,R,unlockedOnly,&filter,&invoke<F>,&ret);
+      return ret;
+      }
+
+    // up to k nearest points within radius R, from nearest to farthest
+    template<class F>
+    size_t findNearest(const Tempest::Vec3& at, size_t k, float R, bool unlockedOnly, const F& filter, const WayPoint** out) const {
+      return implNearest(at,k,R,unlockedOnly,&filter,&invoke<F>,out);
+      }
+
+    static constexpr float Unlimited = std::numeric_limits<float>::max();
+
+  private:
+    enum : uint32_t {
+      NullNode = uint32_t(-1),
+      LeafSize = 8,
+      };
+
+    struct Node {
+      Tempest::Vec3 bmin, bmax;
+      uint32_t      begin    = 0;
+      uint32_t      end      = 0;
+      uint32_t      left     = NullNode;
+      uint32_t      right    = NullNode;
+      uint32_t      parent   = NullNode;
+      uint32_t      unlocked = 0;
+      };
+
+    std::vector<const WayPoint*> points;
+    std::vector<Node>            nodes;
+
+    uint32_t implBuild(uint32_t begin, uint32_t end, uint32_t parent);
+    size_t   implNearest(const Tempest::Vec3& at, size_t k, float R, bool unlockedOnly,
+                         const void* ctx, bool (*filter)(const void*, const WayPoint&), const WayPoint** out) const;
+    void     onLock(uint32_t leaf, bool locked);
+
+    static float qDist(const Node& n, const Tempest::Vec3& p);
+
+    template<class F>
+    static bool invoke(const void* ctx, const WayPoint& wp) {
+      return (*reinterpret_cast<const F*>(ctx))(wp);
+      }
+
+  friend class WayPoint;
+  };
@@ -15,88 +15,100 @@
 #include "world/objects/npc.h"
 #include "world/objects/item.h"
 #include "world/objects/interactive.h"
+#include "world/worldcache.h"
+#include "utils/perfcounters.h"
+#include "utils/stagegraph.h"
 #include "game/globaleffects.h"
 #include "game/serialize.h"
 #include "gothic.h"
 #include "focus.h"
 #include "resources.h"
 
-World::World(Gothic& gothic, GameSession& game, const RendererStorage &storage, std::string file, std::function<void(int)> loadProgress)
-  :wname(std::move(file)),game(game),wsound(gothic,game,*this),wobj(*this) {
-  using namespace Daedalus::GameState;
-
-  ZenLoad::ZenParser parser(wname,Resources::vdfsIndex());
-
-  loadProgress(1);
-  parser.readHeader();
-
-  loadProgress(10);
-  ZenLoad::oCWorldData world;
-
-  auto fver = ZenLoad::ZenParser::FileVersion::Gothic1;
-  if(gothic.version().game==2)
-    fver = ZenLoad::ZenParser::FileVersion::Gothic2;
-  parser.readWorld(world,fver);
-
-  ZenLoad::zCMesh* worldMesh = parser.getWorldMesh();
-  PackedMesh vmesh(*worldMesh,PackedMesh::PK_VisualLnd);
-
-  loadProgress(50);
-  wdynamic.reset(new DynamicWorld(*this,*worldMesh));
-  wview.reset   (new WorldView(*this,vmesh,storage));
-  loadProgress(70);
+static void collectVisuals(const std::vector<ZenLoad::zCVobData>& vobs, std::vector<std::string>& out) {
+  for(auto& i:vobs) {
+    if(!i.visual.empty())
+      out.push_back(i.visual);
+    collectVisuals(i.childVobs,out);
+    }
+  }
 
-  globFx.reset(new GlobalEffects(*this));
+static std::vector<std::string> collectVisuals(const std::vector<ZenLoad::zCVobData>& vobs) {
+  std::vector<std::string> ret;
+  collectVisuals(vobs,ret);
+  return ret;
+  }
 
-  wmatrix.reset(new WayMatrix(*this,world.waynet));
-  if(1){
-    for(auto& vob:world.rootVobs)
-      wobj.addRoot(std::move(vob),true);
-    }
-  wmatrix->buildIndex();
-  bsp = std::move(world.bspTree);
-  bspSectors.resize(bsp.sectors.size());
-  loadProgress(100);
+World::World(Gothic& gothic, GameSession& game, const RendererStorage &storage, std::string file, std::function<void(int)> loadProgress)
+  :wname(std::move(file)),game(game),wsound(gothic,game,*this),wobj(*this) {
+  loadZen(gothic,storage,true,loadProgress);
   }
 
 World::World(Gothic& gothic, GameSession &game, const RendererStorage &storage,
              Serialize &fin, std::function<void(int)> loadProgress)
   :wname(fin.read<std::string>()),game(game),wsound(gothic,game,*this),wobj(*this) {
-  using namespace Daedalus::GameState;
-
-  ZenLoad::ZenParser parser(wname,Resources::vdfsIndex());
+  loadZen(gothic,storage,false,loadProgress);
+  }
 
-  loadProgress(1);
-  parser.readHeader();
+void World::loadZen(Gothic& gothic, const RendererStorage& storage, bool startup, const std::function<void(int)>& loadProgress) {
+  // zen size is part of world-cache key
+  const std::vector<uint8_t> zen = Resources::getFileData(wname);
+  ZenLoad::ZenParser parser(zen.data(),zen.size());
 
-  loadProgress(10);
   ZenLoad::oCWorldData world;
-
   auto fver = ZenLoad::ZenParser::FileVersion::Gothic1;
   if(gothic.version().game==2)
     fver = ZenLoad::ZenParser::FileVersion::Gothic2;
-  parser.readWorld(world,fver);
 
-  ZenLoad::zCMesh* worldMesh = parser.getWorldMesh();
-  PackedMesh vmesh(*worldMesh,PackedMesh::PK_VisualLnd);
+  WorldCache cache(gothic,wname,zen.size());
+  StageGraph stages;
 
-  loadProgress(50);
-  wdynamic.reset(new DynamicWorld(*this,*worldMesh));
-  wview.reset   (new WorldView(*this,vmesh,storage));
-  loadProgress(70);
-
-  globFx.reset(new GlobalEffects(*this));
-
-  wmatrix.reset(new WayMatrix(*this,world.waynet));
-  if(1){
+  // progress is reported by completed stages, weighted roughly by their load time
+  auto zenData = stages.add("zen",StageGraph::Worker,{},[&](){
+    parser.readHeader();
+    parser.readWorld(world,fver);
+    },6);
+  auto cached  = stages.add("cache",StageGraph::Worker,{},[&](){
+    cache.load();
+    });
+  auto packLnd = stages.add("pack landscape",StageGraph::Worker,{zenData,cached},[&](){
+    if(!cache.isValid())
+      cache.visual = PackedMesh(*parser.getWorldMesh(),PackedMesh::PK_VisualLnd);
+    },2);
+  auto packPhy = stages.add("pack physic",StageGraph::Worker,{zenData,cached},[&](){
+    if(!cache.isValid())
+      cache.physic = PackedMesh(*parser.getWorldMesh(),PackedMesh::PK_PhysicZoned);
+    },2);
+  auto physic  = stages.add("physic",StageGraph::Worker,{packPhy},[&](){
+    wdynamic.reset(new DynamicWorld(*this,cache));
+    },4);
+  auto view    = stages.add("landscape",StageGraph::Caller,{packLnd},[&](){
+    wview.reset(new WorldView(*this,cache.visual,storage));
+    },2);
+  stages.add("save cache",StageGraph::Worker,{physic,view},[&](){
+    if(!cache.isValid())
+      cache.save();
+    });
+  auto waynet  = stages.add("waynet",StageGraph::Worker,{zenData},[&](){
+    wmatrix.reset(new WayMatrix(*this,world.waynet));
+    });
+  auto preload = stages.add("preload",StageGraph::Caller,{zenData,view},[&](){
+    // NOTE: after landscape, to not create gpu objects concurrently
+    Resources::preload(collectVisuals(world.rootVobs));
+    },4);
+  auto vobs    = stages.add("vobs",StageGraph::Caller,{physic,view,waynet,preload},[&](){
+    globFx.reset(new GlobalEffects(*this));
     for(auto& vob:world.rootVobs)
-      wobj.addRoot(std::move(vob),false);
-    }
-  wmatrix->buildIndex();
-  bsp = std::move(world.bspTree);
-  bspSectors.resize(bsp.sectors.size());
+      wobj.addRoot(std::move(vob),startup);
+    },4);
+  stages.add("waynet index",StageGraph::Caller,{vobs},[&](){
+    wmatrix->buildIndex();
+    });
+  stages.add("bsp",StageGraph::Worker,{zenData},[&](){
+    bsp.build(world.bspTree);
+    bspSectors.resize(bsp.sectorCount());
+    });
 
-  loadProgress(100);
+  stages.exec(loadProgress,0,100);
   }
 
 World::~World() {
@@ -149,7 +161,7 @@ void World::save(Serialize &fout) {
 
   fout.write(uint32_t(bspSectors.size()));
   for(size_t i=0;i<bspSectors.size();++i) {
-    fout.write(bsp.sectors[i].name,bspSectors[i].guild);
+    fout.write(bsp.sectorName(uint32_t(i)),bspSectors[i].guild);
     }
   }
 
@@ -163,6 +175,10 @@ Npc *World::npcById(uint32_t id) {
   return nullptr;
   }
 
+size_t World::npcCount() const {
+  return wobj.npcCount();
+  }
+
 uint32_t World::mobsiId(const Interactive* ptr) const {
   return wobj.mobsiId(ptr);
   }
@@ -248,6 +264,7 @@ void World::updateAnimation() {
   static bool doAnim=true;
   if(!doAnim)
     return;
+  PerfCounters::Scope perf(PerfCounters::Animation);
   wobj.updateAnimation();
   }
 
@@ -263,65 +280,25 @@ Npc *World::findNpcByInstance(size_t instance) {
   return wobj.findNpcByInstance(instance);
   }
 
-const std::string& World::roomAt(const Tempest::Vec3& p) {
-  static std::string empty;
-
-  if(bsp.nodes.empty())
-    return empty;
-
-  const ZenLoad::zCBspNode* node=&bsp.nodes[0];
-
-  while(true) {
-    const float* v    = node->plane.v;
-    float        sgn  = v[0]*p.x + v[1]*p.y + v[2]*p.z - v[3];
-    uint32_t     next = (sgn>0) ? node->front : node->back;
-    if(next>=bsp.nodes.size())
-      break;
-
-    node = &bsp.nodes[next];
-    }
-
-  if(node->bbox3dMin.x <= p.x && p.x <node->bbox3dMax.x &&
-     node->bbox3dMin.y <= p.y && p.y <node->bbox3dMax.y &&
-     node->bbox3dMin.z <= p.z && p.z <node->bbox3dMax.z) {
-    return roomAt(*node);
-    }
-
-  return empty;
+uint32_t World::roomAt(const Tempest::Vec3& pos) const {
+  return bsp.sectorAt(pos);
   }
 
-const std::string& World::roomAt(const ZenLoad::zCBspNode& node) {
-  std::string* ret=nullptr;
-  size_t       count=0;
-  auto         id = &node-bsp.nodes.data();(void)id;
+void World::roomAt(const Tempest::Vec3* pos, uint32_t* room, size_t count) const {
+  bsp.sectorAt(pos,room,count);
+  }
 
-  for(auto& i:bsp.sectors) {
-    for(auto r:i.bspNodeIndices)
-      if(r<bsp.leafIndices.size()){
-        size_t idx = bsp.leafIndices[r];
-        if(idx>=bsp.nodes.size())
-          continue;
-        if(&bsp.nodes[idx]==&node) {
-          ret = &i.name;
-          count++;
-          }
-        }
-    }
-  if(count==1) {
-    // TODO: portals
-    return *ret;
-    }
-  static std::string empty;
-  return empty;
+const std::string& World::roomName(uint32_t room) const {
+  return bsp.sectorName(room);
   }
 
 World::BspSector* World::portalAt(const std::string &tag) {
   if(tag.empty())
     return nullptr;
 
-  for(size_t i=0;i<bsp.sectors.size();++i)
-    if(bsp.sectors[i].name==tag)
-      return &bspSectors[i];
+  auto id = bsp.findSector(tag);
+  if(id<bspSectors.size())
+    return &bspSectors[id];
   return nullptr;
   }
 
@@ -333,8 +310,14 @@ void World::tick(uint64_t dt) {
   static bool doTicks=true;
   if(!doTicks)
     return;
+  {
+  PerfCounters::Scope perf(PerfCounters::WorldObjects);
   wobj.tick(dt,dt);
+  }
+  {
+  PerfCounters::Scope perf(PerfCounters::Physics);
   wdynamic->tick(dt);
+  }
   wview->tick(dt);
   if(auto pl = player())
     wsound.tick(*pl);
@@ -766,6 +749,14 @@ void World::addTrigger(AbstractTrigger* trigger) {
   wobj.addTrigger(trigger);
   }
 
+void World::triggerMoved(AbstractTrigger& trigger) {
+  wobj.triggerMoved(trigger);
+  }
+
+const char* World::internName(const std::string& name) {
+  return wobj.internName(name);
+  }
+
 void World::addInteractive(Interactive* inter) {
   wobj.addInteractive(inter);
   }
@@ -791,10 +782,6 @@ void World::addSound(const ZenLoad::zCVobData& vob) {
     }
   }
 
-void World::invalidateVobIndex() {
-  wobj.invalidateVobIndex();
-  }
-
 void World::triggerOnStart(bool firstTime) {
   wobj.triggerOnStart(firstTime);
   }
@@ -816,9 +803,7 @@ const WayPoint *World::findFreePoint(const Npc &npc, const char *name) const {
   auto pos = npc.position();
   pos.y+=npc.translateY();
 
-  return wmatrix->findFreePoint(pos,name,[&npc](const WayPoint& wp) -> bool {
-    if(wp.isLocked())
-      return false;
+  return wmatrix->findFreePoint(pos,name,true,[&npc](const WayPoint& wp) -> bool {
     if(!npc.canSeeNpc(wp.x,wp.y+10,wp.z,true))
       return false;
     return true;
@@ -826,9 +811,7 @@ const WayPoint *World::findFreePoint(const Npc &npc, const char *name) const {
   }
 
 const WayPoint *World::findFreePoint(const Tempest::Vec3& pos, const char* name) const {
-  return wmatrix->findFreePoint(pos,name,[](const WayPoint& wp) -> bool {
-    if(wp.isLocked())
-      return false;
+  return wmatrix->findFreePoint(pos,name,true,[](const WayPoint&) -> bool {
     return true;
     });
   }
@@ -837,8 +820,8 @@ const WayPoint *World::findNextFreePoint(const Npc &npc, const char *name) const
   auto pos = npc.position();
   pos.y+=npc.translateY();
   auto cur = npc.currentWayPoint();
-  auto wp  = wmatrix->findFreePoint(pos,name,[cur,&npc](const WayPoint& wp) -> bool {
-    if(wp.isLocked() || &wp==cur)
+  auto wp  = wmatrix->findFreePoint(pos,name,true,[cur,&npc](const WayPoint& wp) -> bool {
+    if(&wp==cur)
       return false;
     if(!npc.canSeeNpc(wp.x,wp.y+10,wp.z,true))
       return false;
@@ -851,6 +834,14 @@ const WayPoint *World::findNextPoint(const WayPoint &pos) const {
   return wmatrix->findNextPoint(pos.position());
   }
 
+void World::onNpcMove(Npc& npc) {
+  wobj.onNpcMove(npc);
+  }
+
+bool World::lineOfSight(const Npc& from, const Npc& to) {
+  return wobj.lineOfSight(from,to);
+  }
+
 void World::detectNpcNear(std::function<void (Npc &)> f) {
   wobj.detectNpcNear(f);
   }
@@ -863,11 +854,11 @@ void World::detectItem(const Tempest::Vec3& p, const float r, const std::functio
   wobj.detectItem(p.x,p.y,p.z,r,f);
   }
 
-WayPath World::wayTo(const Npc &npc, const WayPoint &end) const {
+const WayPoint* World::wayBegin(const Npc &npc) const {
   auto p     = npc.position();
   auto begin = npc.currentWayPoint();
   if(begin && !begin->isFreePoint() && MoveAlgo::isClose(npc.position(),*begin)){
-    return wmatrix->wayTo(*begin,end);
+    return begin;
     }
 
   begin = wmatrix->findWayPoint(p,[&npc](const WayPoint &wp){
@@ -876,11 +867,30 @@ WayPath World::wayTo(const Npc &npc, const WayPoint &end) const {
     return true;
     });
   if(begin==nullptr)
-    return WayPath();
+    return nullptr;
   if(MoveAlgo::isClose(p,*begin))
-    return WayPath();
+    return nullptr;
+  return begin;
+  }
 
-  return wmatrix->wayTo(*begin,end);
+void World::wayTo(std::vector<WayMatrix::PathRequest*>& req) const {
+  wmatrix->wayTo(req);
+  }
+
+void World::benchmarkWaynet() const {
+  // every routine change of every npc: from point of one routine to point of next one
+  std::vector<WayMatrix::PathRequest> req;
+  for(size_t i=0; i<wobj.npcCount(); ++i) {
+    auto& npc = wobj.npc(i);
+    for(size_t r=0; r<npc.routineCount(); ++r) {
+      WayMatrix::PathRequest q;
+      q.begin = npc.routinePoint(r);
+      q.end   = npc.routinePoint((r+1)%npc.routineCount());
+      if(q.begin!=nullptr && q.end!=nullptr && q.begin!=q.end)
+        req.emplace_back(std::move(q));
+      }
+    }
+  wmatrix->benchmark(req);
   }
 
 GameScript &World::script() const {
@@ -905,11 +915,12 @@ void World::assignRoomToGuild(const char* r, int32_t guildId) {
   }
 
 int32_t World::guildOfRoom(const Tempest::Vec3& pos) {
-  const std::string& tg = roomAt(pos);
-  if(auto room=portalAt(tg)) {
-    if(room->guild==GIL_PUBLIC) //FIXME: proper portal implementation
-      return room->guild;
-    }
+  return guildOfRoom(roomAt(pos));
+  }
+
+int32_t World::guildOfRoom(uint32_t room) const {
+  if(room<bspSectors.size() && bspSectors[room].guild==GIL_PUBLIC) //FIXME: proper portal implementation
+    return bspSectors[room].guild;
   return GIL_NONE;
   }
 
@@ -928,13 +939,8 @@ int32_t World::guildOfRoom(const char* portalName) {
     size = std::strlen(b); else
     size = size_t(std::distance(b,e));
 
-  for(size_t i=0;i<bsp.sectors.size();++i) {
-    auto& s = bsp.sectors[i].name;
-    if(s.size()!=size)
-      continue;
-
-    if(std::memcmp(s.c_str(),b,size)==0)
-      return bspSectors[i].guild;
-    }
+  auto id = bsp.findSector(std::string(b,size));
+  if(id<bspSectors.size())
+    return bspSectors[id].guild;
   return GIL_NONE;
   }
@@ -18,6 +18,7 @@
 #include "triggers/trigger.h"
 #include "worldobjects.h"
 #include "worldsound.h"
+#include "bsptree.h"
 #include "waypoint.h"
 #include "waymatrix.h"
 #include "resources.h"
@@ -55,6 +56,7 @@ class World final {
 
     uint32_t             npcId(const Npc* ptr) const;
     Npc*                 npcById(uint32_t id);
+    size_t               npcCount() const;
 
     uint32_t             mobsiId(const Interactive* ptr) const;
     Interactive*         mobsiById(uint32_t id);
@@ -72,11 +74,15 @@ class World final {
     const WayPoint*      findNextFreePoint(const Npc& pos,const char* name) const;
     const WayPoint*      findNextPoint(const WayPoint& pos) const;
 
+    void                 onNpcMove(Npc& npc);
+    bool                 lineOfSight(const Npc& from, const Npc& to);
     void                 detectNpcNear(std::function<void(Npc&)> f);
     void                 detectNpc (const Tempest::Vec3& p, const float r, const std::function<void(Npc&)>& f);
     void                 detectItem(const Tempest::Vec3& p, const float r, const std::function<void(Item&)>& f);
 
-    WayPath              wayTo(const Npc& pos,const WayPoint& end) const;
+    const WayPoint*      wayBegin(const Npc& npc) const;
+    void                 wayTo(std::vector<WayMatrix::PathRequest*>& req) const;
+    void                 benchmarkWaynet() const;
 
     WorldView*           view()     const { return wview.get();    }
     WorldSound*          sound()          { return &wsound;         }
@@ -88,6 +94,7 @@ class World final {
     void                 assignRoomToGuild(const char* room, int32_t guildId);
     int32_t              guildOfRoom(const Tempest::Vec3& pos);
     int32_t              guildOfRoom(const char* portalName);
+    int32_t              guildOfRoom(uint32_t room) const;
 
     void                 runEffect(Effect&& e);
     void                 stopEffect(const VisualFx& vfx);
@@ -112,7 +119,10 @@ class World final {
     auto                 takeHero() -> std::unique_ptr<Npc>;
     Npc*                 player() const { return npcPlayer; }
     Npc*                 findNpcByInstance(size_t instance);
-    auto                 roomAt(const Tempest::Vec3& arr) -> const std::string&;
+    // room is interned bsp-sector id, BspTree::NoSector outside of any room
+    uint32_t             roomAt(const Tempest::Vec3& pos) const;
+    void                 roomAt(const Tempest::Vec3* pos, uint32_t* room, size_t count) const;
+    auto                 roomName(uint32_t room) const -> const std::string&;
 
     void                 scaleTime(uint64_t& dt);
     void                 tick(uint64_t dt);
@@ -170,19 +180,19 @@ class World final {
     void                 addBlockSound   (Npc& self,Npc& other);
 
     void                 addTrigger    (AbstractTrigger* trigger);
+    const char*          internName    (const std::string& name);
+    void                 triggerMoved  (AbstractTrigger& trigger);
     void                 addInteractive(Interactive* inter);
     void                 addStartPoint (const Tempest::Vec3& pos, const Tempest::Vec3& dir, const char* name);
     void                 addFreePoint  (const Tempest::Vec3& pos, const Tempest::Vec3& dir, const char* name);
     void                 addSound      (const ZenLoad::zCVobData& vob);
 
-    void                 invalidateVobIndex();
-
   private:
     std::string                           wname;
     GameSession&                          game;
 
     std::unique_ptr<WayMatrix>            wmatrix;
-    ZenLoad::zCBspTreeData                bsp;
+    BspTree                               bsp;
     std::vector<BspSector>                bspSectors;
 
     Npc*                                  npcPlayer=nullptr;
@@ -194,8 +204,8 @@ class World final {
     WorldObjects                          wobj;
     std::unique_ptr<Npc>                  lvlInspector;
 
-    auto         roomAt(const ZenLoad::zCBspNode &node) -> const std::string &;
     auto         portalAt(const std::string& tag) -> BspSector*;
 
+    void         loadZen(Gothic& gothic, const RendererStorage& storage, bool startup, const std::function<void(int)>& loadProgress);
     void         initScripts(bool firstTime);
   };
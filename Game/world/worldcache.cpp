@@ -0,0 +1,284 @@
+#include "worldcache.h"
+
+#include <Tempest/Dir>
+#include <Tempest/File>
+#include <Tempest/Log>
+#include <Tempest/TextCodec>
+
+#include <cstring>
+#include <cctype>
+#include <stdexcept>
+#include <type_traits>
+
+#include "utils/fileutil.h"
+#include "utils/mappedfile.h"
+#include "gothic.h"
+#include "resources.h"
+
+using namespace Tempest;
+
+static const char     tag[]    = "OGWCACHE";
+static const char16_t cacheDir[] = u"cache";
+
+struct WorldCache::Reader final {
+  uint8_t* begin = nullptr;
+  uint8_t* at    = nullptr;
+  uint8_t* end   = nullptr;
+
+  void readBytes(void* dest, size_t sz) {
+    if(size_t(end-at)<sz)
+      throw std::runtime_error("unexpected end of file");
+    std::memcpy(dest,at,sz);
+    at += sz;
+    }
+
+  uint8_t* skip(size_t sz) {
+    if(size_t(end-at)<sz)
+      throw std::runtime_error("unexpected end of file");
+    auto ret = at;
+    at += sz;
+    return ret;
+    }
+
+  void align() {
+    size_t pos = size_t(at-begin);
+    skip((Alignment-pos%Alignment)%Alignment);
+    }
+
+  template<class T>
+  void read(T& t) {
+    static_assert(std::is_trivially_copyable<T>::value,"trivially copyable type expected");
+    readBytes(&t,sizeof(t));
+    }
+
+  void read(std::string& s) {
+    uint32_t sz=0;
+    read(sz);
+    if(size_t(end-at)<sz)
+      throw std::runtime_error("unexpected end of file");
+    s.resize(sz);
+    if(sz>0)
+      readBytes(&s[0],sz);
+    }
+
+  template<class T>
+  void read(std::vector<T>& v) {
+    static_assert(std::is_trivially_copyable<T>::value,"trivially copyable type expected");
+    uint64_t sz=0;
+    read(sz);
+    if(uint64_t(end-at)/sizeof(T)<sz)
+      throw std::runtime_error("unexpected end of file");
+    v.resize(size_t(sz));
+    if(sz>0)
+      readBytes(v.data(),v.size()*sizeof(T));
+    }
+  };
+
+struct WorldCache::Writer final {
+  WFile& fout;
+  size_t pos = 0;
+
+  void writeBytes(const void* src, size_t sz) {
+    if(fout.write(src,sz)!=sz)
+      throw std::runtime_error("unable to write file");
+    pos += sz;
+    }
+
+  void align() {
+    static const uint8_t zero[Alignment] = {};
+    writeBytes(zero,(Alignment-pos%Alignment)%Alignment);
+    }
+
+  template<class T>
+  void write(const T& t) {
+    static_assert(std::is_trivially_copyable<T>::value,"trivially copyable type expected");
+    writeBytes(&t,sizeof(t));
+    }
+
+  void write(const std::string& s) {
+    write(uint32_t(s.size()));
+    writeBytes(s.data(),s.size());
+    }
+
+  template<class T>
+  void write(const std::vector<T>& v) {
+    static_assert(std::is_trivially_copyable<T>::value,"trivially copyable type expected");
+    write(uint64_t(v.size()));
+    writeBytes(v.data(),v.size()*sizeof(T));
+    }
+  };
+
+WorldCache::WorldCache(Gothic& gothic, const std::string& world, size_t zenSize) {
+  std::string name;
+  name.reserve(world.size()+8);
+  for(auto c:world)
+    name.push_back(char(std::tolower(c)));
+  name += ".wcache";
+  path = std::u16string(cacheDir) + u"/" + TextCodec::toUtf16(name);
+
+  // bvh layout is pointer-size dependent
+  key = Resources::vdfsTimestamp()*31 + sizeof(void*);
+  // zen can be replaced by mod or by loose file, while archives stay same
+  key = key*31 + uint64_t(zenSize);
+  auto loose = findLooseFile(gothic.nestedPath({u"_work",u"Data",u"Worlds"},Dir::FT_Dir),TextCodec::toUtf16(world));
+  uint64_t size = 0, mtime = 0;
+  if(!loose.empty() && FileUtil::fileInfo(loose,size,mtime)) {
+    key = key*31 + size;
+    key = key*31 + mtime;
+    }
+  }
+
+WorldCache::~WorldCache() {
+  }
+
+bool WorldCache::load() {
+  valid = false;
+  if(!FileUtil::exists(path))
+    return false;
+
+  try {
+    // copy-on-write: bullet writes object header into the buffer, on in-place deserialization
+    file = std::make_shared<MappedFile>(path,MappedFile::CopyOnWrite);
+
+    Reader rd;
+    rd.begin = file->data();
+    rd.at    = rd.begin;
+    rd.end   = rd.begin+file->size();
+    implLoad(rd);
+    valid = true;
+    }
+  catch(std::exception& e) {
+    Log::e("world cache: \"",TextCodec::toUtf8(path),"\" is not usable (",e.what(),")");
+    }
+
+  if(!valid) {
+    visual   = PackedMesh();
+    physic   = PackedMesh();
+    landBvh  = Bvh();
+    waterBvh = Bvh();
+    // unmap, so file can be rewritten
+    file.reset();
+    }
+  return valid;
+  }
+
+void WorldCache::save() const {
+  try {
+    if(!FileUtil::createDirectory(cacheDir))
+      throw std::runtime_error("unable to create cache directory");
+    WFile  fout(path);
+    Writer wr{fout};
+    implSave(wr);
+    }
+  catch(...) {
+    Log::e("world cache: unable to write \"",TextCodec::toUtf8(path),"\"");
+    }
+  }
+
+void WorldCache::implLoad(Reader& rd) {
+  char     buf[sizeof(tag)]={};
+  uint32_t ver = 0;
+  uint64_t k   = 0;
+
+  rd.readBytes(buf,sizeof(buf));
+  rd.read(ver);
+  rd.read(k);
+  if(std::memcmp(buf,tag,sizeof(tag))!=0 || ver!=Version)
+    throw std::runtime_error("invalid file format");
+  if(k!=key)
+    throw std::runtime_error("archives are modified");
+
+  read(rd,visual);
+  read(rd,physic);
+  read(rd,landBvh);
+  read(rd,waterBvh);
+  }
+
+void WorldCache::implSave(Writer& wr) const {
+  wr.writeBytes(tag,sizeof(tag));
+  wr.write(uint32_t(Version));
+  wr.write(key);
+
+  write(wr,visual);
+  write(wr,physic);
+  write(wr,landBvh);
+  write(wr,waterBvh);
+  }
+
+void WorldCache::read(Reader& rd, PackedMesh& mesh) {
+  rd.read(mesh.bbox);
+  rd.read(mesh.vertices);
+
+  uint32_t cnt = 0;
+  rd.read(cnt);
+  mesh.subMeshes.resize(cnt);
+  for(auto& i:mesh.subMeshes) {
+    // only fields, that are in use by landscape and physic
+    auto& m = i.material;
+    rd.read(m.matName);
+    rd.read(m.matGroup);
+    rd.read(m.texture);
+    rd.read(m.texAniFPS);
+    rd.read(m.texAniMapMode);
+    rd.read(m.texAniMapDir);
+    rd.read(m.alphaFunc);
+    rd.read(m.noCollDet);
+    rd.read(i.indices);
+    }
+  }
+
+void WorldCache::write(Writer& wr, const PackedMesh& mesh) {
+  wr.write(mesh.bbox);
+  wr.write(mesh.vertices);
+
+  wr.write(uint32_t(mesh.subMeshes.size()));
+  for(auto& i:mesh.subMeshes) {
+    auto& m = i.material;
+    wr.write(m.matName);
+    wr.write(m.matGroup);
+    wr.write(m.texture);
+    wr.write(m.texAniFPS);
+    wr.write(m.texAniMapMode);
+    wr.write(m.texAniMapDir);
+    wr.write(m.alphaFunc);
+    wr.write(m.noCollDet);
+    wr.write(i.indices);
+    }
+  }
+
+void WorldCache::read(Reader& rd, Bvh& bvh) {
+  uint64_t sz = 0;
+  rd.read(sz);
+  rd.align();
+  bvh.size = size_t(sz);
+  bvh.data = sz>0 ? rd.skip(bvh.size) : nullptr;
+  }
+
+void WorldCache::write(Writer& wr, const Bvh& bvh) {
+  const size_t sz = bvh.blob.size()*sizeof(bvh.blob[0]);
+  wr.write(uint64_t(sz));
+  wr.align();
+  wr.writeBytes(bvh.blob.data(),sz);
+  }
+
+std::u16string WorldCache::findLooseFile(const std::u16string& root, const std::u16string& name) {
+  auto lower = [](char16_t c) {
+    return ('A'<=c && c<='Z') ? char16_t(c-'A'+'a') : c;
+    };
+  std::u16string ret;
+  Dir::scan(root,[&](const std::u16string& f, Dir::FileType t){
+    if(!ret.empty())
+      return;
+    if(t==Dir::FT_Dir && f!=u".." && f!=u".") {
+      ret = findLooseFile(root+f+u"/",name);
+      return;
+      }
+    if(t!=Dir::FT_File || f.size()!=name.size())
+      return;
+    for(size_t i=0; i<f.size(); ++i)
+      if(lower(f[i])!=lower(name[i]))
+        return;
+    ret = root+f;
+    });
+  return ret;
+  }
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "graphics/mesh/submesh/packedmesh.h"
+
+class Gothic;
+class MappedFile;
+
+// Baked data of world, that is expensive to derive from zen: packed landscape meshes and collision bvh.
+// Cache is keyed by vdf-archives, zen file and pointer size; stale or broken cache is rebuilt on load.
+// File is memory-mapped: meshes are copied out, bvh is deserialized in place.
+class WorldCache final {
+  public:
+    // bullet requires 16-byte aligned memory for in-place bvh
+    struct alignas(16) Chunk {
+      uint8_t data[16];
+      };
+    using Blob = std::vector<Chunk>;
+
+    struct Bvh {
+      Blob     blob;           // built on this run, written by save()
+      uint8_t* data = nullptr; // in place, inside of mapped file
+      size_t   size = 0;
+      };
+
+    WorldCache(Gothic& gothic, const std::string& world, size_t zenSize);
+    WorldCache(const WorldCache&)=delete;
+    ~WorldCache();
+
+    bool       isValid() const { return valid; }
+    bool       load();
+    void       save() const;
+
+    PackedMesh                  visual;
+    PackedMesh                  physic;
+    Bvh                         landBvh;
+    Bvh                         waterBvh;
+    // keeps in-place bvh alive
+    std::shared_ptr<MappedFile> file;
+
+  private:
+    enum {
+      Version   = 2,
+      Alignment = 16,
+      };
+
+    struct Reader;
+    struct Writer;
+
+    std::u16string path;
+    uint64_t       key   = 0;
+    bool           valid = false;
+
+    void        implLoad(Reader& rd);
+    void        implSave(Writer& wr) const;
+
+    static void read (Reader& rd, PackedMesh& mesh);
+    static void write(Writer& wr, const PackedMesh& mesh);
+    static void read (Reader& rd, Bvh& bvh);
+    static void write(Writer& wr, const Bvh& bvh);
+
+    static std::u16string findLooseFile(const std::u16string& root, const std::u16string& name);
+  };
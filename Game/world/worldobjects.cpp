@@ -12,12 +12,15 @@
 #include "world/objects/interactive.h"
 #include "world/objects/vob.h"
 #include "world.h"
+#include "utils/perfcounters.h"
 #include "utils/workers.h"
 #include "utils/dbgpainter.h"
 
 #include <Tempest/Painter>
 #include <Tempest/Application>
 #include <Tempest/Log>
+#include <algorithm>
+#include <tuple>
 
 using namespace Tempest;
 using namespace Daedalus::GameState;
@@ -57,7 +60,7 @@ WorldObjects::SearchOpt::SearchOpt(float rangeMin, float rangeMax, float azi, Ta
   :rangeMin(rangeMin),rangeMax(rangeMax),azi(azi),collectAlgo(collectAlgo),flags(flags) {
   }
 
-WorldObjects::WorldObjects(World& owner):owner(owner){
+WorldObjects::WorldObjects(World& owner):owner(owner),los(owner){
   npcNear.reserve(512);
   }
 
@@ -69,10 +72,17 @@ void WorldObjects::load(Serialize &fin) {
 
   fin.read(sz);
   npcArr.clear();
+  npcIndex.clear();
+  npcIds.clear();
+  los.clear();
   for(size_t i=0;i<sz;++i)
     npcArr.emplace_back(std::make_unique<Npc>(owner,size_t(-1),nullptr));
-  for(auto& i:npcArr)
+  for(auto& i:npcArr) {
     i->load(fin);
+    npcIndex.add(*i);
+    }
+  npcUnsorted = npcArr.size();
+  sortNpc();
 
   fin.read(sz);
   itemArr.clear();
@@ -123,9 +133,11 @@ void WorldObjects::save(Serialize &fout) {
   fout.write(sz);
   for(auto& i:rootVobs)
     i->saveVobTree(fout);
-  fout.write(uint32_t(triggerEvents.size()));
+  fout.write(uint32_t(triggerEvents.size()+triggerTimers.size()));
   for(auto& i:triggerEvents)
     i.save(fout);
+  for(auto& i:triggerTimers)
+    i.evt.save(fout);
 
   fout.write(uint32_t(routines.size()));
   for(auto& i:routines)
@@ -136,15 +148,30 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
   auto passive=std::move(sndPerc);
   sndPerc.clear();
 
-  std::sort(npcArr.begin(),npcArr.end(),[](std::unique_ptr<Npc>& a, std::unique_ptr<Npc>& b){
-    return a->handle()->id<b->handle()->id;
+  sortNpc();
+  // parallel phase: per-npc animation state, no script or physics access
+  {
+  PerfCounters::Scope perf(PerfCounters::Animation);
+  Workers::parallelFor(npcArr,[](std::unique_ptr<Npc>& i){
+    i->tickAnimation();
     });
+  }
+  // serial phase: AI, scripts, physics and events - in stable npc order
   for(size_t i=0; i<npcArr.size(); ++i) {
     auto& npc = *npcArr[i];
     if(npc.isPlayer())
       npc.tick(dtPlayer); else
       npc.tick(dt);
     }
+  // paths, requested by AI in serial phase, are solved together; npc picks result on next tick
+  {
+  std::vector<WayMatrix::PathRequest*> ways;
+  for(auto& i:npcArr)
+    if(auto r = i->pendingWay())
+      ways.push_back(r);
+  if(!ways.empty())
+    owner.wayTo(ways);
+  }
 
   for(auto& i:routines) {
     auto s = i.stateByTime(owner.time());
@@ -157,8 +184,11 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
   for(auto& i:interactiveObj)
     i->tick(dt);
 
-  for(auto i:triggersTk)
-    i->tick(dt);
+  // backward, so trigger can disable own ticks
+  for(size_t i=triggersTk.size(); i>0; ) {
+    --i;
+    triggersTk[i]->tick(dt);
+    }
 
   bullets.remove_if([](Bullet& b){
     return b.isFinished();
@@ -181,13 +211,15 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
   const float nearDist = 3000*3000;
   const float farDist  = 6000*6000;
 
-  auto plPos = pl->position();
+  auto  plPos    = pl->position();
+  float maxRange = 0;
   for(auto& i:npcArr) {
     float dist = (i->position()-plPos).quadLength();
     if(dist<nearDist){
       npcNear.push_back(i.get());
       if(i.get()!=pl)
         i->setProcessPolicy(Npc::ProcessPolicy::AiNormal);
+      maxRange = std::max(maxRange,float(i->handle()->senses_range));
       } else
     if(dist<farDist) {
       i->setProcessPolicy(Npc::ProcessPolicy::AiFar);
@@ -198,18 +230,110 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
   tickNear(dt);
   tickTriggers(dt);
 
-  for(auto& ptr:npcArr) {
-    Npc& i = *ptr;
+  // (npc id, message id) pairs for passive perception; ordered the same way as full npc x message scan
+  std::vector<std::pair<uint32_t,uint32_t>> percCandidates;
+  for(size_t m=0; m<passive.size(); ++m) {
+    npcIndex.find(passive[m].pos,maxRange,[this,m,&percCandidates](Npc& n){
+      if(n.processPolicy()!=Npc::AiNormal)
+        return;
+      auto id = npcIds.find(&n);
+      if(id!=npcIds.end())
+        percCandidates.emplace_back(id->second,uint32_t(m));
+      });
+    }
+  std::sort(percCandidates.begin(),percCandidates.end());
+  // scripts may add or remove npcs, while perception is processed: candidates are found by npc, not by index
+  std::unordered_map<const Npc*,std::pair<size_t,size_t>> percRange;
+  for(size_t b=0; b<percCandidates.size();) {
+    size_t e = b;
+    while(e<percCandidates.size() && percCandidates[e].first==percCandidates[b].first)
+      ++e;
+    percRange[npcArr[percCandidates[b].first].get()] = std::make_pair(b,e);
+    b = e;
+    }
+
+  // see-checks of this tick, resolved as one batched ray query
+  los.tick();
+  std::vector<std::pair<const Npc*,const Npc*>> losPairs;
+  for(auto& c:percCandidates) {
+    const Npc& i = *npcArr[c.first];
+    auto&      r = passive[c.second];
+    if(r.self==&i || i.isPlayer() || i.isDead() || i.isDown())
+      continue;
+    const float range = float(i.handle()->senses_range);
+    if(i.qDistTo(r.pos.x,r.pos.y,r.pos.z)>=range*range)
+      continue;
+    losPairs.emplace_back(&i,r.other);
+    losPairs.emplace_back(&i,r.victum);
+    }
+  for(Npc* i:npcNear) {
+    if(i==pl || i->isDead() || i->percNextTime()>owner.tickCount())
+      continue;
+    const float range = float(i->handle()->senses_range);
+    if(i->qDistTo(*pl)<range*range)
+      losPairs.emplace_back(i,pl);
+    }
+  los.prefetch(losPairs);
+
+  // rooms for smell/hear checks, resolved in one batched bsp traversal
+  {
+  std::vector<Tempest::Vec3> pos(npcNear.size()*2);
+  std::vector<uint32_t>      room(pos.size());
+  for(size_t i=0; i<npcNear.size(); ++i) {
+    pos[i*2+0] = npcNear[i]->position();
+    pos[i*2+1] = pos[i*2+0]+Tempest::Vec3(0,180,0);
+    }
+  owner.roomAt(pos.data(),room.data(),pos.size());
+  for(size_t i=0; i<npcNear.size(); ++i)
+    npcNear[i]->setRooms(pos[i*2],room[i*2+0],room[i*2+1]);
+  }
+
+  // for each prefix of messages: last one with item and last one with item from another sender,
+  // so last item message, that is not npc's own, is found without rescan
+  std::vector<std::pair<size_t,size_t>> itemBefore(passive.size()+1,std::make_pair(size_t(-1),size_t(-1)));
+  for(size_t m=0; m<passive.size(); ++m) {
+    auto  last = itemBefore[m];
+    auto& r    = passive[m];
+    if(r.item!=size_t(-1) && r.other!=nullptr) {
+      if(last.first!=size_t(-1) && passive[last.first].self!=r.self)
+        last.second = last.first;
+      last.first = m;
+      }
+    itemBefore[m+1] = last;
+    }
+
+  // full scan sets item instance of every (npc,message) pair, even out of range; scripts can see it,
+  // so reproduce same state for each processed message and after each npc
+  const PerceptionMsg* itemMsg = nullptr;
+  auto lastItemMsg = [&passive,&itemBefore](const Npc& i, size_t end) -> const PerceptionMsg* {
+    auto&        last = itemBefore[end];
+    const size_t m    = (last.first!=size_t(-1) && passive[last.first].self==&i) ? last.second : last.first;
+    return m==size_t(-1) ? nullptr : &passive[m];
+    };
+  auto setItemMsg = [this,&itemMsg](const PerceptionMsg* r) {
+    if(r==nullptr || r==itemMsg)
+      return;
+    itemMsg = r;
+    owner.script().setInstanceItem(*r->other,r->item);
+    };
+
+  for(size_t id=0; id<npcArr.size(); ++id) {
+    Npc& i = *npcArr[id];
     if(i.isPlayer() || i.isDead())
       continue;
 
     if(i.processPolicy()==Npc::AiNormal) {
-      for(auto& r:passive) {
+      auto   rg   = percRange.find(&i);
+      size_t cand = 0, end = 0;
+      if(rg!=percRange.end())
+        std::tie(cand,end) = rg->second;
+      for(; cand<end; ++cand) {
+        const size_t m = percCandidates[cand].second;
+        auto&        r = passive[m];
         if(r.self==&i)
           continue;
         float l = i.qDistTo(r.pos.x,r.pos.y,r.pos.z);
-        if(r.item!=size_t(-1) && r.other!=nullptr)
-          owner.script().setInstanceItem(*r.other,r.item);
+        setItemMsg(lastItemMsg(i,m+1));
         const float range = float(i.handle()->senses_range);
         if(l<range*range) {
           // aproximation of behavior of original G2
@@ -218,24 +342,27 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
              i.canSenseNpc(*r.victum,true,float(r.other->handle()->senses_range))!=SensesBit::SENSE_NONE
             ) {
             i.perceptionProcess(*r.other,r.victum,l,Npc::PercType(r.what));
+            itemMsg = nullptr; // script may have changed item instance
             }
           }
         }
+      setItemMsg(lastItemMsg(i,passive.size()));
       }
 
     if(i.percNextTime()>owner.tickCount())
       continue;
     i.perceptionProcess(*pl);
+    itemMsg = nullptr;
     }
   }
 
 uint32_t WorldObjects::npcId(const Npc *ptr) const {
   if(ptr==nullptr)
     return uint32_t(-1);
-  for(size_t i=0;i<npcArr.size();++i)
-    if(npcArr[i].get()==ptr)
-      return uint32_t(i);
-  return uint32_t(-1);
+  auto it = npcIds.find(ptr);
+  if(it==npcIds.end())
+    return uint32_t(-1);
+  return it->second;
   }
 
 uint32_t WorldObjects::itmId(const void *ptr) const {
@@ -274,8 +401,7 @@ Npc *WorldObjects::addNpc(size_t npcInstance, const Daedalus::ZString& at) {
     npc->updateTransform();
     }
 
-  npcArr.emplace_back(npc);
-  return npc;
+  return addNpc(std::unique_ptr<Npc>(npc));
   }
 
 Npc* WorldObjects::addNpc(size_t npcInstance, const Vec3& pos) {
@@ -284,8 +410,17 @@ Npc* WorldObjects::addNpc(size_t npcInstance, const Vec3& pos) {
   //npc->setDirection (pos->dirX,pos->dirY,pos->dirZ);
   npc->updateTransform();
 
-  npcArr.emplace_back(npc);
-  return npc;
+  return addNpc(std::unique_ptr<Npc>(npc));
+  }
+
+Npc* WorldObjects::addNpc(std::unique_ptr<Npc>&& npc) {
+  // NOTE: can be called from script, while npc's are ticking - append now, merge in sortNpc
+  npcArr.emplace_back(std::move(npc));
+  auto ret = npcArr.back().get();
+  npcIndex.add(*ret);
+  npcIds[ret] = uint32_t(npcArr.size()-1);
+  npcUnsorted++;
+  return ret;
   }
 
 Npc* WorldObjects::insertPlayer(std::unique_ptr<Npc> &&npc, const Daedalus::ZString& at) {
@@ -306,79 +441,126 @@ Npc* WorldObjects::insertPlayer(std::unique_ptr<Npc> &&npc, const Daedalus::ZStr
     npc->attachToPoint(pos);
     npc->updateTransform();
     }
-  npcArr.emplace_back(std::move(npc));
-  return npcArr.back().get();
+  return addNpc(std::move(npc));
   }
 
 std::unique_ptr<Npc> WorldObjects::takeNpc(const Npc* ptr) {
-  for(size_t i=0; i<npcArr.size(); ++i){
-    auto& npc=*npcArr[i];
-    if(&npc==ptr){
-      auto ret=std::move(npcArr[i]);
-      npcArr[i] = std::move(npcArr.back());
-      npcArr.pop_back();
-      return ret;
-      }
-    }
-  return nullptr;
+  auto it = npcIds.find(ptr);
+  if(it==npcIds.end())
+    return nullptr;
+  const size_t i = it->second;
+  npcIds.erase(it);
+  npcIndex.del(*ptr);
+  los.remove(*ptr);
+
+  auto ret=std::move(npcArr[i]);
+  npcArr.erase(npcArr.begin()+int(i));
+  if(i+npcUnsorted>npcArr.size())
+    npcUnsorted--;
+  updateNpcIds(i);
+  return ret;
+  }
+
+void WorldObjects::onNpcMove(Npc& npc) {
+  npcIndex.update(npc);
+  }
+
+bool WorldObjects::lineOfSight(const Npc& from, const Npc& to) {
+  return los.lineOfSight(from,to);
+  }
+
+void WorldObjects::updateNpcIds(size_t from) {
+  for(size_t i=from; i<npcArr.size(); ++i)
+    npcIds[npcArr[i].get()] = uint32_t(i);
+  }
+
+void WorldObjects::sortNpc() {
+  // npcArr is kept ordered by script id; only npc's inserted since last tick have to be merged in
+  if(npcUnsorted==0)
+    return;
+  auto byId = [](const std::unique_ptr<Npc>& a, const std::unique_ptr<Npc>& b){
+    return a->handle()->id<b->handle()->id;
+    };
+  const auto mid = npcArr.end()-int(npcUnsorted);
+  std::stable_sort(mid,npcArr.end(),byId);
+  std::inplace_merge(npcArr.begin(),mid,npcArr.end(),byId);
+  updateNpcIds(0);
+  npcUnsorted = 0;
   }
 
 void WorldObjects::tickNear(uint64_t /*dt*/) {
   for(Npc* i:npcNear) {
-    auto pos=i->position();
-    for(AbstractTrigger* t:triggersZn)
-      if(t->checkPos(pos.x,pos.y+i->translateY(),pos.z))
-        t->onIntersect(*i);
+    auto pos = i->position();
+    pos.y += i->translateY();
+    triggersZn.find(pos,[i,&pos](AbstractTrigger& t){
+      if(t.checkPos(pos.x,pos.y,pos.z))
+        t.onIntersect(*i);
+      });
     }
   }
 
 void WorldObjects::tickTriggers(uint64_t /*dt*/) {
-  auto evt = std::move(triggerEvents);
-  triggerEvents.clear();
+  const uint64_t time = owner.tickCount();
+  while(triggerTimers.size()>0 && triggerTimers.front().evt.timeBarrier<=time) {
+    std::pop_heap(triggerTimers.begin(),triggerTimers.end());
+    triggerEvents.emplace_back(std::move(triggerTimers.back().evt));
+    triggerTimers.pop_back();
+    }
 
-  for(auto& e:evt) {
+  std::swap(triggerEvents,triggerEventsExec);
+  for(auto& e:triggerEventsExec) {
     execTriggerEvent(e);
     }
+  triggerEventsExec.clear();
   }
 
 void WorldObjects::triggerEvent(const TriggerEvent &e) {
-  triggerEvents.push_back(e);
+  if(e.timeBarrier<=owner.tickCount()) {
+    triggerEvents.push_back(e);
+    return;
+    }
+  TimedEvent t;
+  t.evt = e;
+  t.seq = triggerTimerSeq++;
+  triggerTimers.emplace_back(std::move(t));
+  std::push_heap(triggerTimers.begin(),triggerTimers.end());
   }
 
 void WorldObjects::execTriggerEvent(const TriggerEvent& e) {
   if(e.timeBarrier>owner.tickCount()) {
-    triggerEvent(std::move(e));
+    triggerEvent(e);
     return;
     }
 
-  bool emitted=false;
-  for(auto& i:triggers) {
-    auto& t = *i;
-    if(t.name()==e.target) { // NOTE: trigger name is not unique - more then one trigger can be activated
-      t.processEvent(e);
-      emitted=true;
-      }
-    }
-  if(!emitted)
+  // NOTE: trigger name is not unique - more then one trigger can be activated
+  auto it = triggersByName.find(names.find(e.target));
+  if(it==triggersByName.end()) {
     Log::d("unable to process trigger: \"",e.target,"\"");
+    return;
+    }
+  for(auto t:it->second)
+    t->processEvent(e);
   }
 
 void WorldObjects::updateAnimation() {
+  Workers::TaskGroup mobsi;
+  mobsi.run([this](){
+    interactiveObj.parallelFor([](Interactive& i){
+      i.updateAnimation();
+      });
+    });
   Workers::parallelFor(npcArr,[](std::unique_ptr<Npc>& i){
     i->updateAnimation();
     });
-  interactiveObj.parallelFor([](Interactive& i){
-    i.updateAnimation();
-    });
+  mobsi.wait();
   }
 
 bool WorldObjects::isTargeted(Npc& dst) {
-  std::atomic_flag flg = ATOMIC_FLAG_INIT;
-  Workers::parallelFor(npcArr,[&dst,&flg](std::unique_ptr<Npc>& i) {
+  // few compares per npc: cheaper, than dispatching it to workers
+  for(auto& i:npcArr)
     if(isTargetedBy(*i,dst))
-      flg.test_and_set();
-    });
-  return flg.test_and_set();
+      return true;
+  return false;
   }
 
 bool WorldObjects::isTargetedBy(Npc& npc, Npc& dst) {
@@ -400,10 +582,20 @@ Npc *WorldObjects::findHero() {
   }
 
 Npc *WorldObjects::findNpcByInstance(size_t instance) {
-  for(auto& i:npcArr)
-    if(i->handle()->instanceSymbol==instance)
-      return i.get();
-  return nullptr;
+  // first one in npcArr order, same as plain scan would return
+  auto   all = npcIndex.findByInstance(instance);
+  Npc*   ret = nullptr;
+  size_t id  = size_t(-1);
+  if(all==nullptr)
+    return nullptr;
+  for(auto i:*all) {
+    size_t iid = npcId(i);
+    if(iid<id) {
+      id  = iid;
+      ret = i;
+      }
+    }
+  return ret;
   }
 
 void WorldObjects::detectNpcNear(const std::function<void(Npc&)>& f) {
@@ -413,28 +605,39 @@ void WorldObjects::detectNpcNear(const std::function<void(Npc&)>& f) {
 
 void WorldObjects::detectNpc(const float x, const float y, const float z,
                              const float r, const std::function<void(Npc&)>& f) {
-  float maxDist=r*r;
-  for(auto& i:npcArr) {
-    auto qDist = (i->position()-Vec3(x,y,z)).quadLength();
+  const Vec3  pos     = Vec3(x,y,z);
+  const float maxDist = r*r;
+  // scripts may depend on order of detection: report in npcArr order, as plain scan does
+  std::vector<std::pair<uint32_t,Npc*>> found;
+  npcIndex.find(pos,r,[this,&pos,maxDist,&found](Npc& i){
+    auto qDist = (i.position()-pos).quadLength();
     if(qDist<maxDist)
-      f(*i);
+      found.emplace_back(npcId(&i),&i);
+    });
+  std::sort(found.begin(),found.end());
+  for(auto& i:found) {
+    // callback can remove npc
+    if(npcIndex.hasObject(i.second))
+      f(*i.second);
     }
   }
 
 void WorldObjects::detectItem(const float x, const float y, const float z,
                               const float r, const std::function<void(Item&)>& f) {
-  float maxDist=r*r;
-  for(auto& i:itemArr) {
-    auto qDist = (i->position()-Vec3(x,y,z)).quadLength();
+  const Vec3  pos     = Vec3(x,y,z);
+  const float maxDist = r*r;
+  items.find(pos,r,[&pos,maxDist,&f](Item& i){
+    auto qDist = (i.position()-pos).quadLength();
     if(qDist<maxDist)
-      f(*i);
-    }
+      f(i);
+    });
   }
 
 void WorldObjects::addTrigger(AbstractTrigger* tg) {
   if(tg->hasVolume())
-    triggersZn.emplace_back(tg);
+    triggersZn.add(*tg);
   triggers.emplace_back(tg);
+  triggersByName[tg->nameTag()].push_back(tg);
   }
 
 void WorldObjects::triggerOnStart(bool firstTime) {
@@ -444,19 +647,22 @@ void WorldObjects::triggerOnStart(bool firstTime) {
   }
 
 void WorldObjects::enableTicks(AbstractTrigger& t) {
-  for(auto& i:triggersTk)
-    if(i==&t)
-      return;
+  if(triggersTkId.find(&t)!=triggersTkId.end())
+    return;
+  triggersTkId[&t] = triggersTk.size();
   triggersTk.push_back(&t);
   }
 
 void WorldObjects::disableTicks(AbstractTrigger& t) {
-  for(auto& i:triggersTk)
-    if(i==&t) {
-      i = triggersTk.back();
-      triggersTk.pop_back();
-      return;
-      }
+  auto it = triggersTkId.find(&t);
+  if(it==triggersTkId.end())
+    return;
+  const size_t id = it->second;
+  triggersTkId.erase(it);
+  triggersTk[id] = triggersTk.back();
+  triggersTk.pop_back();
+  if(id<triggersTk.size())
+    triggersTkId[triggersTk[id]] = id;
   }
 
 void WorldObjects::runEffect(Effect&& ex) {
@@ -557,22 +763,12 @@ void WorldObjects::addRoot(ZenLoad::zCVobData&& vob, bool startup) {
   rootVobs.emplace_back(std::move(p));
   }
 
-void WorldObjects::invalidateVobIndex() {
-  items.invalidate();
-  interactiveObj.invalidate();
-  }
-
 Interactive* WorldObjects::validateInteractive(Interactive *def) {
   return interactiveObj.hasObject(def) ? def : nullptr;
   }
 
 Npc *WorldObjects::validateNpc(Npc *def) {
-  if(def==nullptr)
-    return nullptr;
-  for(auto& i:npcArr)
-    if(i.get()==def)
-      return def;
-  return nullptr;
+  return npcIndex.hasObject(def) ? def : nullptr;
   }
 
 Item *WorldObjects::validateItem(Item *def) {
@@ -733,8 +929,13 @@ void WorldObjects::resetPositionToTA() {
     if(n.resetPositionToTA()){
       ++i;
       } else {
+      npcIndex.del(n);
+      npcIds.erase(&n);
+      los.remove(n);
       npcInvalid.emplace_back(std::move(npcArr[i]));
       npcArr.erase(npcArr.begin()+int(i));
+      if(i+npcUnsorted>npcArr.size())
+        npcUnsorted--;
 
       auto& npc = *npcInvalid.back();
       npc.attachToPoint(nullptr);
@@ -742,6 +943,7 @@ void WorldObjects::resetPositionToTA() {
       npc.updateTransform();
       }
     }
+  updateNpcIds(0);
   for(auto& i:interactiveObj) {
     i->resetPositionToTA();
     }
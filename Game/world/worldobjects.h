@@ -2,14 +2,21 @@
 
 #include <vector>
 #include <memory>
+#include <functional>
+#include <unordered_map>
 
 #include <daedalus/DaedalusGameState.h>
 
 #include "bullet.h"
 #include "spaceindex.h"
+#include "npcindex.h"
+#include "loscache.h"
+#include "triggerindex.h"
+#include "triggers/abstracttrigger.h"
 #include "game/gametime.h"
 #include "game/perceptionmsg.h"
 #include "game/constants.h"
+#include "utils/nameinterner.h"
 
 class Npc;
 class Item;
@@ -18,8 +25,6 @@ class StaticObj;
 class Interactive;
 class World;
 class Serialize;
-class TriggerEvent;
-class AbstractTrigger;
 
 class WorldObjects final {
   public:
@@ -52,6 +57,8 @@ class WorldObjects final {
     Npc*           addNpc(size_t itemInstance, const Tempest::Vec3&     at);
     Npc*           insertPlayer(std::unique_ptr<Npc>&& npc, const Daedalus::ZString& waypoint);
     auto           takeNpc(const Npc* npc) -> std::unique_ptr<Npc>;
+    void           onNpcMove(Npc& npc);
+    bool           lineOfSight(const Npc& from, const Npc& to);
 
     void           updateAnimation();
 
@@ -76,6 +83,8 @@ class WorldObjects final {
     uint32_t       mobsiId(const void* ptr) const;
 
     void           addTrigger(AbstractTrigger* trigger);
+    const char*    internName(const std::string& name) { return names.intern(name); }
+    void           triggerMoved(AbstractTrigger&) { triggersZn.invalidate(); }
     void           triggerEvent(const TriggerEvent& e);
     void           execTriggerEvent(const TriggerEvent& e);
     void           triggerOnStart(bool firstTime);
@@ -96,7 +105,6 @@ class WorldObjects final {
     void           addInteractive(Interactive*         obj);
     void           addStatic     (StaticObj*           obj);
     void           addRoot       (ZenLoad::zCVobData&& vob, bool startup);
-    void           invalidateVobIndex();
 
     Interactive*   validateInteractive(Interactive *def);
     Npc*           validateNpc        (Npc         *def);
@@ -135,6 +143,17 @@ class WorldObjects final {
       uint64_t timeUntil = 0;
       };
 
+    struct TimedEvent {
+      TriggerEvent evt;
+      uint64_t     seq = 0;
+      // inverted: std heap functions keep the earliest event at front
+      bool operator < (const TimedEvent& other) const {
+        if(evt.timeBarrier!=other.evt.timeBarrier)
+          return evt.timeBarrier>other.evt.timeBarrier;
+        return seq>other.seq;
+        }
+      };
+
     World&                             owner;
     std::vector<std::unique_ptr<Vob>>  rootVobs;
 
@@ -151,13 +170,22 @@ class WorldObjects final {
     std::vector<std::unique_ptr<Npc>>  npcArr;
     std::vector<std::unique_ptr<Npc>>  npcInvalid;
     std::vector<Npc*>                  npcNear;
+    size_t                             npcUnsorted = 0;
+    NpcIndex                           npcIndex;
+    std::unordered_map<const Npc*,uint32_t> npcIds;
+    LosCache                           los;
 
     std::vector<AbstractTrigger*>      triggers;
-    std::vector<AbstractTrigger*>      triggersZn;
+    TriggerIndex                       triggersZn;
     std::vector<AbstractTrigger*>      triggersTk;
+    std::unordered_map<const AbstractTrigger*,size_t> triggersTkId;
+    std::unordered_map<const char*,std::vector<AbstractTrigger*>> triggersByName; // by interned name
+    NameInterner                       names;
 
     std::vector<PerceptionMsg>         sndPerc;
-    std::vector<TriggerEvent>          triggerEvents;
+    std::vector<TriggerEvent>          triggerEvents, triggerEventsExec;
+    std::vector<TimedEvent>            triggerTimers; // min-heap by time
+    uint64_t                           triggerTimerSeq = 0;
 
     template<class T>
     auto findObj(T &src, const Npc &pl, const SearchOpt& opt) -> typename std::remove_reference<decltype(src[0])>::type*;
@@ -168,6 +196,9 @@ class WorldObjects final {
     bool testObj(T &src, const Npc &pl, const SearchOpt& opt, float& rlen);
 
     void             setMobState(const char* scheme, int32_t st);
+    Npc*             addNpc(std::unique_ptr<Npc>&& npc);
+    void             updateNpcIds(size_t from);
+    void             sortNpc();
 
     void             tickNear(uint64_t dt);
     void             tickTriggers(uint64_t dt);
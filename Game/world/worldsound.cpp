@@ -2,6 +2,8 @@
 
 #include <Tempest/SoundEffect>
 
+#include <algorithm>
+
 #include "game/gamesession.h"
 #include "world/objects/npc.h"
 #include "world/objects/sound.h"
@@ -11,8 +13,11 @@
 #include "gothic.h"
 #include "resources.h"
 
-const float WorldSound::maxDist   = 3500; // 35 meters
-const float WorldSound::talkRange = 800;
+const float    WorldSound::maxDist          = 3500; // 35 meters
+const float    WorldSound::talkRange        = 800;
+const float    WorldSound::musicPreloadDist = 6000; // zones are checked every 5 sec: enough, to load theme before player runs in
+const float    WorldSound::occMoveThreshold = 50;
+const uint64_t WorldSound::occSmoothTime    = 150;
 
 struct WorldSound::WSound final {
   Sound          current;
@@ -35,12 +40,27 @@ struct WorldSound::WSound final {
 struct WorldSound::Zone final {
   ZMath::float3 bbox[2]={};
   std::string   name;
+  bool          preloaded = false;
+  uint8_t       kept      = 0; // themes, that are kept in music cache: bit per (day,mode)
+
   bool          checkPos(float x,float y,float z) const {
     return
         bbox[0].x <= x && x<bbox[1].x &&
         bbox[0].y <= y && y<bbox[1].y &&
         bbox[0].z <= z && z<bbox[1].z;
     }
+  float         quadDist(float x,float y,float z) const {
+    float dx = std::max(0.f,std::max(bbox[0].x-x,x-bbox[1].x));
+    float dy = std::max(0.f,std::max(bbox[0].y-y,y-bbox[1].y));
+    float dz = std::max(0.f,std::max(bbox[0].z-z,z-bbox[1].z));
+    return dx*dx+dy*dy+dz*dz;
+    }
+  const char*   tag() const {
+    const size_t sep = name.find('_');
+    if(sep!=std::string::npos)
+      return name.c_str()+sep+1;
+    return name.c_str();
+    }
   };
 
 void WorldSound::Effect::setOcclusion(float v) {
@@ -60,6 +80,10 @@ WorldSound::WorldSound(Gothic& gothic, GameSession &game, World& owner)
   }
 
 WorldSound::~WorldSound() {
+  if(def!=nullptr)
+    releaseMusic(*def);
+  for(auto& zn:zones)
+    releaseMusic(zn);
   }
 
 void WorldSound::setDefaultZone(const ZenLoad::zCVobData &vob) {
@@ -157,6 +181,7 @@ void WorldSound::tick(Npc &player) {
   tickSlot(effect3d);
   for(auto& i:freeSlot)
     tickSlot(*i.second);
+  updateOcclusion();
 
   for(auto& i:worldEff) {
     if(!i.active || !i.current.isFinished())
@@ -202,6 +227,8 @@ void WorldSound::tickSoundZone(Npc& player) {
     return;
   nextSoundUpdate = owner.tickCount()+5*1000;
 
+  preloadMusic(plPos.x,plPos.y+player.translateY(),plPos.z);
+
   Zone* zone = def.get();
   if(currentZone!=nullptr &&
      currentZone->checkPos(plPos.x,plPos.y+player.translateY(),plPos.z)){
@@ -242,17 +269,55 @@ void WorldSound::tickSoundZone(Npc& player) {
   for(auto zone:zTry)
     for(auto day:dayTry)
       for(auto mode:modeTry) {
-        const size_t sep = zone->name.find('_');
-        const char*  tag = zone->name.c_str();
-        if(sep!=std::string::npos)
-          tag = tag+sep+1;
-
         tags = GameMusic::mkTags(day,mode);
-        if(setMusic(tag,tags))
+        if(setMusic(zone->tag(),tags))
           return;
         }
   }
 
+void WorldSound::preloadMusic(float x, float y, float z) {
+  if(def!=nullptr)
+    preloadMusic(*def);
+  for(auto& zn:zones) {
+    if(zn.quadDist(x,y,z)<musicPreloadDist*musicPreloadDist)
+      preloadMusic(zn); else
+      releaseMusic(zn); // out of range: cache may evict themes of this zone
+    }
+  }
+
+void WorldSound::preloadMusic(Zone& zn) {
+  if(zn.preloaded)
+    return;
+  // cache can be full of themes of zones in range: rest is preloaded on next pass
+  bool    all = true;
+  uint8_t bit = 1;
+  for(auto day:{GameMusic::Day,GameMusic::Ngt})
+    for(auto mode:{GameMusic::Std,GameMusic::Fgt,GameMusic::Thr}) {
+      auto* theme = (zn.kept & bit)==0 ? musicDef(zn.tag(),GameMusic::mkTags(day,mode)) : nullptr;
+      if(theme!=nullptr) {
+        if(GameMusic::inst().preload(*theme))
+          zn.kept |= bit; else
+          all = false;
+        }
+      bit = uint8_t(bit<<1);
+      }
+  zn.preloaded = all;
+  }
+
+void WorldSound::releaseMusic(Zone& zn) {
+  uint8_t bit = 1;
+  for(auto day:{GameMusic::Day,GameMusic::Ngt})
+    for(auto mode:{GameMusic::Std,GameMusic::Fgt,GameMusic::Thr}) {
+      if((zn.kept & bit)!=0) {
+        if(auto* theme = musicDef(zn.tag(),GameMusic::mkTags(day,mode)))
+          GameMusic::inst().release(*theme);
+        }
+      bit = uint8_t(bit<<1);
+      }
+  zn.kept      = 0;
+  zn.preloaded = false;
+  }
+
 void WorldSound::tickSlot(std::vector<PEffect>& effect) {
   for(size_t i=0;i<effect.size();) {
     auto& e = *effect[i];
@@ -274,25 +339,78 @@ void WorldSound::tickSlot(Effect& slot) {
       return;
     slot.eff.play();
     }
+  occQueue.push_back(&slot);
+  }
 
-  if(slot.ambient) {
-    slot.setOcclusion(1.f);
-    } else {
-    auto  dyn = owner.physic();
-    auto  pos = slot.pos;
-    float occ = dyn->soundOclusion(plPos.x,plPos.y+180/*head pos*/,plPos.z, pos.x,pos.y,pos.z);
-    slot.setOcclusion(std::max(0.f,1.f-occ));
+void WorldSound::initSlot(WorldSound::Effect& slot) {
+  auto  dyn  = owner.physic();
+  auto  head = headPos();
+  auto  pos  = slot.pos;
+  float occ  = dyn->soundOclusion(head.x,head.y,head.z, pos.x,pos.y,pos.z);
+  slot.occTarget = std::max(0.f,1.f-occ);
+  slot.occFrom   = head;
+  slot.occTo     = pos;
+  slot.occValid  = true;
+  slot.setOcclusion(slot.occTarget);
+  }
+
+void WorldSound::updateOcclusion() {
+  const uint64_t now = owner.tickCount();
+  const float    k    = std::min(1.f,float(now-occTime)/float(occSmoothTime));
+  const float    th   = occMoveThreshold*occMoveThreshold;
+  const auto     head = headPos();
+  occTime = now;
+
+  // only effects with moved listener or emitter are traced - all together, in one batch
+  occSlots.clear();
+  occRays.clear();
+  for(auto i:occQueue) {
+    if(i->ambient)
+      continue;
+    if(i->occValid && (i->occFrom-head).quadLength()<th && (i->occTo-i->pos).quadLength()<th)
+      continue;
+    DynamicWorld::RaySegment r;
+    r.from = head;
+    r.to   = i->pos;
+    occSlots.push_back(i);
+    occRays.push_back(r);
     }
+
+  if(!occRays.empty()) {
+    occHits.resize(occRays.size());
+    owner.physic()->soundOclusion(occRays.data(),occHits.data(),occRays.size());
+    for(size_t i=0; i<occSlots.size(); ++i) {
+      auto& slot = *occSlots[i];
+      slot.occTarget = std::max(0.f,1.f-occHits[i]);
+      slot.occFrom   = occRays[i].from;
+      slot.occTo     = occRays[i].to;
+      if(!slot.occValid)
+        slot.setOcclusion(slot.occTarget); // no fade-in for a fresh effect
+      slot.occValid  = true;
+      }
+    }
+
+  for(auto i:occQueue) {
+    if(i->ambient)
+      i->setOcclusion(1.f); else
+      i->setOcclusion(i->occ + (i->occTarget-i->occ)*k);
+    }
+  occQueue.clear();
   }
 
-void WorldSound::initSlot(WorldSound::Effect& slot) {
-  auto  dyn = owner.physic();
-  auto  pos = slot.pos;
-  float occ = dyn->soundOclusion(plPos.x,plPos.y+180/*head pos*/,plPos.z, pos.x,pos.y,pos.z);
-  slot.setOcclusion(std::max(0.f,1.f-occ));
+Tempest::Vec3 WorldSound::headPos() const {
+  return {plPos.x,plPos.y+180,plPos.z};
   }
 
 bool WorldSound::setMusic(const char* zone, GameMusic::Tags tags) {
+  if(auto* theme = musicDef(zone,tags)) {
+    GameMusic::inst().setMusic(*theme,tags);
+    return true;
+    }
+  return false;
+  }
+
+auto WorldSound::musicDef(const char* zone, GameMusic::Tags tags) const -> const Daedalus::GEngineClasses::C_MusicTheme* {
   bool        isDay = (tags&GameMusic::Ngt)==0;
   const char* smode = "STD";
   if(tags&GameMusic::Thr)
@@ -302,12 +420,7 @@ bool WorldSound::setMusic(const char* zone, GameMusic::Tags tags) {
 
   char name[64]={};
   std::snprintf(name,sizeof(name),"%s_%s_%s",zone,(isDay ? "DAY" : "NGT"),smode);
-
-  if(auto* theme = gothic.getMusicDef(name)) {
-    GameMusic::inst().setMusic(*theme,tags);
-    return true;
-    }
-  return false;
+  return gothic.getMusicDef(name);
   }
 
 bool WorldSound::isInListenerRange(const Tempest::Vec3& pos, float sndRgn) const {
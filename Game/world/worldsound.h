@@ -8,6 +8,7 @@
 #include <mutex>
 
 #include "game/gametime.h"
+#include "physics/dynamicworld.h"
 #include "gamemusic.h"
 
 class GameSession;
@@ -48,6 +49,11 @@ class WorldSound final {
       bool                 active  = true;
       bool                 ambient = false;
 
+      // last occlusion query: effect fades towards occTarget, until listener or emitter moves
+      float                occTarget = 1.f;
+      Tempest::Vec3        occFrom, occTo;
+      bool                 occValid  = false;
+
       void setOcclusion(float occ);
       void setVolume(float v);
       };
@@ -58,7 +64,13 @@ class WorldSound final {
     void    tickSlot(std::vector<PEffect>& eff);
     void    tickSlot(Effect& slot);
     void    initSlot(Effect& slot);
+    void    updateOcclusion();
+    auto    headPos() const -> Tempest::Vec3;
     bool    setMusic(const char* zone, GameMusic::Tags tags);
+    auto    musicDef(const char* zone, GameMusic::Tags tags) const -> const Daedalus::GEngineClasses::C_MusicTheme*;
+    void    preloadMusic(float x, float y, float z);
+    void    preloadMusic(Zone& z);
+    void    releaseMusic(Zone& z);
 
     Sound   implAddSound(const SoundFx& s, float x, float y, float z, float rangeRef, float rangeMax);
     Sound   implAddSound(Tempest::SoundEffect&& s, float x, float y, float z, float rangeRef, float rangeMax);
@@ -81,9 +93,18 @@ class WorldSound final {
     std::vector<PEffect>                    effect3d; // snd_play3d
     std::vector<WSound>                     worldEff;
 
+    uint64_t                                occTime = 0;
+    std::vector<Effect*>                    occQueue;
+    std::vector<Effect*>                    occSlots;
+    std::vector<DynamicWorld::RaySegment>   occRays;
+    std::vector<float>                      occHits;
+
     std::mutex                              sync;
 
-    static const float maxDist;
+    static const float    maxDist;
+    static const float    musicPreloadDist;
+    static const float    occMoveThreshold;
+    static const uint64_t occSmoothTime;
 
   friend class Sound;
   };
@@ -0,0 +1,175 @@
+// AnimSamples: compression error bound and simd mix against scalar reference
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "graphics/mesh/animsamples.h"
+#include "graphics/mesh/animmath.h"
+#include "testing.h"
+
+using namespace Tempest;
+
+static ZMath::float4 axisAngle(float ax, float ay, float az, float angle) {
+  const float l = std::sqrt(ax*ax+ay*ay+az*az);
+  const float s = std::sin(angle*0.5f)/l;
+  ZMath::float4 q;
+  q.x = ax*s;
+  q.y = ay*s;
+  q.z = az*s;
+  q.w = std::cos(angle*0.5f);
+  return q;
+  }
+
+// mix of smooth, constant, noisy and stepping tracks; node count is not multiple of simd width
+static std::vector<ZenLoad::zCModelAniSample> makeAnimation(size_t nodes, size_t frames, uint32_t seed) {
+  std::mt19937                          rnd(seed);
+  std::uniform_real_distribution<float> u(-1.f,1.f);
+
+  std::vector<ZenLoad::zCModelAniSample> ret(nodes*frames);
+  for(size_t n=0; n<nodes; ++n) {
+    const float ax = u(rnd), ay = u(rnd), az = u(rnd)+2.f;
+    const float sp = 0.02f+0.1f*std::abs(u(rnd));
+    for(size_t f=0; f<frames; ++f) {
+      auto&       s = ret[f*nodes+n];
+      const float t = float(f);
+      switch(n%4) {
+        case 0:
+          s.rotation   = axisAngle(ax,ay,az,std::sin(t*sp)*3.f);
+          s.position.x = std::sin(t*sp)*100.f;
+          s.position.y = 50.f;
+          s.position.z = t*2.f;
+          break;
+        case 1:
+          s.rotation   = axisAngle(ax,ay,az,0.7f);
+          s.position.x = 10.f;
+          s.position.y = 20.f;
+          s.position.z = 30.f;
+          break;
+        case 2:
+          s.rotation   = axisAngle(ax+u(rnd)*0.1f,ay,az,u(rnd)*3.1f);
+          s.position.x = u(rnd)*500.f;
+          s.position.y = u(rnd)*500.f;
+          s.position.z = u(rnd)*500.f;
+          break;
+        case 3:
+          s.rotation   = axisAngle(ax,ay,az,(f/16)%2 ? 2.5f : -2.5f);
+          s.position.x = float((f/8)%3)*40.f;
+          s.position.y = -t;
+          s.position.z = 0.f;
+          break;
+        }
+      }
+    }
+  return ret;
+  }
+
+static void testErrorBound(const std::vector<ZenLoad::zCModelAniSample>& src, size_t nodes) {
+  auto& tol = AnimSamples::tolerance();
+  // float rounding in reconstruction
+  const float eps = 1e-5f;
+
+  AnimSamples packed;
+  packed.assign(src,nodes);
+  CHECK(packed.frameCount()==src.size()/nodes,"frame count %u",uint32_t(packed.frameCount()));
+  CHECK(packed.keyCount()<src.size()*2,"no key reduction: %u keys",uint32_t(packed.keyCount()));
+
+  float rotErr = 0, posErr = 0;
+  for(size_t f=0; f<packed.frameCount(); ++f)
+    for(size_t n=0; n<nodes; ++n) {
+      auto& a = src[f*nodes+n];
+      auto  b = packed.at(f,n);
+
+      const float s  = (a.rotation.x*b.rotation.x + a.rotation.y*b.rotation.y +
+                        a.rotation.z*b.rotation.z + a.rotation.w*b.rotation.w)<0 ? -1.f : 1.f;
+      const float er = std::max(std::max(std::abs(a.rotation.x-b.rotation.x*s),std::abs(a.rotation.y-b.rotation.y*s)),
+                                std::max(std::abs(a.rotation.z-b.rotation.z*s),std::abs(a.rotation.w-b.rotation.w*s)));
+      const float ep = std::max(std::abs(a.position.x-b.position.x),
+                                std::max(std::abs(a.position.y-b.position.y),std::abs(a.position.z-b.position.z)));
+      rotErr = std::max(rotErr,er);
+      posErr = std::max(posErr,ep);
+      }
+  CHECK(rotErr<=tol.rotation+eps,"rotation error %g exceeds tolerance %g",double(rotErr),double(tol.rotation));
+  CHECK(posErr<=tol.position+eps,"position error %g exceeds tolerance %g",double(posErr),double(tol.position));
+  }
+
+static float maxDiff(const Matrix4x4& a, const Matrix4x4& b) {
+  float ret = 0;
+  for(int x=0; x<4; ++x)
+    for(int y=0; y<4; ++y)
+      ret = std::max(ret,std::abs(a.at(x,y)-b.at(x,y)));
+  return ret;
+  }
+
+static void testMix(const std::vector<ZenLoad::zCModelAniSample>& src, size_t nodes) {
+  AnimSamples packed;
+  packed.assign(src,nodes);
+  const size_t frames = packed.frameCount();
+
+  // reversed out-node order and few skipped nodes
+  std::vector<uint32_t> index(nodes);
+  std::vector<uint8_t>  skip(nodes);
+  for(size_t i=0; i<nodes; ++i) {
+    index[i] = uint32_t(nodes-1-i);
+    skip [i] = (i%5==3) ? 1 : 0;
+    }
+
+  const float           sentinel = 12345.f;
+  std::vector<Matrix4x4> out(nodes);
+  AnimSamples::Cursor   cursor;
+  std::mt19937          rnd(7);
+
+  auto run = [&](size_t fa, size_t fb, float a, bool useSkip) {
+    for(auto& m:out)
+      m = Matrix4x4(std::vector<float>(16,sentinel).data());
+    packed.mix(fa,fb,a,index.data(),useSkip ? skip.data() : nullptr,out.data(),&cursor);
+
+    for(size_t i=0; i<nodes; ++i) {
+      const uint32_t id = index[i];
+      if(useSkip && skip[id]) {
+        CHECK(out[id].at(0,0)==sentinel,"skipped node %u is written",id);
+        continue;
+        }
+      const Matrix4x4 ref = mkMatrix(mix(packed.at(fa,i),packed.at(fb,i),a));
+      const float     d   = maxDiff(out[id],ref);
+      CHECK(d<1e-4f,"mix(%u,%u,%g) node %u differs from scalar by %g",
+            uint32_t(fa),uint32_t(fb),double(a),uint32_t(i),double(d));
+      }
+    };
+
+  // forward, looped playback: cursor advances
+  for(size_t f=0; f<frames*2; ++f)
+    run(f%frames,(f+1)%frames,0.25f,false);
+  // reversed playback
+  for(size_t f=frames; f>0; --f)
+    run(f-1,f>1 ? f-2 : 0,0.5f,true);
+  // random access: cursor falls back to search
+  std::uniform_int_distribution<size_t> rf(0,frames-1);
+  std::uniform_real_distribution<float> ra(0.f,1.f);
+  for(int i=0; i<200; ++i)
+    run(rf(rnd),rf(rnd),ra(rnd),i%2==0);
+  // out of range frame is clamped
+  run(frames+10,frames+11,0.5f,false);
+  }
+
+int main() {
+  const size_t nodeCount[] = {1, 4, 7, 13};
+  uint32_t     seed        = 1;
+  for(auto nodes:nodeCount) {
+    auto src = makeAnimation(nodes,150,seed++);
+    testErrorBound(src,nodes);
+    testMix(src,nodes);
+    }
+
+  // tighter bound keeps more keys, but must hold as well
+  AnimSamples::Tolerance tol;
+  tol.rotation = 0.0001f;
+  tol.position = 0.01f;
+  AnimSamples::setTolerance(tol);
+  auto src = makeAnimation(7,300,42);
+  testErrorBound(src,7);
+  testMix(src,7);
+
+  return testResult();
+  }
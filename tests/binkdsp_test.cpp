@@ -0,0 +1,146 @@
+// Bink::Dsp: simd kernels against scalar reference
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "bink/dsp.h"
+#include "testing.h"
+
+using namespace Bink;
+
+// dequantized coefficients stay well below this; larger values overflow int in scalar code
+static const int32_t coeffMax = 1<<20;
+
+static void checkIdct(const int32_t (&src)[64], const char* name) {
+  int32_t a[64], b[64];
+  std::memcpy(a,src,sizeof(a));
+  std::memcpy(b,src,sizeof(b));
+  Dsp::idct(a);
+  Dsp::Scalar::idct(b);
+  for(int i=0; i<64; ++i)
+    if(a[i]!=b[i]) {
+      CHECK(false,"idct(%s): [%d] %d != %d",name,i,a[i],b[i]);
+      return;
+      }
+  }
+
+static void testIdct(std::mt19937& rnd) {
+  std::uniform_int_distribution<int32_t> full (-coeffMax,coeffMax);
+  std::uniform_int_distribution<int32_t> small(-64,64);
+  std::uniform_int_distribution<int>     pos  (0,63);
+  int32_t block[64];
+
+  for(int i=0; i<20000; ++i) {
+    for(auto& v:block)
+      v = (i%2==0) ? full(rnd) : small(rnd);
+    checkIdct(block,"random");
+    }
+
+  // sparse: few non-zero coefficients, as in most of real blocks
+  for(int i=0; i<20000; ++i) {
+    std::memset(block,0,sizeof(block));
+    for(int r=i%4; r>=0; --r)
+      block[pos(rnd)] = full(rnd);
+    checkIdct(block,"sparse");
+    }
+
+  // dc-only columns take short path in scalar code
+  for(int i=0; i<1000; ++i) {
+    std::memset(block,0,sizeof(block));
+    for(int c=0; c<8; ++c)
+      if((i>>c)&1)
+        block[c] = full(rnd); else
+        block[c+8*(1+c%7)] = small(rnd);
+    checkIdct(block,"dc-only columns");
+    }
+
+  // saturated coefficients
+  const int32_t sat[] = {coeffMax, -coeffMax, 32767, -32768, 0x7F, -0x80};
+  for(auto s:sat) {
+    for(auto& v:block)
+      v = s;
+    checkIdct(block,"saturated");
+    for(int i=0; i<64; ++i)
+      block[i] = (i%2==0) ? s : -s;
+    checkIdct(block,"saturated, alternating");
+    std::memset(block,0,sizeof(block));
+    block[0] = s;
+    checkIdct(block,"saturated dc");
+    }
+  }
+
+static void testBlocks(std::mt19937& rnd) {
+  std::uniform_int_distribution<int32_t> b32(-(1<<30),1<<30);
+  std::uniform_int_distribution<int>     b16(-32768,32767);
+  std::uniform_int_distribution<int>     u8 (0,255);
+
+  int32_t blk32[64];
+  int16_t blk16[64];
+  uint8_t prev[64], a[64], b[64];
+  for(int i=0; i<20000; ++i) {
+    // every 4th block is at the edges of value range
+    const bool edge = (i%4==3);
+    for(int r=0; r<64; ++r) {
+      prev [r] = edge ? uint8_t(r%2==0 ? 255 : 0) : uint8_t(u8(rnd));
+      blk32[r] = edge ? ((r/2)%2==0 ? (1<<30) : -(1<<30)) + r : b32(rnd);
+      blk16[r] = edge ? int16_t((r/2)%2==0 ? 32767 : -32768) : int16_t(b16(rnd));
+      }
+
+    Dsp::addBlock(a,prev,blk32);
+    Dsp::Scalar::addBlock(b,prev,blk32);
+    CHECK(std::memcmp(a,b,64)==0,"addBlock(int32_t) differs from scalar");
+
+    Dsp::addBlock(a,prev,blk16);
+    Dsp::Scalar::addBlock(b,prev,blk16);
+    CHECK(std::memcmp(a,b,64)==0,"addBlock(int16_t) differs from scalar");
+
+    Dsp::putBlock(a,blk32);
+    Dsp::Scalar::putBlock(b,blk32);
+    CHECK(std::memcmp(a,b,64)==0,"putBlock differs from scalar");
+    }
+  }
+
+static bool same(float a, float b) {
+  // compiler is free to contract scalar code into fma
+  return std::abs(a-b)<=1e-5f*std::max(1.f,std::abs(a));
+  }
+
+static void testFftPass(std::mt19937& rnd) {
+  std::uniform_real_distribution<float> u(-1.f,1.f);
+
+  // odd n leaves a tail after paired simd steps
+  for(unsigned n=1; n<=33; ++n) {
+    for(int iter=0; iter<50; ++iter) {
+      std::vector<Video::FFTComplex> src(8*n);
+      std::vector<float>             tab(8*n);
+      for(auto& z:src) {
+        z.re = u(rnd);
+        z.im = u(rnd);
+        }
+      for(size_t i=0; i<tab.size(); ++i)
+        tab[i] = std::cos(float(i)*6.2831853f/float(tab.size()));
+
+      auto a = src, b = src;
+      Dsp::fftPass(a.data(),tab.data(),n);
+      Dsp::Scalar::fftPass(b.data(),tab.data(),n);
+      for(size_t i=0; i<a.size(); ++i)
+        if(!same(a[i].re,b[i].re) || !same(a[i].im,b[i].im)) {
+          CHECK(false,"fftPass(n=%u): [%u] (%g,%g) != (%g,%g)",n,uint32_t(i),
+                double(a[i].re),double(a[i].im),double(b[i].re),double(b[i].im));
+          break;
+          }
+      }
+    }
+  }
+
+int main() {
+  std::mt19937 rnd(1);
+  testIdct(rnd);
+  testBlocks(rnd);
+  testFftPass(rnd);
+
+  return testResult();
+  }
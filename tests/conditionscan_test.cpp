@@ -0,0 +1,101 @@
+// ConditionScan: conditions with side effects must not be cached
+
+#include <cstdio>
+#include <vector>
+
+#include "game/conditionscan.h"
+#include "testing.h"
+
+using namespace Daedalus;
+
+enum : size_t {
+  Self,
+  Other,
+  Aivar,
+  Global,
+  Local,
+  SafeExt,
+  UnsafeExt,
+  };
+
+static PARSymbol symbol(const char* name, uint32_t type, uint32_t flags) {
+  PARSymbol s;
+  s.name                      = name;
+  s.properties.elemProps.type  = type  & 0xF;
+  s.properties.elemProps.flags = flags & 0x3F;
+  return s;
+  }
+
+static std::vector<PARSymbol> makeSymbols() {
+  std::vector<PARSymbol> sym;
+  sym.push_back(symbol("SELF",          EParType::EParType_Instance, 0));
+  sym.push_back(symbol("OTHER",         EParType::EParType_Instance, 0));
+  sym.push_back(symbol("C_NPC.AIVAR",   EParType::EParType_Int,      EParFlag::EParFlag_ClassVar));
+  sym.push_back(symbol("KAPITEL",       EParType::EParType_Int,      0));
+  sym.push_back(symbol("DIA_COND.TMP",  EParType::EParType_Int,      0));
+  sym.push_back(symbol("NPC_ISDEAD",    EParType::EParType_Func,     EParFlag::EParFlag_External));
+  sym.push_back(symbol("AI_OUTPUT",     EParType::EParType_Func,     EParFlag::EParFlag_External));
+  return sym;
+  }
+
+static PARStackOpCode op(EParOp code, size_t arg = 0) {
+  PARStackOpCode ret = {};
+  ret.op      = code;
+  ret.symbol  = int32_t(arg);
+  ret.address = int32_t(arg);
+  ret.opSize  = 1;
+  return ret;
+  }
+
+static bool scan(const std::vector<PARStackOpCode>& code, std::vector<size_t>& globals) {
+  static const std::vector<PARSymbol> sym     = makeSymbols();
+  static const std::vector<uint8_t>   safeExt = {0,0,0,0,0,1,0};
+  ConditionScan s(sym,Self,Other,safeExt);
+  return s.exec(0,[&code](size_t pc){ return code[pc]; },globals);
+  }
+
+static bool scan(const std::vector<PARStackOpCode>& code) {
+  std::vector<size_t> globals;
+  return scan(code,globals);
+  }
+
+int main() {
+  // return self.aivar[0] + kapitel;
+  {
+    std::vector<size_t> globals;
+    const bool ret = scan({op(EParOp_SetInstance,Self), op(EParOp_PushArrayVar,Aivar), op(EParOp_PushVar,Global), op(EParOp_Add),
+                           op(EParOp_Ret)},globals);
+    CHECK(ret,"read-only condition is volatile");
+    CHECK(globals.size()==1 && globals[0]==Global,"global is not tracked");
+  }
+
+  // self.aivar[0] = 1; return true;
+  CHECK(!scan({op(EParOp_PushInt), op(EParOp_SetInstance,Self), op(EParOp_PushArrayVar,Aivar), op(EParOp_Assign),
+               op(EParOp_PushInt), op(EParOp_Ret)}),
+        "aivar-writing condition is cached");
+
+  // other.aivar[0] += 1; return true;
+  CHECK(!scan({op(EParOp_PushInt), op(EParOp_SetInstance,Other), op(EParOp_PushArrayVar,Aivar), op(EParOp_AssignAdd),
+               op(EParOp_PushInt), op(EParOp_Ret)}),
+        "aivar-writing condition is cached");
+
+  // aivar write in a function, called by condition
+  CHECK(!scan({op(EParOp_Call,3), op(EParOp_PushInt), op(EParOp_Ret),
+               op(EParOp_PushInt), op(EParOp_SetInstance,Self), op(EParOp_PushArrayVar,Aivar), op(EParOp_Assign),
+               op(EParOp_Ret)}),
+        "aivar write in callee is not detected");
+
+  // kapitel = 3;
+  CHECK(!scan({op(EParOp_PushInt), op(EParOp_PushVar,Global), op(EParOp_Assign), op(EParOp_PushInt), op(EParOp_Ret)}),
+        "global-writing condition is cached");
+
+  // var int tmp; tmp = Npc_IsDead(other); return tmp;
+  CHECK(scan({op(EParOp_PushInstance,Other), op(EParOp_CallExternal,SafeExt), op(EParOp_PushVar,Local), op(EParOp_Assign),
+              op(EParOp_PushVar,Local), op(EParOp_Ret)}),
+        "local write makes condition volatile");
+
+  CHECK(!scan({op(EParOp_CallExternal,UnsafeExt), op(EParOp_PushInt), op(EParOp_Ret)}),
+        "unsafe external is not detected");
+
+  return testResult();
+  }
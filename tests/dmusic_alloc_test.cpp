@@ -0,0 +1,255 @@
+// dmusic: audio-thread paths of SoundFont and Mixer don't allocate or free memory
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "dmusic/dlscollection.h"
+#include "dmusic/mixer.h"
+#include "dmusic/music.h"
+#include "dmusic/riff.h"
+#include "dmusic/soundfont.h"
+#include "testing.h"
+
+using namespace Dx8;
+
+// only calling thread is counted: mixer releases memory on it's own thread by design
+static thread_local bool   counting    = false;
+static thread_local size_t allocations = 0;
+
+void* operator new(std::size_t sz) {
+  if(counting)
+    allocations++;
+  if(void* p = std::malloc(sz>0 ? sz : 1))
+    return p;
+  throw std::bad_alloc();
+  }
+
+void* operator new[](std::size_t sz) {
+  return operator new(sz);
+  }
+
+void operator delete(void* p) noexcept {
+  if(counting && p!=nullptr)
+    allocations++;
+  std::free(p);
+  }
+
+void operator delete[](void* p) noexcept {
+  operator delete(p);
+  }
+
+void operator delete(void* p, std::size_t) noexcept {
+  operator delete(p);
+  }
+
+void operator delete[](void* p, std::size_t) noexcept {
+  operator delete(p);
+  }
+
+struct AllocScope final {
+  AllocScope()  { allocations = 0; counting = true; }
+  ~AllocScope() { counting = false; }
+  };
+
+using Bytes = std::vector<uint8_t>;
+
+static Bytes chunk(const char* id, const void* data, size_t sz) {
+  Bytes ret(8+sz+sz%2);
+  const uint32_t size = uint32_t(sz);
+  std::memcpy(&ret[0],id,4);
+  std::memcpy(&ret[4],&size,4);
+  if(sz>0)
+    std::memcpy(&ret[8],data,sz);
+  return ret;
+  }
+
+template<class T>
+static Bytes chunk(const char* id, const T& data) {
+  return chunk(id,&data,sizeof(data));
+  }
+
+static Bytes list(const char* type, const char* id, std::initializer_list<Bytes> sub) {
+  Bytes body(id,id+4);
+  for(auto& i:sub)
+    body.insert(body.end(),i.begin(),i.end());
+  return chunk(type,body.data(),body.size());
+  }
+
+// one instrument: looped sine over whole key range
+static Bytes makeDls() {
+  enum { Period = 100, Periods = 4 };
+
+  DlsCollection::InstrumentHeader insh;
+  insh.cRegions = 1;
+
+  DlsCollection::RegionHeader rgnh;
+  rgnh.RangeKey.usLow       = 0;
+  rgnh.RangeKey.usHigh      = 127;
+  rgnh.RangeVelocity.usLow  = 0;
+  rgnh.RangeVelocity.usHigh = 127;
+
+  struct {
+    DlsCollection::WaveSample     smp;
+    DlsCollection::WaveSampleLoop loop;
+    } wsmp;
+  wsmp.smp.cbSize        = sizeof(wsmp.smp);
+  wsmp.smp.usUnityNote   = 60;
+  wsmp.smp.cSampleLoops  = 1;
+  wsmp.loop.cbSize       = sizeof(wsmp.loop);
+  wsmp.loop.ulLoopStart  = 0;
+  wsmp.loop.ulLoopLength = Period*Periods;
+
+  DlsCollection::WaveLink wlnk;
+  wlnk.ulTableIndex = 0;
+
+  Wave::WaveFormat fmt;
+  fmt.wFormatTag       = Wave::PCM;
+  fmt.wChannels        = 1;
+  fmt.dwSamplesPerSec  = SoundFont::SampleRate;
+  fmt.dwAvgBytesPerSec = SoundFont::SampleRate*2;
+  fmt.wBlockAlign      = 2;
+  fmt.wBitsPerSample   = 16;
+
+  std::vector<int16_t> pcm(Period*Periods);
+  for(size_t i=0; i<pcm.size(); ++i)
+    pcm[i] = int16_t(std::sin(float(i)*6.2831853f/float(Period))*16000.f);
+
+  return list("RIFF","DLS ",{
+    list("LIST","lins",{
+      list("LIST","ins ",{
+        chunk("insh",insh),
+        list("LIST","lrgn",{
+          list("LIST","rgn ",{
+            chunk("rgnh",rgnh),
+            chunk("wsmp",wsmp),
+            chunk("wlnk",wlnk),
+            }),
+          }),
+        }),
+      }),
+    list("LIST","wvpl",{
+      list("LIST","wave",{
+        chunk("fmt ",fmt),
+        chunk("data",pcm.data(),pcm.size()*sizeof(int16_t)),
+        }),
+      }),
+    });
+  }
+
+static void release(SoundFont& font, float* buf, size_t count) {
+  for(int i=0; i<100 && font.hasNotes(); ++i)
+    font.mix(buf,count,1.f);
+  }
+
+static void testSoundFont(const DlsCollection& dls) {
+  enum { Block = 512, Notes = 100 };
+
+  SoundFont font = dls.toSoundfont(0);
+  font.setPan(0.5f);
+
+  std::array<SoundFont::Ticket,Notes> tickets;
+  std::vector<float>                  buf(Block*2);
+
+  // notes beyond preallocated voices are dropped, instead of growing voice pool
+  size_t accepted[2] = {};
+  for(int round=0; round<2; ++round) {
+    AllocScope scope;
+    float      peak = 0;
+    for(size_t i=0; i<Notes; ++i) {
+      tickets[i] = font.noteOn(uint8_t(20+i),100);
+      if(!(tickets[i]==nullptr))
+        accepted[round]++;
+      }
+    for(int r=0; r<8; ++r) {
+      std::fill(buf.begin(),buf.end(),0.f);
+      font.mix(buf.data(),Block,0.5f);
+      for(auto v:buf)
+        peak = std::max(peak,std::abs(v));
+      }
+    for(auto& t:tickets)
+      SoundFont::noteOff(t);
+    release(font,buf.data(),Block);
+
+    CHECK(allocations==0,"soundfont, round %d: %u allocations",round,uint32_t(allocations));
+    CHECK(peak>0.f,"soundfont, round %d: silent output",round);
+    CHECK(!font.hasNotes(),"soundfont, round %d: notes are not released",round);
+    }
+  CHECK(0<accepted[0] && accepted[0]<Notes,"unexpected voice capacity: %u",uint32_t(accepted[0]));
+  CHECK(accepted[0]==accepted[1],"voice capacity changed: %u -> %u",uint32_t(accepted[0]),uint32_t(accepted[1]));
+
+  // same note twice goes to the next instance
+  auto t0 = font.noteOn(60,100);
+  auto t1 = font.noteOn(60,100);
+  CHECK(!(t0==nullptr) && !(t1==nullptr),"repeated note is dropped");
+  SoundFont::noteOff(t0);
+  SoundFont::noteOff(t1);
+  release(font,buf.data(),Block);
+  }
+
+static void testGain(const DlsCollection& dls) {
+  enum { Block = 1024 };
+  const float gain = 0.3f;
+
+  SoundFont a = dls.toSoundfont(0);
+  SoundFont b = dls.toSoundfont(0);
+  const uint8_t notes[] = {48, 60, 67};
+  for(auto n:notes) {
+    a.noteOn(n,90);
+    b.noteOn(n,90);
+    }
+
+  std::vector<float> ba(Block*2), bb(Block*2);
+  for(int r=0; r<4; ++r) {
+    std::fill(ba.begin(),ba.end(),0.f);
+    std::fill(bb.begin(),bb.end(),0.f);
+    a.mix(ba.data(),Block,1.f);
+    b.mix(bb.data(),Block,gain);
+    for(size_t i=0; i<ba.size(); ++i) {
+      const float ref = ba[i]*gain;
+      if(std::abs(bb[i]-ref)>1e-5f*std::max(1.f,std::abs(ref))) {
+        CHECK(false,"mix with gain: [%u] %g != %g",uint32_t(i),double(bb[i]),double(ref));
+        return;
+        }
+      }
+    }
+  }
+
+static void testMixer() {
+  enum { Block = 512 };
+  std::vector<int16_t> out(Block*2);
+
+  Mixer mixer;
+  auto  prev = std::make_unique<Music>();
+  Music next;
+  mixer.setMusic(*prev);
+  mixer.mix(out.data(),Block);
+
+  // mixer holds last reference to previous music, when it switches
+  mixer.setMusic(next);
+  prev.reset();
+
+  AllocScope scope;
+  for(int i=0; i<4; ++i)
+    mixer.mix(out.data(),Block);
+  CHECK(allocations==0,"mixer: %u allocations",uint32_t(allocations));
+  }
+
+int main() {
+  const Bytes   data = makeDls();
+  Riff          input(data.data(),data.size());
+  DlsCollection dls(input);
+
+  testSoundFont(dls);
+  testGain(dls);
+  testMixer();
+
+  return testResult();
+  }
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdio>
+
+// shared by all tests: failed CHECK prints location and message, main returns testResult()
+static int failed = 0;
+
+#define CHECK(cond, ...) \
+  do { \
+    if(!(cond)) { \
+      std::printf("%s:%d: ",__FILE__,__LINE__); \
+      std::printf(__VA_ARGS__); \
+      std::printf("\n"); \
+      failed++; \
+      } \
+    } while(false)
+
+static int testResult() {
+  if(failed>0) {
+    std::printf("%d checks failed\n",failed);
+    return 1;
+    }
+  return 0;
+  }